@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string_view>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "metrics/metrics_layout.hpp"
+#include "proactor/timer_handler.hpp"
+#include "timing/time.hpp"
+
+namespace Sage::Bench
+{
+
+/// Log-linear histogram, the same bucketing the proactor publishes its latencies with
+class LatencyRecorder
+{
+public:
+    /// Negative values are recorded as 0
+    void Record(TimeNS latency) noexcept
+    {
+        const auto ns{ static_cast<uint64_t>(std::max(latency.count(), TimeNS::rep{ 0 })) };
+        Increment(m_values[Metrics::LatencyBucket(ns)], 1);
+        Increment(m_values[Metrics::s_latencyBuckets], 1);
+        Increment(m_values[Metrics::s_latencyBuckets + 1], ns);
+        m_max = std::max(m_max, ns);
+    }
+
+    void Reset() noexcept
+    {
+        for (auto& value : m_values)
+        {
+            value.store(0, std::memory_order_relaxed);
+        }
+        m_max = 0;
+    }
+
+    uint64_t Count() const noexcept { return m_values[Metrics::s_latencyBuckets].load(std::memory_order_relaxed); }
+
+    uint64_t Max() const noexcept { return m_max; }
+
+    double Mean() const noexcept
+    {
+        const uint64_t count{ Count() };
+        const uint64_t sum{ m_values[Metrics::s_latencyBuckets + 1].load(std::memory_order_relaxed) };
+        return count == 0 ? 0 : static_cast<double>(sum) / static_cast<double>(count);
+    }
+
+    /// @param percentile in [0, 100]
+    uint64_t Percentile(double percentile) const noexcept
+    {
+        return Metrics::LatencyPercentile(m_values.data(), percentile);
+    }
+
+private:
+    static void Increment(std::atomic<uint64_t>& value, uint64_t by) noexcept
+    {
+        value.store(value.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, Metrics::s_latencySize> m_values{};
+    uint64_t m_max{ 0 };
+};
+
+/// Runs a callback on every expiry
+class CallbackTimer final : public TimerHandler
+{
+public:
+    CallbackTimer(std::string_view name, const TimeNS& period, std::function<void()>&& onExpired) :
+        TimerHandler{ name, period },
+        m_onExpired{ std::move(onExpired) }
+    {
+    }
+
+private:
+    void OnTimerExpired() override { m_onExpired(); }
+
+    std::function<void()> m_onExpired;
+};
+
+/// User and system time of the whole process
+inline double CpuSeconds()
+{
+    rusage usage{};
+    ::getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+inline long MaxResidentKB()
+{
+    rusage usage{};
+    ::getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/// Current resident set size, or 0 if it can't be read
+inline size_t ResidentBytes()
+{
+    std::FILE* statm{ std::fopen("/proc/self/statm", "r") };
+    if (statm == nullptr)
+    {
+        return 0;
+    }
+
+    unsigned long size{ 0 };
+    unsigned long resident{ 0 };
+    const int read{ std::fscanf(statm, "%lu %lu", &size, &resident) };
+    std::fclose(statm);
+
+    return read == 2 ? resident * static_cast<size_t>(::sysconf(_SC_PAGESIZE)) : 0;
+}
+
+} // namespace Sage::Bench
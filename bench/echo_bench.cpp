@@ -0,0 +1,445 @@
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <print>
+#include <string>
+#include <string_view>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "bench_utils.hpp"
+#include "echo_server.hpp"
+#include "log/logger.hpp"
+#include "proactor/proactor.hpp"
+#include "proactor/tcp_client.hpp"
+#include "proactor/timer_handler.hpp"
+#include "timing/time.hpp"
+
+/**
+ * End to end loopback benchmark. A forked echo server is driven by TcpClients sending fixed size messages,
+ * either as fast as the echoes come back or at a fixed rate. Throughput and round trip percentiles are
+ * printed to stdout as JSON. build with -DCMAKE_BUILD_TYPE=Release
+ */
+
+namespace Sage
+{
+
+namespace
+{
+
+struct Options
+{
+    size_t m_clients{ 16 };
+    size_t m_messageSize{ 64 };
+    // messages in flight per client
+    size_t m_depth{ 1 };
+    // messages per second over all clients. 0 sends the next message as soon as an echo arrives
+    uint64_t m_rate{ 0 };
+    TimeS m_warmup{ 2 };
+    TimeS m_duration{ 10 };
+    TcpClient::RecvMode m_recvMode{ TcpClient::CompletionRecv };
+    BackendOptions m_backend{};
+    std::string m_logFile{ "/dev/null" };
+};
+
+Options GetOptions(int argc, char* const argv[])
+{
+    constexpr std::array argOptions{
+        option{ "help",      no_argument,       nullptr, 'h' },
+        option{ "clients",   required_argument, nullptr, 'c' },
+        option{ "size",      required_argument, nullptr, 's' },
+        option{ "depth",     required_argument, nullptr, 'd' },
+        option{ "rate",      required_argument, nullptr, 'r' },
+        option{ "warmup",    required_argument, nullptr, 'w' },
+        option{ "duration",  required_argument, nullptr, 't' },
+        option{ "readiness", no_argument,       nullptr, 'R' },
+        option{ "backend",   required_argument, nullptr, 'B' },
+        option{ "record",    required_argument, nullptr, 'C' },
+        option{ "replay",    required_argument, nullptr, 'P' },
+        option{ "file",      required_argument, nullptr, 'f' },
+        option{ 0,           0,                 0,       0   }
+    };
+
+    auto usage = [&argv]
+    {
+        std::println(
+            std::cerr,
+            "Usage: {}"
+            "\n\t[optional] --clients|-c <connections> (default 16)"
+            "\n\t[optional] --size|-s <message bytes> (default 64)"
+            "\n\t[optional] --depth|-d <messages in flight per connection> (default 1)"
+            "\n\t[optional] --rate|-r <messages/s over all connections> (default 0, closed loop)"
+            "\n\t[optional] --warmup|-w <seconds> (default 2)"
+            "\n\t[optional] --duration|-t <seconds> (default 10)"
+            "\n\t[optional] --readiness|-R (poll for readiness instead of posting a recv per connection)"
+            "\n\t[optional] --backend|-B <io_uring|epoll> (default io_uring)"
+            "\n\t[optional] --record|-C <trace filename> (every completion, for --replay)"
+            "\n\t[optional] --replay|-P <trace filename> (rerun a recorded run without the kernel. times are the"
+            " proactor's and handlers' alone)"
+            "\n\t[optional] --file|-f <log filename> (default /dev/null)"
+            "\n\t[optional] --help|-h",
+            argv[0]
+        );
+    };
+
+    Options options;
+    int option;
+    int optIndex;
+    while ((option = getopt_long(argc, argv, "hc:s:d:r:w:t:RB:C:P:f:", argOptions.data(), &optIndex)) != -1)
+    {
+        switch (option)
+        {
+            case 'h':
+                usage();
+                std::exit(0);
+                break;
+
+            case 'c':
+                options.m_clients = std::max(std::stoul(optarg), 1ul);
+                break;
+
+            case 's':
+                options.m_messageSize = std::max(std::stoul(optarg), 1ul);
+                break;
+
+            case 'd':
+                options.m_depth = std::max(std::stoul(optarg), 1ul);
+                break;
+
+            case 'r':
+                options.m_rate = std::stoul(optarg);
+                break;
+
+            case 'w':
+                options.m_warmup = TimeS{ std::stol(optarg) };
+                break;
+
+            case 't':
+                options.m_duration = TimeS{ std::max(std::stol(optarg), 1l) };
+                break;
+
+            case 'R':
+                options.m_recvMode = TcpClient::ReadinessRecv;
+                break;
+
+            case 'B':
+            {
+                auto backend{ ParseBackendType(optarg) };
+                if (not backend)
+                {
+                    usage();
+                    std::exit(1);
+                }
+                options.m_backend.m_type = *backend;
+                break;
+            }
+
+            case 'C':
+                options.m_backend.m_recordFile = optarg;
+                break;
+
+            case 'P':
+                options.m_backend.m_replayFile = optarg;
+                break;
+
+            case 'f':
+                options.m_logFile = optarg;
+                break;
+
+            case '?':
+            default:
+                usage();
+                std::exit(1);
+                break;
+        }
+    }
+
+    if (not options.m_backend.m_replayFile.empty())
+    {
+        options.m_backend.m_type = BackendType::Replay;
+    }
+
+    return options;
+}
+
+class LoadGenerator;
+
+class EchoClient final : public TcpClient
+{
+public:
+    EchoClient(LoadGenerator& generator, const std::string& port, const Options& options);
+
+    bool Connected() const noexcept { return m_connected; }
+
+    bool CanSend() const noexcept { return m_connected and m_inFlight < m_sentAt.size(); }
+
+    void Send();
+
+private:
+    void OnConnect() override;
+
+    void OnReceive(std::span<uint8_t>) override {}
+
+    void OnReceiveBuffer(BufferHandle buff) override;
+
+    /// Connections are made once up front. skips the base client's periodic chatter and health checks,
+    /// which would otherwise show up in the round trips
+    void OnTimerExpired() override { UpdateInterval(24h); }
+
+    LoadGenerator& m_generator;
+    const size_t m_messageSize;
+    // send times of the messages in flight, oldest first from m_oldest
+    std::vector<Clock::time_point> m_sentAt;
+    size_t m_oldest{ 0 };
+    size_t m_inFlight{ 0 };
+    size_t m_rxBytes{ 0 };
+    bool m_connected{ false };
+};
+
+class LoadGenerator
+{
+public:
+    LoadGenerator(const Options& options, uint16_t port) :
+        m_options{ options },
+        m_payload{ std::make_shared<const std::string>(options.m_messageSize, 'x') },
+        m_phaseTimer{ "echo-phase", options.m_warmup.count() > 0 ? TimeNS{ options.m_warmup } : TimeNS{ 1ms },
+                      [this] { OnPhaseEnd(); } }
+    {
+        const std::string portStr{ std::to_string(port) };
+        m_clients.reserve(options.m_clients);
+        for (size_t i{ 0 }; i < options.m_clients; i++)
+        {
+            m_clients.push_back(std::make_unique<EchoClient>(*this, portStr, options));
+        }
+
+        if (options.m_rate > 0)
+        {
+            m_pacer = std::make_unique<Bench::CallbackTimer>("echo-pacer", 1ms, [this] { Pace(); });
+        }
+    }
+
+    const SharedPayload& Payload() const noexcept { return m_payload; }
+
+    bool ClosedLoop() const noexcept { return m_options.m_rate == 0; }
+
+    void OnEcho(EchoClient& client, TimeNS rtt)
+    {
+        if (m_measuring)
+        {
+            m_rtt.Record(rtt);
+        }
+
+        if (ClosedLoop())
+        {
+            client.Send();
+        }
+    }
+
+    void PrintJson() const
+    {
+        // stopped early by a signal, possibly before the warmup was over
+        const Clock::time_point end{ m_measuring ? Clock::now() : m_end };
+        const double seconds{
+            m_start == Clock::time_point{} ? 0 : std::chrono::duration<double>(end - m_start).count()
+        };
+        const double messages{ static_cast<double>(m_rtt.Count()) };
+        const size_t connected{ static_cast<size_t>(
+            std::ranges::count_if(m_clients, [](const auto& client) { return client->Connected(); })
+        ) };
+
+        std::println(
+            "{{\n  \"clients\": {},\n  \"connected\": {},\n  \"message_size\": {},\n  \"depth\": {},\n"
+            "  \"rate\": {},\n  \"recv_mode\": \"{}\",\n  \"backend\": \"{}\",\n  \"seconds\": {:.3f},\n"
+            "  \"messages\": {},\n"
+            "  \"messages_per_sec\": {:.0f},\n  \"mb_per_sec\": {:.2f},\n  \"rtt_ns\": {{ \"mean\": {:.0f}, "
+            "\"p50\": {}, \"p99\": {}, \"p999\": {}, \"max\": {} }},\n  \"cpu_seconds\": {:.3f},\n"
+            "  \"max_rss_kb\": {}\n}}",
+            m_options.m_clients,
+            connected,
+            m_options.m_messageSize,
+            m_options.m_depth,
+            m_options.m_rate,
+            m_options.m_recvMode == TcpClient::ReadinessRecv ? "readiness" : "completion",
+            GetBackendTypeName(Proactor::Instance().Backend()),
+            seconds,
+            m_rtt.Count(),
+            seconds > 0 ? messages / seconds : 0,
+            seconds > 0 ? messages * static_cast<double>(m_options.m_messageSize) / seconds / 1e6 : 0,
+            m_rtt.Mean(),
+            m_rtt.Percentile(50),
+            m_rtt.Percentile(99),
+            m_rtt.Percentile(99.9),
+            m_rtt.Max(),
+            Bench::CpuSeconds(),
+            Bench::MaxResidentKB()
+        );
+    }
+
+private:
+    /// The first expiry ends the warmup, the second the measurement
+    void OnPhaseEnd()
+    {
+        if (not m_measuring)
+        {
+            m_rtt.Reset();
+            m_measuring = true;
+            m_start = Clock::now();
+            m_phaseTimer.UpdateInterval(m_options.m_duration);
+            std::println(std::cerr, "measuring for {}s", m_options.m_duration.count());
+            return;
+        }
+
+        m_end = Clock::now();
+        m_measuring = false;
+        Proactor::Instance().Stop();
+    }
+
+    /// Hands out the sends due since the last tick, round robin over the clients with room in their pipeline
+    void Pace()
+    {
+        const Clock::time_point now{ Clock::now() };
+        if (m_lastPace != Clock::time_point{})
+        {
+            m_credit += static_cast<double>(m_options.m_rate) * std::chrono::duration<double>(now - m_lastPace).count();
+            // a saturated server doesn't build up a burst to release later
+            m_credit = std::min(m_credit, static_cast<double>(m_clients.size() * m_options.m_depth));
+        }
+        m_lastPace = now;
+
+        size_t idle{ 0 };
+        while (m_credit >= 1 and idle < m_clients.size())
+        {
+            EchoClient& client{ *m_clients[m_next] };
+            m_next = (m_next + 1) % m_clients.size();
+            if (client.CanSend())
+            {
+                client.Send();
+                m_credit -= 1;
+                idle = 0;
+            }
+            else
+            {
+                idle++;
+            }
+        }
+    }
+
+    const Options& m_options;
+    const SharedPayload m_payload;
+    std::vector<std::unique_ptr<EchoClient>> m_clients;
+    Bench::CallbackTimer m_phaseTimer;
+    std::unique_ptr<Bench::CallbackTimer> m_pacer;
+    Bench::LatencyRecorder m_rtt;
+    bool m_measuring{ false };
+    Clock::time_point m_start{};
+    Clock::time_point m_end{};
+    Clock::time_point m_lastPace{};
+    double m_credit{ 0 };
+    size_t m_next{ 0 };
+};
+
+EchoClient::EchoClient(LoadGenerator& generator, const std::string& port, const Options& options) :
+    TcpClient{ "127.0.0.1", port, options.m_recvMode },
+    m_generator{ generator },
+    m_messageSize{ options.m_messageSize },
+    m_sentAt(options.m_depth)
+{
+}
+
+void EchoClient::Send()
+{
+    m_sentAt[(m_oldest + m_inFlight) % m_sentAt.size()] = Clock::now();
+    m_inFlight++;
+    Proactor::Instance().RequestTcpSend(*this, m_generator.Payload());
+}
+
+void EchoClient::OnConnect()
+{
+    m_connected = true;
+    if (m_generator.ClosedLoop())
+    {
+        while (CanSend())
+        {
+            Send();
+        }
+    }
+}
+
+void EchoClient::OnReceiveBuffer(BufferHandle buff)
+{
+    const Clock::time_point now{ Clock::now() };
+    m_rxBytes += buff.Size();
+
+    // echoes arrive in order, so every full message completes the oldest send
+    while (m_rxBytes >= m_messageSize and m_inFlight > 0)
+    {
+        const Clock::time_point sentAt{ m_sentAt[m_oldest] };
+        m_oldest = (m_oldest + 1) % m_sentAt.size();
+        m_inFlight--;
+        m_rxBytes -= m_messageSize;
+        m_generator.OnEcho(*this, now - sentAt);
+    }
+}
+
+} // namespace
+
+} // namespace Sage
+
+int main(int argc, char* const argv[])
+{
+    using namespace Sage;
+
+    const Options options{ GetOptions(argc, argv) };
+
+    uint16_t port{ 0 };
+    int listenFd{ Bench::ListenOnLoopback(port) };
+    if (listenFd == -1)
+    {
+        return 1;
+    }
+
+    // forked before the logger or the ring exist, so the child inherits neither
+    const pid_t serverPid{ ::fork() };
+    if (serverPid == -1)
+    {
+        int err{ errno };
+        std::println(std::cerr, "unable to fork the echo server. {}", strerror(err));
+        return 1;
+    }
+
+    if (serverPid == 0)
+    {
+        Bench::RunEchoServer(listenFd);
+    }
+    ::close(listenFd);
+
+    Logger::SetupLogger(options.m_logFile, Logger::Level::Info);
+    Proactor::Create(options.m_backend);
+    {
+        std::println(
+            std::cerr,
+            "{} clients sending {}B messages to 127.0.0.1:{}. warming up for {}s",
+            options.m_clients,
+            options.m_messageSize,
+            port,
+            options.m_warmup.count()
+        );
+
+        LoadGenerator generator{ options, port };
+        Proactor::Instance().Run();
+        generator.PrintJson();
+    }
+    Proactor::Destroy();
+    Logger::ShutdownLogger();
+
+    ::kill(serverPid, SIGTERM);
+    ::waitpid(serverPid, nullptr, 0);
+
+    return 0;
+}
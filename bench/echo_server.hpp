@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <print>
+#include <sys/epoll.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace Sage::Bench
+{
+
+/// @returns a non blocking socket listening on an ephemeral loopback port, or -1
+inline int ListenOnLoopback(uint16_t& port)
+{
+    int listenFd{ ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0) };
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLen{ sizeof(addr) };
+
+    if (listenFd == -1 or ::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), addrLen) != 0 or
+        ::listen(listenFd, SOMAXCONN) != 0 or
+        ::getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &addrLen) != 0)
+    {
+        int err{ errno };
+        std::println(std::cerr, "unable to listen on loopback. {}", strerror(err));
+        if (listenFd != -1)
+        {
+            ::close(listenFd);
+        }
+        return -1;
+    }
+
+    port = ntohs(addr.sin_port);
+    return listenFd;
+}
+
+inline bool SendAll(int fd, const char* data, size_t size)
+{
+    while (size > 0)
+    {
+        const ssize_t txBytes{ ::send(fd, data, size, MSG_NOSIGNAL) };
+        if (txBytes < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+
+        data += txBytes;
+        size -= static_cast<size_t>(txBytes);
+    }
+
+    return true;
+}
+
+/// Plain epoll echo server, deliberately independent of the proactor under test. Runs in its own process so
+/// it doesn't compete for the client's loop, and dies with the parent. listenFd is a non blocking tcp or unix
+/// stream socket
+[[noreturn]] inline void RunEchoServer(int listenFd)
+{
+    ::prctl(PR_SET_PDEATHSIG, SIGKILL);
+
+    const int epollFd{ ::epoll_create1(EPOLL_CLOEXEC) };
+    epoll_event listenEvent{};
+    listenEvent.events = EPOLLIN;
+    listenEvent.data.fd = listenFd;
+    if (epollFd == -1 or ::epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &listenEvent) != 0)
+    {
+        int err{ errno };
+        std::println(std::cerr, "echo server failed to start. {}", strerror(err));
+        ::_exit(1);
+    }
+
+    std::array<epoll_event, 256> events;
+    std::vector<char> buff(256 * 1024);
+
+    while (true)
+    {
+        const int ready{ ::epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), -1) };
+        for (int i{ 0 }; i < ready; i++)
+        {
+            const int fd{ events[static_cast<size_t>(i)].data.fd };
+            if (fd == listenFd)
+            {
+                int clientFd;
+                while ((clientFd = ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC)) != -1)
+                {
+                    // fails harmlessly on a unix socket
+                    const int noDelay{ 1 };
+                    ::setsockopt(clientFd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+                    epoll_event clientEvent{};
+                    clientEvent.events = EPOLLIN;
+                    clientEvent.data.fd = clientFd;
+                    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, clientFd, &clientEvent);
+                }
+                continue;
+            }
+
+            // sends block. the clients always have a recv outstanding so they never stall for long
+            const ssize_t rxBytes{ ::recv(fd, buff.data(), buff.size(), MSG_DONTWAIT) };
+            if ((rxBytes < 0 and errno != EAGAIN and errno != EINTR) or rxBytes == 0 or
+                (rxBytes > 0 and not SendAll(fd, buff.data(), static_cast<size_t>(rxBytes))))
+            {
+                ::close(fd);
+            }
+        }
+    }
+}
+
+} // namespace Sage::Bench
@@ -0,0 +1,508 @@
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <getopt.h>
+#include <iostream>
+#include <linux/magic.h>
+#include <memory>
+#include <print>
+#include <random>
+#include <string>
+#include <string_view>
+#include <sys/statfs.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+#include "bench_utils.hpp"
+#include "log/logger.hpp"
+#include "proactor/file_handle.hpp"
+#include "proactor/proactor.hpp"
+#include "timing/time.hpp"
+
+/**
+ * File IOPS and bandwidth through FileHandle. The file is written out in full first, then each pattern, sequential
+ * and random, is read and written block by block with the queue depth of ops kept in flight. Point --path at the
+ * filesystem to measure, /tmp for tmpfs or somewhere on ext4. Buffered reads of a file just written come from the
+ * page cache, --direct bypasses it where the filesystem allows O_DIRECT. Results are printed to stdout as JSON.
+ * build with -DCMAKE_BUILD_TYPE=Release
+ */
+
+namespace Sage
+{
+
+namespace
+{
+
+enum class Pattern : uint8_t
+{
+    Sequential = 0,
+    Random,
+};
+
+enum class Direction : uint8_t
+{
+    Read = 0,
+    Write,
+};
+
+struct BenchOptions
+{
+    std::string m_path{ "/tmp/proactor-file-bench.dat" };
+    size_t m_megabytes{ 256 };
+    size_t m_blockSize{ 4096 };
+    size_t m_queueDepth{ 32 };
+    std::vector<Pattern> m_patterns{ Pattern::Sequential, Pattern::Random };
+    std::vector<Direction> m_directions{ Direction::Read, Direction::Write };
+    bool m_direct{ false };
+    bool m_registered{ false };
+    BackendType m_backend{ BackendType::IOURing };
+    std::string m_logFile{ "/dev/null" };
+};
+
+std::string_view PatternName(Pattern pattern) noexcept { return pattern == Pattern::Sequential ? "seq" : "random"; }
+
+std::string_view DirectionName(Direction direction) noexcept
+{
+    return direction == Direction::Read ? "read" : "write";
+}
+
+std::string_view FilesystemName(const std::string& path)
+{
+    struct statfs fs{};
+    if (::statfs(path.c_str(), &fs) != 0)
+    {
+        return "unknown";
+    }
+
+    switch (fs.f_type)
+    {
+        case TMPFS_MAGIC:
+            return "tmpfs";
+        case EXT4_SUPER_MAGIC:
+            return "ext4";
+        case XFS_SUPER_MAGIC:
+            return "xfs";
+        case BTRFS_SUPER_MAGIC:
+            return "btrfs";
+        default:
+            return "other";
+    }
+}
+
+BenchOptions GetOptions(int argc, char* const argv[])
+{
+    constexpr std::array argOptions{
+        option{ "help",       no_argument,       nullptr, 'h' },
+        option{ "path",       required_argument, nullptr, 'p' },
+        option{ "megabytes",  required_argument, nullptr, 'm' },
+        option{ "block",      required_argument, nullptr, 'b' },
+        option{ "depth",      required_argument, nullptr, 'd' },
+        option{ "pattern",    required_argument, nullptr, 'P' },
+        option{ "op",         required_argument, nullptr, 'o' },
+        option{ "direct",     no_argument,       nullptr, 'D' },
+        option{ "registered", no_argument,       nullptr, 'r' },
+        option{ "backend",    required_argument, nullptr, 'B' },
+        option{ "file",       required_argument, nullptr, 'f' },
+        option{ 0,            0,                 0,       0   }
+    };
+
+    auto usage = [&argv]
+    {
+        std::println(
+            std::cerr,
+            "Usage: {}"
+            "\n\t[optional] --path|-p <file to create and remove> (default /tmp/proactor-file-bench.dat)"
+            "\n\t[optional] --megabytes|-m <file size> (default 256)"
+            "\n\t[optional] --block|-b <bytes per op> (default 4096)"
+            "\n\t[optional] --depth|-d <ops in flight> (default 32)"
+            "\n\t[optional] --pattern|-P <seq|random|both> (default both)"
+            "\n\t[optional] --op|-o <read|write|both> (default both)"
+            "\n\t[optional] --direct|-D bypass the page cache, blocks rounded up to 4096"
+            "\n\t[optional] --registered|-r read and write through registered buffers"
+            "\n\t[optional] --backend|-B <io_uring|epoll> (default io_uring)"
+            "\n\t[optional] --file|-f <log filename> (default /dev/null)"
+            "\n\t[optional] --help|-h",
+            argv[0]
+        );
+    };
+
+    BenchOptions options;
+    int option;
+    int optIndex;
+    while ((option = getopt_long(argc, argv, "hp:m:b:d:P:o:DrB:f:", argOptions.data(), &optIndex)) != -1)
+    {
+        switch (option)
+        {
+            case 'h':
+                usage();
+                std::exit(0);
+                break;
+
+            case 'p':
+                options.m_path = optarg;
+                break;
+
+            case 'm':
+                options.m_megabytes = std::max(std::stoul(optarg), 1ul);
+                break;
+
+            case 'b':
+                options.m_blockSize = std::clamp(std::stoul(optarg), 512ul, 1024ul * 1024);
+                break;
+
+            case 'd':
+                options.m_queueDepth = std::clamp(std::stoul(optarg), 1ul, 4096ul);
+                break;
+
+            case 'P':
+            {
+                const std::string_view pattern{ optarg };
+                if (pattern == "seq")
+                {
+                    options.m_patterns = { Pattern::Sequential };
+                }
+                else if (pattern == "random")
+                {
+                    options.m_patterns = { Pattern::Random };
+                }
+                else if (pattern != "both")
+                {
+                    usage();
+                    std::exit(1);
+                }
+                break;
+            }
+
+            case 'o':
+            {
+                const std::string_view op{ optarg };
+                if (op == "read")
+                {
+                    options.m_directions = { Direction::Read };
+                }
+                else if (op == "write")
+                {
+                    options.m_directions = { Direction::Write };
+                }
+                else if (op != "both")
+                {
+                    usage();
+                    std::exit(1);
+                }
+                break;
+            }
+
+            case 'D':
+                options.m_direct = true;
+                break;
+
+            case 'r':
+                options.m_registered = true;
+                break;
+
+            case 'B':
+            {
+                auto backend{ ParseBackendType(optarg) };
+                if (not backend)
+                {
+                    usage();
+                    std::exit(1);
+                }
+                options.m_backend = *backend;
+                break;
+            }
+
+            case 'f':
+                options.m_logFile = optarg;
+                break;
+
+            case '?':
+            default:
+                usage();
+                std::exit(1);
+                break;
+        }
+    }
+
+    if (options.m_direct)
+    {
+        options.m_blockSize = (options.m_blockSize + s_directAlignment - 1) / s_directAlignment * s_directAlignment;
+    }
+
+    return options;
+}
+
+class Runs;
+
+class BenchFile final : public FileHandle
+{
+public:
+    BenchFile(Runs& runs, const BenchOptions& options) :
+        FileHandle{ "file-bench",
+                    options.m_path,
+                    Options{ .m_flags = O_RDWR | O_CREAT | O_TRUNC,
+                             .m_mode = 0644,
+                             .m_direct = options.m_direct,
+                             .m_queueDepth = options.m_queueDepth } },
+        m_runs{ runs }
+    {
+    }
+
+private:
+    void OnOpen(int res) override;
+
+    Runs& m_runs;
+};
+
+/// Fills the file, then runs each pattern and direction in turn, keeping the queue depth of ops in flight.
+/// Each op slot has a block of its own in one buffer, registered with the ring when asked
+class Runs
+{
+public:
+    explicit Runs(const BenchOptions& options) :
+        m_options{ options },
+        m_blocks{ options.m_megabytes * 1024 * 1024 / options.m_blockSize },
+        m_buffer{ AllocateAligned(options.m_blockSize * options.m_queueDepth) }
+    {
+        std::fill_n(m_buffer.get(), m_options.m_blockSize * m_options.m_queueDepth, uint8_t{ 'x' });
+        if (m_options.m_registered)
+        {
+            const iovec memory{ m_buffer.get(), m_options.m_blockSize * m_options.m_queueDepth };
+            m_registered = Proactor::Instance().RegisterFileBuffers(std::span{ &memory, 1 });
+            if (not m_registered)
+            {
+                std::println(std::cerr, "buffers couldn't be registered, running without");
+            }
+        }
+
+        m_file = std::make_unique<BenchFile>(*this, m_options);
+    }
+
+    ~Runs()
+    {
+        m_file.reset();
+        ::unlink(m_options.m_path.c_str());
+    }
+
+    void OnOpen(int res)
+    {
+        if (res != 0)
+        {
+            std::println(std::cerr, "unable to open {}. {}", m_options.m_path, strerror(-res));
+            Proactor::Instance().Stop();
+            return;
+        }
+
+        std::println(
+            std::cerr, "filling {}MB at {}", m_blocks * m_options.m_blockSize / (1024 * 1024), m_options.m_path
+        );
+        StartPhase();
+    }
+
+    void PrintJson() const
+    {
+        std::string runs;
+        for (const Result& result : m_results)
+        {
+            const double iops{ result.m_seconds > 0 ? static_cast<double>(result.m_ops) / result.m_seconds : 0 };
+            const double megabytesPerSec{ iops * static_cast<double>(m_options.m_blockSize) / 1e6 };
+            runs += std::format(
+                "{}\n    {{ \"pattern\": \"{}\", \"op\": \"{}\", \"ops\": {}, \"errors\": {}, \"seconds\": {:.3f}, "
+                "\"iops\": {:.0f}, \"mb_per_sec\": {:.1f}, \"p50_us\": {:.1f}, \"p99_us\": {:.1f} }}",
+                runs.empty() ? "" : ",",
+                PatternName(result.m_pattern),
+                DirectionName(result.m_direction),
+                result.m_ops,
+                result.m_errors,
+                result.m_seconds,
+                iops,
+                megabytesPerSec,
+                static_cast<double>(result.m_p50) / 1e3,
+                static_cast<double>(result.m_p99) / 1e3
+            );
+
+            std::println(
+                std::cerr,
+                "{:>6} {:<5}: {:>9.0f} iops {:>8.1f} MB/s",
+                PatternName(result.m_pattern),
+                DirectionName(result.m_direction),
+                iops,
+                megabytesPerSec
+            );
+        }
+
+        std::println(
+            "{{\n  \"backend\": \"{}\",\n  \"filesystem\": \"{}\",\n  \"megabytes\": {},\n  \"block_bytes\": {},\n"
+            "  \"queue_depth\": {},\n  \"direct\": {},\n  \"registered\": {},\n  \"runs\": [{}\n  ]\n}}",
+            GetBackendTypeName(Proactor::Instance().Backend()),
+            FilesystemName(m_options.m_path),
+            m_options.m_megabytes,
+            m_options.m_blockSize,
+            m_options.m_queueDepth,
+            m_options.m_direct,
+            m_registered,
+            runs
+        );
+    }
+
+private:
+    struct Phase
+    {
+        Pattern m_pattern;
+        Direction m_direction;
+        // the fill isn't reported
+        bool m_measured;
+    };
+
+    struct Result
+    {
+        Pattern m_pattern;
+        Direction m_direction;
+        size_t m_ops;
+        size_t m_errors;
+        double m_seconds;
+        uint64_t m_p50;
+        uint64_t m_p99;
+    };
+
+    Phase CurrentPhase() const
+    {
+        if (m_phase == 0)
+        {
+            return Phase{ Pattern::Sequential, Direction::Write, false };
+        }
+
+        const size_t run{ m_phase - 1 };
+        return Phase{ m_options.m_patterns[run / m_options.m_directions.size()],
+                      m_options.m_directions[run % m_options.m_directions.size()],
+                      true };
+    }
+
+    size_t Phases() const { return 1 + m_options.m_patterns.size() * m_options.m_directions.size(); }
+
+    void StartPhase()
+    {
+        const Phase phase{ CurrentPhase() };
+        if (phase.m_measured)
+        {
+            std::println(std::cerr, "{} {}", PatternName(phase.m_pattern), DirectionName(phase.m_direction));
+        }
+
+        m_issued = 0;
+        m_completed = 0;
+        m_errors = 0;
+        m_latency.Reset();
+        m_start = Clock::now();
+        for (size_t slot{ 0 }; slot < std::min(m_options.m_queueDepth, m_blocks); slot++)
+        {
+            Issue(slot);
+        }
+    }
+
+    void Issue(size_t slot)
+    {
+        const Phase phase{ CurrentPhase() };
+        const size_t block{ phase.m_pattern == Pattern::Sequential ? m_issued : m_pick(m_random) % m_blocks };
+        const uint64_t offset{ block * m_options.m_blockSize };
+        m_issued++;
+
+        auto onComplete = [this, slot, submitted{ Clock::now() }](int res) { OnComplete(slot, submitted, res); };
+        const std::span<uint8_t> buffer{ m_buffer.get() + slot * m_options.m_blockSize, m_options.m_blockSize };
+        const bool queued{ phase.m_direction == Direction::Read
+                               ? m_file->Read(buffer, offset, std::move(onComplete))
+                               : m_file->Write(buffer, offset, std::move(onComplete)) };
+        if (not queued)
+        {
+            Proactor::Instance().Stop();
+        }
+    }
+
+    void OnComplete(size_t slot, Clock::time_point submitted, int res)
+    {
+        m_latency.Record(Clock::now() - submitted);
+        m_completed++;
+        if (res != static_cast<int>(m_options.m_blockSize))
+        {
+            m_errors++;
+        }
+
+        if (m_issued < m_blocks)
+        {
+            Issue(slot);
+            return;
+        }
+
+        if (m_completed < m_blocks)
+        {
+            return;
+        }
+
+        const Phase phase{ CurrentPhase() };
+        if (phase.m_measured)
+        {
+            m_results.push_back(Result{
+                .m_pattern = phase.m_pattern,
+                .m_direction = phase.m_direction,
+                .m_ops = m_completed,
+                .m_errors = m_errors,
+                .m_seconds = std::chrono::duration<double>(Clock::now() - m_start).count(),
+                .m_p50 = m_latency.Percentile(50),
+                .m_p99 = m_latency.Percentile(99),
+            });
+        }
+        else if (m_errors > 0)
+        {
+            std::println(std::cerr, "{} of {} blocks failed to fill", m_errors, m_blocks);
+        }
+
+        if (++m_phase == Phases())
+        {
+            Proactor::Instance().Stop();
+            return;
+        }
+        StartPhase();
+    }
+
+    const BenchOptions& m_options;
+    const size_t m_blocks;
+    AlignedBuffer m_buffer;
+    bool m_registered{ false };
+    std::unique_ptr<BenchFile> m_file;
+    std::mt19937_64 m_random{ 42 };
+    std::uniform_int_distribution<size_t> m_pick{};
+    size_t m_phase{ 0 };
+    size_t m_issued{ 0 };
+    size_t m_completed{ 0 };
+    size_t m_errors{ 0 };
+    Bench::LatencyRecorder m_latency;
+    Clock::time_point m_start{};
+    std::vector<Result> m_results;
+};
+
+void BenchFile::OnOpen(int res) { m_runs.OnOpen(res); }
+
+} // namespace
+
+} // namespace Sage
+
+int main(int argc, char* const argv[])
+{
+    using namespace Sage;
+
+    const BenchOptions options{ GetOptions(argc, argv) };
+
+    Logger::SetupLogger(options.m_logFile, Logger::Level::Info);
+    Proactor::Create(options.m_backend);
+    {
+        Runs runs{ options };
+        Proactor::Instance().Run();
+        runs.PrintJson();
+    }
+    Proactor::Destroy();
+    Logger::ShutdownLogger();
+
+    return 0;
+}
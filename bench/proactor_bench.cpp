@@ -0,0 +1,462 @@
+#include <arpa/inet.h>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <print>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "log/logger.hpp"
+#include "proactor/epoll_backend.hpp"
+#include "proactor/io_uring.hpp"
+#include "proactor/proactor.hpp"
+#include "proactor/proactor_internals.hpp"
+#include "proactor/tcp_client.hpp"
+#include "proactor/timer_handler.hpp"
+#include "timing/time.hpp"
+
+/**
+ * Microbenchmarks of the ring, the proactor's internals and the logger.
+ * Usage: proactor-bench [--backend io_uring|epoll] [filter]. only runs benchmarks whose name contains filter.
+ * The backend is the one the proactor benchmarks run on.
+ * Results are printed to stdout as JSON, progress to stderr. build with -DCMAKE_BUILD_TYPE=Release
+ */
+
+namespace
+{
+
+// every heap allocation in the process goes through here
+std::atomic<size_t> g_allocations{ 0 };
+std::atomic<size_t> g_allocatedBytes{ 0 };
+
+void* CountedAlloc(size_t size, size_t alignment)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+    size = std::max(size, size_t{ 1 });
+    void* ptr{ nullptr };
+    if (alignment <= alignof(std::max_align_t))
+    {
+        ptr = std::malloc(size);
+    }
+    else
+    {
+        // aligned_alloc wants a multiple of the alignment
+        ptr = std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+    }
+
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc{};
+    }
+    return ptr;
+}
+
+} // namespace
+
+void* operator new(size_t size) { return CountedAlloc(size, alignof(std::max_align_t)); }
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    return CountedAlloc(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+namespace Sage
+{
+
+namespace
+{
+
+template<typename T> void DoNotOptimize(const T& value) { asm volatile("" : : "r,m"(value) : "memory"); }
+
+class Bench
+{
+public:
+    explicit Bench(std::string_view filter) : m_filter{ filter } {}
+
+    /// Runs op(i) for a tenth of the iterations to warm up, then measures the full count
+    template<typename Op> void Run(const std::string& name, size_t iterations, Op&& op)
+    {
+        if (not name.contains(m_filter))
+        {
+            return;
+        }
+
+        for (size_t i{ 0 }; i < iterations / 10; i++)
+        {
+            op(i);
+        }
+
+        const size_t allocations{ g_allocations.load(std::memory_order_relaxed) };
+        const size_t allocatedBytes{ g_allocatedBytes.load(std::memory_order_relaxed) };
+        const Clock::time_point start{ Clock::now() };
+
+        for (size_t i{ 0 }; i < iterations; i++)
+        {
+            op(i);
+        }
+
+        const TimeNS elapsed{ Clock::now() - start };
+        const auto count{ static_cast<double>(iterations) };
+
+        Result result{
+            .m_name = name,
+            .m_iterations = iterations,
+            .m_nsPerOp = static_cast<double>(elapsed.count()) / count,
+            .m_opsPerSec = count / std::chrono::duration<double>(elapsed).count(),
+            .m_allocsPerOp = static_cast<double>(g_allocations.load(std::memory_order_relaxed) - allocations) / count,
+            .m_bytesPerOp = static_cast<double>(g_allocatedBytes.load(std::memory_order_relaxed) - allocatedBytes) /
+                            count,
+        };
+
+        std::println(
+            std::cerr,
+            "{:<40} {:>12.1f} ns/op {:>14.0f} ops/s {:>8.2f} allocs/op",
+            result.m_name,
+            result.m_nsPerOp,
+            result.m_opsPerSec,
+            result.m_allocsPerOp
+        );
+        m_results.push_back(std::move(result));
+    }
+
+    void PrintJson() const
+    {
+        std::print("{{\n  \"benchmarks\": [");
+        std::string_view separator{ "" };
+        for (const Result& result : m_results)
+        {
+            std::print(
+                "{}\n    {{ \"name\": \"{}\", \"iterations\": {}, \"ns_per_op\": {:.2f}, \"ops_per_sec\": {:.0f}, "
+                "\"allocs_per_op\": {:.3f}, \"alloc_bytes_per_op\": {:.1f} }}",
+                separator,
+                result.m_name,
+                result.m_iterations,
+                result.m_nsPerOp,
+                result.m_opsPerSec,
+                result.m_allocsPerOp,
+                result.m_bytesPerOp
+            );
+            separator = ",";
+        }
+        std::println("\n  ]\n}}");
+    }
+
+private:
+    struct Result
+    {
+        std::string m_name;
+        size_t m_iterations;
+        double m_nsPerOp;
+        double m_opsPerSec;
+        double m_allocsPerOp;
+        double m_bytesPerOp;
+    };
+
+    std::string_view m_filter;
+    std::vector<Result> m_results;
+};
+
+class IdleTimer final : public TimerHandler
+{
+public:
+    IdleTimer() : TimerHandler{ "bench-timer", 1h } {}
+
+private:
+    void OnTimerExpired() override {}
+};
+
+class SinkClient final : public TcpClient
+{
+public:
+    explicit SinkClient(const std::string& port) : TcpClient{ "127.0.0.1", port } {}
+
+    bool m_connected{ false };
+
+private:
+    void OnConnect() override { m_connected = true; }
+
+    void OnReceive(std::span<uint8_t>) override {}
+};
+
+} // namespace
+
+class ProactorBench
+{
+public:
+    static void RunAll(Bench& bench)
+    {
+        Proactor& proactor{ Proactor::Instance() };
+        // kept until the end. a removed timer is cancelled through the ring and would complete in later benchmarks
+        std::vector<std::unique_ptr<IdleTimer>> timers;
+
+        RingRoundTrip(bench);
+        PendingEvents(bench, proactor);
+        TimerUpdates(bench, proactor, timers);
+        Sends(bench, proactor);
+        Logging(bench);
+    }
+
+private:
+    static void NoopComplete(Event&, const io_uring_cqe&) {}
+
+    static void RingRoundTrip(Bench& bench)
+    {
+        IOURing ring{ 256 };
+        EpollBackend epoll;
+        for (auto [name, backend] : { std::pair<const char*, IOBackend*>{ "iouring_nop_round_trip", &ring },
+                                      std::pair<const char*, IOBackend*>{ "epoll_nop_round_trip", &epoll } })
+        {
+            bench.Run(
+                name,
+                200'000,
+                [backend](size_t i)
+                {
+                    backend->QueueNop(i);
+                    UniqueUringCEvent cEvent{ backend->WaitForEvent() };
+                    DoNotOptimize(cEvent->res);
+                }
+            );
+        }
+    }
+
+    static void PendingEvents(Bench& bench, Proactor& proactor)
+    {
+        auto& pendingEvents{ ProactorInternals::PendingEvents(proactor) };
+
+        bench.Run(
+            "pending_event_create_lookup_erase",
+            1'000'000,
+            [&pendingEvents](size_t)
+            {
+                auto event{ std::make_unique<TimerUpdateEvent>(0, NoopComplete) };
+                const EventId id{ event->m_id };
+                pendingEvents[id] = std::move(event);
+
+                auto itr{ pendingEvents.find(id) };
+                DoNotOptimize(itr->second.get());
+                pendingEvents.erase(itr);
+            }
+        );
+
+        // the full path of an op: event, submission, completion, dispatch and release
+        bench.Run(
+            "proactor_nop_completion",
+            200'000,
+            [&proactor, &pendingEvents](size_t)
+            {
+                auto event{ std::make_unique<TimerUpdateEvent>(0, NoopComplete) };
+                const IOBackend::UserData userData{ event->m_id };
+                ProactorInternals::Backend(proactor).QueueNop(userData);
+                pendingEvents[userData] = std::move(event);
+                ProactorInternals::HandleCompletion(proactor);
+            }
+        );
+    }
+
+    static void TimerUpdates(Bench& bench, Proactor& proactor, std::vector<std::unique_ptr<IdleTimer>>& timers)
+    {
+        std::vector<Handle::Id> timerIds;
+        TimeNS period{ 1h };
+
+        for (size_t count : { 1, 10, 100, 1000 })
+        {
+            while (timers.size() < count)
+            {
+                timers.push_back(std::make_unique<IdleTimer>());
+                proactor.StartTimerHandler(*timers.back());
+            }
+
+            timerIds.clear();
+            for (const auto& [_, event] : ProactorInternals::PendingEvents(proactor))
+            {
+                if (dynamic_cast<const TimerExpiredEvent*>(event.get()) != nullptr)
+                {
+                    timerIds.push_back(event->m_handlerId);
+                }
+            }
+
+            bench.Run(
+                std::format("find_pending_event_{}_handlers", count),
+                100'000,
+                [&proactor, &timerIds](size_t i)
+                {
+                    const Handle::Id id{ timerIds[i % timerIds.size()] };
+                    DoNotOptimize(ProactorInternals::FindPendingEvent<TimerExpiredEvent>(proactor, id));
+                }
+            );
+
+            bench.Run(
+                std::format("timer_update_{}_handlers", count),
+                20'000,
+                [&proactor, &timers, &period, count](size_t i)
+                {
+                    // a new period every time or the update is skipped
+                    period += 1ns;
+                    timers[i % count]->UpdateInterval(period);
+                    ProactorInternals::HandleCompletion(proactor);
+                }
+            );
+        }
+    }
+
+    static void Sends(Bench& bench, Proactor& proactor)
+    {
+        int listenFd{ ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0) };
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t addrLen{ sizeof(addr) };
+
+        if (listenFd == -1 or ::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), addrLen) != 0 or
+            ::listen(listenFd, 1) != 0 or ::getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &addrLen) != 0)
+        {
+            int err{ errno };
+            std::println(std::cerr, "skipping send benchmarks. unable to listen on loopback. {}", strerror(err));
+            return;
+        }
+
+        SinkClient client{ std::to_string(ntohs(addr.sin_port)) };
+        proactor.StartSocketClient(client);
+        // the connect is the only op in flight
+        ProactorInternals::HandleCompletion(proactor);
+
+        int peerFd{ ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC) };
+        ::close(listenFd);
+        if (not client.m_connected or peerFd == -1)
+        {
+            std::println(std::cerr, "skipping send benchmarks. loopback connection failed");
+            return;
+        }
+
+        // keep the socket buffers from filling up. the kernel would otherwise hold the send back
+        auto sendAndDrain = [&proactor, peerFd](size_t i, auto&& send)
+        {
+            send();
+            ProactorInternals::HandleCompletion(proactor);
+            if (i % 64 == 0)
+            {
+                std::array<char, 64 * 1024> sink;
+                while (::recv(peerFd, sink.data(), sink.size(), 0) > 0)
+                {
+                }
+            }
+        };
+
+        constexpr size_t messageSize{ 64 };
+        constexpr size_t iterations{ 100'000 };
+        const std::array<uint8_t, messageSize> message{};
+        const SharedPayload shared{ std::make_shared<const std::string>(messageSize, 'x') };
+
+        bench.Run(
+            "tcp_send_string",
+            iterations,
+            [&](size_t i) { sendAndDrain(i, [&] { proactor.RequestTcpSend(client, std::string(messageSize, 'x')); }); }
+        );
+
+        bench.Run(
+            "tcp_send_span",
+            iterations,
+            [&](size_t i) { sendAndDrain(i, [&] { proactor.RequestTcpSend(client, message, [](int) {}); }); }
+        );
+
+        bench.Run(
+            "tcp_send_pooled",
+            iterations,
+            [&](size_t i)
+            {
+                sendAndDrain(
+                    i,
+                    [&]
+                    {
+                        BufferHandle buff{ proactor.AcquireTxBuffer() };
+                        std::memcpy(buff.Data(), message.data(), message.size());
+                        proactor.RequestTcpSend(client, buff.Slice(0, message.size()));
+                    }
+                );
+            }
+        );
+
+        bench.Run(
+            "tcp_send_shared",
+            iterations,
+            [&](size_t i) { sendAndDrain(i, [&] { proactor.RequestTcpSend(client, shared); }); }
+        );
+
+        ::close(peerFd);
+    }
+
+    static void Logging(Bench& bench)
+    {
+        bench.Run("log_enabled", 200'000, [](size_t i) { LOG_INFO("bench message {} {}", i, 0.5); });
+
+        bench.Run("log_disabled", 10'000'000, [](size_t i) { LOG_DEBUG("bench message {} {}", i, 0.5); });
+
+        bench.Run("get_current_timestamp", 1'000'000, [](size_t) { DoNotOptimize(GetCurrentTimeStamp()); });
+    }
+};
+
+} // namespace Sage
+
+int main(int argc, char* const argv[])
+{
+    using namespace Sage;
+
+    constexpr std::array argOptions{
+        option{ "backend", required_argument, nullptr, 'B' },
+        option{ 0,         0,                 0,       0   }
+    };
+
+    auto usage = [&argv] { std::println(std::cerr, "Usage: {} [--backend|-B <io_uring|epoll>] [filter]", argv[0]); };
+
+    BackendType backend{ BackendType::IOURing };
+    int option;
+    int optIndex{ 0 };
+    while ((option = getopt_long(argc, argv, "B:", argOptions.data(), &optIndex)) != -1)
+    {
+        auto parsed{ option == 'B' ? ParseBackendType(optarg) : std::nullopt };
+        if (not parsed)
+        {
+            usage();
+            return 1;
+        }
+        backend = *parsed;
+    }
+
+    if (argc - optind > 1)
+    {
+        usage();
+        return 1;
+    }
+
+    // logged lines are formatted and written as usual, just not kept
+    Logger::SetupLogger("/dev/null", Logger::Level::Info);
+
+    Bench bench{ optind < argc ? argv[optind] : "" };
+    Proactor::Create(backend);
+    ProactorBench::RunAll(bench);
+    Proactor::Destroy();
+
+    bench.PrintJson();
+    Logger::ShutdownLogger();
+
+    return 0;
+}
@@ -0,0 +1,448 @@
+#include <algorithm>
+#include <array>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <format>
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <netinet/in.h>
+#include <poll.h>
+#include <print>
+#include <string>
+#include <string_view>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "bench_utils.hpp"
+#include "echo_server.hpp"
+#include "log/logger.hpp"
+#include "proactor/proactor.hpp"
+#include "proactor/tcp_relay.hpp"
+#include "timing/time.hpp"
+
+/**
+ * Relay throughput, splicing against copying. A forked client streams a fixed number of bytes through a TcpRelay
+ * to a forked echo server and reads the echo back, so every byte crosses the relay in both directions. Once the
+ * client has sent everything it shuts down its writes, which the relay passes on, and the transfer ends when the
+ * hang up has come back round. Each mode relays its own transfer in turn. Throughput and the relay process's cpu
+ * time per GB, its io_uring workers included, are printed to stdout as JSON. build with -DCMAKE_BUILD_TYPE=Release
+ */
+
+namespace Sage
+{
+
+namespace
+{
+
+struct BenchOptions
+{
+    // per transfer, each way
+    size_t m_megabytes{ 1024 };
+    // the client's writes
+    size_t m_chunkSize{ 64 * 1024 };
+    size_t m_maxInFlight{ 64 * 1024 };
+    std::vector<TcpRelay::Mode> m_modes{ TcpRelay::Mode::Splice, TcpRelay::Mode::Copy };
+    BackendType m_backend{ BackendType::IOURing };
+    std::string m_logFile{ "/dev/null" };
+};
+
+std::string_view ModeName(TcpRelay::Mode mode) noexcept { return mode == TcpRelay::Mode::Splice ? "splice" : "copy"; }
+
+BenchOptions GetOptions(int argc, char* const argv[])
+{
+    constexpr std::array argOptions{
+        option{ "help",      no_argument,       nullptr, 'h' },
+        option{ "megabytes", required_argument, nullptr, 'm' },
+        option{ "chunk",     required_argument, nullptr, 'c' },
+        option{ "in-flight", required_argument, nullptr, 'i' },
+        option{ "mode",      required_argument, nullptr, 'M' },
+        option{ "backend",   required_argument, nullptr, 'B' },
+        option{ "file",      required_argument, nullptr, 'f' },
+        option{ 0,           0,                 0,       0   }
+    };
+
+    auto usage = [&argv]
+    {
+        std::println(
+            std::cerr,
+            "Usage: {}"
+            "\n\t[optional] --megabytes|-m <MB sent through per mode> (default 1024)"
+            "\n\t[optional] --chunk|-c <client write bytes> (default 65536)"
+            "\n\t[optional] --in-flight|-i <relay bytes in flight per direction> (default 65536)"
+            "\n\t[optional] --mode|-M <splice|copy|both> (default both)"
+            "\n\t[optional] --backend|-B <io_uring|epoll> (default io_uring)"
+            "\n\t[optional] --file|-f <log filename> (default /dev/null)"
+            "\n\t[optional] --help|-h",
+            argv[0]
+        );
+    };
+
+    BenchOptions options;
+    int option;
+    int optIndex;
+    while ((option = getopt_long(argc, argv, "hm:c:i:M:B:f:", argOptions.data(), &optIndex)) != -1)
+    {
+        switch (option)
+        {
+            case 'h':
+                usage();
+                std::exit(0);
+                break;
+
+            case 'm':
+                options.m_megabytes = std::max(std::stoul(optarg), 1ul);
+                break;
+
+            case 'c':
+                options.m_chunkSize = std::max(std::stoul(optarg), 1ul);
+                break;
+
+            case 'i':
+                options.m_maxInFlight = std::max(std::stoul(optarg), 4096ul);
+                break;
+
+            case 'M':
+            {
+                const std::string_view mode{ optarg };
+                if (mode == "splice")
+                {
+                    options.m_modes = { TcpRelay::Mode::Splice };
+                }
+                else if (mode == "copy")
+                {
+                    options.m_modes = { TcpRelay::Mode::Copy };
+                }
+                else if (mode != "both")
+                {
+                    usage();
+                    std::exit(1);
+                }
+                break;
+            }
+
+            case 'B':
+            {
+                auto backend{ ParseBackendType(optarg) };
+                if (not backend)
+                {
+                    usage();
+                    std::exit(1);
+                }
+                options.m_backend = *backend;
+                break;
+            }
+
+            case 'f':
+                options.m_logFile = optarg;
+                break;
+
+            case '?':
+            default:
+                usage();
+                std::exit(1);
+                break;
+        }
+    }
+
+    return options;
+}
+
+/// @returns a blocking socket connected to the loopback port, or -1
+int ConnectToLoopback(uint16_t port)
+{
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+
+    const int fd{ ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0) };
+    if (fd == -1 or ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        int err{ errno };
+        std::println(std::cerr, "unable to connect to port {}. {}", port, strerror(err));
+        if (fd != -1)
+        {
+            ::close(fd);
+        }
+        return -1;
+    }
+
+    return fd;
+}
+
+/// Waits for the client's next connection on the non blocking listener
+/// @returns the accepted socket, or -1
+int AcceptOne(int listenFd)
+{
+    pollfd readable{ .fd = listenFd, .events = POLLIN, .revents = 0 };
+    while (true)
+    {
+        const int fd{ ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC) };
+        if (fd != -1)
+        {
+            return fd;
+        }
+
+        const int err{ errno };
+        if ((err != EAGAIN and err != EINTR) or (::poll(&readable, 1, 10'000) == 0))
+        {
+            std::println(std::cerr, "no connection from the client. {}", strerror(err));
+            return -1;
+        }
+    }
+}
+
+/// Plain blocking sockets, one thread writing and one reading, so it keeps the relay busy both ways. Runs in its
+/// own process so it doesn't compete for the relay's cpu time
+[[noreturn]] void RunClient(uint16_t port, const BenchOptions& options)
+{
+    ::prctl(PR_SET_PDEATHSIG, SIGKILL);
+
+    const std::vector<char> chunk(options.m_chunkSize, 'x');
+    const size_t total{ options.m_megabytes * 1024 * 1024 };
+    for (size_t transfer{ 0 }; transfer < options.m_modes.size(); transfer++)
+    {
+        const int fd{ ConnectToLoopback(port) };
+        if (fd == -1)
+        {
+            ::_exit(1);
+        }
+
+        std::thread reader{ [fd]
+                            {
+                                std::vector<char> buff(256 * 1024);
+                                while (::recv(fd, buff.data(), buff.size(), 0) > 0)
+                                {
+                                }
+                            } };
+
+        for (size_t sent{ 0 }; sent < total; sent += chunk.size())
+        {
+            if (not Bench::SendAll(fd, chunk.data(), std::min(chunk.size(), total - sent)))
+            {
+                break;
+            }
+        }
+        ::shutdown(fd, SHUT_WR);
+
+        // the echo has come back and the hang up with it
+        reader.join();
+        ::close(fd);
+    }
+
+    ::_exit(0);
+}
+
+class Transfers;
+
+class MeasuredRelay final : public TcpRelay
+{
+public:
+    MeasuredRelay(Transfers& transfers, int clientFd, int upstreamFd, const Options& options) :
+        TcpRelay{ "relay-bench", clientFd, upstreamFd, options },
+        m_transfers{ transfers }
+    {
+    }
+
+private:
+    void OnClose(int res) override;
+
+    Transfers& m_transfers;
+};
+
+/// Relays one transfer per mode, each started once the one before has closed
+class Transfers
+{
+public:
+    Transfers(const BenchOptions& options, int listenFd, uint16_t upstreamPort) :
+        m_options{ options },
+        m_listenFd{ listenFd },
+        m_upstreamPort{ upstreamPort },
+        // idle until a relay closes. the next is started outside the closed one's callback
+        m_nextTimer{ "relay-bench-next", 24h, [this] { OnNext(); } }
+    {
+        StartTransfer();
+    }
+
+    void OnClosed(int res)
+    {
+        const TcpRelay::Mode mode{ m_options.m_modes[m_results.size()] };
+        m_results.push_back(Result{
+            .m_mode = m_relay->GetMode(),
+            .m_requested = mode,
+            .m_seconds = std::chrono::duration<double>(Clock::now() - m_start).count(),
+            .m_bytes = m_relay->BytesToUpstream() + m_relay->BytesToClient(),
+            .m_cpuSeconds = Bench::CpuSeconds() - m_cpuStart,
+            .m_res = res,
+        });
+        m_nextTimer.UpdateInterval(1ms);
+    }
+
+    void PrintJson() const
+    {
+        std::string modes;
+        for (const Result& result : m_results)
+        {
+            const double gigabytes{ static_cast<double>(result.m_bytes) / 1e9 };
+            modes += std::format(
+                "{}\n    {{ \"mode\": \"{}\", \"requested\": \"{}\", \"result\": \"{}\", \"seconds\": {:.3f}, "
+                "\"bytes\": {}, \"gbit_per_sec\": {:.2f}, \"cpu_seconds\": {:.3f}, \"cpu_seconds_per_gb\": {:.3f} }}",
+                modes.empty() ? "" : ",",
+                ModeName(result.m_mode),
+                ModeName(result.m_requested),
+                result.m_res == 0 ? "ok" : strerror(-result.m_res),
+                result.m_seconds,
+                result.m_bytes,
+                result.m_seconds > 0 ? gigabytes * 8 / result.m_seconds : 0,
+                result.m_cpuSeconds,
+                gigabytes > 0 ? result.m_cpuSeconds / gigabytes : 0
+            );
+
+            std::println(
+                std::cerr,
+                "{:>6}: {:.2f} Gbit/s relayed, {:.3f} cpu seconds per GB",
+                ModeName(result.m_mode),
+                result.m_seconds > 0 ? gigabytes * 8 / result.m_seconds : 0,
+                gigabytes > 0 ? result.m_cpuSeconds / gigabytes : 0
+            );
+        }
+
+        std::println(
+            "{{\n  \"backend\": \"{}\",\n  \"megabytes\": {},\n  \"chunk_bytes\": {},\n  \"max_in_flight\": {},\n"
+            "  \"modes\": [{}\n  ]\n}}",
+            GetBackendTypeName(Proactor::Instance().Backend()),
+            m_options.m_megabytes,
+            m_options.m_chunkSize,
+            m_options.m_maxInFlight,
+            modes
+        );
+    }
+
+private:
+    struct Result
+    {
+        // what the relay ran as, copy if splicing wasn't supported
+        TcpRelay::Mode m_mode;
+        TcpRelay::Mode m_requested;
+        double m_seconds;
+        uint64_t m_bytes;
+        double m_cpuSeconds;
+        int m_res;
+    };
+
+    void StartTransfer()
+    {
+        const TcpRelay::Mode mode{ m_options.m_modes[m_results.size()] };
+        const int clientFd{ AcceptOne(m_listenFd) };
+        const int upstreamFd{ clientFd == -1 ? -1 : ConnectToLoopback(m_upstreamPort) };
+        if (upstreamFd == -1)
+        {
+            if (clientFd != -1)
+            {
+                ::close(clientFd);
+            }
+            Proactor::Instance().Stop();
+            return;
+        }
+
+        std::println(std::cerr, "{}: relaying {}MB each way", ModeName(mode), m_options.m_megabytes);
+        m_start = Clock::now();
+        m_cpuStart = Bench::CpuSeconds();
+        m_relay = std::make_unique<MeasuredRelay>(
+            *this, clientFd, upstreamFd, TcpRelay::Options{ .m_mode = mode, .m_maxInFlight = m_options.m_maxInFlight }
+        );
+    }
+
+    void OnNext()
+    {
+        m_nextTimer.UpdateInterval(24h);
+        m_relay.reset();
+        if (m_results.size() == m_options.m_modes.size())
+        {
+            Proactor::Instance().Stop();
+            return;
+        }
+
+        StartTransfer();
+    }
+
+    const BenchOptions& m_options;
+    const int m_listenFd;
+    const uint16_t m_upstreamPort;
+    Bench::CallbackTimer m_nextTimer;
+    std::unique_ptr<MeasuredRelay> m_relay;
+    Clock::time_point m_start{};
+    double m_cpuStart{ 0 };
+    std::vector<Result> m_results;
+};
+
+void MeasuredRelay::OnClose(int res) { m_transfers.OnClosed(res); }
+
+} // namespace
+
+} // namespace Sage
+
+int main(int argc, char* const argv[])
+{
+    using namespace Sage;
+
+    const BenchOptions options{ GetOptions(argc, argv) };
+
+    uint16_t relayPort{ 0 };
+    uint16_t upstreamPort{ 0 };
+    const int relayListenFd{ Bench::ListenOnLoopback(relayPort) };
+    const int upstreamListenFd{ Bench::ListenOnLoopback(upstreamPort) };
+    if (relayListenFd == -1 or upstreamListenFd == -1)
+    {
+        return 1;
+    }
+
+    // forked before the logger or the ring exist, so the children inherit neither
+    const pid_t serverPid{ ::fork() };
+    if (serverPid == 0)
+    {
+        ::close(relayListenFd);
+        Bench::RunEchoServer(upstreamListenFd);
+    }
+    ::close(upstreamListenFd);
+
+    const pid_t clientPid{ serverPid == -1 ? -1 : ::fork() };
+    if (clientPid == 0)
+    {
+        ::close(relayListenFd);
+        RunClient(relayPort, options);
+    }
+
+    if (serverPid == -1 or clientPid == -1)
+    {
+        int err{ errno };
+        std::println(std::cerr, "unable to fork. {}", strerror(err));
+        return 1;
+    }
+
+    Logger::SetupLogger(options.m_logFile, Logger::Level::Info);
+    Proactor::Create(options.m_backend);
+    {
+        Transfers transfers{ options, relayListenFd, upstreamPort };
+        Proactor::Instance().Run();
+        transfers.PrintJson();
+    }
+    Proactor::Destroy();
+    Logger::ShutdownLogger();
+
+    ::close(relayListenFd);
+    for (pid_t pid : { clientPid, serverPid })
+    {
+        ::kill(pid, SIGTERM);
+        ::waitpid(pid, nullptr, 0);
+    }
+
+    return 0;
+}
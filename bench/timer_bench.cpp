@@ -0,0 +1,455 @@
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <print>
+#include <random>
+#include <string>
+#include <string_view>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "bench_utils.hpp"
+#include "log/logger.hpp"
+#include "proactor/proactor.hpp"
+#include "proactor/timer_handler.hpp"
+#include "timing/time.hpp"
+
+/**
+ * Timer accuracy and scalability benchmark. Registers 1, 10, 100 ... timers with mixed periods while a share of
+ * them are moved to another period, and measures how late expiries are handled, the CPU spent per expiry and
+ * the memory each timer takes. Every timer count runs in its own process. results are printed to stdout as JSON,
+ * progress to stderr. build with -DCMAKE_BUILD_TYPE=Release
+ */
+
+namespace Sage
+{
+
+namespace
+{
+
+struct Options
+{
+    size_t m_maxTimers{ 1'000'000 };
+    // assigned round robin
+    std::vector<TimeNS> m_periods{ 100ms, 250ms, 1s, 5s };
+    // UpdateInterval calls per second over all timers
+    uint64_t m_updateRate{ 100 };
+    TimeS m_warmup{ 1 };
+    TimeS m_duration{ 5 };
+    BackendType m_backend{ BackendType::IOURing };
+    std::string m_logFile{ "/dev/null" };
+};
+
+std::vector<TimeNS> ParsePeriods(std::string_view arg)
+{
+    std::vector<TimeNS> periods;
+    while (not arg.empty())
+    {
+        const size_t end{ std::min(arg.find(','), arg.size()) };
+        uint64_t ms{ 0 };
+        if (std::from_chars(arg.data(), arg.data() + end, ms).ec == std::errc{} and ms > 0)
+        {
+            periods.push_back(TimeMS{ ms });
+        }
+        arg.remove_prefix(std::min(end + 1, arg.size()));
+    }
+
+    return periods;
+}
+
+Options GetOptions(int argc, char* const argv[])
+{
+    constexpr std::array argOptions{
+        option{ "help",     no_argument,       nullptr, 'h' },
+        option{ "timers",   required_argument, nullptr, 'n' },
+        option{ "periods",  required_argument, nullptr, 'p' },
+        option{ "updates",  required_argument, nullptr, 'u' },
+        option{ "warmup",   required_argument, nullptr, 'w' },
+        option{ "duration", required_argument, nullptr, 't' },
+        option{ "backend",  required_argument, nullptr, 'B' },
+        option{ "file",     required_argument, nullptr, 'f' },
+        option{ 0,          0,                 0,       0   }
+    };
+
+    auto usage = [&argv]
+    {
+        std::println(
+            std::cerr,
+            "Usage: {}"
+            "\n\t[optional] --timers|-n <most timers> (default 1000000. runs 1, 10, 100 ... up to it)"
+            "\n\t[optional] --periods|-p <ms,ms,...> (default 100,250,1000,5000)"
+            "\n\t[optional] --updates|-u <UpdateInterval calls/s> (default 100)"
+            "\n\t[optional] --warmup|-w <seconds> (default 1)"
+            "\n\t[optional] --duration|-t <seconds per timer count> (default 5)"
+            "\n\t[optional] --backend|-B <io_uring|epoll> (default io_uring. epoll takes an fd per timer)"
+            "\n\t[optional] --file|-f <log filename> (default /dev/null)"
+            "\n\t[optional] --help|-h",
+            argv[0]
+        );
+    };
+
+    Options options;
+    int option;
+    int optIndex;
+    while ((option = getopt_long(argc, argv, "hn:p:u:w:t:B:f:", argOptions.data(), &optIndex)) != -1)
+    {
+        switch (option)
+        {
+            case 'h':
+                usage();
+                std::exit(0);
+                break;
+
+            case 'n':
+                options.m_maxTimers = std::max(std::stoul(optarg), 1ul);
+                break;
+
+            case 'p':
+                options.m_periods = ParsePeriods(optarg);
+                if (options.m_periods.empty())
+                {
+                    usage();
+                    std::exit(1);
+                }
+                break;
+
+            case 'u':
+                options.m_updateRate = std::stoul(optarg);
+                break;
+
+            case 'w':
+                options.m_warmup = TimeS{ std::stol(optarg) };
+                break;
+
+            case 't':
+                options.m_duration = TimeS{ std::max(std::stol(optarg), 1l) };
+                break;
+
+            case 'B':
+            {
+                auto backend{ ParseBackendType(optarg) };
+                if (not backend)
+                {
+                    usage();
+                    std::exit(1);
+                }
+                options.m_backend = *backend;
+                break;
+            }
+
+            case 'f':
+                options.m_logFile = optarg;
+                break;
+
+            case '?':
+            default:
+                usage();
+                std::exit(1);
+                break;
+        }
+    }
+
+    return options;
+}
+
+class TimerScale;
+
+class BenchTimer final : public TimerHandler
+{
+public:
+    BenchTimer(TimerScale& scale, const TimeNS& period) :
+        TimerHandler{ "bench-timer", period },
+        m_scale{ scale },
+        m_period{ period }
+    {
+    }
+
+    const TimeNS& Period() const noexcept { return m_period; }
+
+    /// The kernel restarts the period from when the update lands, so the next expiry sets a new schedule
+    void ChangePeriod(const TimeNS& period)
+    {
+        m_period = period;
+        m_anchored = false;
+        UpdateInterval(period);
+    }
+
+private:
+    void OnTimerExpired() override;
+
+    TimerScale& m_scale;
+    TimeNS m_period;
+    Clock::time_point m_due{};
+    bool m_anchored{ false };
+};
+
+/// One timer count. A 1ms driver timer ends the warmup and the measurement and spreads the updates
+class TimerScale
+{
+public:
+    TimerScale(const Options& options, size_t count) :
+        m_options{ options },
+        m_baselineRss{ Bench::ResidentBytes() },
+        m_driver{ "timer-bench-driver", 1ms, [this] { OnTick(); } }
+    {
+        m_timers.reserve(count);
+        for (size_t i{ 0 }; i < count; i++)
+        {
+            m_timers.push_back(std::make_unique<BenchTimer>(*this, options.m_periods[i % options.m_periods.size()]));
+        }
+    }
+
+    void OnExpiry() noexcept
+    {
+        if (m_measuring)
+        {
+            m_expiries++;
+        }
+    }
+
+    void OnExpiry(TimeNS lateness) noexcept
+    {
+        if (m_measuring)
+        {
+            m_expiries++;
+            m_lateness.Record(lateness);
+        }
+    }
+
+    void PrintJson() const
+    {
+        // zero when stopped by a signal before the measurement was over
+        const double seconds{
+            m_end == Clock::time_point{} ? 0 : std::chrono::duration<double>(m_end - m_start).count()
+        };
+        const double expiries{ static_cast<double>(std::max(m_expiries, uint64_t{ 1 })) };
+        const double rssPerTimer{ static_cast<double>(m_endRss - std::min(m_endRss, m_baselineRss)) /
+                                  static_cast<double>(m_timers.size()) };
+
+        std::print(
+            "{{ \"backend\": \"{}\", \"timers\": {}, \"seconds\": {:.3f}, \"expiries\": {}, "
+            "\"expiries_per_sec\": {:.0f}, "
+            "\"lateness_ns\": {{ \"mean\": {:.0f}, \"p50\": {}, \"p99\": {}, \"p999\": {}, \"max\": {} }}, "
+            "\"cpu_ns_per_expiry\": {:.0f}, \"rss_bytes_per_timer\": {:.0f}, \"updates\": {}, "
+            "\"update_call_ns\": {:.0f} }}",
+            GetBackendTypeName(Proactor::Instance().Backend()),
+            m_timers.size(),
+            seconds,
+            m_expiries,
+            seconds > 0 ? static_cast<double>(m_expiries) / seconds : 0,
+            m_lateness.Mean(),
+            m_lateness.Percentile(50),
+            m_lateness.Percentile(99),
+            m_lateness.Percentile(99.9),
+            m_lateness.Max(),
+            seconds > 0 ? (m_cpuEnd - m_cpuStart) * 1e9 / expiries : 0,
+            rssPerTimer,
+            m_updates,
+            m_updates == 0 ? 0 : static_cast<double>(m_updateTime.count()) / static_cast<double>(m_updates)
+        );
+
+        std::println(
+            std::cerr,
+            "{:>8} timers {:>10.0f} expiries/s lateness p50 {}us p99 {}us max {}us cpu/expiry {:.0f}ns "
+            "rss/timer {:.0f}B",
+            m_timers.size(),
+            seconds > 0 ? static_cast<double>(m_expiries) / seconds : 0,
+            m_lateness.Percentile(50) / 1000,
+            m_lateness.Percentile(99) / 1000,
+            m_lateness.Max() / 1000,
+            seconds > 0 ? (m_cpuEnd - m_cpuStart) * 1e9 / expiries : 0,
+            rssPerTimer
+        );
+    }
+
+private:
+    void OnTick()
+    {
+        const Clock::time_point now{ Clock::now() };
+        if (m_phaseEnd == Clock::time_point{})
+        {
+            m_phaseEnd = now + m_options.m_warmup;
+            m_lastTick = now;
+            return;
+        }
+
+        // checked against the clock rather than a timer of its own. a loop that has fallen behind would only
+        // get to that timer's expiry after everything queued before it
+        if (now >= m_phaseEnd)
+        {
+            if (m_measuring)
+            {
+                m_end = now;
+                m_cpuEnd = Bench::CpuSeconds();
+                // by now most timers have expired at least once and have their profiling entry too
+                m_endRss = Bench::ResidentBytes();
+                m_measuring = false;
+                Proactor::Instance().Stop();
+                return;
+            }
+
+            m_measuring = true;
+            m_start = now;
+            m_phaseEnd = now + m_options.m_duration;
+            m_cpuStart = Bench::CpuSeconds();
+        }
+
+        UpdateSome(now);
+        m_lastTick = now;
+    }
+
+    /// Moves timers picked at random to another period, at the configured rate
+    void UpdateSome(Clock::time_point now)
+    {
+        const auto rate{ static_cast<double>(m_options.m_updateRate) };
+        m_updateCredit += rate * std::chrono::duration<double>(now - m_lastTick).count();
+        // a loop that can't keep up makes fewer updates rather than catching up in a burst
+        m_updateCredit = std::min(m_updateCredit, std::max(rate / 100, 1.0));
+
+        while (m_updateCredit >= 1)
+        {
+            m_updateCredit -= 1;
+
+            BenchTimer& timer{ *m_timers[m_random() % m_timers.size()] };
+            const auto& periods{ m_options.m_periods };
+            const size_t current{ static_cast<size_t>(
+                std::ranges::find(periods, timer.Period()) - periods.begin()
+            ) };
+            TimeNS period{ periods[(current + 1) % periods.size()] };
+            // an unchanged period is skipped altogether. with a single period alternate with one 1ms longer
+            if (period == timer.Period())
+            {
+                period += 1ms;
+            }
+
+            const Clock::time_point start{ Clock::now() };
+            timer.ChangePeriod(period);
+            if (m_measuring)
+            {
+                m_updateTime += Clock::now() - start;
+                m_updates++;
+            }
+        }
+    }
+
+    const Options& m_options;
+    const size_t m_baselineRss;
+    std::vector<std::unique_ptr<BenchTimer>> m_timers;
+    Bench::CallbackTimer m_driver;
+    Bench::LatencyRecorder m_lateness;
+    std::minstd_rand m_random{ 42 };
+    bool m_measuring{ false };
+    uint64_t m_expiries{ 0 };
+    uint64_t m_updates{ 0 };
+    TimeNS m_updateTime{ 0 };
+    double m_updateCredit{ 0 };
+    double m_cpuStart{ 0 };
+    double m_cpuEnd{ 0 };
+    size_t m_endRss{ 0 };
+    Clock::time_point m_phaseEnd{};
+    Clock::time_point m_lastTick{};
+    Clock::time_point m_start{};
+    Clock::time_point m_end{};
+};
+
+void BenchTimer::OnTimerExpired()
+{
+    const Clock::time_point now{ Clock::now() };
+    if (not m_anchored)
+    {
+        // the first expiry also carries the time the timer waited to be submitted
+        m_anchored = true;
+        m_due = now + m_period;
+        m_scale.OnExpiry();
+        return;
+    }
+
+    // expiries the loop was too slow for queue up, each one period after the other
+    const TimeNS lateness{ now - m_due };
+    m_due += m_period;
+    m_scale.OnExpiry(lateness);
+}
+
+/// Runs in a child process, which exits without tearing the timers down. every removal looks the timer's
+/// expiry up among all the pending events, which would take far longer than the measurement itself
+[[noreturn]] void RunScale(const Options& options, size_t count)
+{
+    Logger::SetupLogger(options.m_logFile, Logger::Level::Warning);
+    Proactor::Create(options.m_backend);
+
+    TimerScale scale{ options, count };
+    Proactor::Instance().Run();
+    scale.PrintJson();
+
+    // the proactor isn't destroyed, its metrics would otherwise stay behind in /dev/shm
+    Proactor::Instance().UnpublishMetrics();
+
+    std::fflush(stdout);
+    std::fflush(stderr);
+    ::_exit(0);
+}
+
+} // namespace
+
+} // namespace Sage
+
+int main(int argc, char* const argv[])
+{
+    using namespace Sage;
+
+    const Options options{ GetOptions(argc, argv) };
+
+    std::vector<size_t> counts;
+    for (size_t count{ 1 }; count <= options.m_maxTimers; count *= 10)
+    {
+        counts.push_back(count);
+    }
+    if (counts.back() != options.m_maxTimers)
+    {
+        counts.push_back(options.m_maxTimers);
+    }
+
+    std::print("{{\n  \"benchmarks\": [");
+    std::string_view separator{ "" };
+    int res{ 0 };
+
+    for (size_t count : counts)
+    {
+        std::print("{}\n    ", separator);
+        separator = ",";
+        // the child would otherwise write out whatever is still buffered here too
+        std::fflush(stdout);
+
+        const pid_t pid{ ::fork() };
+        if (pid == -1)
+        {
+            int err{ errno };
+            std::println(std::cerr, "unable to fork for {} timers. {}", count, strerror(err));
+            return 1;
+        }
+
+        if (pid == 0)
+        {
+            RunScale(options, count);
+        }
+
+        int status{ 0 };
+        ::waitpid(pid, &status, 0);
+        if (not WIFEXITED(status) or WEXITSTATUS(status) != 0)
+        {
+            std::println(std::cerr, "run with {} timers failed", count);
+            std::print("{{ \"timers\": {}, \"failed\": true }}", count);
+            res = 1;
+        }
+    }
+
+    std::println("\n  ]\n}}");
+    return res;
+}
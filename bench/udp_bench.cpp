@@ -0,0 +1,352 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <getopt.h>
+#include <iostream>
+#include <print>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "bench_utils.hpp"
+#include "log/logger.hpp"
+#include "proactor/proactor.hpp"
+#include "proactor/udp_socket.hpp"
+#include "timing/time.hpp"
+
+/**
+ * Loopback UDP packet rate benchmark. A sender keeps a window of fixed size datagrams in flight to a receiver in
+ * the same loop, sending another for every one received, so replies to a GRO coalesced receive go out as one GSO
+ * batch. Packets per second are printed to stdout as JSON. build with -DCMAKE_BUILD_TYPE=Release
+ */
+
+namespace Sage
+{
+
+namespace
+{
+
+struct BenchOptions
+{
+    size_t m_datagramSize{ 64 };
+    // datagrams in flight
+    size_t m_window{ 256 };
+    TimeS m_warmup{ 1 };
+    TimeS m_duration{ 5 };
+    bool m_gro{ true };
+    bool m_gso{ true };
+    BackendType m_backend{ BackendType::IOURing };
+    std::string m_logFile{ "/dev/null" };
+};
+
+BenchOptions GetOptions(int argc, char* const argv[])
+{
+    constexpr std::array argOptions{
+        option{ "help",     no_argument,       nullptr, 'h' },
+        option{ "size",     required_argument, nullptr, 's' },
+        option{ "window",   required_argument, nullptr, 'n' },
+        option{ "warmup",   required_argument, nullptr, 'w' },
+        option{ "duration", required_argument, nullptr, 't' },
+        option{ "no-gro",   no_argument,       nullptr, 'G' },
+        option{ "no-gso",   no_argument,       nullptr, 'S' },
+        option{ "backend",  required_argument, nullptr, 'B' },
+        option{ "file",     required_argument, nullptr, 'f' },
+        option{ 0,          0,                 0,       0   }
+    };
+
+    auto usage = [&argv]
+    {
+        std::println(
+            std::cerr,
+            "Usage: {}"
+            "\n\t[optional] --size|-s <datagram bytes> (default 64)"
+            "\n\t[optional] --window|-n <datagrams in flight> (default 256)"
+            "\n\t[optional] --warmup|-w <seconds> (default 1)"
+            "\n\t[optional] --duration|-t <seconds> (default 5)"
+            "\n\t[optional] --no-gro|-G receive every datagram on its own"
+            "\n\t[optional] --no-gso|-S send every datagram on its own"
+            "\n\t[optional] --backend|-B <io_uring|epoll> (default io_uring)"
+            "\n\t[optional] --file|-f <log filename> (default /dev/null)"
+            "\n\t[optional] --help|-h",
+            argv[0]
+        );
+    };
+
+    BenchOptions options;
+    int option;
+    int optIndex;
+    while ((option = getopt_long(argc, argv, "hs:n:w:t:GSB:f:", argOptions.data(), &optIndex)) != -1)
+    {
+        switch (option)
+        {
+            case 'h':
+                usage();
+                std::exit(0);
+                break;
+
+            case 's':
+                // fits a 64KB receive buffer, GRO coalesced or not
+                options.m_datagramSize = std::clamp(std::stoul(optarg), 1ul, 60'000ul);
+                break;
+
+            case 'n':
+                options.m_window = std::max(std::stoul(optarg), 1ul);
+                break;
+
+            case 'w':
+                options.m_warmup = TimeS{ std::stol(optarg) };
+                break;
+
+            case 't':
+                options.m_duration = TimeS{ std::max(std::stol(optarg), 1l) };
+                break;
+
+            case 'G':
+                options.m_gro = false;
+                break;
+
+            case 'S':
+                options.m_gso = false;
+                break;
+
+            case 'B':
+            {
+                auto backend{ ParseBackendType(optarg) };
+                if (not backend)
+                {
+                    usage();
+                    std::exit(1);
+                }
+                options.m_backend = *backend;
+                break;
+            }
+
+            case 'f':
+                options.m_logFile = optarg;
+                break;
+
+            case '?':
+            default:
+                usage();
+                std::exit(1);
+                break;
+        }
+    }
+
+    return options;
+}
+
+class UdpLoop;
+
+class Receiver final : public UdpSocket
+{
+public:
+    Receiver(UdpLoop& loop, const BenchOptions& options);
+
+private:
+    void OnDatagram(std::span<const uint8_t> datagram, const sockaddr_in& from) override;
+
+    UdpLoop& m_loop;
+};
+
+class Sender final : public UdpSocket
+{
+public:
+    Sender(const BenchOptions& options, uint16_t port) :
+        UdpSocket{
+            "udp-bench-sender",
+            UdpSocket::Options{
+                .m_bindHost = "127.0.0.1",
+                .m_peerHost = "127.0.0.1",
+                .m_peerPort = port,
+                .m_gso = options.m_gso,
+                // nothing is sent back to it
+                .m_rxBufferSize = 1024,
+                .m_rxBufferCount = 1,
+            },
+        }
+    {
+    }
+
+private:
+    void OnDatagram(std::span<const uint8_t>, const sockaddr_in&) override {}
+};
+
+/// A 1ms driver timer ends the warmup and the measurement, and refills a window lost to drops
+class UdpLoop
+{
+public:
+    explicit UdpLoop(const BenchOptions& options) :
+        m_options{ options },
+        m_payload(options.m_datagramSize, uint8_t{ 'x' }),
+        m_receiver{ *this, options },
+        m_sender{ options, m_receiver.LocalPort() },
+        m_driver{ "udp-bench-driver", 1ms, [this] { OnTick(); } }
+    {
+    }
+
+    void OnReceived() noexcept
+    {
+        m_inFlight -= std::min(m_inFlight, size_t{ 1 });
+        m_receivedSinceTick = true;
+        if (m_measuring)
+        {
+            m_received++;
+        }
+        Refill();
+    }
+
+    void PrintJson() const
+    {
+        // zero when stopped by a signal before the measurement was over
+        const double seconds{
+            m_end == Clock::time_point{} ? 0 : std::chrono::duration<double>(m_end - m_start).count()
+        };
+        const double packetsPerSec{ seconds > 0 ? static_cast<double>(m_received) / seconds : 0 };
+
+        std::println(
+            "{{ \"backend\": \"{}\", \"datagram_bytes\": {}, \"window\": {}, \"gro\": {}, \"gso\": {}, "
+            "\"seconds\": {:.3f}, \"sent\": {}, \"received\": {}, \"packets_per_sec\": {:.0f}, "
+            "\"mbit_per_sec\": {:.1f}, \"cpu_ns_per_packet\": {:.0f}, \"window_refills\": {} }}",
+            GetBackendTypeName(Proactor::Instance().Backend()),
+            m_options.m_datagramSize,
+            m_options.m_window,
+            m_options.m_gro,
+            m_options.m_gso,
+            seconds,
+            m_sent,
+            m_received,
+            packetsPerSec,
+            packetsPerSec * static_cast<double>(m_options.m_datagramSize) * 8 / 1e6,
+            m_received == 0 ? 0 : (m_cpuEnd - m_cpuStart) * 1e9 / static_cast<double>(m_received),
+            m_refills
+        );
+
+        std::println(
+            std::cerr,
+            "{:.0f} packets/s {:.1f} Mbit/s sent({}) received({}) refills({})",
+            packetsPerSec,
+            packetsPerSec * static_cast<double>(m_options.m_datagramSize) * 8 / 1e6,
+            m_sent,
+            m_received,
+            m_refills
+        );
+    }
+
+private:
+    void Refill()
+    {
+        while (m_inFlight < m_options.m_window)
+        {
+            m_sender.Send(m_payload);
+            m_inFlight++;
+            if (m_measuring)
+            {
+                m_sent++;
+            }
+        }
+    }
+
+    void OnTick()
+    {
+        const Clock::time_point now{ Clock::now() };
+        if (m_phaseEnd == Clock::time_point{})
+        {
+            m_phaseEnd = now + m_options.m_warmup;
+            Refill();
+            return;
+        }
+
+        // a whole tick without a datagram back means the kernel dropped the window
+        if (not m_receivedSinceTick)
+        {
+            m_inFlight = 0;
+            m_refills++;
+            Refill();
+        }
+        m_receivedSinceTick = false;
+
+        if (now < m_phaseEnd)
+        {
+            return;
+        }
+
+        if (m_measuring)
+        {
+            m_end = now;
+            m_cpuEnd = Bench::CpuSeconds();
+            m_measuring = false;
+            Proactor::Instance().Stop();
+            return;
+        }
+
+        m_measuring = true;
+        m_start = now;
+        m_phaseEnd = now + m_options.m_duration;
+        m_cpuStart = Bench::CpuSeconds();
+    }
+
+    const BenchOptions& m_options;
+    const std::vector<uint8_t> m_payload;
+    Receiver m_receiver;
+    Sender m_sender;
+    Bench::CallbackTimer m_driver;
+    size_t m_inFlight{ 0 };
+    bool m_receivedSinceTick{ false };
+    bool m_measuring{ false };
+    uint64_t m_sent{ 0 };
+    uint64_t m_received{ 0 };
+    uint64_t m_refills{ 0 };
+    double m_cpuStart{ 0 };
+    double m_cpuEnd{ 0 };
+    Clock::time_point m_phaseEnd{};
+    Clock::time_point m_start{};
+    Clock::time_point m_end{};
+};
+
+Receiver::Receiver(UdpLoop& loop, const BenchOptions& options) :
+    UdpSocket{
+        "udp-bench-receiver",
+        UdpSocket::Options{
+            .m_bindHost = "127.0.0.1",
+            .m_gro = options.m_gro,
+        },
+    },
+    m_loop{ loop }
+{
+}
+
+void Receiver::OnDatagram(std::span<const uint8_t>, const sockaddr_in&) { m_loop.OnReceived(); }
+
+} // namespace
+
+} // namespace Sage
+
+int main(int argc, char* const argv[])
+{
+    using namespace Sage;
+
+    const BenchOptions options{ GetOptions(argc, argv) };
+
+    Logger::SetupLogger(options.m_logFile, Logger::Level::Info);
+    Proactor::Create(options.m_backend);
+    {
+        std::println(
+            std::cerr,
+            "keeping {} {}B datagrams in flight over loopback. gro({}) gso({}). warming up for {}s",
+            options.m_window,
+            options.m_datagramSize,
+            options.m_gro,
+            options.m_gso,
+            options.m_warmup.count()
+        );
+
+        UdpLoop loop{ options };
+        Proactor::Instance().Run();
+        loop.PrintJson();
+    }
+    Proactor::Destroy();
+    Logger::ShutdownLogger();
+
+    return 0;
+}
@@ -0,0 +1,514 @@
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <format>
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "bench_utils.hpp"
+#include "echo_server.hpp"
+#include "log/logger.hpp"
+#include "proactor/proactor.hpp"
+#include "proactor/tcp_client.hpp"
+#include "proactor/unix_socket.hpp"
+#include "timing/time.hpp"
+
+/**
+ * Unix domain sockets against loopback TCP. One connection per transport keeps a pipeline of fixed size messages
+ * in flight to a forked echo server, tcp then unix, each warmed up and measured in turn by the same loop. Round
+ * trip percentiles and throughput per transport are printed to stdout as JSON. Small messages one at a time show
+ * the latency difference, large ones with a deeper pipeline the throughput. build with -DCMAKE_BUILD_TYPE=Release
+ */
+
+namespace Sage
+{
+
+namespace
+{
+
+enum class Transport : uint8_t
+{
+    Tcp = 0,
+    Unix,
+};
+
+std::string_view TransportName(Transport transport) noexcept { return transport == Transport::Tcp ? "tcp" : "unix"; }
+
+struct BenchOptions
+{
+    size_t m_messageSize{ 64 };
+    // messages in flight
+    size_t m_depth{ 1 };
+    TimeS m_warmup{ 1 };
+    TimeS m_duration{ 5 };
+    std::vector<Transport> m_transports{ Transport::Tcp, Transport::Unix };
+    BackendType m_backend{ BackendType::IOURing };
+    std::string m_logFile{ "/dev/null" };
+};
+
+BenchOptions GetOptions(int argc, char* const argv[])
+{
+    constexpr std::array argOptions{
+        option{ "help",      no_argument,       nullptr, 'h' },
+        option{ "size",      required_argument, nullptr, 's' },
+        option{ "depth",     required_argument, nullptr, 'd' },
+        option{ "warmup",    required_argument, nullptr, 'w' },
+        option{ "duration",  required_argument, nullptr, 't' },
+        option{ "transport", required_argument, nullptr, 'T' },
+        option{ "backend",   required_argument, nullptr, 'B' },
+        option{ "file",      required_argument, nullptr, 'f' },
+        option{ 0,           0,                 0,       0   }
+    };
+
+    auto usage = [&argv]
+    {
+        std::println(
+            std::cerr,
+            "Usage: {}"
+            "\n\t[optional] --size|-s <message bytes> (default 64)"
+            "\n\t[optional] --depth|-d <messages in flight> (default 1)"
+            "\n\t[optional] --warmup|-w <seconds per transport> (default 1)"
+            "\n\t[optional] --duration|-t <seconds per transport> (default 5)"
+            "\n\t[optional] --transport|-T <tcp|unix|both> (default both)"
+            "\n\t[optional] --backend|-B <io_uring|epoll> (default io_uring)"
+            "\n\t[optional] --file|-f <log filename> (default /dev/null)"
+            "\n\t[optional] --help|-h",
+            argv[0]
+        );
+    };
+
+    BenchOptions options;
+    int option;
+    int optIndex;
+    while ((option = getopt_long(argc, argv, "hs:d:w:t:T:B:f:", argOptions.data(), &optIndex)) != -1)
+    {
+        switch (option)
+        {
+            case 'h':
+                usage();
+                std::exit(0);
+                break;
+
+            case 's':
+                options.m_messageSize = std::max(std::stoul(optarg), 1ul);
+                break;
+
+            case 'd':
+                options.m_depth = std::max(std::stoul(optarg), 1ul);
+                break;
+
+            case 'w':
+                options.m_warmup = TimeS{ std::stol(optarg) };
+                break;
+
+            case 't':
+                options.m_duration = TimeS{ std::max(std::stol(optarg), 1l) };
+                break;
+
+            case 'T':
+            {
+                const std::string_view transport{ optarg };
+                if (transport == "tcp")
+                {
+                    options.m_transports = { Transport::Tcp };
+                }
+                else if (transport == "unix")
+                {
+                    options.m_transports = { Transport::Unix };
+                }
+                else if (transport != "both")
+                {
+                    usage();
+                    std::exit(1);
+                }
+                break;
+            }
+
+            case 'B':
+            {
+                auto backend{ ParseBackendType(optarg) };
+                if (not backend)
+                {
+                    usage();
+                    std::exit(1);
+                }
+                options.m_backend = *backend;
+                break;
+            }
+
+            case 'f':
+                options.m_logFile = optarg;
+                break;
+
+            case '?':
+            default:
+                usage();
+                std::exit(1);
+                break;
+        }
+    }
+
+    return options;
+}
+
+/// @returns a non blocking unix stream socket listening on path, or -1
+int ListenOnPath(const std::string& path)
+{
+    sockaddr_un address{};
+    socklen_t addressLen{ 0 };
+    const int listenFd{ ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0) };
+    if (listenFd == -1 or not MakeUnixAddress(path, address, addressLen) or
+        ::bind(listenFd, reinterpret_cast<const sockaddr*>(&address), addressLen) != 0 or
+        ::listen(listenFd, SOMAXCONN) != 0)
+    {
+        int err{ errno };
+        std::println(std::cerr, "unable to listen on {}. {}", path, strerror(err));
+        if (listenFd != -1)
+        {
+            ::close(listenFd);
+        }
+        return -1;
+    }
+
+    return listenFd;
+}
+
+/// @returns the echo server's pid, or -1
+pid_t ForkEchoServer(int listenFd)
+{
+    const pid_t serverPid{ ::fork() };
+    if (serverPid == -1)
+    {
+        int err{ errno };
+        std::println(std::cerr, "unable to fork the echo server. {}", strerror(err));
+        return -1;
+    }
+
+    if (serverPid == 0)
+    {
+        Bench::RunEchoServer(listenFd);
+    }
+    ::close(listenFd);
+
+    return serverPid;
+}
+
+class Comparison;
+
+/// Keeps the pipeline full on one connection. Echoes arrive in order, so every full message completes the
+/// oldest send
+class Pinger
+{
+public:
+    Pinger(Comparison& comparison, const BenchOptions& options) :
+        m_comparison{ comparison },
+        m_payload(options.m_messageSize, 'x'),
+        m_sentAt(options.m_depth)
+    {
+    }
+
+    virtual ~Pinger() = default;
+
+protected:
+    virtual void Transmit(const std::string& payload) = 0;
+
+    void Fill()
+    {
+        while (m_inFlight < m_sentAt.size())
+        {
+            m_sentAt[(m_oldest + m_inFlight) % m_sentAt.size()] = Clock::now();
+            m_inFlight++;
+            Transmit(m_payload);
+        }
+    }
+
+    void OnBytes(size_t bytes);
+
+private:
+    Comparison& m_comparison;
+    const std::string m_payload;
+    // send times of the messages in flight, oldest first from m_oldest
+    std::vector<Clock::time_point> m_sentAt;
+    size_t m_oldest{ 0 };
+    size_t m_inFlight{ 0 };
+    size_t m_rxBytes{ 0 };
+};
+
+class TcpPinger final : public TcpClient, public Pinger
+{
+public:
+    TcpPinger(Comparison& comparison, const BenchOptions& options, uint16_t port) :
+        TcpClient{ "127.0.0.1", std::to_string(port) },
+        Pinger{ comparison, options }
+    {
+    }
+
+private:
+    // copied, as the unix send does
+    void Transmit(const std::string& payload) override { Proactor::Instance().RequestTcpSend(*this, payload); }
+
+    void OnConnect() override { Fill(); }
+
+    void OnReceive(std::span<uint8_t> buff) override { OnBytes(buff.size()); }
+
+    /// The connection is made once up front. skips the base client's periodic chatter and health checks
+    void OnTimerExpired() override { UpdateInterval(24h); }
+};
+
+class UnixPinger final : public UnixSocket, public Pinger
+{
+public:
+    UnixPinger(Comparison& comparison, const BenchOptions& options, const std::string& path) :
+        UnixSocket{ "unix-bench-client", path },
+        Pinger{ comparison, options }
+    {
+    }
+
+private:
+    void Transmit(const std::string& payload) override
+    {
+        Send(std::span{ reinterpret_cast<const uint8_t*>(payload.data()), payload.size() });
+    }
+
+    void OnConnect() override { Fill(); }
+
+    void OnReceive(std::span<const uint8_t> data, std::span<const int>) override { OnBytes(data.size()); }
+
+    void OnClose(int res) override
+    {
+        std::println(std::cerr, "unix connection closed. {}", res == 0 ? "hung up" : strerror(-res));
+    }
+};
+
+/// Runs each transport in turn. A phase timer ends each warmup and measurement
+class Comparison
+{
+public:
+    Comparison(const BenchOptions& options, uint16_t port, std::string path) :
+        m_options{ options },
+        m_port{ port },
+        m_path{ std::move(path) },
+        m_phaseTimer{ "unix-bench-phase", options.m_warmup.count() > 0 ? TimeNS{ options.m_warmup } : TimeNS{ 1ms },
+                      [this] { OnPhaseEnd(); } }
+    {
+        StartTransport();
+    }
+
+    void OnEcho(TimeNS rtt)
+    {
+        if (m_measuring)
+        {
+            m_rtt.Record(rtt);
+        }
+    }
+
+    void PrintJson() const
+    {
+        std::string transports;
+        for (const Result& result : m_results)
+        {
+            const double messages{ static_cast<double>(result.m_messages) };
+            transports += std::format(
+                "{}\n    {{ \"transport\": \"{}\", \"seconds\": {:.3f}, \"messages\": {}, "
+                "\"messages_per_sec\": {:.0f}, \"mb_per_sec\": {:.2f}, \"cpu_ns_per_message\": {:.0f}, "
+                "\"rtt_ns\": {{ \"mean\": {:.0f}, \"p50\": {}, \"p99\": {}, \"p999\": {}, \"max\": {} }} }}",
+                transports.empty() ? "" : ",",
+                TransportName(result.m_transport),
+                result.m_seconds,
+                result.m_messages,
+                result.m_seconds > 0 ? messages / result.m_seconds : 0,
+                result.m_seconds > 0 ? messages * static_cast<double>(m_options.m_messageSize) / result.m_seconds / 1e6
+                                     : 0,
+                result.m_messages == 0 ? 0 : result.m_cpuSeconds * 1e9 / messages,
+                result.m_rttMean,
+                result.m_rttP50,
+                result.m_rttP99,
+                result.m_rttP999,
+                result.m_rttMax
+            );
+
+            std::println(
+                std::cerr,
+                "{:>4}: {:.0f} messages/s rtt p50({}ns) p99({}ns)",
+                TransportName(result.m_transport),
+                result.m_seconds > 0 ? messages / result.m_seconds : 0,
+                result.m_rttP50,
+                result.m_rttP99
+            );
+        }
+
+        std::println(
+            "{{\n  \"backend\": \"{}\",\n  \"message_size\": {},\n  \"depth\": {},\n  \"transports\": [{}\n  ]\n}}",
+            GetBackendTypeName(Proactor::Instance().Backend()),
+            m_options.m_messageSize,
+            m_options.m_depth,
+            transports
+        );
+    }
+
+private:
+    struct Result
+    {
+        Transport m_transport;
+        double m_seconds;
+        uint64_t m_messages;
+        double m_cpuSeconds;
+        double m_rttMean;
+        uint64_t m_rttP50;
+        uint64_t m_rttP99;
+        uint64_t m_rttP999;
+        uint64_t m_rttMax;
+    };
+
+    void StartTransport()
+    {
+        const Transport transport{ m_options.m_transports[m_next] };
+        std::println(std::cerr, "{}: warming up for {}s", TransportName(transport), m_options.m_warmup.count());
+        if (transport == Transport::Tcp)
+        {
+            m_pinger = std::make_unique<TcpPinger>(*this, m_options, m_port);
+        }
+        else
+        {
+            m_pinger = std::make_unique<UnixPinger>(*this, m_options, m_path);
+        }
+    }
+
+    /// Expiries alternate between ending a transport's warmup and ending its measurement
+    void OnPhaseEnd()
+    {
+        const Clock::time_point now{ Clock::now() };
+        if (not m_measuring)
+        {
+            m_rtt.Reset();
+            m_measuring = true;
+            m_start = now;
+            m_cpuStart = Bench::CpuSeconds();
+            m_phaseTimer.UpdateInterval(m_options.m_duration);
+            return;
+        }
+
+        m_measuring = false;
+        m_results.push_back(Result{
+            .m_transport = m_options.m_transports[m_next],
+            .m_seconds = std::chrono::duration<double>(now - m_start).count(),
+            .m_messages = m_rtt.Count(),
+            .m_cpuSeconds = Bench::CpuSeconds() - m_cpuStart,
+            .m_rttMean = m_rtt.Mean(),
+            .m_rttP50 = m_rtt.Percentile(50),
+            .m_rttP99 = m_rtt.Percentile(99),
+            .m_rttP999 = m_rtt.Percentile(99.9),
+            .m_rttMax = m_rtt.Max(),
+        });
+
+        // the server echoes what's still in flight into a closed connection
+        m_pinger.reset();
+        if (++m_next == m_options.m_transports.size())
+        {
+            Proactor::Instance().Stop();
+            return;
+        }
+
+        m_phaseTimer.UpdateInterval(m_options.m_warmup.count() > 0 ? TimeNS{ m_options.m_warmup } : TimeNS{ 1ms });
+        StartTransport();
+    }
+
+    const BenchOptions& m_options;
+    const uint16_t m_port;
+    const std::string m_path;
+    Bench::CallbackTimer m_phaseTimer;
+    std::unique_ptr<Pinger> m_pinger;
+    size_t m_next{ 0 };
+    Bench::LatencyRecorder m_rtt;
+    bool m_measuring{ false };
+    Clock::time_point m_start{};
+    double m_cpuStart{ 0 };
+    std::vector<Result> m_results;
+};
+
+void Pinger::OnBytes(size_t bytes)
+{
+    const Clock::time_point now{ Clock::now() };
+    m_rxBytes += bytes;
+
+    while (m_rxBytes >= m_payload.size() and m_inFlight > 0)
+    {
+        const Clock::time_point sentAt{ m_sentAt[m_oldest] };
+        m_oldest = (m_oldest + 1) % m_sentAt.size();
+        m_inFlight--;
+        m_rxBytes -= m_payload.size();
+        m_comparison.OnEcho(now - sentAt);
+    }
+
+    Fill();
+}
+
+} // namespace
+
+} // namespace Sage
+
+int main(int argc, char* const argv[])
+{
+    using namespace Sage;
+
+    const BenchOptions options{ GetOptions(argc, argv) };
+
+    uint16_t port{ 0 };
+    const std::string path{ std::format("/tmp/proactor-unix-bench-{}.sock", ::getpid()) };
+    const int tcpListenFd{ Bench::ListenOnLoopback(port) };
+    const int unixListenFd{ ListenOnPath(path) };
+    if (tcpListenFd == -1 or unixListenFd == -1)
+    {
+        ::unlink(path.c_str());
+        return 1;
+    }
+
+    // forked before the logger or the ring exist, so the children inherit neither. one server per transport
+    const pid_t tcpServerPid{ ForkEchoServer(tcpListenFd) };
+    const pid_t unixServerPid{ ForkEchoServer(unixListenFd) };
+    if (tcpServerPid == -1 or unixServerPid == -1)
+    {
+        ::unlink(path.c_str());
+        return 1;
+    }
+
+    Logger::SetupLogger(options.m_logFile, Logger::Level::Info);
+    Proactor::Create(options.m_backend);
+    {
+        std::println(
+            std::cerr,
+            "{} {}B message(s) in flight to echo servers on 127.0.0.1:{} and {}",
+            options.m_depth,
+            options.m_messageSize,
+            port,
+            path
+        );
+
+        Comparison comparison{ options, port, path };
+        Proactor::Instance().Run();
+        comparison.PrintJson();
+    }
+    Proactor::Destroy();
+    Logger::ShutdownLogger();
+
+    for (pid_t serverPid : { tcpServerPid, unixServerPid })
+    {
+        ::kill(serverPid, SIGTERM);
+        ::waitpid(serverPid, nullptr, 0);
+    }
+    ::unlink(path.c_str());
+
+    return 0;
+}
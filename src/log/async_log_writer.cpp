@@ -0,0 +1,556 @@
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <new>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "log/async_log_writer.hpp"
+
+namespace Sage::Logger::Internal
+{
+
+// Single producer single consumer byte ring. Lines are committed whole so they never interleave
+class LogRing
+{
+public:
+    explicit LogRing(size_t capacity) :
+        m_capacity{ std::bit_ceil(capacity) },
+        m_mask{ m_capacity - 1 },
+        m_data{ std::make_unique<char[]>(m_capacity) }
+    {
+    }
+
+    // Producer
+
+    bool TryWrite(std::string_view line) noexcept
+    {
+        const size_t tail{ m_tail.load(std::memory_order_relaxed) };
+        const size_t head{ m_head.load(std::memory_order_acquire) };
+        if (m_capacity - (tail - head) < line.size())
+        {
+            return false;
+        }
+
+        const size_t offset{ tail & m_mask };
+        const size_t firstPart{ std::min(line.size(), m_capacity - offset) };
+        std::memcpy(m_data.get() + offset, line.data(), firstPart);
+        std::memcpy(m_data.get(), line.data() + firstPart, line.size() - firstPart);
+        m_tail.store(tail + line.size(), std::memory_order_release);
+
+        return true;
+    }
+
+    void CountDrop() noexcept { m_dropped.fetch_add(1, std::memory_order_relaxed); }
+
+    void Retire() noexcept { m_retired.store(true, std::memory_order_release); }
+
+    // Consumer
+
+    /// @returns the number of segments filled. the readable bytes may wrap around the end of the ring
+    size_t Readable(std::span<iovec, 2> segments) const noexcept
+    {
+        const size_t head{ m_head.load(std::memory_order_relaxed) };
+        const size_t used{ m_tail.load(std::memory_order_acquire) - head };
+        if (used == 0)
+        {
+            return 0;
+        }
+
+        const size_t offset{ head & m_mask };
+        const size_t firstPart{ std::min(used, m_capacity - offset) };
+        segments[0] = iovec{ .iov_base = m_data.get() + offset, .iov_len = firstPart };
+        if (firstPart == used)
+        {
+            return 1;
+        }
+
+        segments[1] = iovec{ .iov_base = m_data.get(), .iov_len = used - firstPart };
+        return 2;
+    }
+
+    void Consume(size_t bytes) noexcept
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + bytes, std::memory_order_release);
+    }
+
+    size_t Dropped() const noexcept { return m_dropped.load(std::memory_order_relaxed); }
+
+    bool Retired() const noexcept { return m_retired.load(std::memory_order_acquire); }
+
+    // Either side
+
+    size_t Used() const noexcept
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    size_t Capacity() const noexcept { return m_capacity; }
+
+    // only touched by the writer
+    size_t m_droppedReported{ 0 };
+
+private:
+    const size_t m_capacity;
+    const size_t m_mask;
+    const std::unique_ptr<char[]> m_data;
+    alignas(64) std::atomic<size_t> m_head{ 0 };
+    alignas(64) std::atomic<size_t> m_tail{ 0 };
+    std::atomic<size_t> m_dropped{ 0 };
+    std::atomic<bool> m_retired{ false };
+};
+
+namespace
+{
+
+// Hands the thread's ring back to the writer once the thread exits
+struct ThreadRingHolder
+{
+    ~ThreadRingHolder()
+    {
+        if (m_ring != nullptr)
+        {
+            m_ring->Retire();
+        }
+    }
+
+    LogRing* m_ring{ nullptr };
+    bool m_registrationFailed{ false };
+};
+
+thread_local ThreadRingHolder t_ringHolder;
+
+} // namespace
+
+AsyncLogWriter::AsyncLogWriter(int fd, const AsyncOptions& options) :
+    m_overflowPolicy{ options.m_overflowPolicy },
+    m_ringSize{ options.m_ringSize },
+    m_fd{ fd }
+{
+    // the thread inherits the mask. with every signal blocked, process directed ones like SIGTERM only reach
+    // threads that handle them, the loop thread reading them through its signalfd
+    sigset_t all;
+    sigset_t previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &previous);
+    try
+    {
+        m_thread = std::thread{ [this] { Run(); } };
+    }
+    catch (...)
+    {
+        pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+        throw;
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+
+    s_crashWriter.store(this, std::memory_order_release);
+    InstallCrashHandlers();
+}
+
+AsyncLogWriter::~AsyncLogWriter()
+{
+    Stop();
+
+    AsyncLogWriter* self{ this };
+    s_crashWriter.compare_exchange_strong(self, nullptr);
+
+    for (auto& slot : m_rings)
+    {
+        delete slot.exchange(nullptr);
+    }
+
+    if (int fd{ m_fd.load() }; fd > STDERR_FILENO)
+    {
+        ::close(fd);
+    }
+}
+
+void AsyncLogWriter::Append(std::string_view line) noexcept
+{
+    LogRing* ring{ ThreadRing() };
+    if (ring == nullptr or not m_running.load(std::memory_order_acquire)) [[unlikely]]
+    {
+        WriteDirect(line);
+        return;
+    }
+
+    if (ring->TryWrite(line)) [[likely]]
+    {
+        // wake the writer early rather than waiting for the next flush interval
+        const size_t used{ ring->Used() };
+        const size_t half{ ring->Capacity() / 2 };
+        if (used > half and used - line.size() <= half)
+        {
+            m_wakeCv.notify_one();
+        }
+        return;
+    }
+
+    if (m_overflowPolicy == OverflowPolicy::Drop)
+    {
+        ring->CountDrop();
+        m_wakeCv.notify_one();
+        return;
+    }
+
+    do
+    {
+        m_wakeCv.notify_one();
+        std::this_thread::yield();
+
+        if (not m_running.load(std::memory_order_acquire))
+        {
+            WriteDirect(line);
+            return;
+        }
+    } while (not ring->TryWrite(line));
+}
+
+void AsyncLogWriter::SetFd(int fd)
+{
+    if (int unapplied{ m_pendingFd.exchange(fd) }; unapplied > STDERR_FILENO)
+    {
+        ::close(unapplied);
+    }
+
+    if (not m_running.load(std::memory_order_acquire))
+    {
+        SwapPendingFd();
+    }
+}
+
+void AsyncLogWriter::AppendPreamble(std::string_view data)
+{
+    {
+        std::lock_guard lock{ m_preambleMutex };
+        m_preamble.append(data);
+    }
+
+    if (not m_running.load(std::memory_order_acquire))
+    {
+        WriteDirect(TakePendingPreamble());
+    }
+}
+
+void AsyncLogWriter::Stop()
+{
+    if (not m_running.exchange(false))
+    {
+        return;
+    }
+
+    m_wakeCv.notify_one();
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+
+    SwapPendingFd();
+}
+
+AsyncLogWriter::Stats AsyncLogWriter::GetStats() const noexcept
+{
+    return Stats{
+        .m_droppedLines = m_droppedLines.load(std::memory_order_relaxed),
+        .m_bytesWritten = m_bytesWritten.load(std::memory_order_relaxed),
+        .m_writes = m_writes.load(std::memory_order_relaxed),
+        .m_writeErrors = m_writeErrors.load(std::memory_order_relaxed),
+    };
+}
+
+void AsyncLogWriter::Run()
+{
+    while (m_running.load(std::memory_order_acquire))
+    {
+        if (Drain() == 0)
+        {
+            std::unique_lock lock{ m_wakeMutex };
+            m_wakeCv.wait_for(lock, s_flushInterval);
+        }
+    }
+
+    // everything appended before stopping must make it out
+    while (Drain() != 0)
+    {
+    }
+}
+
+size_t AsyncLogWriter::Drain()
+{
+    SwapPendingFd();
+
+    // slot 0 is kept for the preamble
+    std::array<iovec, s_maxThreads * 2 + 1> iovecs{};
+    std::array<std::pair<LogRing*, size_t>, s_maxThreads> queued{};
+    size_t iovecCount{ 1 };
+    size_t ringCount{ 0 };
+
+    for (auto& slot : m_rings)
+    {
+        LogRing* ring{ slot.load(std::memory_order_acquire) };
+        if (ring == nullptr)
+        {
+            continue;
+        }
+
+        ReportDrops(*ring);
+
+        const size_t segments{ ring->Readable(std::span<iovec, 2>{ iovecs.data() + iovecCount, 2 }) };
+        if (segments == 0)
+        {
+            // the owning thread has exited and everything it logged is out
+            if (ring->Retired() and ring->Used() == 0)
+            {
+                slot.store(nullptr, std::memory_order_release);
+                delete ring;
+            }
+            continue;
+        }
+
+        size_t bytes{ 0 };
+        for (size_t i{ 0 }; i < segments; i++)
+        {
+            bytes += iovecs[iovecCount + i].iov_len;
+        }
+
+        queued[ringCount++] = { ring, bytes };
+        iovecCount += segments;
+    }
+
+    // taken after the rings are read so it covers everything any queued line refers to
+    const std::string preamble{ TakePendingPreamble() };
+    iovecs[0] = iovec{ .iov_base = const_cast<char*>(preamble.data()), .iov_len = preamble.size() };
+
+    if (iovecCount == 1 and preamble.empty())
+    {
+        return 0;
+    }
+
+    // on a failed write the remainder is dropped rather than retried forever
+    WriteAll(std::span{ iovecs.data(), iovecCount });
+    size_t drained{ preamble.size() };
+    for (size_t i{ 0 }; i < ringCount; i++)
+    {
+        auto [ring, bytes]{ queued[i] };
+        ring->Consume(bytes);
+        drained += bytes;
+    }
+
+    return drained;
+}
+
+size_t AsyncLogWriter::WriteAll(std::span<iovec> iovecs) noexcept
+{
+    const int fd{ m_fd.load(std::memory_order_relaxed) };
+    size_t written{ 0 };
+
+    while (not iovecs.empty())
+    {
+        ssize_t res{ ::writev(fd, iovecs.data(), static_cast<int>(iovecs.size())) };
+        if (res < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            m_writeErrors.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+
+        m_writes.fetch_add(1, std::memory_order_relaxed);
+        written += static_cast<size_t>(res);
+
+        // partial write. skip what made it out
+        auto remaining{ static_cast<size_t>(res) };
+        while (not iovecs.empty() and remaining >= iovecs.front().iov_len)
+        {
+            remaining -= iovecs.front().iov_len;
+            iovecs = iovecs.subspan(1);
+        }
+
+        if (not iovecs.empty())
+        {
+            iovecs.front().iov_base = static_cast<char*>(iovecs.front().iov_base) + remaining;
+            iovecs.front().iov_len -= remaining;
+        }
+    }
+
+    m_bytesWritten.fetch_add(written, std::memory_order_relaxed);
+    return written;
+}
+
+void AsyncLogWriter::WriteDirect(std::string_view line) noexcept
+{
+    if (line.empty())
+    {
+        return;
+    }
+
+    std::array iovecs{ iovec{ .iov_base = const_cast<char*>(line.data()), .iov_len = line.size() } };
+    WriteAll(iovecs);
+}
+
+void AsyncLogWriter::ReportDrops(LogRing& ring) noexcept
+{
+    const size_t dropped{ ring.Dropped() };
+    if (dropped == ring.m_droppedReported)
+    {
+        return;
+    }
+
+    const size_t newlyDropped{ dropped - ring.m_droppedReported };
+    ring.m_droppedReported = dropped;
+    m_droppedLines.fetch_add(newlyDropped, std::memory_order_relaxed);
+
+    std::array<char, 128> notice{};
+    auto res{ std::format_to_n(
+        notice.data(), notice.size(), "==== async logger dropped {} line(s). ring full ====\n", newlyDropped
+    ) };
+
+    if (NoticeEncoder encoder{ m_noticeEncoder.load() }; encoder != nullptr)
+    {
+        WriteDirect(encoder({ notice.data(), res.out }));
+        return;
+    }
+
+    WriteDirect({ notice.data(), res.out });
+}
+
+void AsyncLogWriter::SwapPendingFd()
+{
+    if (int fd{ m_pendingFd.exchange(-1) }; fd != -1)
+    {
+        if (int oldFd{ m_fd.exchange(fd) }; oldFd > STDERR_FILENO)
+        {
+            ::close(oldFd);
+        }
+
+        {
+            std::lock_guard lock{ m_preambleMutex };
+            m_preambleWritten = 0;
+        }
+
+        // nothing else will write it out once the writer thread is gone
+        if (not m_running.load(std::memory_order_acquire))
+        {
+            WriteDirect(TakePendingPreamble());
+        }
+    }
+}
+
+std::string AsyncLogWriter::TakePendingPreamble()
+{
+    std::lock_guard lock{ m_preambleMutex };
+    if (m_preambleWritten == m_preamble.size())
+    {
+        return {};
+    }
+
+    std::string pending{ m_preamble.substr(m_preambleWritten) };
+    m_preambleWritten = m_preamble.size();
+    return pending;
+}
+
+LogRing* AsyncLogWriter::ThreadRing() noexcept
+{
+    if (t_ringHolder.m_ring != nullptr) [[likely]]
+    {
+        return t_ringHolder.m_ring;
+    }
+
+    if (t_ringHolder.m_registrationFailed)
+    {
+        return nullptr;
+    }
+
+    LogRing* ring{ nullptr };
+    try
+    {
+        ring = new LogRing{ m_ringSize };
+    }
+    catch (const std::bad_alloc&)
+    {
+        t_ringHolder.m_registrationFailed = true;
+        return nullptr;
+    }
+
+    for (auto& slot : m_rings)
+    {
+        LogRing* expected{ nullptr };
+        if (slot.compare_exchange_strong(expected, ring, std::memory_order_acq_rel))
+        {
+            t_ringHolder.m_ring = ring;
+            return ring;
+        }
+    }
+
+    // too many logging threads. this one logs synchronously
+    delete ring;
+    t_ringHolder.m_registrationFailed = true;
+    return nullptr;
+}
+
+void AsyncLogWriter::CrashFlush() noexcept
+{
+    const int fd{ m_fd.load(std::memory_order_relaxed) };
+
+    for (auto& slot : m_rings)
+    {
+        LogRing* ring{ slot.load(std::memory_order_acquire) };
+        if (ring == nullptr)
+        {
+            continue;
+        }
+
+        std::array<iovec, 2> segments{};
+        const size_t count{ ring->Readable(segments) };
+        size_t bytes{ 0 };
+        for (size_t i{ 0 }; i < count; i++)
+        {
+            if (::write(fd, segments[i].iov_base, segments[i].iov_len) > 0)
+            {
+                bytes += segments[i].iov_len;
+            }
+        }
+        ring->Consume(bytes);
+    }
+}
+
+void AsyncLogWriter::InstallCrashHandlers()
+{
+    static std::once_flag s_installed;
+    std::call_once(
+        s_installed,
+        []
+        {
+            struct sigaction action{};
+            action.sa_handler = OnCrashSignal;
+            // the default action is restored before the handler runs so the re-raise terminates
+            action.sa_flags = SA_RESETHAND | SA_NODEFER;
+            sigemptyset(&action.sa_mask);
+
+            for (int sig : { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT })
+            {
+                ::sigaction(sig, &action, nullptr);
+            }
+        }
+    );
+}
+
+void AsyncLogWriter::OnCrashSignal(int sig)
+{
+    if (AsyncLogWriter* writer{ s_crashWriter.load(std::memory_order_acquire) }; writer != nullptr)
+    {
+        writer->CrashFlush();
+    }
+
+    ::raise(sig);
+}
+
+} // namespace Sage::Logger::Internal
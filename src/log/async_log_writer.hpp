@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <sys/uio.h>
+#include <thread>
+
+#include "log/log_options.hpp"
+
+namespace Sage::Logger::Internal
+{
+
+class LogRing;
+
+/**
+ * Takes log writes off the logging threads.
+ * Each thread appends formatted lines to its own lock-free ring and a background thread
+ * writes out everything that's queued across all rings with a single writev.
+ */
+class AsyncLogWriter
+{
+public:
+    struct Stats
+    {
+        size_t m_droppedLines{ 0 };
+        size_t m_bytesWritten{ 0 };
+        size_t m_writes{ 0 };
+        size_t m_writeErrors{ 0 };
+    };
+
+    /// Wraps writer generated notices so they fit the output format
+    using NoticeEncoder = std::string (*)(std::string_view notice);
+
+    /// Takes ownership of fd
+    AsyncLogWriter(int fd, const AsyncOptions& options);
+
+    ~AsyncLogWriter();
+
+    void Append(std::string_view line) noexcept;
+
+    /// Takes ownership of fd. the current one is closed once everything queued before has been written
+    void SetFd(int fd);
+
+    /**
+     * Bytes every output has to start with.
+     * Written ahead of any line queued after this returns and again whenever the fd changes
+     */
+    void AppendPreamble(std::string_view data);
+
+    void SetNoticeEncoder(NoticeEncoder encoder) noexcept { m_noticeEncoder.store(encoder); }
+
+    /// Writes out everything queued and stops the writer thread. later appends are written synchronously
+    void Stop();
+
+    Stats GetStats() const noexcept;
+
+private:
+    AsyncLogWriter(const AsyncLogWriter&) = delete;
+    AsyncLogWriter(AsyncLogWriter&&) = delete;
+    AsyncLogWriter& operator=(const AsyncLogWriter&) = delete;
+    AsyncLogWriter& operator=(AsyncLogWriter&&) = delete;
+
+    void Run();
+
+    size_t Drain();
+
+    size_t WriteAll(std::span<iovec> iovecs) noexcept;
+
+    void WriteDirect(std::string_view line) noexcept;
+
+    void ReportDrops(LogRing& ring) noexcept;
+
+    void SwapPendingFd();
+
+    /// @returns the preamble bytes not yet written to the current fd
+    std::string TakePendingPreamble();
+
+    LogRing* ThreadRing() noexcept;
+
+    /// Best effort, async signal safe drain of every ring
+    void CrashFlush() noexcept;
+
+    static void InstallCrashHandlers();
+
+    static void OnCrashSignal(int sig);
+
+    static constexpr size_t s_maxThreads{ 64 };
+    static constexpr auto s_flushInterval{ std::chrono::milliseconds{ 5 } };
+
+    static inline std::atomic<AsyncLogWriter*> s_crashWriter{ nullptr };
+
+    const OverflowPolicy m_overflowPolicy;
+    const size_t m_ringSize;
+    std::atomic<int> m_fd;
+    std::atomic<int> m_pendingFd{ -1 };
+    std::atomic<bool> m_running{ true };
+    std::atomic<NoticeEncoder> m_noticeEncoder{ nullptr };
+    std::mutex m_preambleMutex;
+    std::string m_preamble;
+    size_t m_preambleWritten{ 0 };
+    std::array<std::atomic<LogRing*>, s_maxThreads> m_rings{};
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCv;
+    std::atomic<size_t> m_droppedLines{ 0 };
+    std::atomic<size_t> m_bytesWritten{ 0 };
+    std::atomic<size_t> m_writes{ 0 };
+    std::atomic<size_t> m_writeErrors{ 0 };
+    std::thread m_thread;
+};
+
+} // namespace Sage::Logger::Internal
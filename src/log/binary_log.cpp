@@ -0,0 +1,92 @@
+#include <mutex>
+#include <unistd.h>
+
+#include "log/binary_log.hpp"
+#include "log/logger.hpp"
+
+namespace Sage::Logger::Internal
+{
+
+namespace
+{
+
+std::string EncodeTextRecord(std::string_view text)
+{
+    std::array<char, s_maxRecordSize> record;
+    RecordEncoder encoder{ record, BinaryLog::RecordKind::Text, sizeof(uint32_t) };
+    encoder.PutString(text);
+
+    return std::string{ encoder.Finish() };
+}
+
+} // namespace
+
+std::span<char> GetRecordBuffer() noexcept
+{
+    thread_local std::array<char, s_maxRecordSize> t_record;
+    return t_record;
+}
+
+uint32_t RegisterLogSite(
+    AsyncLogWriter& writer,
+    LogSite& site,
+    Level level,
+    std::string_view format,
+    const std::source_location& loc,
+    bool preformatted,
+    std::span<const BinaryLog::ArgType> argTypes
+)
+{
+    static std::mutex s_registryMutex;
+    static uint32_t s_nextId{ 1 };
+
+    std::lock_guard lock{ s_registryMutex };
+
+    // another thread got here first
+    if (uint32_t id{ site.m_id.load(std::memory_order_relaxed) }; id != 0)
+    {
+        return id;
+    }
+
+    if (preformatted)
+    {
+        argTypes = {};
+    }
+
+    const uint32_t id{ s_nextId++ };
+    const size_t fixedSize{ sizeof(id) + sizeof(uint8_t) + sizeof(uint32_t) + 2 * sizeof(uint8_t) + argTypes.size() +
+                            2 * sizeof(uint32_t) };
+
+    std::array<char, s_maxRecordSize> record;
+    RecordEncoder encoder{ record, BinaryLog::RecordKind::Site, fixedSize };
+    encoder.Put(id);
+    encoder.Put(static_cast<uint8_t>(level));
+    encoder.Put(static_cast<uint32_t>(loc.line()));
+    encoder.Put(static_cast<uint8_t>(preformatted));
+    encoder.Put(static_cast<uint8_t>(argTypes.size()));
+    for (BinaryLog::ArgType type : argTypes)
+    {
+        encoder.Put(type);
+    }
+    encoder.PutString(GetFilenameStem(loc.file_name()));
+    encoder.PutString(format);
+
+    writer.AppendPreamble(encoder.Finish());
+    site.m_id.store(id, std::memory_order_release);
+
+    return id;
+}
+
+void EnableBinaryLogging(AsyncLogWriter& writer)
+{
+    std::array<char, s_maxRecordSize> record;
+    RecordEncoder encoder{ record, BinaryLog::RecordKind::Header, sizeof(BinaryLog::s_magic) + 2 * sizeof(uint32_t) };
+    encoder.Put(BinaryLog::s_magic);
+    encoder.Put(BinaryLog::s_version);
+    encoder.Put(static_cast<int32_t>(::getpid()));
+
+    writer.AppendPreamble(encoder.Finish());
+    writer.SetNoticeEncoder(EncodeTextRecord);
+}
+
+} // namespace Sage::Logger::Internal
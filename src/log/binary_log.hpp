@@ -0,0 +1,234 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <format>
+#include <source_location>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "log/async_log_writer.hpp"
+#include "log/binary_log_format.hpp"
+#include "log/log_levels.hpp"
+
+namespace Sage::Logger::Internal
+{
+
+/// One per LOG_* call site. The id is handed out the first time the site logs in binary mode
+struct LogSite
+{
+    std::atomic<uint32_t> m_id{ 0 };
+};
+
+constexpr size_t s_maxRecordSize{ 4096 };
+
+/// @returns a zero value for arguments that need formatting on the logging thread
+template<typename T>
+consteval BinaryLog::ArgType GetArgType() noexcept
+{
+    using Arg = std::decay_t<T>;
+    using enum BinaryLog::ArgType;
+
+    if constexpr (std::same_as<Arg, bool>)
+        return Bool;
+    else if constexpr (std::same_as<Arg, char>)
+        return Char;
+    else if constexpr (std::signed_integral<Arg>)
+        return Int;
+    else if constexpr (std::unsigned_integral<Arg>)
+        return UInt;
+    else if constexpr (std::same_as<Arg, float>)
+        return Float;
+    else if constexpr (std::same_as<Arg, double>)
+        return Double;
+    else if constexpr (std::same_as<Arg, void*> or std::same_as<Arg, const void*> or std::same_as<Arg, std::nullptr_t>)
+        return Pointer;
+    else if constexpr (
+        std::same_as<Arg, std::string> or std::same_as<Arg, std::string_view> or std::same_as<Arg, char*> or
+        std::same_as<Arg, const char*>
+    )
+        return String;
+    else
+        return BinaryLog::ArgType{};
+}
+
+template<typename T>
+concept BinaryEncodable = GetArgType<T>() != BinaryLog::ArgType{};
+
+template<typename T>
+consteval size_t GetArgFixedSize() noexcept
+{
+    switch (GetArgType<T>())
+    {
+        case BinaryLog::ArgType::Bool:
+        case BinaryLog::ArgType::Char:
+            return 1;
+        case BinaryLog::ArgType::Float:
+            return sizeof(float);
+        case BinaryLog::ArgType::String:
+            return sizeof(uint32_t);
+        default:
+            return sizeof(uint64_t);
+    }
+}
+
+template<typename... Args>
+constexpr std::array<BinaryLog::ArgType, sizeof...(Args)> s_siteArgTypes{ GetArgType<Args>()... };
+
+/**
+ * Writes a single record into a fixed size buffer.
+ * Strings are truncated so the fixed size fields that follow them always fit
+ */
+class RecordEncoder
+{
+public:
+    /// @param reserved bytes needed by the fixed size fields. strings count as their length prefix
+    RecordEncoder(std::span<char> buffer, BinaryLog::RecordKind kind, size_t reserved) noexcept :
+        m_begin{ buffer.data() },
+        m_cur{ m_begin + BinaryLog::s_recordHeaderSize },
+        m_end{ m_begin + buffer.size() },
+        m_reserved{ reserved }
+    {
+        m_begin[sizeof(uint32_t)] = static_cast<char>(kind);
+    }
+
+    template<typename T>
+        requires std::is_trivially_copyable_v<T>
+    void Put(const T& value) noexcept
+    {
+        std::memcpy(m_cur, &value, sizeof(T));
+        m_cur += sizeof(T);
+        m_reserved -= std::min(m_reserved, sizeof(T));
+    }
+
+    void PutString(std::string_view str) noexcept
+    {
+        m_reserved -= std::min(m_reserved, sizeof(uint32_t));
+        const auto room{ static_cast<size_t>(m_end - m_cur) - sizeof(uint32_t) - m_reserved };
+        const auto length{ static_cast<uint32_t>(std::min(str.size(), room)) };
+
+        std::memcpy(m_cur, &length, sizeof(length));
+        std::memcpy(m_cur + sizeof(length), str.data(), length);
+        m_cur += sizeof(length) + length;
+    }
+
+    template<typename T>
+    void PutArg(const T& arg) noexcept
+    {
+        using enum BinaryLog::ArgType;
+        constexpr BinaryLog::ArgType type{ GetArgType<T>() };
+
+        if constexpr (type == Bool)
+            Put(static_cast<uint8_t>(arg));
+        else if constexpr (type == Char)
+            Put(arg);
+        else if constexpr (type == Int)
+            Put(static_cast<int64_t>(arg));
+        else if constexpr (type == UInt)
+            Put(static_cast<uint64_t>(arg));
+        else if constexpr (type == Float or type == Double)
+            Put(arg);
+        else if constexpr (std::same_as<std::decay_t<T>, std::nullptr_t>)
+            Put(uint64_t{ 0 });
+        else if constexpr (type == Pointer)
+            Put(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(arg)));
+        else
+            PutString(std::string_view{ arg });
+    }
+
+    /// Renders the message on the calling thread for sites with arguments that can't be encoded
+    template<typename... Args>
+    void PutFormatted(std::format_string<Args...> fmt, Args&&... args) noexcept
+    {
+        m_reserved -= std::min(m_reserved, sizeof(uint32_t));
+        char* const text{ m_cur + sizeof(uint32_t) };
+        const auto room{ static_cast<std::ptrdiff_t>(m_end - text) - static_cast<std::ptrdiff_t>(m_reserved) };
+
+        char* const textEnd{ std::format_to_n(text, room, fmt, std::forward_like<Args>(args)...).out };
+        const auto length{ static_cast<uint32_t>(textEnd - text) };
+
+        std::memcpy(m_cur, &length, sizeof(length));
+        m_cur = textEnd;
+    }
+
+    std::string_view Finish() noexcept
+    {
+        const auto size{ static_cast<uint32_t>(m_cur - m_begin) };
+        std::memcpy(m_begin, &size, sizeof(size));
+
+        return { m_begin, m_cur };
+    }
+
+private:
+    char* const m_begin;
+    char* m_cur;
+    char* const m_end;
+    size_t m_reserved;
+};
+
+/// The calling thread's buffer line records are encoded into. One per thread whatever the call site
+std::span<char> GetRecordBuffer() noexcept;
+
+/// Queues the site record ahead of any line using it
+uint32_t RegisterLogSite(
+    AsyncLogWriter& writer,
+    LogSite& site,
+    Level level,
+    std::string_view format,
+    const std::source_location& loc,
+    bool preformatted,
+    std::span<const BinaryLog::ArgType> argTypes
+);
+
+/// Queues the header and switches writer notices over to text records
+void EnableBinaryLogging(AsyncLogWriter& writer);
+
+template<typename... Args>
+inline void LogBinary(
+    AsyncLogWriter& writer,
+    LogSite& site,
+    Level level,
+    std::format_string<Args...> fmt,
+    const std::source_location& loc,
+    Args&&... args
+)
+{
+    constexpr bool preformatted{ not(BinaryEncodable<Args> and ...) };
+    constexpr size_t fixedSize{
+        sizeof(uint32_t) + sizeof(int64_t) + (preformatted ? sizeof(uint32_t) : (GetArgFixedSize<Args>() + ... + 0))
+    };
+    static_assert(BinaryLog::s_recordHeaderSize + fixedSize < s_maxRecordSize, "too many log arguments");
+
+    timespec now{};
+    std::timespec_get(&now, TIME_UTC);
+
+    uint32_t id{ site.m_id.load(std::memory_order_acquire) };
+    if (id == 0) [[unlikely]]
+    {
+        id = RegisterLogSite(writer, site, level, fmt.get(), loc, preformatted, s_siteArgTypes<Args...>);
+    }
+
+    RecordEncoder encoder{ GetRecordBuffer(), BinaryLog::RecordKind::Line, fixedSize };
+    encoder.Put(id);
+    encoder.Put(static_cast<int64_t>(now.tv_sec) * 1'000'000'000 + now.tv_nsec);
+
+    if constexpr (preformatted)
+    {
+        encoder.PutFormatted(fmt, std::forward_like<Args>(args)...);
+    }
+    else
+    {
+        (encoder.PutArg(args), ...);
+    }
+
+    writer.Append(encoder.Finish());
+}
+
+} // namespace Sage::Logger::Internal
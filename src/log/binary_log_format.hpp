@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * On disk layout of binary logs. Shared with the log-decoder tool.
+ *
+ * Every record is: u32 size (including itself) | u8 kind | payload.
+ * Integers are native endian, strings are u32 length | bytes.
+ *
+ * Header: magic | u32 version | i32 pid
+ * Site:   u32 id | u8 level | u32 line | u8 preformatted | u8 arg count | u8 arg types... | str file | str format
+ * Line:   u32 site id | i64 unix ns | args... (a single rendered str when the site is preformatted)
+ * Text:   str text
+ */
+namespace Sage::Logger::BinaryLog
+{
+
+constexpr std::array<char, 8> s_magic{ 'S', 'A', 'G', 'E', 'B', 'L', 'O', 'G' };
+constexpr uint32_t s_version{ 1 };
+
+constexpr size_t s_recordHeaderSize{ sizeof(uint32_t) + sizeof(uint8_t) };
+
+enum class RecordKind : uint8_t
+{
+    Header = 1,
+    Site,
+    Line,
+    Text,
+};
+
+enum class ArgType : uint8_t
+{
+    // u8
+    Bool = 1,
+    // char
+    Char,
+    // i64
+    Int,
+    // u64
+    UInt,
+    // float
+    Float,
+    // double
+    Double,
+    // u64
+    Pointer,
+    // str
+    String,
+};
+
+} // namespace Sage::Logger::BinaryLog
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <source_location>
+
+#include "log/binary_log.hpp"
+#include "log/log_levels.hpp"
+#include "timing/time.hpp"
+
+namespace Sage::Logger::Internal
+{
+
+struct Admission
+{
+    bool m_allowed{ false };
+    // lines held back since the last one that was let through
+    uint64_t m_suppressed{ 0 };
+
+    explicit operator bool() const noexcept { return m_allowed; }
+};
+
+/// Lets through at most N lines per second from a single call site
+class RateLimiter
+{
+public:
+    Admission Admit(uint32_t perSecond, Level level, const std::source_location& loc) noexcept
+    {
+        const int64_t now{ GetCoarseMonotonicTime().count() };
+        int64_t windowStart{ m_windowStart.load(std::memory_order_relaxed) };
+
+        if (now - windowStart >= s_window.count() and
+            m_windowStart.compare_exchange_strong(windowStart, now, std::memory_order_relaxed))
+        {
+            m_count.store(0, std::memory_order_relaxed);
+        }
+
+        if (m_count.fetch_add(1, std::memory_order_relaxed) < perSecond)
+        {
+            return { true, m_suppressed.exchange(0, std::memory_order_relaxed) };
+        }
+
+        if (m_suppressed.fetch_add(1, std::memory_order_relaxed) == 0) [[unlikely]]
+        {
+            Track(level, loc);
+        }
+        return {};
+    }
+
+    /// @returns lines held back, once a window has passed without any being let through
+    uint64_t TakeExpired(int64_t now) noexcept
+    {
+        if (m_suppressed.load(std::memory_order_relaxed) == 0 or
+            now - m_windowStart.load(std::memory_order_relaxed) < s_window.count())
+        {
+            return 0;
+        }
+
+        return m_suppressed.exchange(0, std::memory_order_relaxed);
+    }
+
+    LogSite& SummarySite() noexcept { return m_summarySite; }
+
+    Level GetLevel() const noexcept { return m_level; }
+
+    const std::source_location& Location() const noexcept { return m_loc; }
+
+    RateLimiter* Next() const noexcept { return m_next; }
+
+    /// Every limiter that has held back a line, most recent first
+    static RateLimiter* Tracked() noexcept { return s_tracked.load(std::memory_order_acquire); }
+
+private:
+    // sites are only tracked once they first hold a line back
+    void Track(Level level, const std::source_location& loc) noexcept
+    {
+        if (m_tracked.exchange(true, std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        m_level = level;
+        m_loc = loc;
+        m_next = s_tracked.load(std::memory_order_relaxed);
+        while (not s_tracked.compare_exchange_weak(m_next, this, std::memory_order_release))
+        {
+        }
+    }
+
+    static constexpr TimeNS s_window{ 1s };
+    // limiters are call site statics, never removed
+    static constinit inline std::atomic<RateLimiter*> s_tracked{ nullptr };
+
+    std::atomic<int64_t> m_windowStart{ 0 };
+    std::atomic<uint32_t> m_count{ 0 };
+    std::atomic<uint64_t> m_suppressed{ 0 };
+    std::atomic<bool> m_tracked{ false };
+    // where the suppressed summary is logged from. set before the limiter is tracked
+    LogSite m_summarySite{};
+    Level m_level{ Level::Info };
+    std::source_location m_loc{};
+    RateLimiter* m_next{ nullptr };
+};
+
+/// Lets through the 1st, N+1th, 2N+1th... line from a single call site. N of 0 lets every line through
+class Sampler
+{
+public:
+    Admission Admit(uint32_t everyN) noexcept
+    {
+        return { m_count.fetch_add(1, std::memory_order_relaxed) % std::max(everyN, 1u) == 0, 0 };
+    }
+
+private:
+    std::atomic<uint64_t> m_count{ 0 };
+};
+
+} // namespace Sage::Logger::Internal
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Sage::Logger
+{
+
+enum class OverflowPolicy
+{
+    // lines that don't fit are counted and reported once there is room again
+    Drop,
+    // the logging thread waits for the writer to make room
+    Block
+};
+
+struct AsyncOptions
+{
+    bool m_enabled{ false };
+    OverflowPolicy m_overflowPolicy{ OverflowPolicy::Drop };
+    // per logging thread. rounded up to a power of 2
+    size_t m_ringSize{ 1 << 20 };
+    // lines are written as binary records and formatted offline by log-decoder
+    bool m_binary{ false };
+};
+
+} // namespace Sage::Logger
@@ -1,4 +1,9 @@
+#include <array>
+#include <cstdlib>
+#include <fcntl.h>
 #include <filesystem>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "log/log_stream.hpp"
 #include "log/logger.hpp"
@@ -6,7 +11,7 @@
 namespace Sage::Logger::Internal
 {
 
-void LogStreamer::Setup(const std::string& filename, Level level)
+void LogStreamer::Setup(const std::string& filename, Level level, const AsyncOptions& asyncOptions)
 {
     m_logFilename = filename;
     m_logLevel = level;
@@ -14,35 +19,29 @@ void LogStreamer::Setup(const std::string& filename, Level level)
     if (m_logFilename.empty())
     {
         SetStreamToConsole();
+        StartAsync(asyncOptions);
         return;
     }
 
     // try setup a file logger if specified
     try
     {
-        if (std::filesystem::exists(m_logFilename) and not std::filesystem::is_regular_file(m_logFilename))
-        {
-            throw std::runtime_error("cannot write to non regular file '" + m_logFilename + "'");
-        }
-
-        std::ofstream file{ m_logFilename, std::ios::out | std::ios::ate | std::ios::app };
-        std::filesystem::permissions(
-            m_logFilename,
-            std::filesystem::perms::owner_write | std::filesystem::perms::group_read,
-            std::filesystem::perm_options::add
-        );
-
-        if (file.fail())
-        {
-            throw std::runtime_error("unable to open file '" + m_logFilename + "' for writing");
-        }
-
-        SetStreamToFile(std::move(file));
+        SetStreamToFile(OpenLogFile());
     }
     catch (const std::exception& e)
     {
         LOG_CRITICAL("==== failed to setup file logger. what: {} ====", e.what());
     }
+
+    StartAsync(asyncOptions);
+}
+
+void LogStreamer::StopAsync()
+{
+    if (AsyncLogWriter* writer{ GetAsyncWriter() }; writer != nullptr)
+    {
+        writer->Stop();
+    }
 }
 
 void LogStreamer::EnsureLogFileWriteable()
@@ -52,46 +51,56 @@ void LogStreamer::EnsureLogFileWriteable()
         return;
     }
 
-    try
+    // still writing to the file at that path
+    struct stat fileStat{};
+    if (::stat(m_logFilename.c_str(), &fileStat) == 0 and fileStat.st_dev == m_logFileDevice and
+        fileStat.st_ino == m_logFileInode and not m_logFileLost.load())
     {
-        // everything is okay
-        if (std::filesystem::exists(m_logFilename) and std::filesystem::is_regular_file(m_logFilename))
-        {
-            return;
-        }
-
-        // No longer writing to log file
+        return;
+    }
 
-        m_lostLogTime += s_logFileCreatorPeriod.count();
+    try
+    {
+        SetStreamToFile(OpenLogFile());
+    }
+    catch (const std::exception& e)
+    {
+        // lines are dropped until the file can be opened again
+        m_logFileLost = true;
+        std::println(std::cerr, "failed to reopen log file. what: {}", e.what());
+        return;
+    }
 
-        if (std::filesystem::exists(m_logFilename) and not std::filesystem::is_regular_file(m_logFilename))
-        {
-            std::println(std::cerr, "cannot write to non regular file '{}'", m_logFilename);
-            return;
-        }
+    m_logFileLost = false;
+    if (size_t dropped{ m_droppedLines.exchange(0) }; dropped != 0)
+    {
+        LOG_CRITICAL("dropped {} line(s) while the log file was unavailable", dropped);
+        return;
+    }
 
-        std::ofstream file{ m_logFilename, std::ios::out | std::ios::ate | std::ios::app };
-        std::filesystem::permissions(
-            m_logFilename,
-            std::filesystem::perms::owner_write | std::filesystem::perms::group_read,
-            std::filesystem::perm_options::add
-        );
+    LOG_WARNING("log file '{}' was moved or removed. reopened", m_logFilename);
+}
 
-        if (file.fail())
-        {
-            std::println(std::cerr, "unable to open file '{}' for writing", m_logFilename);
-            return;
-        }
+std::ofstream LogStreamer::OpenLogFile()
+{
+    if (std::filesystem::exists(m_logFilename) and not std::filesystem::is_regular_file(m_logFilename))
+    {
+        throw std::runtime_error("cannot write to non regular file '" + m_logFilename + "'");
+    }
 
-        SetStreamToFile(std::move(file));
+    std::ofstream file{ m_logFilename, std::ios::out | std::ios::ate | std::ios::app };
+    std::filesystem::permissions(
+        m_logFilename,
+        std::filesystem::perms::owner_write | std::filesystem::perms::group_read,
+        std::filesystem::perm_options::add
+    );
 
-        LOG_CRITICAL("lost {} worth of logs", static_cast<decltype(s_logFileCreatorPeriod)>(m_lostLogTime));
-        m_lostLogTime = {};
-    }
-    catch (const std::filesystem::filesystem_error& e)
+    if (file.fail())
     {
-        std::println(std::cerr, "file system error when attempting to recreate file logger. e: {}", e.what());
+        throw std::runtime_error("unable to open file '" + m_logFilename + "' for writing");
     }
+
+    return file;
 }
 
 void LogStreamer::SetStreamToConsole()
@@ -104,6 +113,57 @@ void LogStreamer::SetStreamToFile(std::ofstream fileStream)
 {
     m_logFileStream = std::move(fileStream);
     m_streamRef = m_logFileStream;
+
+    if (struct stat fileStat{}; ::stat(m_logFilename.c_str(), &fileStat) == 0)
+    {
+        m_logFileDevice = fileStat.st_dev;
+        m_logFileInode = fileStat.st_ino;
+    }
+
+    // the async writer has its own fd. point it at the recreated file too
+    if (AsyncLogWriter* writer{ GetAsyncWriter() }; writer != nullptr)
+    {
+        if (int fd{ OpenAsyncFd() }; fd != -1)
+        {
+            writer->SetFd(fd);
+        }
+    }
+}
+
+void LogStreamer::StartAsync(const AsyncOptions& asyncOptions)
+{
+    if (not asyncOptions.m_enabled or GetAsyncWriter() != nullptr)
+    {
+        return;
+    }
+
+    int fd{ OpenAsyncFd() };
+    if (fd == -1)
+    {
+        LOG_CRITICAL("==== failed to open fd for async logger. errno: {} ====", errno);
+        return;
+    }
+
+    auto* writer{ new AsyncLogWriter{ fd, asyncOptions } };
+    if (asyncOptions.m_binary)
+    {
+        EnableBinaryLogging(*writer);
+        m_binary = true;
+    }
+
+    m_asyncWriter.store(writer, std::memory_order_release);
+    std::atexit([] { GetLogStreamer().StopAsync(); });
+}
+
+int LogStreamer::OpenAsyncFd() const
+{
+    // a file that failed to open is logged to the console, same as the sync path
+    if (m_logFilename.empty() or not m_logFileStream.is_open())
+    {
+        return STDOUT_FILENO;
+    }
+
+    return ::open(m_logFilename.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
 }
 
 /**
@@ -114,4 +174,10 @@ LogStreamer* const g_logStreamer{ new LogStreamer };
 
 LogStreamer& GetLogStreamer() noexcept { return *g_logStreamer; }
 
+std::span<char> GetLineBuffer() noexcept
+{
+    thread_local std::array<char, 4096> t_line;
+    return t_line;
+}
+
 } // namespace Sage::Logger::Internal
@@ -1,12 +1,17 @@
 #pragma once
 
-#include <chrono>
+#include <atomic>
 #include <fstream>
 #include <iostream>
 #include <source_location>
+#include <span>
 #include <string>
+#include <sys/types.h>
 
+#include "log/async_log_writer.hpp"
+#include "log/binary_log.hpp"
 #include "log/log_levels.hpp"
+#include "log/log_options.hpp"
 
 namespace Sage::Logger::Internal
 {
@@ -18,12 +23,35 @@ public:
 
     LogStreamer() = default;
 
-    void Setup(const std::string& filename, Level level);
+    void Setup(const std::string& filename, Level level, const AsyncOptions& asyncOptions = {});
 
     Level GetLogLevel() const noexcept { return m_logLevel; }
 
+    /// nullptr unless async logging is enabled
+    AsyncLogWriter* GetAsyncWriter() const noexcept { return m_asyncWriter.load(std::memory_order_acquire); }
+
+    bool IsBinary() const noexcept { return m_binary; }
+
+    /// Writes out everything the async writer has queued. logging afterwards is synchronous
+    void StopAsync();
+
+    const std::string& GetLogFilename() const noexcept { return m_logFilename; }
+
+    /// Reopens the log file if it was removed or replaced. lines logged while it can't be reopened are dropped
     void EnsureLogFileWriteable();
 
+    /// @returns true if the line should be dropped because the log file is gone
+    bool DropIfLogFileLost() noexcept
+    {
+        if (not m_logFileLost.load(std::memory_order_relaxed)) [[likely]]
+        {
+            return false;
+        }
+
+        m_droppedLines.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
 private:
     // Nothing in here is movable or copyable
     LogStreamer(const LogStreamer&) = delete;
@@ -35,21 +63,36 @@ private:
 
     void SetStreamToFile(std::ofstream fileStream);
 
+    std::ofstream OpenLogFile();
+
+    void StartAsync(const AsyncOptions& asyncOptions);
+
+    int OpenAsyncFd() const;
+
 private:
     static constexpr std::reference_wrapper<Stream> s_consoleStream{ std::cout };
-    static constexpr auto s_logFileCreatorPeriod{ std::chrono::seconds{ 60 } };
-
     std::reference_wrapper<Stream> m_streamRef{ s_consoleStream };
     std::string m_logFilename{};
     Level m_logLevel{ Level::Info };
-    size_t m_lostLogTime{ 0 };
     std::ofstream m_logFileStream{};
+    // identifies the file that's open, to tell when the path points somewhere else
+    dev_t m_logFileDevice{ 0 };
+    ino_t m_logFileInode{ 0 };
+    std::atomic<bool> m_logFileLost{ false };
+    std::atomic<size_t> m_droppedLines{ 0 };
+    // leaked like the streamer itself so logging from global destructors stays safe
+    std::atomic<AsyncLogWriter*> m_asyncWriter{ nullptr };
+    bool m_binary{ false };
 
     template<typename... Args>
-    friend inline void
-    LogToStream(Level level, std::format_string<Args...> fmt, const std::source_location& loc, Args&&... args);
+    friend inline void LogToStream(
+        Level level, LogSite& site, std::format_string<Args...> fmt, const std::source_location& loc, Args&&... args
+    );
 };
 
 LogStreamer& GetLogStreamer() noexcept;
 
+/// The calling thread's buffer async lines are formatted into. One per thread whatever the call site
+std::span<char> GetLineBuffer() noexcept;
+
 } // namespace Sage::Logger::Internal
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <sys/inotify.h>
+
+#include "log/logger.hpp"
+#include "proactor/proactor.hpp"
+
+namespace Sage
+{
+
+/**
+ * Watches the log file's directory and invokes the check callback as soon as the log file is
+ * removed, renamed or created, e.g. by logrotate. Nothing runs while the file is left alone
+ */
+class LogFileWatcher final
+{
+public:
+    using CheckFunc = std::function<void()>;
+
+    LogFileWatcher(const std::string& logFilename, CheckFunc&& cb) : m_checkCb{ std::move(cb) }
+    {
+        if (logFilename.empty())
+        {
+            return;
+        }
+
+        const std::filesystem::path logPath{ logFilename };
+        m_logFileName = logPath.filename();
+        const std::filesystem::path directory{ logPath.has_parent_path() ? logPath.parent_path() : "." };
+
+        m_watchId = Proactor::Instance().AddFileWatch(
+            directory,
+            IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR,
+            [this](const inotify_event& event) { OnFileEvent(event); }
+        );
+
+        if (m_watchId == -1)
+        {
+            LOG_CRITICAL("[LogFileWatcher] unable to watch '{}'. log file will not be recreated", directory.string());
+        }
+    }
+
+    ~LogFileWatcher()
+    {
+        if (m_watchId != -1)
+        {
+            Proactor::Instance().RemoveFileWatch(m_watchId);
+        }
+    }
+
+private:
+    LogFileWatcher(const LogFileWatcher&) = delete;
+    LogFileWatcher(LogFileWatcher&&) = delete;
+    LogFileWatcher& operator=(const LogFileWatcher&) = delete;
+    LogFileWatcher& operator=(LogFileWatcher&&) = delete;
+
+    void OnFileEvent(const inotify_event& event)
+    {
+        if (event.mask & IN_IGNORED)
+        {
+            LOG_CRITICAL("[LogFileWatcher] log directory removed. log file will not be recreated");
+            m_watchId = -1;
+            return;
+        }
+
+        if (event.len == 0 or m_logFileName != event.name)
+        {
+            return;
+        }
+
+        LOG_DEBUG("[LogFileWatcher] log file event mask({:#x}). invoking log file check callback", event.mask);
+        m_checkCb();
+    }
+
+private:
+    const CheckFunc m_checkCb;
+    std::string m_logFileName;
+    int m_watchId{ -1 };
+};
+
+} // namespace Sage
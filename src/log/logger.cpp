@@ -1,3 +1,4 @@
+#include <atomic>
 #include <ctime>
 
 #include "log/logger.hpp"
@@ -8,10 +9,40 @@ namespace Sage
 namespace Logger
 {
 
-void SetupLogger(const std::string& filename, Level logLevel) { Internal::GetLogStreamer().Setup(filename, logLevel); }
+void SetupLogger(const std::string& filename, Level logLevel, const AsyncOptions& asyncOptions)
+{
+    Internal::GetLogStreamer().Setup(filename, logLevel, asyncOptions);
+}
 
 void EnsureLogFileExist() { Internal::GetLogStreamer().EnsureLogFileWriteable(); }
 
+const std::string& GetLogFilename() noexcept { return Internal::GetLogStreamer().GetLogFilename(); }
+
+void ShutdownLogger() { Internal::GetLogStreamer().StopAsync(); }
+
+void ReportSuppressed()
+{
+    // limiters are only walked a few times a window however often this is called
+    static std::atomic<int64_t> s_lastReport{ 0 };
+    constexpr int64_t reportInterval{ TimeNS{ 250ms }.count() };
+
+    const int64_t now{ GetCoarseMonotonicTime().count() };
+    int64_t lastReport{ s_lastReport.load(std::memory_order_relaxed) };
+    if (now - lastReport < reportInterval or
+        not s_lastReport.compare_exchange_strong(lastReport, now, std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    for (auto* limiter{ Internal::RateLimiter::Tracked() }; limiter != nullptr; limiter = limiter->Next())
+    {
+        if (const uint64_t suppressed{ limiter->TakeExpired(now) }; suppressed != 0)
+        {
+            Internal::LogSuppressed(limiter->GetLevel(), limiter->SummarySite(), limiter->Location(), suppressed);
+        }
+    }
+}
+
 namespace Internal
 {
 
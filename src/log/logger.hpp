@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <format>
 #include <print>
@@ -7,6 +9,7 @@
 #include <string>
 #include <string_view>
 
+#include "log/log_limiter.hpp"
 #include "log/log_stream.hpp"
 #include "timing/time.hpp"
 
@@ -16,10 +19,20 @@ namespace Sage
 namespace Logger
 {
 
-void SetupLogger(const std::string& filename = "", Level logLevel = Level::Info);
+void SetupLogger(const std::string& filename = "", Level logLevel = Level::Info, const AsyncOptions& asyncOptions = {});
 
 void EnsureLogFileExist();
 
+/// Empty when logging to the console
+const std::string& GetLogFilename() noexcept;
+
+/// Flushes anything queued by the async logger. logging after this is synchronous
+void ShutdownLogger();
+
+/// Logs what each rate limited site held back once a second has passed without a line getting through,
+/// for bursts that stopped. Called from the proactor loop
+void ReportSuppressed();
+
 namespace Internal
 {
 
@@ -45,14 +58,55 @@ constexpr std::string_view GetFilenameStem(const std::string_view fileName) noex
 }
 
 template<typename... Args>
-inline void LogToStream(Level level, std::format_string<Args...> fmt, const std::source_location& loc, Args&&... args)
+inline void LogToStream(
+    Level level, LogSite& site, std::format_string<Args...> fmt, const std::source_location& loc, Args&&... args
+)
 {
     if (not Internal::ShouldLog(level))
         return;
 
+    auto& logStreamer{ GetLogStreamer() };
+    if (logStreamer.DropIfLogFileLost())
+        return;
+
+    AsyncLogWriter* asyncWriter{ logStreamer.GetAsyncWriter() };
+
+    // formatting and the timestamp are left to the decoder
+    if (logStreamer.IsBinary())
+    {
+        LogBinary(*asyncWriter, site, level, fmt, loc, std::forward_like<Args>(args)...);
+        return;
+    }
+
     Timestamp ts{ GetCurrentTimeStamp() };
 
-    auto& logStreamer{ GetLogStreamer() };
+    if (asyncWriter != nullptr)
+    {
+        // formatted straight into a per thread buffer. lines longer than it are truncated
+        const std::span<char> line{ GetLineBuffer() };
+        char* const begin{ line.data() };
+        char* const end{ begin + line.size() - GetFormatEnd().size() - 1 };
+
+        auto prefix{ std::format_to_n(
+            begin,
+            end - begin,
+            "{}[{}{}] [{}] [{}:{}] ",
+            GetLevelFormatter(level),
+            ts.m_date,
+            ts.m_ns,
+            GetLevelName(level),
+            GetFilenameStem(loc.file_name()),
+            loc.line()
+        ) };
+        char* out{ prefix.out };
+        out = std::format_to_n(out, end - out, fmt, std::forward_like<Args>(args)...).out;
+        out = std::ranges::copy(GetFormatEnd(), out).out;
+        *out++ = '\n';
+
+        asyncWriter->Append({ begin, out });
+        return;
+    }
+
     LogStreamer::Stream& stream{ logStreamer.m_streamRef.get() };
     std::println(
         stream,
@@ -69,40 +123,64 @@ inline void LogToStream(Level level, std::format_string<Args...> fmt, const std:
     std::flush(stream);
 }
 
+inline void LogSuppressed(Level level, LogSite& summarySite, const std::source_location& loc, uint64_t suppressed)
+{
+    LogToStream(level, summarySite, "suppressed {} line(s) from this site over its rate limit", loc, suppressed);
+}
+
 template<typename... Args>
-inline void Trace(std::format_string<Args...> fmt, const std::source_location& loc, Args&&... args)
+inline void LogAdmitted(
+    Admission admission,
+    Level level,
+    LogSite& site,
+    LogSite& summarySite,
+    std::format_string<Args...> fmt,
+    const std::source_location& loc,
+    Args&&... args
+)
 {
-    Logger::Internal::LogToStream(Logger::Trace, fmt, loc, std::forward_like<Args>(args)...);
+    if (admission.m_suppressed != 0) [[unlikely]]
+    {
+        LogSuppressed(level, summarySite, loc, admission.m_suppressed);
+    }
+
+    LogToStream(level, site, fmt, loc, std::forward_like<Args>(args)...);
 }
 
 template<typename... Args>
-inline void Debug(std::format_string<Args...> fmt, const std::source_location& loc, Args&&... args)
+inline void Trace(LogSite& site, std::format_string<Args...> fmt, const std::source_location& loc, Args&&... args)
 {
-    Logger::Internal::LogToStream(Logger::Debug, fmt, loc, std::forward_like<Args>(args)...);
+    Logger::Internal::LogToStream(Logger::Trace, site, fmt, loc, std::forward_like<Args>(args)...);
 }
 
 template<typename... Args>
-inline void Info(std::format_string<Args...> fmt, const std::source_location& loc, Args&&... args)
+inline void Debug(LogSite& site, std::format_string<Args...> fmt, const std::source_location& loc, Args&&... args)
 {
-    Logger::Internal::LogToStream(Logger::Info, fmt, loc, std::forward_like<Args>(args)...);
+    Logger::Internal::LogToStream(Logger::Debug, site, fmt, loc, std::forward_like<Args>(args)...);
 }
 
 template<typename... Args>
-inline void Warning(std::format_string<Args...> fmt, const std::source_location& loc, Args&&... args)
+inline void Info(LogSite& site, std::format_string<Args...> fmt, const std::source_location& loc, Args&&... args)
 {
-    Logger::Internal::LogToStream(Logger::Warning, fmt, loc, std::forward_like<Args>(args)...);
+    Logger::Internal::LogToStream(Logger::Info, site, fmt, loc, std::forward_like<Args>(args)...);
 }
 
 template<typename... Args>
-inline void Error(std::format_string<Args...> fmt, const std::source_location& loc, Args&&... args)
+inline void Warning(LogSite& site, std::format_string<Args...> fmt, const std::source_location& loc, Args&&... args)
 {
-    Logger::Internal::LogToStream(Logger::Error, fmt, loc, std::forward_like<Args>(args)...);
+    Logger::Internal::LogToStream(Logger::Warning, site, fmt, loc, std::forward_like<Args>(args)...);
 }
 
 template<typename... Args>
-inline void Critical(std::format_string<Args...> fmt, const std::source_location& loc, Args&&... args)
+inline void Error(LogSite& site, std::format_string<Args...> fmt, const std::source_location& loc, Args&&... args)
 {
-    Logger::Internal::LogToStream(Logger::Critical, fmt, loc, std::forward_like<Args>(args)...);
+    Logger::Internal::LogToStream(Logger::Error, site, fmt, loc, std::forward_like<Args>(args)...);
+}
+
+template<typename... Args>
+inline void Critical(LogSite& site, std::format_string<Args...> fmt, const std::source_location& loc, Args&&... args)
+{
+    Logger::Internal::LogToStream(Logger::Critical, site, fmt, loc, std::forward_like<Args>(args)...);
 }
 
 } // namespace Internal
@@ -113,18 +191,74 @@ inline void Critical(std::format_string<Args...> fmt, const std::source_location
 
 // Log marcos for lazy va args evaluation
 
+// Each expansion gets its own static so every call site is tracked separately
+#define SAGE_LOG_SITE()                                                                                                \
+    []() -> Sage::Logger::Internal::LogSite&                                                                           \
+    {                                                                                                                  \
+        static constinit Sage::Logger::Internal::LogSite s_site{};                                                     \
+        return s_site;                                                                                                 \
+    }()
+
 #define LOG_TRACE(fmt, ...)                                                                                            \
     if (Sage::Logger::Internal::ShouldLog(Sage::Logger::Trace)) [[unlikely]]                                           \
-    Sage::Logger::Internal::Trace(fmt, std::source_location::current(), ##__VA_ARGS__)
+    Sage::Logger::Internal::Trace(SAGE_LOG_SITE(), fmt, std::source_location::current(), ##__VA_ARGS__)
 
 #define LOG_DEBUG(fmt, ...)                                                                                            \
     if (Sage::Logger::Internal::ShouldLog(Sage::Logger::Debug)) [[unlikely]]                                           \
-    Sage::Logger::Internal::Debug(fmt, std::source_location::current(), ##__VA_ARGS__)
-
-#define LOG_INFO(fmt, ...) Sage::Logger::Internal::Info(fmt, std::source_location::current(), ##__VA_ARGS__)
-
-#define LOG_WARNING(fmt, ...) Sage::Logger::Internal::Warning(fmt, std::source_location::current(), ##__VA_ARGS__)
-
-#define LOG_ERROR(fmt, ...) Sage::Logger::Internal::Error(fmt, std::source_location::current(), ##__VA_ARGS__)
-
-#define LOG_CRITICAL(fmt, ...) Sage::Logger::Internal::Critical(fmt, std::source_location::current(), ##__VA_ARGS__)
+    Sage::Logger::Internal::Debug(SAGE_LOG_SITE(), fmt, std::source_location::current(), ##__VA_ARGS__)
+
+#define LOG_INFO(fmt, ...)                                                                                             \
+    Sage::Logger::Internal::Info(SAGE_LOG_SITE(), fmt, std::source_location::current(), ##__VA_ARGS__)
+
+#define LOG_WARNING(fmt, ...)                                                                                          \
+    Sage::Logger::Internal::Warning(SAGE_LOG_SITE(), fmt, std::source_location::current(), ##__VA_ARGS__)
+
+#define LOG_ERROR(fmt, ...)                                                                                            \
+    Sage::Logger::Internal::Error(SAGE_LOG_SITE(), fmt, std::source_location::current(), ##__VA_ARGS__)
+
+#define LOG_CRITICAL(fmt, ...)                                                                                         \
+    Sage::Logger::Internal::Critical(SAGE_LOG_SITE(), fmt, std::source_location::current(), ##__VA_ARGS__)
+
+// Limited log marcos for call sites that can fire once per completion
+
+#define SAGE_LOG_LIMITER(Limiter)                                                                                      \
+    []() -> Sage::Logger::Internal::Limiter&                                                                           \
+    {                                                                                                                  \
+        static constinit Sage::Logger::Internal::Limiter s_limiter{};                                                  \
+        return s_limiter;                                                                                              \
+    }()
+
+// At most perSecond lines a second. what was held back is reported ahead of the next line let through,
+// or by ReportSuppressed once the burst is over
+#define LOG_RATE_LIMITED(level, perSecond, fmt, ...)                                                                   \
+    if (Sage::Logger::Internal::ShouldLog(level))                                                                      \
+        if (auto& sage_limiter{ SAGE_LOG_LIMITER(RateLimiter) };                                                       \
+            Sage::Logger::Internal::Admission sage_admission{                                                          \
+                sage_limiter.Admit(perSecond, level, std::source_location::current())                                  \
+            })                                                                                                         \
+    Sage::Logger::Internal::LogAdmitted(                                                                               \
+        sage_admission,                                                                                                \
+        level,                                                                                                         \
+        SAGE_LOG_SITE(),                                                                                               \
+        sage_limiter.SummarySite(),                                                                                    \
+        fmt,                                                                                                           \
+        std::source_location::current(),                                                                               \
+        ##__VA_ARGS__                                                                                                  \
+    )
+
+// Only every Nth line, starting with the first. N of 0 is taken as 1
+#define LOG_EVERY_N(level, everyN, fmt, ...)                                                                           \
+    if (Sage::Logger::Internal::ShouldLog(level))                                                                      \
+        if (Sage::Logger::Internal::Admission sage_admission{ SAGE_LOG_LIMITER(Sampler).Admit(everyN) };               \
+            sage_admission)                                                                                            \
+    Sage::Logger::Internal::LogAdmitted(                                                                               \
+        sage_admission,                                                                                                \
+        level,                                                                                                         \
+        SAGE_LOG_SITE(),                                                                                               \
+        SAGE_LOG_SITE(),                                                                                               \
+        fmt,                                                                                                           \
+        std::source_location::current(),                                                                               \
+        ##__VA_ARGS__                                                                                                  \
+    )
+
+#define LOG_ERROR_RATE_LIMITED(perSecond, fmt, ...) LOG_RATE_LIMITED(Sage::Logger::Error, perSecond, fmt, ##__VA_ARGS__)
@@ -11,10 +11,17 @@ namespace Sage
 CliArgs GetCliArgs(int argc, char* const argv[])
 {
     constexpr std::array argOptions{
-        option{ "help",  no_argument,       nullptr, 'h' },
-        option{ "level", required_argument, nullptr, 'l' },
-        option{ "file",  required_argument, nullptr, 'f' },
-        option{ 0,       0,                 0,       0   }
+        option{ "help",     no_argument,       nullptr, 'h' },
+        option{ "level",    required_argument, nullptr, 'l' },
+        option{ "file",     required_argument, nullptr, 'f' },
+        option{ "async",    no_argument,       nullptr, 'a' },
+        option{ "overflow", required_argument, nullptr, 'o' },
+        option{ "binary",   no_argument,       nullptr, 'b' },
+        option{ "trace",    required_argument, nullptr, 't' },
+        option{ "backend",  required_argument, nullptr, 'B' },
+        option{ "record",   required_argument, nullptr, 'r' },
+        option{ "replay",   required_argument, nullptr, 'R' },
+        option{ 0,          0,                 0,       0   }
     };
 
     auto usage = [&argv]
@@ -27,9 +34,16 @@ CliArgs GetCliArgs(int argc, char* const argv[])
 
         std::println(
             std::cerr,
-            "Usage: %s"
+            "Usage: {}"
             "\n\t[optional] --level|-l <t|trace|d|debug|i|info|w|warn|e|error|c|critical>"
             "\n\t[optional] --file|-f <filename> "
+            "\n\t[optional] --async|-a "
+            "\n\t[optional] --overflow|-o <drop|block> "
+            "\n\t[optional] --binary|-b (implies --async. decode with log-decoder)"
+            "\n\t[optional] --trace|-t <filename> (chrome trace of the event loop, written on exit)"
+            "\n\t[optional] --backend|-B <io_uring|epoll> (default io_uring. epoll if io_uring is unavailable)"
+            "\n\t[optional] --record|-r <filename> (trace of every completion, for --replay)"
+            "\n\t[optional] --replay|-R <filename> (complete ops from a recorded trace instead of the kernel)"
             "\n\t[optional] --help|-h",
             progName
         );
@@ -66,12 +80,25 @@ CliArgs GetCliArgs(int argc, char* const argv[])
         return level;
     };
 
+    auto getOverflowPolicy = [](std::string_view overflowArg) -> Logger::OverflowPolicy
+    {
+        if (overflowArg == "block")
+        {
+            return Logger::OverflowPolicy::Block;
+        }
+
+        return Logger::OverflowPolicy::Drop;
+    };
+
     Logger::Level logLevel{ Logger::Info };
     std::string logFile;
+    Logger::AsyncOptions asyncLog;
+    std::string traceFile;
+    BackendOptions backend;
 
     int option;
     int optIndex;
-    while ((option = getopt_long(argc, argv, "hl:f:", argOptions.data(), &optIndex)) != -1)
+    while ((option = getopt_long(argc, argv, "hl:f:ao:bt:B:r:R:", argOptions.data(), &optIndex)) != -1)
     {
         switch (option)
         {
@@ -88,6 +115,43 @@ CliArgs GetCliArgs(int argc, char* const argv[])
                 logFile = optarg;
                 break;
 
+            case 'a':
+                asyncLog.m_enabled = true;
+                break;
+
+            case 'o':
+                asyncLog.m_overflowPolicy = getOverflowPolicy(optarg);
+                break;
+
+            case 'b':
+                asyncLog.m_enabled = true;
+                asyncLog.m_binary = true;
+                break;
+
+            case 't':
+                traceFile = optarg;
+                break;
+
+            case 'B':
+            {
+                auto parsed{ ParseBackendType(optarg) };
+                if (not parsed)
+                {
+                    usage();
+                    std::exit(1);
+                }
+                backend.m_type = *parsed;
+                break;
+            }
+
+            case 'r':
+                backend.m_recordFile = optarg;
+                break;
+
+            case 'R':
+                backend.m_replayFile = optarg;
+                break;
+
             case '?':
             default:
                 usage();
@@ -96,7 +160,13 @@ CliArgs GetCliArgs(int argc, char* const argv[])
         }
     }
 
-    return { logLevel, logFile };
+    // whichever backend was asked for, a replay never touches the kernel
+    if (not backend.m_replayFile.empty())
+    {
+        backend.m_type = BackendType::Replay;
+    }
+
+    return { logLevel, logFile, asyncLog, traceFile, backend };
 }
 
 } // namespace Sage
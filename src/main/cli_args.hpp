@@ -3,6 +3,8 @@
 #include <string>
 
 #include "log/log_levels.hpp"
+#include "log/log_options.hpp"
+#include "proactor/io_backend.hpp"
 
 namespace Sage
 {
@@ -11,6 +13,10 @@ struct CliArgs
 {
     Logger::Level level;
     std::string logFile;
+    Logger::AsyncOptions asyncLog;
+    // empty unless the event loop is traced
+    std::string traceFile;
+    BackendOptions backend;
 };
 
 CliArgs GetCliArgs(int argc, char* const argv[]);
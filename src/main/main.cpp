@@ -1,6 +1,6 @@
 #include <string_view>
 
-#include "log/logfile_checker.hpp"
+#include "log/logfile_watcher.hpp"
 #include "log/logger.hpp"
 #include "main/cli_args.hpp"
 #include "proactor/proactor.hpp"
@@ -47,21 +47,30 @@ int main(int argc, char* const argv[])
 
     try
     {
-        auto [logLevel, logFile]{ GetCliArgs(argc, argv) };
-        Logger::SetupLogger(logFile, logLevel);
+        auto [logLevel, logFile, asyncLog, traceFile, backend]{ GetCliArgs(argc, argv) };
+        Logger::SetupLogger(logFile, logLevel, asyncLog);
 
         LOG_INFO("cpp-io-uring-proactor starting");
 
         {
-            Proactor::Create();
+            Proactor::Create(backend);
+            if (not traceFile.empty())
+            {
+                Proactor::Instance().EnableTracing();
+            }
 
             {
-                LogFileChecker logChecker{ Logger::EnsureLogFileExist };
+                LogFileWatcher logWatcher{ Logger::GetLogFilename(), Logger::EnsureLogFileExist };
                 TestTimerHandler handler;
                 TestTcpClient h2;
                 Proactor::Instance().Run();
             }
 
+            if (not traceFile.empty())
+            {
+                Proactor::Instance().WriteTrace(traceFile);
+            }
+
             Proactor::Destroy();
         }
     }
@@ -72,6 +81,7 @@ int main(int argc, char* const argv[])
     }
 
     LOG_INFO("cpp-io-uring-proactor exiting code({})", res);
+    Logger::ShutdownLogger();
 
     return res;
 }
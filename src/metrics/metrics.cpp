@@ -0,0 +1,137 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "log/logger.hpp"
+#include "metrics/metrics.hpp"
+
+namespace Sage::Metrics
+{
+
+MetricsRegistry::MetricsRegistry() : m_shmName{ std::format("/{}.{}", program_invocation_short_name, ::getpid()) }
+{
+    void* memory{ MAP_FAILED };
+
+    if (int fd{ ::shm_open(m_shmName.c_str(), O_CREAT | O_RDWR | O_TRUNC | O_CLOEXEC, 0644) }; fd != -1)
+    {
+        if (::ftruncate(fd, sizeof(Layout)) == 0)
+        {
+            memory = ::mmap(nullptr, sizeof(Layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+
+        if (memory == MAP_FAILED)
+        {
+            ::shm_unlink(m_shmName.c_str());
+        }
+        ::close(fd);
+    }
+
+    if (memory == MAP_FAILED)
+    {
+        int err{ errno };
+        LOG_WARNING("unable to share metrics at '{}'. {}. keeping them private", m_shmName, strerror(err));
+
+        m_shmName.clear();
+        memory = ::mmap(nullptr, sizeof(Layout), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+        {
+            throw std::runtime_error{ "Metrics Memory Allocation Failed" };
+        }
+    }
+    else
+    {
+        m_path = "/dev/shm" + m_shmName;
+        LOG_INFO("metrics published at '{}'", m_path);
+    }
+
+    m_layout = std::construct_at(static_cast<Layout*>(memory));
+    m_layout->m_magic = s_magic;
+    m_layout->m_version = s_version;
+    m_layout->m_pid = ::getpid();
+}
+
+MetricsRegistry::~MetricsRegistry()
+{
+    std::destroy_at(m_layout);
+    ::munmap(m_layout, sizeof(Layout));
+
+    Unpublish();
+}
+
+void MetricsRegistry::Unpublish() noexcept
+{
+    if (m_shmName.empty())
+    {
+        return;
+    }
+
+    ::shm_unlink(m_shmName.c_str());
+    m_shmName.clear();
+    m_path.clear();
+}
+
+Counter MetricsRegistry::AddCounter(std::string_view name)
+{
+    auto values{ Add(name, MetricType::Counter, 1) };
+    return values.empty() ? Counter{} : Counter{ values.front() };
+}
+
+Gauge MetricsRegistry::AddGauge(std::string_view name)
+{
+    auto values{ Add(name, MetricType::Gauge, 1) };
+    return values.empty() ? Gauge{} : Gauge{ values.front() };
+}
+
+Histogram MetricsRegistry::AddHistogram(std::string_view name)
+{
+    auto values{ Add(name, MetricType::Histogram, s_histogramSize) };
+    return values.empty() ? Histogram{} : Histogram{ values };
+}
+
+LatencyHistogram MetricsRegistry::AddLatencyHistogram(std::string_view name)
+{
+    auto values{ Add(name, MetricType::LatencyHistogram, s_latencySize) };
+    return values.empty() ? LatencyHistogram{} : LatencyHistogram{ values };
+}
+
+CounterArray MetricsRegistry::AddOpcodeCounters(std::string_view name)
+{
+    auto values{ Add(name, MetricType::OpcodeCounters, s_opcodeSlots) };
+    return values.empty() ? CounterArray{} : CounterArray{ values };
+}
+
+CounterArray MetricsRegistry::AddErrnoCounters(std::string_view name)
+{
+    auto values{ Add(name, MetricType::ErrnoCounters, s_errnoSlots) };
+    return values.empty() ? CounterArray{} : CounterArray{ values };
+}
+
+std::span<std::atomic<uint64_t>> MetricsRegistry::Add(std::string_view name, MetricType type, size_t size)
+{
+    const uint32_t count{ m_layout->m_metricCount.load(std::memory_order_relaxed) };
+    if (count == s_maxMetrics or m_valuesUsed + size > s_maxValues)
+    {
+        LOG_ERROR("metrics registry full. '{}' will not be published", name);
+        return {};
+    }
+
+    MetricDescriptor& descriptor{ m_layout->m_metrics[count] };
+    descriptor.m_name = {};
+    name.copy(descriptor.m_name.data(), descriptor.m_name.size() - 1);
+    descriptor.m_type = type;
+    descriptor.m_offset = m_valuesUsed;
+    descriptor.m_size = static_cast<uint32_t>(size);
+
+    std::span values{ m_layout->m_values.data() + m_valuesUsed, size };
+    m_valuesUsed += static_cast<uint32_t>(size);
+
+    // readers only look at described values once the count covers them
+    m_layout->m_metricCount.store(count + 1, std::memory_order_release);
+
+    return values;
+}
+
+} // namespace Sage::Metrics
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "metrics/metrics_layout.hpp"
+
+namespace Sage::Metrics
+{
+
+namespace Internal
+{
+
+// handles that were never registered, or didn't fit, write here
+inline std::array<std::atomic<uint64_t>, std::max({ s_errnoSlots, s_histogramSize, s_latencySize })> g_unregistered{};
+
+/// Every metric has a single writer, so updates skip the locked read-modify-write
+inline void Increment(std::atomic<uint64_t>& value, uint64_t by) noexcept
+{
+    value.store(value.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+} // namespace Internal
+
+class Counter
+{
+public:
+    Counter() = default;
+
+    void Add(uint64_t by = 1) noexcept { Internal::Increment(*m_value, by); }
+
+private:
+    explicit Counter(std::atomic<uint64_t>& value) : m_value{ &value } {}
+
+    std::atomic<uint64_t>* m_value{ &Internal::g_unregistered.front() };
+
+    friend class MetricsRegistry;
+};
+
+class Gauge
+{
+public:
+    Gauge() = default;
+
+    void Set(int64_t value) noexcept { m_value->store(static_cast<uint64_t>(value), std::memory_order_relaxed); }
+
+private:
+    explicit Gauge(std::atomic<uint64_t>& value) : m_value{ &value } {}
+
+    std::atomic<uint64_t>* m_value{ &Internal::g_unregistered.front() };
+
+    friend class MetricsRegistry;
+};
+
+/// Power of 2 buckets
+class Histogram
+{
+public:
+    Histogram() = default;
+
+    void Record(uint64_t value) noexcept
+    {
+        Internal::Increment(m_values[static_cast<size_t>(std::bit_width(value))], 1);
+        Internal::Increment(m_values[s_histogramBuckets], 1);
+        Internal::Increment(m_values[s_histogramBuckets + 1], value);
+    }
+
+private:
+    explicit Histogram(std::span<std::atomic<uint64_t>> values) : m_values{ values.data() } {}
+
+    std::atomic<uint64_t>* m_values{ Internal::g_unregistered.data() };
+
+    friend class MetricsRegistry;
+};
+
+/// Log-linear buckets, precise to ~6%, that percentiles can be read back from
+class LatencyHistogram
+{
+public:
+    LatencyHistogram() = default;
+
+    void Record(uint64_t ns) noexcept
+    {
+        Internal::Increment(m_values[LatencyBucket(ns)], 1);
+        Internal::Increment(m_values[s_latencyBuckets], 1);
+        Internal::Increment(m_values[s_latencyBuckets + 1], ns);
+        if (ns > m_values[s_latencyBuckets + 2].load(std::memory_order_relaxed))
+        {
+            m_values[s_latencyBuckets + 2].store(ns, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t Count() const noexcept { return m_values[s_latencyBuckets].load(std::memory_order_relaxed); }
+
+    uint64_t Max() const noexcept { return m_values[s_latencyBuckets + 2].load(std::memory_order_relaxed); }
+
+    /// @param percentile in [0, 100]
+    uint64_t Percentile(double percentile) const noexcept { return LatencyPercentile(m_values, percentile); }
+
+private:
+    explicit LatencyHistogram(std::span<std::atomic<uint64_t>> values) : m_values{ values.data() } {}
+
+    std::atomic<uint64_t>* m_values{ Internal::g_unregistered.data() };
+
+    friend class MetricsRegistry;
+};
+
+/// Counters indexed by opcode or errno. out of range indexes land in the last slot
+class CounterArray
+{
+public:
+    CounterArray() = default;
+
+    void Add(size_t index, uint64_t by = 1) noexcept { Internal::Increment(m_values[std::min(index, m_last)], by); }
+
+private:
+    explicit CounterArray(std::span<std::atomic<uint64_t>> values) :
+        m_values{ values.data() },
+        m_last{ values.size() - 1 }
+    {
+    }
+
+    std::atomic<uint64_t>* m_values{ Internal::g_unregistered.data() };
+    size_t m_last{ Internal::g_unregistered.size() - 1 };
+
+    friend class MetricsRegistry;
+};
+
+/**
+ * Metrics published in a shared memory file under /dev/shm so external tools can scrape them
+ * without involving the process. Falls back to private memory if the file can't be created.
+ * Registration isn't thread safe, updates are lock free
+ */
+class MetricsRegistry
+{
+public:
+    /// Publishes to /dev/shm/<program>.<pid>
+    MetricsRegistry();
+
+    ~MetricsRegistry();
+
+    /// Empty if the metrics aren't shared
+    const std::string& Path() const noexcept { return m_path; }
+
+    /// Removes the name from /dev/shm ahead of the destructor, for a process exiting without it.
+    /// Readers already attached keep their mapping
+    void Unpublish() noexcept;
+
+    Counter AddCounter(std::string_view name);
+
+    Gauge AddGauge(std::string_view name);
+
+    Histogram AddHistogram(std::string_view name);
+
+    LatencyHistogram AddLatencyHistogram(std::string_view name);
+
+    CounterArray AddOpcodeCounters(std::string_view name);
+
+    CounterArray AddErrnoCounters(std::string_view name);
+
+private:
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry(MetricsRegistry&&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(MetricsRegistry&&) = delete;
+
+    /// @returns an empty span if the registry is full
+    std::span<std::atomic<uint64_t>> Add(std::string_view name, MetricType type, size_t size);
+
+    Layout* m_layout{ nullptr };
+    std::string m_shmName;
+    std::string m_path;
+    uint32_t m_valuesUsed{ 0 };
+};
+
+} // namespace Sage::Metrics
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Layout of the shared memory metrics file. Shared with the metrics-reader tool.
+ *
+ * Descriptors are only ever appended. A reader loads m_metricCount with acquire ordering and can then
+ * read every described value without any further synchronisation.
+ */
+namespace Sage::Metrics
+{
+
+constexpr std::array<char, 8> s_magic{ 'S', 'A', 'G', 'E', 'M', 'E', 'T', 'R' };
+constexpr uint32_t s_version{ 1 };
+
+constexpr size_t s_maxMetrics{ 128 };
+constexpr size_t s_maxValues{ 8192 };
+constexpr size_t s_maxNameLength{ 48 };
+
+// bucket i counts values with a bit width of i, i.e. [2^(i-1), 2^i). followed by count and sum
+constexpr size_t s_histogramBuckets{ 65 };
+constexpr size_t s_histogramSize{ s_histogramBuckets + 2 };
+
+// log-linear latency buckets in ns. every power of 2 is split into 2^s_latencySubBucketBits linear buckets,
+// values below 2^(s_latencySubBucketBits + 1) are exact. followed by count, sum and max
+constexpr size_t s_latencySubBucketBits{ 4 };
+// ~68s. anything slower lands in the last bucket
+constexpr size_t s_latencyMaxBits{ 36 };
+constexpr size_t s_latencyBuckets{ (s_latencyMaxBits - s_latencySubBucketBits + 1) << s_latencySubBucketBits };
+constexpr size_t s_latencySize{ s_latencyBuckets + 3 };
+
+// indexed by io_uring opcode
+constexpr size_t s_opcodeSlots{ 64 };
+// indexed by errno
+constexpr size_t s_errnoSlots{ 256 };
+
+enum class MetricType : uint32_t
+{
+    Counter = 1,
+    Gauge,
+    Histogram,
+    OpcodeCounters,
+    ErrnoCounters,
+    LatencyHistogram,
+};
+
+struct MetricDescriptor
+{
+    std::array<char, s_maxNameLength> m_name;
+    MetricType m_type;
+    // into Layout::m_values
+    uint32_t m_offset;
+    uint32_t m_size;
+};
+
+struct Layout
+{
+    std::array<char, 8> m_magic;
+    uint32_t m_version;
+    int32_t m_pid;
+    std::atomic<uint32_t> m_metricCount;
+    std::array<MetricDescriptor, s_maxMetrics> m_metrics;
+    alignas(64) std::array<std::atomic<uint64_t>, s_maxValues> m_values;
+};
+
+constexpr size_t LatencyBucket(uint64_t value) noexcept
+{
+    value = std::min(value, (uint64_t{ 1 } << s_latencyMaxBits) - 1);
+    const int msb{ static_cast<int>(std::bit_width(value)) - 1 };
+    const int shift{ std::max(msb - static_cast<int>(s_latencySubBucketBits), 0) };
+    return (static_cast<size_t>(shift) << s_latencySubBucketBits) + static_cast<size_t>(value >> shift);
+}
+
+/// Highest value counted by a bucket
+constexpr uint64_t LatencyBucketUpperBound(size_t bucket) noexcept
+{
+    if (bucket < (size_t{ 2 } << s_latencySubBucketBits))
+    {
+        return bucket;
+    }
+
+    const size_t shift{ (bucket >> s_latencySubBucketBits) - 1 };
+    const uint64_t subBucket{ bucket - (shift << s_latencySubBucketBits) };
+    return ((subBucket + 1) << shift) - 1;
+}
+
+/// @param values the s_latencySize values of a latency histogram
+/// @param percentile in [0, 100]
+/// @returns the upper bound of the bucket the percentile falls in, capped to the max. 0 if nothing was recorded
+inline uint64_t LatencyPercentile(const std::atomic<uint64_t>* values, double percentile) noexcept
+{
+    const uint64_t count{ values[s_latencyBuckets].load(std::memory_order_relaxed) };
+    const uint64_t max{ values[s_latencyBuckets + 2].load(std::memory_order_relaxed) };
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    // 1 based rank of the sample the percentile falls on
+    const auto rank{ static_cast<uint64_t>(std::ceil(percentile / 100 * static_cast<double>(count))) };
+    uint64_t seen{ 0 };
+    for (size_t bucket{ 0 }; bucket < s_latencyBuckets; bucket++)
+    {
+        seen += values[bucket].load(std::memory_order_relaxed);
+        if (seen >= std::max(rank, uint64_t{ 1 }))
+        {
+            return std::min(LatencyBucketUpperBound(bucket), max);
+        }
+    }
+
+    // a concurrent reader can see the count ahead of the buckets
+    return max;
+}
+
+static_assert(LatencyBucket(31) == 31 and LatencyBucket(32) == 32 and LatencyBucket(34) == 33);
+static_assert(LatencyBucketUpperBound(LatencyBucket(1'000'000)) >= 1'000'000);
+static_assert(LatencyBucket(~uint64_t{ 0 }) == s_latencyBuckets - 1);
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "metrics are shared across processes");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "metrics are shared across processes");
+
+} // namespace Sage::Metrics
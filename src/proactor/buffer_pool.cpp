@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <new>
+#include <utility>
+
+#include "log/logger.hpp"
+#include "proactor/buffer_pool.hpp"
+
+namespace Sage
+{
+
+// The block's data follows directly after this header in the same allocation
+struct BufferHandle::Block
+{
+    BufferPool* m_pool;
+    Block* m_next;
+    size_t m_refs;
+
+    uint8_t* Data() noexcept { return reinterpret_cast<uint8_t*>(this + 1); }
+};
+
+// BufferHandle
+
+BufferHandle::BufferHandle(Block* block, size_t offset, size_t size) noexcept :
+    m_block{ block },
+    m_offset{ offset },
+    m_size{ size }
+{
+    m_block->m_refs++;
+}
+
+BufferHandle::BufferHandle(const BufferHandle& other) noexcept :
+    m_block{ other.m_block },
+    m_offset{ other.m_offset },
+    m_size{ other.m_size }
+{
+    if (m_block != nullptr)
+    {
+        m_block->m_refs++;
+    }
+}
+
+BufferHandle::BufferHandle(BufferHandle&& other) noexcept :
+    m_block{ std::exchange(other.m_block, nullptr) },
+    m_offset{ std::exchange(other.m_offset, 0) },
+    m_size{ std::exchange(other.m_size, 0) }
+{
+}
+
+BufferHandle& BufferHandle::operator=(const BufferHandle& other) noexcept
+{
+    if (this != &other)
+    {
+        BufferHandle copy{ other };
+        *this = std::move(copy);
+    }
+
+    return *this;
+}
+
+BufferHandle& BufferHandle::operator=(BufferHandle&& other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+        m_block = std::exchange(other.m_block, nullptr);
+        m_offset = std::exchange(other.m_offset, 0);
+        m_size = std::exchange(other.m_size, 0);
+    }
+
+    return *this;
+}
+
+BufferHandle::~BufferHandle() { Release(); }
+
+uint8_t* BufferHandle::Data() const noexcept { return m_block == nullptr ? nullptr : m_block->Data() + m_offset; }
+
+BufferHandle BufferHandle::Slice(size_t offset, size_t length) const noexcept
+{
+    if (m_block == nullptr)
+    {
+        return {};
+    }
+
+    offset = std::min(offset, m_size);
+    length = std::min(length, m_size - offset);
+    return BufferHandle{ m_block, m_offset + offset, length };
+}
+
+size_t BufferHandle::UseCount() const noexcept { return m_block == nullptr ? 0 : m_block->m_refs; }
+
+void BufferHandle::Release() noexcept
+{
+    if (m_block == nullptr)
+    {
+        return;
+    }
+
+    if (--m_block->m_refs == 0)
+    {
+        m_block->m_pool->Release(m_block);
+    }
+
+    m_block = nullptr;
+    m_offset = 0;
+    m_size = 0;
+}
+
+// BufferPool
+
+BufferPool::BufferPool(size_t blockSize, size_t maxFreeBlocks) :
+    m_blockSize{ blockSize },
+    m_maxFreeBlocks{ maxFreeBlocks }
+{
+}
+
+BufferPool::~BufferPool()
+{
+    if (m_stats.m_blocksInUse != 0)
+    {
+        LOG_CRITICAL("buffer pool destroyed with {} block(s) still in use", m_stats.m_blocksInUse);
+    }
+
+    while (m_freeList != nullptr)
+    {
+        FreeBlock(std::exchange(m_freeList, m_freeList->m_next));
+    }
+}
+
+BufferHandle BufferPool::Acquire()
+{
+    BufferHandle::Block* block{ m_freeList };
+    if (block != nullptr)
+    {
+        m_freeList = block->m_next;
+        m_stats.m_blocksFree--;
+    }
+    else
+    {
+        void* mem{ ::operator new(sizeof(BufferHandle::Block) + m_blockSize) };
+        block = new (mem) BufferHandle::Block{ .m_pool = this, .m_next = nullptr, .m_refs = 0 };
+        m_stats.m_blocksAllocated++;
+    }
+
+    m_stats.m_blocksInUse++;
+    m_stats.m_acquires++;
+
+    return BufferHandle{ block, 0, m_blockSize };
+}
+
+void BufferPool::Release(BufferHandle::Block* block) noexcept
+{
+    m_stats.m_blocksInUse--;
+
+    if (m_stats.m_blocksFree >= m_maxFreeBlocks)
+    {
+        FreeBlock(block);
+        m_stats.m_blocksAllocated--;
+        return;
+    }
+
+    block->m_next = m_freeList;
+    m_freeList = block;
+    m_stats.m_blocksFree++;
+}
+
+void BufferPool::FreeBlock(BufferHandle::Block* block) noexcept
+{
+    block->~Block();
+    ::operator delete(block);
+}
+
+} // namespace Sage
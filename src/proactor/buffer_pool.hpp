@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace Sage
+{
+
+class BufferPool;
+
+/// Immutable payload that many sends can reference without copying
+using SharedPayload = std::shared_ptr<const std::string>;
+
+/**
+ * Reference counted view onto a pooled buffer.
+ * Copies and slices share the same memory. The buffer goes back to its pool once the last handle is dropped.
+ * Not thread safe, handles must stay on the proactor thread and must not outlive their pool.
+ */
+class BufferHandle
+{
+public:
+    BufferHandle() = default;
+
+    BufferHandle(const BufferHandle& other) noexcept;
+
+    BufferHandle(BufferHandle&& other) noexcept;
+
+    BufferHandle& operator=(const BufferHandle& other) noexcept;
+
+    BufferHandle& operator=(BufferHandle&& other) noexcept;
+
+    ~BufferHandle();
+
+    uint8_t* Data() const noexcept;
+
+    size_t Size() const noexcept { return m_size; }
+
+    bool Empty() const noexcept { return m_size == 0; }
+
+    std::span<uint8_t> Span() const noexcept { return { Data(), m_size }; }
+
+    std::string_view View() const noexcept { return { reinterpret_cast<const char*>(Data()), m_size }; }
+
+    /// @returns a handle sharing the same buffer. clamped to this handle's range
+    BufferHandle Slice(size_t offset, size_t length) const noexcept;
+
+    size_t UseCount() const noexcept;
+
+    explicit operator bool() const noexcept { return m_block != nullptr; }
+
+private:
+    struct Block;
+
+    BufferHandle(Block* block, size_t offset, size_t size) noexcept;
+
+    void Release() noexcept;
+
+    Block* m_block{ nullptr };
+    size_t m_offset{ 0 };
+    size_t m_size{ 0 };
+
+    friend class BufferPool;
+};
+
+class BufferPool final
+{
+public:
+    struct Stats
+    {
+        size_t m_blocksAllocated{ 0 };
+        size_t m_blocksInUse{ 0 };
+        size_t m_blocksFree{ 0 };
+        size_t m_acquires{ 0 };
+    };
+
+    /// @param maxFreeBlocks blocks beyond this are freed instead of being kept for reuse
+    BufferPool(size_t blockSize, size_t maxFreeBlocks);
+
+    ~BufferPool();
+
+    /// @returns a handle spanning a whole block. slice it down to the bytes actually used
+    BufferHandle Acquire();
+
+    size_t BlockSize() const noexcept { return m_blockSize; }
+
+    const Stats& GetStats() const noexcept { return m_stats; }
+
+private:
+    BufferPool(const BufferPool&) = delete;
+    BufferPool(BufferPool&&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+    BufferPool& operator=(BufferPool&&) = delete;
+
+    void Release(BufferHandle::Block* block) noexcept;
+
+    static void FreeBlock(BufferHandle::Block* block) noexcept;
+
+    const size_t m_blockSize;
+    const size_t m_maxFreeBlocks;
+    BufferHandle::Block* m_freeList{ nullptr };
+    Stats m_stats{};
+
+    friend class BufferHandle;
+};
+
+} // namespace Sage
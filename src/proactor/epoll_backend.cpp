@@ -0,0 +1,852 @@
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <span>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "log/logger.hpp"
+#include "proactor/epoll_backend.hpp"
+
+namespace Sage
+{
+
+namespace
+{
+
+/// The syscall's result, or -errno as a completion carries it
+template <typename Syscall>
+int RetryInterrupted(Syscall&& syscall)
+{
+    while (true)
+    {
+        const auto res{ syscall() };
+        if (res >= 0)
+        {
+            return static_cast<int>(res);
+        }
+        if (int err{ errno }; err != EINTR)
+        {
+            return -err;
+        }
+    }
+}
+
+} // namespace
+
+EpollBackend::EpollBackend() : m_epollFd{ ::epoll_create1(EPOLL_CLOEXEC) }
+{
+    if (m_epollFd == -1)
+    {
+        int err{ errno };
+        LOG_CRITICAL("failed to create epoll instance. {}", strerror(err));
+        throw std::runtime_error{ "Epoll Init Failed" };
+    }
+
+    LOG_INFO("epoll backend created");
+}
+
+EpollBackend::~EpollBackend()
+{
+    for (const auto& [_, timerFd] : m_timers)
+    {
+        ::close(timerFd);
+    }
+    ::close(m_epollFd);
+}
+
+UniqueUringCEvent EpollBackend::WaitForEvent()
+{
+    LOG_TRACE("Waiting for events to populate");
+
+    if (m_completions.empty())
+    {
+        m_handedOut = 0;
+        if (not WaitAndDispatch(-1) or m_completions.empty())
+        {
+            return nullptr;
+        }
+    }
+    // ops completing straight away would otherwise keep the ready queue from ever emptying
+    else if (++m_handedOut % s_pollEvery == 0 and not WaitAndDispatch(0))
+    {
+        return nullptr;
+    }
+
+    const Completion& completion{ m_completions.front() };
+    m_current->user_data = completion.m_data;
+    m_current->res = completion.m_res;
+    m_current->flags = completion.m_flags;
+    m_completions.pop_front();
+
+    // nothing to release. the next wait overwrites it
+    return UniqueUringCEvent{ m_current.get(), [](io_uring_cqe*) {} };
+}
+
+void EpollBackend::AttachMetrics(Metrics::MetricsRegistry& registry)
+{
+    m_opsSubmitted = registry.AddOpcodeCounters("ops_submitted");
+    m_waitCalls = registry.AddCounter("epoll_waits");
+}
+
+bool EpollBackend::QueueNop(const UserData& data)
+{
+    Submitted(data, IORING_OP_NOP);
+    Complete(data, 0);
+
+    return true;
+}
+
+bool EpollBackend::QueueTimeoutEvent(const UserData& data, const TimeNS& timeout)
+{
+    Submitted(data, IORING_OP_TIMEOUT);
+
+    const int timerFd{ ::timerfd_create(CLOCK_BOOTTIME, TFD_NONBLOCK | TFD_CLOEXEC) };
+    if (timerFd == -1)
+    {
+        int err{ errno };
+        LOG_ERROR("failed to create timer. {}", strerror(err));
+        return false;
+    }
+    ForgetFd(timerFd);
+
+    // a zero period would disarm the timer
+    const timespec period{ ChronoTimeToTimeSpec(std::max(timeout, TimeNS{ 1 })) };
+    const itimerspec spec{ .it_interval = period, .it_value = period };
+    if (::timerfd_settime(timerFd, 0, &spec, nullptr) != 0)
+    {
+        int err{ errno };
+        LOG_ERROR("failed to arm timer. {}", strerror(err));
+        ::close(timerFd);
+        return false;
+    }
+
+    m_timers[data] = timerFd;
+    Wait(timerFd, Op{ .m_type = OpType::Timeout, .m_data = data }, false);
+
+    return true;
+}
+
+bool EpollBackend::CancelTimeoutEvent(const UserData& cancelData, const UserData& timeoutData)
+{
+    Submitted(cancelData, IORING_OP_TIMEOUT_REMOVE);
+
+    auto itr{ m_timers.find(timeoutData) };
+    if (itr == m_timers.end())
+    {
+        Complete(cancelData, -ENOENT);
+        return true;
+    }
+
+    // closing the timer drops it from epoll
+    const int timerFd{ itr->second };
+    m_timers.erase(itr);
+    m_waiters.erase(timerFd);
+    ::close(timerFd);
+
+    Complete(timeoutData, -ECANCELED);
+    Complete(cancelData, 0);
+
+    return true;
+}
+
+bool EpollBackend::UpdateTimeoutEvent(const UserData& updateData, const UserData& timeoutData, const TimeNS& timeout)
+{
+    Submitted(updateData, IORING_OP_TIMEOUT_REMOVE);
+
+    auto itr{ m_timers.find(timeoutData) };
+    if (itr == m_timers.end())
+    {
+        Complete(updateData, -ENOENT);
+        return true;
+    }
+
+    const timespec period{ ChronoTimeToTimeSpec(std::max(timeout, TimeNS{ 1 })) };
+    const itimerspec spec{ .it_interval = period, .it_value = period };
+    Complete(updateData, ::timerfd_settime(itr->second, 0, &spec, nullptr) == 0 ? 0 : -errno);
+
+    return true;
+}
+
+bool EpollBackend::QueueSignalRead(const UserData& data, int fd, signalfd_siginfo& readBuff)
+{
+    return QueueRead(data, fd, std::span{ reinterpret_cast<uint8_t*>(&readBuff), sizeof(readBuff) });
+}
+
+bool EpollBackend::QueueRead(const UserData& data, int fd, std::span<uint8_t> buffer)
+{
+    Submitted(data, IORING_OP_READ);
+    // the fd may be blocking, so nothing is read before it's reported readable
+    Wait(fd, Op{ .m_type = OpType::Read, .m_data = data, .m_buffer = buffer }, false);
+
+    return true;
+}
+
+int EpollBackend::QueueTcpConnect(const UserData& data, const std::string& host, const std::string& port)
+{
+    Submitted(data, IORING_OP_CONNECT);
+
+    struct addrinfo hints{};
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* res{ nullptr };
+
+    if (int err{ getaddrinfo(host.c_str(), port.c_str(), &hints, &res) }; err != 0 or res == nullptr)
+    {
+        LOG_ERROR("failed to create socket. res-nullptr?{} e={}", res == nullptr, gai_strerror(err));
+        return -1;
+    }
+
+    const int sockFd{ ::socket(res->ai_family, res->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, res->ai_protocol) };
+    if (sockFd == -1)
+    {
+        int err{ errno };
+        freeaddrinfo(res);
+        LOG_ERROR("failed to create socket. e={}", strerror(err));
+        return -1;
+    }
+    ForgetFd(sockFd);
+
+    const int err{ ::connect(sockFd, res->ai_addr, res->ai_addrlen) == 0 ? 0 : errno };
+    freeaddrinfo(res);
+
+    // the result is reported through the completion, as with io_uring
+    if (err == EINPROGRESS)
+    {
+        Wait(sockFd, Op{ .m_type = OpType::Connect, .m_data = data }, true);
+    }
+    else
+    {
+        Complete(data, -err);
+    }
+
+    return sockFd;
+}
+
+bool EpollBackend::QueueTcpSend(const UserData& data, int fd, std::string_view buffer)
+{
+    Submitted(data, IORING_OP_SEND);
+
+    Op op{ .m_type = OpType::Send, .m_data = data, .m_unsent = buffer };
+
+    // sends on a socket go out in order. only one with nothing queued ahead of it can go straight away
+    auto itr{ m_waiters.find(fd) };
+    if ((itr == m_waiters.end() or itr->second.m_writers.empty()) and TrySend(fd, op))
+    {
+        return true;
+    }
+
+    Wait(fd, std::move(op), true);
+
+    return true;
+}
+
+bool EpollBackend::QueueSendMsg(const UserData& data, int fd, const msghdr& message)
+{
+    Submitted(data, IORING_OP_SENDMSG);
+
+    Op op{ .m_type = OpType::SendMsg, .m_data = data, .m_message = &message };
+
+    auto itr{ m_waiters.find(fd) };
+    if ((itr == m_waiters.end() or itr->second.m_writers.empty()) and TrySend(fd, op))
+    {
+        return true;
+    }
+
+    Wait(fd, std::move(op), true);
+
+    return true;
+}
+
+bool EpollBackend::QueueTcpRecv(const UserData& data, int fd, std::span<uint8_t> rxBuffer)
+{
+    Submitted(data, IORING_OP_RECV);
+
+    auto itr{ m_waiters.find(fd) };
+    if (itr == m_waiters.end() or itr->second.m_readers.empty())
+    {
+        const ssize_t rxBytes{ ::recv(fd, rxBuffer.data(), rxBuffer.size(), MSG_DONTWAIT) };
+        const int err{ rxBytes < 0 ? errno : 0 };
+        if (err != EAGAIN and err != EWOULDBLOCK and err != EINTR)
+        {
+            Complete(data, rxBytes < 0 ? -err : static_cast<int>(rxBytes));
+            return true;
+        }
+    }
+
+    Wait(fd, Op{ .m_type = OpType::Recv, .m_data = data, .m_buffer = rxBuffer }, false);
+
+    return true;
+}
+
+bool EpollBackend::QueueRecvMsg(const UserData& data, int fd, msghdr& message)
+{
+    Submitted(data, IORING_OP_RECVMSG);
+
+    Op op{ .m_type = OpType::RecvMsg, .m_data = data, .m_rxMessage = &message };
+
+    auto itr{ m_waiters.find(fd) };
+    if ((itr == m_waiters.end() or itr->second.m_readers.empty()) and TryRecvMsg(fd, op))
+    {
+        return true;
+    }
+
+    Wait(fd, std::move(op), false);
+
+    return true;
+}
+
+bool EpollBackend::QueueAccept(const UserData& data, int listenFd)
+{
+    Submitted(data, IORING_OP_ACCEPT);
+    // keeps accepting until cancelled, as multishot accept does
+    Wait(listenFd, Op{ .m_type = OpType::Accept, .m_data = data }, false);
+
+    return true;
+}
+
+bool EpollBackend::QueueConnect(const UserData& data, int fd, const sockaddr& address, socklen_t addressLen)
+{
+    Submitted(data, IORING_OP_CONNECT);
+    ForgetFd(fd);
+
+    int err{ EINTR };
+    while (err == EINTR)
+    {
+        err = ::connect(fd, &address, addressLen) == 0 ? 0 : errno;
+    }
+
+    if (err == EINPROGRESS)
+    {
+        Wait(fd, Op{ .m_type = OpType::Connect, .m_data = data }, true);
+    }
+    else
+    {
+        Complete(data, -err);
+    }
+
+    return true;
+}
+
+bool EpollBackend::QueueSplice(const UserData& data, int fdIn, int64_t offsetIn, int fdOut, uint32_t len)
+{
+    Submitted(data, IORING_OP_SPLICE);
+
+    // completes straight away either way, as a non-blocking splice on the ring does
+    loff_t offset{ offsetIn };
+    ssize_t res{ -1 };
+    int err{ EINTR };
+    while (res < 0 and err == EINTR)
+    {
+        res = ::splice(
+            fdIn, offsetIn < 0 ? nullptr : &offset, fdOut, nullptr, len, SPLICE_F_MOVE | SPLICE_F_NONBLOCK
+        );
+        err = res < 0 ? errno : 0;
+    }
+    Complete(data, res < 0 ? -err : static_cast<int>(res));
+
+    return true;
+}
+
+bool EpollBackend::QueuePoll(const UserData& data, int fd, uint32_t events)
+{
+    Submitted(data, IORING_OP_POLL_ADD);
+    Wait(fd, Op{ .m_type = OpType::PollOnce, .m_data = data }, (events & POLLOUT) != 0);
+
+    return true;
+}
+
+bool EpollBackend::QueueOpen(const UserData& data, const char* path, int flags, mode_t mode)
+{
+    Submitted(data, IORING_OP_OPENAT);
+    Complete(data, RetryInterrupted([&] { return ::open(path, flags | O_CLOEXEC, mode); }));
+
+    return true;
+}
+
+bool EpollBackend::QueueReadAt(const UserData& data, int fd, std::span<uint8_t> buffer, uint64_t offset)
+{
+    Submitted(data, IORING_OP_READ);
+    Complete(data, RetryInterrupted([&] {
+                 return ::pread(fd, buffer.data(), buffer.size(), static_cast<off_t>(offset));
+             }));
+
+    return true;
+}
+
+bool EpollBackend::QueueWriteAt(const UserData& data, int fd, std::span<const uint8_t> buffer, uint64_t offset)
+{
+    Submitted(data, IORING_OP_WRITE);
+    Complete(data, RetryInterrupted([&] {
+                 return ::pwrite(fd, buffer.data(), buffer.size(), static_cast<off_t>(offset));
+             }));
+
+    return true;
+}
+
+bool EpollBackend::QueueFsync(const UserData& data, int fd, bool dataOnly)
+{
+    Submitted(data, IORING_OP_FSYNC);
+    Complete(data, RetryInterrupted([&] { return dataOnly ? ::fdatasync(fd) : ::fsync(fd); }));
+
+    return true;
+}
+
+bool EpollBackend::QueueStatx(const UserData& data, int fd, struct statx& statxBuf)
+{
+    Submitted(data, IORING_OP_STATX);
+    Complete(data, RetryInterrupted([&] { return ::statx(fd, "", AT_EMPTY_PATH, STATX_BASIC_STATS, &statxBuf); }));
+
+    return true;
+}
+
+bool EpollBackend::QueuePollIn(const UserData& data, int fd)
+{
+    Submitted(data, IORING_OP_POLL_ADD);
+
+    m_polls[data] = fd;
+    Wait(fd, Op{ .m_type = OpType::Poll, .m_data = data }, false);
+
+    return true;
+}
+
+bool EpollBackend::CancelPoll(const UserData& cancelData, const UserData& pollData)
+{
+    Submitted(cancelData, IORING_OP_POLL_REMOVE);
+
+    auto itr{ m_polls.find(pollData) };
+    if (itr == m_polls.end())
+    {
+        Complete(cancelData, -ENOENT);
+        return true;
+    }
+
+    const int fd{ itr->second };
+    m_polls.erase(itr);
+    if (auto waiters{ m_waiters.find(fd) }; waiters != m_waiters.end())
+    {
+        std::erase_if(waiters->second.m_readers, [pollData](const Op& op) { return op.m_data == pollData; });
+        UpdateInterest(fd);
+    }
+
+    Complete(pollData, -ECANCELED);
+    Complete(cancelData, 0);
+
+    return true;
+}
+
+bool EpollBackend::CancelOp(const UserData& cancelData, const UserData& targetData)
+{
+    // counted as the timeout or poll remove they're handled as
+    if (m_timers.contains(targetData))
+    {
+        return CancelTimeoutEvent(cancelData, targetData);
+    }
+
+    if (m_polls.contains(targetData))
+    {
+        return CancelPoll(cancelData, targetData);
+    }
+
+    Submitted(cancelData, IORING_OP_ASYNC_CANCEL);
+
+    for (auto& [waitingFd, waiters] : m_waiters)
+    {
+        for (std::deque<Op>* ops : { &waiters.m_readers, &waiters.m_writers })
+        {
+            auto itr{ std::ranges::find(*ops, targetData, &Op::m_data) };
+            if (itr == ops->end())
+            {
+                continue;
+            }
+
+            // may drop the fd's entry
+            const int fd{ waitingFd };
+            ops->erase(itr);
+            UpdateInterest(fd);
+
+            Complete(targetData, -ECANCELED);
+            Complete(cancelData, 0);
+            return true;
+        }
+    }
+
+    Complete(cancelData, -ENOENT);
+    return true;
+}
+
+void EpollBackend::Complete(UserData data, int res, uint32_t flags)
+{
+    m_completions.push_back(Completion{ .m_data = data, .m_res = res, .m_flags = flags });
+}
+
+void EpollBackend::Submitted(UserData data, uint8_t opcode)
+{
+    m_opsSubmitted.Add(opcode);
+
+    if (m_tracer != nullptr) [[unlikely]]
+    {
+        m_tracer->Trace(TracePhase::Submit, data, 0, opcode);
+    }
+}
+
+bool EpollBackend::WaitAndDispatch(int timeoutMs)
+{
+    std::array<epoll_event, s_maxEvents> events;
+
+    m_waitCalls.Add();
+    const int ready{ ::epoll_wait(m_epollFd, events.data(), static_cast<int>(events.size()), timeoutMs) };
+    if (ready < 0)
+    {
+        int err{ errno };
+        // Ignore interrupts. i.e debugger pause / suspend
+        if (err != EINTR)
+        {
+            LOG_ERROR("failed to wait for events. {}", strerror(err));
+        }
+        return false;
+    }
+
+    for (const epoll_event& event : std::span{ events.data(), static_cast<size_t>(ready) })
+    {
+        const int fd{ event.data.fd };
+        auto itr{ m_waiters.find(fd) };
+        if (itr == m_waiters.end())
+        {
+            continue;
+        }
+
+        // errors and hang ups are picked up by whichever ops are waiting
+        if ((event.events & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0)
+        {
+            HandleReadable(fd, itr->second);
+        }
+
+        if ((event.events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) != 0)
+        {
+            HandleWritable(fd, itr->second);
+        }
+
+        UpdateInterest(fd);
+    }
+
+    return true;
+}
+
+void EpollBackend::Wait(int fd, Op&& op, bool write)
+{
+    FdWaiters& waiters{ m_waiters[fd] };
+    (write ? waiters.m_writers : waiters.m_readers).push_back(std::move(op));
+    UpdateInterest(fd);
+}
+
+void EpollBackend::HandleReadable(int fd, FdWaiters& waiters)
+{
+    while (not waiters.m_readers.empty())
+    {
+        Op& op{ waiters.m_readers.front() };
+        switch (op.m_type)
+        {
+            // keep firing until cancelled. expiries the loop was too slow for complete one after the other
+            case OpType::Timeout:
+            {
+                uint64_t expirations{ 0 };
+                if (::read(fd, &expirations, sizeof(expirations)) == static_cast<ssize_t>(sizeof(expirations)))
+                {
+                    for (; expirations > 0; expirations--)
+                    {
+                        Complete(op.m_data, -ETIME, IORING_CQE_F_MORE);
+                    }
+                }
+                return;
+            }
+
+            // keeps reporting until cancelled
+            case OpType::Poll:
+            {
+                Complete(op.m_data, POLLIN, IORING_CQE_F_MORE);
+                return;
+            }
+
+            // the fd may be blocking. one read per readiness report
+            case OpType::PollOnce:
+            {
+                Complete(op.m_data, POLLIN);
+                waiters.m_readers.pop_front();
+                break;
+            }
+
+            case OpType::Read:
+            {
+                const ssize_t res{ ::read(fd, op.m_buffer.data(), op.m_buffer.size()) };
+                const int err{ res < 0 ? errno : 0 };
+                if (err == EAGAIN or err == EINTR)
+                {
+                    return;
+                }
+
+                Complete(op.m_data, res < 0 ? -err : static_cast<int>(res));
+                waiters.m_readers.pop_front();
+                return;
+            }
+
+            case OpType::Recv:
+            {
+                const ssize_t res{ ::recv(fd, op.m_buffer.data(), op.m_buffer.size(), MSG_DONTWAIT) };
+                const int err{ res < 0 ? errno : 0 };
+                if (err == EAGAIN or err == EWOULDBLOCK or err == EINTR)
+                {
+                    return;
+                }
+
+                Complete(op.m_data, res < 0 ? -err : static_cast<int>(res));
+                waiters.m_readers.pop_front();
+                break;
+            }
+
+            case OpType::RecvMsg:
+            {
+                if (not TryRecvMsg(fd, op))
+                {
+                    return;
+                }
+
+                waiters.m_readers.pop_front();
+                break;
+            }
+
+            case OpType::Accept:
+            {
+                if (DrainAccepts(fd, op))
+                {
+                    return;
+                }
+
+                waiters.m_readers.pop_front();
+                break;
+            }
+
+            case OpType::Connect:
+            case OpType::Send:
+            case OpType::SendMsg:
+            {
+                LOG_ERROR("write op waiting for fd({}) to become readable", fd);
+                waiters.m_readers.pop_front();
+                break;
+            }
+        }
+    }
+}
+
+void EpollBackend::HandleWritable(int fd, FdWaiters& waiters)
+{
+    while (not waiters.m_writers.empty())
+    {
+        Op& op{ waiters.m_writers.front() };
+        if (op.m_type == OpType::PollOnce)
+        {
+            Complete(op.m_data, POLLOUT);
+        }
+        else if (op.m_type == OpType::Connect)
+        {
+            int err{ 0 };
+            socklen_t errLen{ sizeof(err) };
+            if (::getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &errLen) != 0)
+            {
+                err = errno;
+            }
+            Complete(op.m_data, -err);
+        }
+        else if (not TrySend(fd, op))
+        {
+            return;
+        }
+
+        waiters.m_writers.pop_front();
+    }
+}
+
+bool EpollBackend::TrySend(int fd, Op& op)
+{
+    // a datagram goes out whole or not at all
+    if (op.m_type == OpType::SendMsg)
+    {
+        ssize_t txBytes{ -1 };
+        int err{ EINTR };
+        while (txBytes < 0 and err == EINTR)
+        {
+            txBytes = ::sendmsg(fd, op.m_message, MSG_DONTWAIT | MSG_NOSIGNAL);
+            err = txBytes < 0 ? errno : 0;
+        }
+
+        if (err == EAGAIN or err == EWOULDBLOCK)
+        {
+            return false;
+        }
+
+        Complete(op.m_data, txBytes < 0 ? -err : static_cast<int>(txBytes));
+        return true;
+    }
+
+    while (not op.m_unsent.empty())
+    {
+        const ssize_t txBytes{ ::send(fd, op.m_unsent.data(), op.m_unsent.size(), MSG_DONTWAIT | MSG_NOSIGNAL) };
+        if (txBytes < 0)
+        {
+            const int err{ errno };
+            if (err == EINTR)
+            {
+                continue;
+            }
+
+            if (err == EAGAIN or err == EWOULDBLOCK)
+            {
+                return false;
+            }
+
+            Complete(op.m_data, -err);
+            return true;
+        }
+
+        op.m_sent += static_cast<int>(txBytes);
+        op.m_unsent.remove_prefix(static_cast<size_t>(txBytes));
+    }
+
+    Complete(op.m_data, op.m_sent);
+    return true;
+}
+
+bool EpollBackend::TryRecvMsg(int fd, Op& op)
+{
+    ssize_t rxBytes{ -1 };
+    int err{ EINTR };
+    while (rxBytes < 0 and err == EINTR)
+    {
+        rxBytes = ::recvmsg(fd, op.m_rxMessage, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+        err = rxBytes < 0 ? errno : 0;
+    }
+
+    if (err == EAGAIN or err == EWOULDBLOCK)
+    {
+        return false;
+    }
+
+    Complete(op.m_data, rxBytes < 0 ? -err : static_cast<int>(rxBytes));
+    return true;
+}
+
+bool EpollBackend::DrainAccepts(int fd, const Op& op)
+{
+    while (true)
+    {
+        const int acceptedFd{ ::accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC) };
+        if (acceptedFd >= 0)
+        {
+            ForgetFd(acceptedFd);
+            Complete(op.m_data, acceptedFd, IORING_CQE_F_MORE);
+            continue;
+        }
+
+        const int err{ errno };
+        if (err == EAGAIN or err == EWOULDBLOCK)
+        {
+            return true;
+        }
+
+        // the connection went away before it was accepted
+        if (err == EINTR or err == ECONNABORTED)
+        {
+            continue;
+        }
+
+        Complete(op.m_data, -err);
+        return false;
+    }
+}
+
+void EpollBackend::UpdateInterest(int fd)
+{
+    auto itr{ m_waiters.find(fd) };
+    if (itr == m_waiters.end())
+    {
+        return;
+    }
+
+    FdWaiters& waiters{ itr->second };
+    const uint32_t events{ (waiters.m_readers.empty() ? 0U : static_cast<uint32_t>(EPOLLIN)) |
+                           (waiters.m_writers.empty() ? 0U : static_cast<uint32_t>(EPOLLOUT)) };
+
+    if (events == 0)
+    {
+        // the fd may already be closed, which drops it from epoll anyway
+        if (waiters.m_events != 0)
+        {
+            ::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        }
+        m_waiters.erase(itr);
+        return;
+    }
+
+    if (events == waiters.m_events)
+    {
+        return;
+    }
+
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+
+    int res{ ::epoll_ctl(m_epollFd, waiters.m_events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &event) };
+    // closing an fd drops it from epoll unnoticed, and a new fd with the same number may already be registered
+    if (res != 0 and errno == ENOENT)
+    {
+        res = ::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+    else if (res != 0 and errno == EEXIST)
+    {
+        res = ::epoll_ctl(m_epollFd, EPOLL_CTL_MOD, fd, &event);
+    }
+
+    if (res == 0)
+    {
+        waiters.m_events = events;
+        return;
+    }
+
+    // e.g. regular files, which epoll doesn't support. nothing waiting would ever complete
+    int err{ errno };
+    LOG_ERROR("failed to watch fd({}). {}", fd, strerror(err));
+    for (const Op& op : waiters.m_readers)
+    {
+        Complete(op.m_data, -err);
+    }
+    for (const Op& op : waiters.m_writers)
+    {
+        Complete(op.m_data, -err);
+    }
+    m_waiters.erase(itr);
+}
+
+void EpollBackend::ForgetFd(int fd)
+{
+    if (auto itr{ m_waiters.find(fd) }; itr != m_waiters.end())
+    {
+        LOG_DEBUG(
+            "dropping {} op(s) left waiting on a closed fd({})",
+            itr->second.m_readers.size() + itr->second.m_writers.size(),
+            fd
+        );
+        m_waiters.erase(itr);
+    }
+
+    std::erase_if(m_polls, [fd](const auto& entry) { return entry.second == fd; });
+}
+
+} // namespace Sage
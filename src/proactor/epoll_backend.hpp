@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <liburing.h>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <sys/signalfd.h>
+#include <unordered_map>
+
+#include "metrics/metrics.hpp"
+#include "proactor/io_backend.hpp"
+#include "timing/time.hpp"
+
+namespace Sage
+{
+
+/**
+ * Emulates io_uring's completions with epoll readiness and timerfd timers, for hosts without io_uring and to
+ * measure what it buys. Ops are attempted straight away where that can't block and otherwise wait for their fd
+ * in the order they were queued. Completions carry what io_uring would have posted: bytes or -errno, -ETIME with
+ * IORING_CQE_F_MORE for firing timers, and the ready mask with IORING_CQE_F_MORE for polls. Files are always
+ * ready as far as epoll is concerned, so file ops run synchronously as they're queued, blocking the loop
+ */
+class EpollBackend final : public IOBackend
+{
+public:
+    EpollBackend();
+
+    ~EpollBackend() override;
+
+    BackendType Type() const noexcept override { return BackendType::Epoll; }
+
+    UniqueUringCEvent WaitForEvent() override;
+
+    void AttachMetrics(Metrics::MetricsRegistry& registry) override;
+
+    Occupancy GetOccupancy() const noexcept override
+    {
+        return Occupancy{ 0, static_cast<uint>(m_completions.size()) };
+    }
+
+    bool QueueNop(const UserData& data) override;
+
+    bool QueueTimeoutEvent(const UserData& data, const TimeNS& timeout) override;
+
+    bool CancelTimeoutEvent(const UserData& cancelData, const UserData& timeoutData) override;
+
+    bool UpdateTimeoutEvent(const UserData& updateData, const UserData& timeoutData, const TimeNS& timeout) override;
+
+    bool QueueSignalRead(const UserData& data, int fd, signalfd_siginfo& readBuff) override;
+
+    bool QueueRead(const UserData& data, int fd, std::span<uint8_t> buffer) override;
+
+    int QueueTcpConnect(const UserData& data, const std::string& host, const std::string& port) override;
+
+    bool QueueTcpSend(const UserData& data, int fd, std::string_view buffer) override;
+
+    bool QueueTcpRecv(const UserData& data, int fd, std::span<uint8_t> rxBuffer) override;
+
+    bool QueuePollIn(const UserData& data, int fd) override;
+
+    bool CancelPoll(const UserData& cancelData, const UserData& pollData) override;
+
+    bool CancelOp(const UserData& cancelData, const UserData& targetData) override;
+
+    /// Provided buffers and so multishot recvmsg aren't emulated. the capabilities say as much
+    bool AddBufferGroup(uint16_t, std::span<uint8_t>, uint32_t) override { return false; }
+
+    void RemoveBufferGroup(uint16_t) override {}
+
+    void ReturnBuffer(uint16_t, uint16_t) override {}
+
+    bool QueueRecvMsg(const UserData&, int, const msghdr&, uint16_t) override { return false; }
+
+    bool QueueSendMsg(const UserData& data, int fd, const msghdr& message) override;
+
+    bool QueueRecvMsg(const UserData& data, int fd, msghdr& message) override;
+
+    bool QueueAccept(const UserData& data, int listenFd) override;
+
+    bool QueueConnect(const UserData& data, int fd, const sockaddr& address, socklen_t addressLen) override;
+
+    bool QueueSplice(const UserData& data, int fdIn, int64_t offsetIn, int fdOut, uint32_t len) override;
+
+    bool QueuePoll(const UserData& data, int fd, uint32_t events) override;
+
+    bool QueueOpen(const UserData& data, const char* path, int flags, mode_t mode) override;
+
+    bool QueueReadAt(const UserData& data, int fd, std::span<uint8_t> buffer, uint64_t offset) override;
+
+    bool QueueWriteAt(const UserData& data, int fd, std::span<const uint8_t> buffer, uint64_t offset) override;
+
+    bool QueueFsync(const UserData& data, int fd, bool dataOnly) override;
+
+    bool QueueStatx(const UserData& data, int fd, struct statx& statxBuf) override;
+
+private:
+    EpollBackend(const EpollBackend&) = delete;
+    EpollBackend(EpollBackend&&) = delete;
+    EpollBackend& operator=(const EpollBackend&) = delete;
+    EpollBackend& operator=(EpollBackend&&) = delete;
+
+    enum class OpType : uint8_t
+    {
+        Timeout,
+        Read,
+        Connect,
+        Send,
+        SendMsg,
+        Recv,
+        RecvMsg,
+        Accept,
+        Poll,
+        // single shot, for readability or writability
+        PollOnce,
+    };
+
+    struct Op
+    {
+        OpType m_type;
+        UserData m_data;
+        // reads and recvs
+        std::span<uint8_t> m_buffer{};
+        // sends. what's left to send
+        std::string_view m_unsent{};
+        int m_sent{ 0 };
+        const msghdr* m_message{ nullptr };
+        // single shot recvmsg
+        msghdr* m_rxMessage{ nullptr };
+    };
+
+    struct Completion
+    {
+        UserData m_data;
+        int m_res;
+        uint32_t m_flags;
+    };
+
+    /// Ops waiting on one fd, oldest first
+    struct FdWaiters
+    {
+        std::deque<Op> m_readers;
+        std::deque<Op> m_writers;
+        // the interest currently registered with epoll
+        uint32_t m_events{ 0 };
+    };
+
+    void Complete(UserData data, int res, uint32_t flags = 0);
+
+    /// Counted and traced as the io_uring op it emulates
+    void Submitted(UserData data, uint8_t opcode);
+
+    /// Queues the completions of ops whose fds became ready within timeoutMs, -1 blocking
+    /// @returns false if waiting failed
+    bool WaitAndDispatch(int timeoutMs);
+
+    void Wait(int fd, Op&& op, bool write);
+
+    void HandleReadable(int fd, FdWaiters& waiters);
+
+    void HandleWritable(int fd, FdWaiters& waiters);
+
+    /// @returns false if the op must keep waiting
+    bool TrySend(int fd, Op& op);
+
+    /// @returns false if the op must keep waiting
+    bool TryRecvMsg(int fd, Op& op);
+
+    /// Completes every connection waiting to be accepted
+    /// @returns false once the op has completed for good
+    bool DrainAccepts(int fd, const Op& op);
+
+    /// Registers the interest the remaining waiters need, dropping the fd once there are none
+    void UpdateInterest(int fd);
+
+    /// A newly created fd can't have anything waiting on it. anything left is from a closed fd with the same number
+    void ForgetFd(int fd);
+
+    static constexpr size_t s_maxEvents{ 256 };
+    // completions handed out between checks for ready fds while completions are still queued
+    static constexpr size_t s_pollEvery{ 64 };
+
+    int m_epollFd{ -1 };
+    std::unordered_map<int, FdWaiters> m_waiters;
+    // timeout user data -> timerfd
+    std::unordered_map<UserData, int> m_timers;
+    // poll user data -> polled fd
+    std::unordered_map<UserData, int> m_polls;
+    std::deque<Completion> m_completions;
+    // the completion handed out by WaitForEvent. a cqe ends in a flexible array so can't be held by value
+    std::unique_ptr<io_uring_cqe> m_current{ std::make_unique<io_uring_cqe>() };
+    size_t m_handedOut{ 0 };
+    Metrics::CounterArray m_opsSubmitted;
+    Metrics::Counter m_waitCalls;
+};
+
+} // namespace Sage
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <bit>
+#include <format>
+#include <fstream>
+#include <print>
+#include <unistd.h>
+#include <unordered_map>
+
+#include "log/logger.hpp"
+#include "proactor/event_tracer.hpp"
+#include "proactor/opcode_name.hpp"
+
+namespace Sage
+{
+
+void EventTracer::Enable(size_t capacity)
+{
+    m_records.resize(std::bit_ceil(std::max(capacity, size_t{ 1 })));
+    m_mask = m_records.size() - 1;
+    m_next = 0;
+    m_enabled = true;
+
+    LOG_INFO("event tracing enabled. keeping the last {} record(s)", m_records.size());
+}
+
+bool EventTracer::WriteChromeTrace(const std::string& path) const
+{
+    std::ofstream file{ path, std::ios::out | std::ios::trunc };
+    if (not file)
+    {
+        LOG_ERROR("unable to write the event trace to '{}'", path);
+        return false;
+    }
+
+    struct Op
+    {
+        std::string m_name;
+        // a completion ends the op unless it already has. later multishot completions are instants
+        bool m_open;
+    };
+
+    // by event id, from each event's last submission
+    std::unordered_map<uint64_t, Op> ops;
+    auto opName = [&ops](uint64_t eventId) -> std::string_view
+    {
+        auto itr{ ops.find(eventId) };
+        return itr == ops.end() ? std::string_view{ "unknown" } : std::string_view{ itr->second.m_name };
+    };
+
+    const int pid{ ::getpid() };
+    const uint64_t count{ std::min<uint64_t>(m_next, m_records.size()) };
+    std::string_view separator{ "" };
+    // the oldest records may have been overwritten mid callback
+    bool callbackOpen{ false };
+
+    std::print(file, "{{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+    for (uint64_t i{ m_next - count }; i != m_next; i++)
+    {
+        const Record& record{ m_records[i & m_mask] };
+        // in µs
+        const std::string ts{ std::format("{}.{:03}", record.m_ns / 1000, record.m_ns % 1000) };
+        const std::string common{ std::format("\"pid\":{},\"tid\":{},\"ts\":{}", pid, pid, ts) };
+
+        switch (record.m_phase)
+        {
+            case TracePhase::Submit:
+            {
+                std::string_view name{ GetOpcodeName(record.m_opcode) };
+                auto& op{ ops[record.m_eventId] };
+                op.m_name = name.empty() ? std::format("op{}", record.m_opcode) : std::string{ name };
+                op.m_open = true;
+
+                std::print(
+                    file,
+                    "{}\n{{\"name\":\"{}\",\"cat\":\"op\",\"ph\":\"b\",\"id\":{},{},\"args\":{{\"event\":{}}}}}",
+                    separator,
+                    op.m_name,
+                    record.m_eventId,
+                    common,
+                    record.m_eventId
+                );
+                break;
+            }
+
+            case TracePhase::Complete:
+            {
+                auto itr{ ops.find(record.m_eventId) };
+                const bool ends{ itr != ops.end() and itr->second.m_open };
+                if (ends)
+                {
+                    itr->second.m_open = false;
+                }
+
+                std::print(
+                    file,
+                    "{}\n{{\"name\":\"{}\",\"cat\":\"op\",\"ph\":\"{}\",\"id\":{},{},\"args\":{{\"event\":{},"
+                    "\"handler\":{},\"res\":{}}}}}",
+                    separator,
+                    opName(record.m_eventId),
+                    ends ? "e" : "n",
+                    record.m_eventId,
+                    common,
+                    record.m_eventId,
+                    record.m_handlerId,
+                    record.m_res
+                );
+                break;
+            }
+
+            case TracePhase::CallbackBegin:
+                callbackOpen = true;
+                std::print(
+                    file,
+                    "{}\n{{\"name\":\"{}\",\"cat\":\"callback\",\"ph\":\"B\",{},\"args\":{{\"event\":{},"
+                    "\"handler\":{},\"res\":{}}}}}",
+                    separator,
+                    opName(record.m_eventId),
+                    common,
+                    record.m_eventId,
+                    record.m_handlerId,
+                    record.m_res
+                );
+                break;
+
+            case TracePhase::CallbackEnd:
+                if (not callbackOpen)
+                {
+                    continue;
+                }
+                callbackOpen = false;
+                std::print(file, "{}\n{{\"ph\":\"E\",{}}}", separator, common);
+                break;
+        }
+
+        separator = ",";
+    }
+
+    std::println(file, "\n]}}");
+    file.flush();
+
+    if (not file)
+    {
+        LOG_ERROR("failed writing the event trace to '{}'", path);
+        return false;
+    }
+
+    LOG_INFO("wrote {} trace record(s) to '{}'", count, path);
+    return true;
+}
+
+} // namespace Sage
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "timing/time.hpp"
+
+namespace Sage
+{
+
+enum class TracePhase : uint8_t
+{
+    Submit = 0,
+    Complete,
+    CallbackBegin,
+    CallbackEnd,
+};
+
+/**
+ * Opt-in record of every event's submission, completion and callback, to see how the loop interleaved them.
+ * Records go into a ring allocated up front and owned by the loop thread. The oldest are overwritten.
+ * While disabled tracing costs a single branch
+ */
+class EventTracer
+{
+public:
+    struct Record
+    {
+        int64_t m_ns;
+        uint64_t m_eventId;
+        uint64_t m_handlerId;
+        int32_t m_res;
+        // only known on submission. completions and callbacks are matched up by event id
+        uint8_t m_opcode;
+        TracePhase m_phase;
+    };
+
+    /// Rounded up to a power of 2
+    void Enable(size_t capacity);
+
+    bool Enabled() const noexcept { return m_enabled; }
+
+    void Trace(TracePhase phase, uint64_t eventId, uint64_t handlerId = 0, uint8_t opcode = 0, int res = 0) noexcept
+    {
+        if (not m_enabled) [[likely]]
+        {
+            return;
+        }
+
+        m_records[m_next++ & m_mask] = Record{
+            .m_ns = Clock::now().time_since_epoch().count(),
+            .m_eventId = eventId,
+            .m_handlerId = handlerId,
+            .m_res = res,
+            .m_opcode = opcode,
+            .m_phase = phase,
+        };
+    }
+
+    /// Chrome trace-event JSON. opens in chrome://tracing or ui.perfetto.dev
+    /// @returns false if the file couldn't be written
+    bool WriteChromeTrace(const std::string& path) const;
+
+private:
+    bool m_enabled{ false };
+    std::vector<Record> m_records;
+    size_t m_mask{ 0 };
+    uint64_t m_next{ 0 };
+};
+
+} // namespace Sage
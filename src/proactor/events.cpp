@@ -0,0 +1,37 @@
+#include <cstddef>
+#include <memory_resource>
+
+#include "proactor/events.hpp"
+
+namespace Sage
+{
+
+namespace
+{
+
+/**
+ * Intentionally leaking here.
+ * Events may still be released during global object destruction
+ */
+std::pmr::unsynchronized_pool_resource* const g_eventPool{ new std::pmr::unsynchronized_pool_resource };
+Event::PoolStats g_eventPoolStats{};
+
+} // namespace
+
+void* Event::operator new(size_t size)
+{
+    void* ptr{ g_eventPool->allocate(size, alignof(std::max_align_t)) };
+    g_eventPoolStats.m_allocations++;
+    g_eventPoolStats.m_live++;
+    return ptr;
+}
+
+void Event::operator delete(void* ptr, size_t size) noexcept
+{
+    g_eventPoolStats.m_live--;
+    g_eventPool->deallocate(ptr, size, alignof(std::max_align_t));
+}
+
+const Event::PoolStats& Event::GetPoolStats() noexcept { return g_eventPoolStats; }
+
+} // namespace Sage
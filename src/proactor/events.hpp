@@ -7,6 +7,7 @@
 #include <sys/signalfd.h>
 
 #include "proactor/handle.hpp"
+#include "timing/time.hpp"
 #include "utils/demangled_name.hpp"
 
 namespace Sage
@@ -19,14 +20,32 @@ class Event
 public:
     using OnCompleteFunc = std::move_only_function<void(Event&, const io_uring_cqe&)>;
 
+    struct PoolStats
+    {
+        size_t m_allocations{ 0 };
+        size_t m_live{ 0 };
+    };
+
     virtual ~Event() noexcept = default;
 
     std::string NameAndType() const { return DemangleTypeName(*this); }
 
+    // Events are created and destroyed for every op so they come from a pool rather than the heap.
+    // Only to be used from the proactor thread
+    static void* operator new(size_t size);
+
+    static void operator delete(void* ptr, size_t size) noexcept;
+
+    static const PoolStats& GetPoolStats() noexcept;
+
     const EventId m_id{ NextId() };
     const Handle::Id m_handlerId;
     OnCompleteFunc m_onCompleteCb;
     bool m_removeOnComplete{ true };
+    // completes more than once per submission. those completions wait on a peer or the clock, they aren't timed
+    bool m_multishot{ false };
+    // events are queued as soon as they're created. moved on by each completion of a re-queued op
+    Clock::time_point m_submitTime{ Clock::now() };
 
 protected:
     Event(Handle::Id handlerId, OnCompleteFunc&& onComplete) noexcept :
@@ -46,6 +65,4 @@ private:
     }
 };
 
-
-
 } // namespace Sage
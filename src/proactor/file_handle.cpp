@@ -0,0 +1,117 @@
+#include "proactor/file_handle.hpp"
+#include "log/logger.hpp"
+#include "proactor/proactor.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <unistd.h>
+
+namespace Sage
+{
+
+AlignedBuffer AllocateAligned(size_t size, size_t alignment)
+{
+    const size_t rounded{ (std::max(size, size_t{ 1 }) + alignment - 1) / alignment * alignment };
+    auto* data{ static_cast<uint8_t*>(std::aligned_alloc(alignment, rounded)) };
+    if (data == nullptr)
+    {
+        throw std::bad_alloc{};
+    }
+    return AlignedBuffer{ data };
+}
+
+FileHandle::FileHandle(std::string_view name, const std::string& path, const Options& options) :
+    m_name{ name },
+    m_path{ path },
+    m_options{ options }
+{
+    LOG_DEBUG("[{}] c'tor path({}) queue-depth({}) direct({})", Name(), path, options.m_queueDepth, options.m_direct);
+    Proactor::Instance().AddFileHandle(*this);
+}
+
+FileHandle::~FileHandle()
+{
+    LOG_DEBUG("[{}] d'tor", Name());
+    Proactor::Instance().RemoveFileHandle(*this);
+
+    if (m_inFlight > 0)
+    {
+        LOG_WARNING("[{}] closed with ops({}) in flight", Name(), m_inFlight);
+    }
+
+    // ops in flight hold their own reference to the file, closing the fd doesn't end them
+    if (m_fd != -1 and ::close(m_fd) != 0)
+    {
+        int err{ errno };
+        LOG_ERROR("[{}] failed to close fd({}). {}", Name(), m_fd, strerror(err));
+    }
+}
+
+bool FileHandle::Read(std::span<uint8_t> buffer, uint64_t offset, FileCompleteFunc&& onComplete)
+{
+    if (not Accepts(buffer.data(), buffer.size(), offset))
+    {
+        return false;
+    }
+
+    Proactor::Instance().RequestFileRead(*this, buffer, offset, std::move(onComplete));
+    return true;
+}
+
+bool FileHandle::Write(std::span<const uint8_t> buffer, uint64_t offset, FileCompleteFunc&& onComplete)
+{
+    if (not Accepts(buffer.data(), buffer.size(), offset))
+    {
+        return false;
+    }
+
+    Proactor::Instance().RequestFileWrite(*this, buffer, offset, std::move(onComplete));
+    return true;
+}
+
+bool FileHandle::Sync(FileCompleteFunc&& onComplete, bool dataOnly)
+{
+    if (not Accepts(nullptr, 0, 0))
+    {
+        return false;
+    }
+
+    Proactor::Instance().RequestFileSync(*this, dataOnly, std::move(onComplete));
+    return true;
+}
+
+bool FileHandle::Stat(FileStatFunc&& onStat)
+{
+    if (not Accepts(nullptr, 0, 0))
+    {
+        return false;
+    }
+
+    Proactor::Instance().RequestFileStat(*this, std::move(onStat));
+    return true;
+}
+
+bool FileHandle::Accepts(const void* data, size_t size, uint64_t offset) const noexcept
+{
+    if (m_state == Closed)
+    {
+        LOG_ERROR_RATE_LIMITED(10, "[{}] file op while closed", Name());
+        return false;
+    }
+
+    if (m_options.m_direct and
+        (reinterpret_cast<uintptr_t>(data) % s_directAlignment != 0 or size % s_directAlignment != 0 or
+         offset % s_directAlignment != 0))
+    {
+        LOG_ERROR_RATE_LIMITED(
+            10, "[{}] direct file op not aligned to {}B. size({}) offset({})", Name(), s_directAlignment, size, offset
+        );
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace Sage
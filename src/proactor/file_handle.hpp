@@ -0,0 +1,151 @@
+#pragma once
+
+#include "proactor/handle.hpp"
+#include "proactor/proactor.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <fcntl.h>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <sys/stat.h>
+
+namespace Sage
+{
+
+enum class FileOpKind : uint8_t
+{
+    Open = 0,
+    Read,
+    Write,
+    Sync,
+    Stat,
+};
+
+class FileOp final : public Event
+{
+public:
+    FileOp(Handle::Id handlerId, OnCompleteFunc&& onComplete, FileOpKind kind) :
+        Event{ handlerId, std::move(onComplete) },
+        m_kind{ kind }
+    {
+    }
+
+    FileOpKind m_kind;
+    // opens only. lives with the op so the path outlives a handle destroyed mid open
+    std::string m_path{};
+    int m_flags{ 0 };
+    mode_t m_mode{ 0 };
+    // reads into the first, writes from the second. caller owned
+    std::span<uint8_t> m_rxBuffer{};
+    std::span<const uint8_t> m_txBuffer{};
+    uint64_t m_offset{ 0 };
+    bool m_dataOnly{ false };
+    struct statx m_stat{};
+    FileCompleteFunc m_onComplete{};
+    FileStatFunc m_onStat{};
+};
+
+// what O_DIRECT needs buffers, offsets and sizes aligned to. the logical block size on most devices is smaller
+constexpr size_t s_directAlignment{ 4096 };
+
+struct AlignedFree
+{
+    void operator()(uint8_t* data) const noexcept { std::free(data); }
+};
+
+using AlignedBuffer = std::unique_ptr<uint8_t[], AlignedFree>;
+
+/// size is rounded up to a multiple of alignment. Throws std::bad_alloc
+AlignedBuffer AllocateAligned(size_t size, size_t alignment = s_directAlignment);
+
+/**
+ * A file read, written, synced and stat'd through the proactor's ring, each op completing through the loop like
+ * any other event. At most the queue depth of ops are in flight, more wait their turn in the order they're made,
+ * as do ops made before the open completes. Ops in flight together complete in any order and a sync only covers
+ * writes that have completed. Buffers are the caller's and must stay valid until their op completes, they go
+ * through as fixed buffers where they lie within memory registered with Proactor::RegisterFileBuffers
+ */
+class FileHandle
+{
+public:
+    enum State
+    {
+        Opening = 0,
+        Open,
+        Closed,
+    };
+
+    struct Options
+    {
+        // O_RDONLY, O_WRONLY or O_RDWR along with the likes of O_CREAT and O_TRUNC
+        int m_flags{ O_RDONLY };
+        mode_t m_mode{ 0644 };
+        // bypasses the page cache. buffers, offsets and sizes must then be aligned to s_directAlignment
+        bool m_direct{ false };
+        size_t m_queueDepth{ 32 };
+    };
+
+    FileHandle(std::string_view name, const std::string& path, const Options& options);
+
+    /// Ops still in flight complete without their callbacks
+    virtual ~FileHandle();
+
+    std::string_view Name() const noexcept { return m_name; }
+
+    const std::string& Path() const noexcept { return m_path; }
+
+    State GetState() const noexcept { return m_state; }
+
+    /// -1 until open
+    int Fd() const noexcept { return m_fd; }
+
+    size_t InFlight() const noexcept { return m_inFlight; }
+
+    size_t Queued() const noexcept { return m_queue.size(); }
+
+    /// Completes with the bytes read, fewer than asked for at the end of the file, and 0 past it
+    /// @returns false if closed or misaligned for O_DIRECT
+    bool Read(std::span<uint8_t> buffer, uint64_t offset, FileCompleteFunc&& onComplete);
+
+    /// Completes with the bytes written, which can be fewer than asked for
+    /// @returns false if closed or misaligned for O_DIRECT
+    bool Write(std::span<const uint8_t> buffer, uint64_t offset, FileCompleteFunc&& onComplete);
+
+    /// dataOnly skips metadata that isn't needed to read the data back, as fdatasync does
+    bool Sync(FileCompleteFunc&& onComplete, bool dataOnly = true);
+
+    bool Stat(FileStatFunc&& onStat);
+
+protected:
+    /// The file opened (0) or couldn't be (-errno), in which case the ops waiting on it fail with the same error
+    virtual void OnOpen(int /*res*/) {}
+
+private:
+    FileHandle() = delete;
+    FileHandle(const FileHandle&) = delete;
+    FileHandle(FileHandle&&) = delete;
+    FileHandle& operator=(const FileHandle&) = delete;
+    FileHandle& operator=(FileHandle&&) = delete;
+
+    /// @returns false if closed or misaligned for O_DIRECT
+    bool Accepts(const void* data, size_t size, uint64_t offset) const noexcept;
+
+    const std::string m_name;
+    const std::string m_path;
+    const Options m_options;
+    const Handle::Id m_id{ Handle::NextId() };
+    int m_fd{ -1 };
+    State m_state{ Opening };
+    bool m_openPending{ false };
+    size_t m_inFlight{ 0 };
+    // waiting for the open or for the queue depth to allow them
+    std::deque<std::unique_ptr<FileOp>> m_queue;
+
+    friend class Proactor;
+};
+
+} // namespace Sage
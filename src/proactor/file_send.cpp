@@ -0,0 +1,35 @@
+#include "proactor/file_send.hpp"
+#include "log/logger.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+namespace Sage
+{
+
+FileSend::FileSend(
+    FileSendId id, Handle::Id clientId, std::string_view name, int fileFd, int socketFd, std::array<int, 2> pipe
+) :
+    m_id{ id },
+    m_clientId{ clientId },
+    m_name{ name },
+    m_fileFd{ fileFd },
+    m_socketFd{ socketFd },
+    m_pipe{ pipe }
+{
+}
+
+FileSend::~FileSend()
+{
+    for (int fd : { m_socketFd, m_pipe[0], m_pipe[1] })
+    {
+        if (::close(fd) != 0)
+        {
+            int err{ errno };
+            LOG_ERROR("[{}] failed to close file send fd({}). {}", Name(), fd, strerror(err));
+        }
+    }
+}
+
+} // namespace Sage
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "proactor/handle.hpp"
+#include "proactor/proactor.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace Sage
+{
+
+enum class FileSendLeg : uint8_t
+{
+    // from the file into the pipe
+    Fill = 0,
+    // out of the pipe to the socket
+    Drain,
+};
+
+class FileSendSplice final : public Event
+{
+public:
+    FileSendSplice(
+        Handle::Id handlerId, OnCompleteFunc&& onComplete, FileSendId sendId, FileSendLeg leg, uint8_t opcode
+    ) :
+        Event{ handlerId, std::move(onComplete) },
+        m_sendId{ sendId },
+        m_leg{ leg },
+        m_opcode{ opcode }
+    {
+    }
+
+    FileSendId m_sendId;
+    FileSendLeg m_leg;
+    // a splice, or a poll waiting for the socket to have room for one
+    uint8_t m_opcode;
+};
+
+class FileSendCancel final : public Event
+{
+public:
+    FileSendCancel(Handle::Id handlerId, OnCompleteFunc&& onComplete) : Event{ handlerId, std::move(onComplete) } {}
+};
+
+/**
+ * A file streaming to a client's socket through a pipe of its own, a chunk spliced in from the file while what's
+ * already in the pipe is spliced out to the socket. The pipe is all the memory a send holds, however large the
+ * file, and a socket without room stops the filling once the pipe is full. A non-blocking socket without room is
+ * polled, a blocking one has the drain wait for room in the kernel
+ */
+struct FileSend
+{
+    /// Takes ownership of socketFd and the pipe
+    FileSend(
+        FileSendId id, Handle::Id clientId, std::string_view name, int fileFd, int socketFd, std::array<int, 2> pipe
+    );
+
+    ~FileSend();
+
+    FileSend(const FileSend&) = delete;
+    FileSend(FileSend&&) = delete;
+    FileSend& operator=(const FileSend&) = delete;
+    FileSend& operator=(FileSend&&) = delete;
+
+    std::string_view Name() const noexcept { return m_name; }
+
+    const FileSendId m_id;
+    const Handle::Id m_clientId;
+    const std::string m_name;
+    const int m_fileFd;
+    // a duplicate of the client's, so a reconnect reusing the fd number never receives the rest
+    const int m_socketFd;
+    // read end, write end
+    const std::array<int, 2> m_pipe;
+    size_t m_capacity{ 0 };
+    uint32_t m_chunkSize{ 0 };
+    // where the next chunk is read from, and where the send ends
+    uint64_t m_offset{ 0 };
+    uint64_t m_end{ 0 };
+    uint64_t m_total{ 0 };
+    // in the pipe, waiting to be drained
+    size_t m_buffered{ 0 };
+    uint64_t m_sent{ 0 };
+    bool m_filling{ false };
+    bool m_draining{ false };
+    // the splice or poll in flight per leg, 0 for none. cancelled when the send finishes early
+    std::array<EventId, 2> m_inFlight{};
+    // the pipe ran out of slots before bytes. a drain frees them
+    bool m_stalled{ false };
+    FileSendCompleteFunc m_onComplete;
+    FileSendProgressFunc m_onProgress;
+};
+
+} // namespace Sage
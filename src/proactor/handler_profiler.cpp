@@ -0,0 +1,109 @@
+#include <algorithm>
+
+#include "proactor/handler_profiler.hpp"
+
+namespace Sage
+{
+
+std::string_view GetCallbackName(HandlerCallback callback) noexcept
+{
+    switch (callback)
+    {
+        case HandlerCallback::TimerExpired:
+            return "OnTimerExpired";
+        case HandlerCallback::Connect:
+            return "OnConnect";
+        case HandlerCallback::Receive:
+            return "OnReceive";
+        case HandlerCallback::Close:
+            return "OnClose";
+        case HandlerCallback::Open:
+            return "OnOpen";
+        case HandlerCallback::FileRead:
+            return "OnRead";
+        case HandlerCallback::FileWrite:
+            return "OnWrite";
+        case HandlerCallback::FileSync:
+            return "OnSync";
+        case HandlerCallback::FileStat:
+            return "OnStat";
+        case HandlerCallback::FileSendProgress:
+            return "OnFileSendProgress";
+        case HandlerCallback::FileSendComplete:
+            return "OnFileSendComplete";
+    }
+
+    return "Unknown";
+}
+
+void HandlerProfiler::Collect()
+{
+    for (Handle::Id id : m_retiring)
+    {
+        auto itr{ m_profiles.find(id) };
+        if (itr == m_profiles.end())
+        {
+            continue;
+        }
+
+        const HandlerProfile& profile{ itr->second };
+        auto retired{ m_retired.find(profile.m_name) };
+        if (retired == m_retired.end())
+        {
+            const std::string name{ m_retired.size() < s_maxRetiredNames ? profile.m_name : s_otherRetiredName };
+            retired = m_retired.try_emplace(name).first;
+            retired->second.m_name = name;
+        }
+        Fold(retired->second, profile);
+
+        m_profiles.erase(itr);
+    }
+
+    m_retiring.clear();
+}
+
+void HandlerProfiler::Fold(HandlerProfile& into, const HandlerProfile& from) noexcept
+{
+    for (size_t callback{ 0 }; callback < from.m_callbacks.size(); callback++)
+    {
+        into.m_callbacks[callback].Merge(from.m_callbacks[callback]);
+    }
+}
+
+std::vector<HandlerProfiler::Entry> HandlerProfiler::Top(size_t n) const
+{
+    std::vector<Entry> entries;
+    auto collect = [&entries](const HandlerProfile& handler)
+    {
+        for (size_t callback{ 0 }; callback < handler.m_callbacks.size(); callback++)
+        {
+            const CallbackProfile& profile{ handler.m_callbacks[callback] };
+            if (profile.m_calls != 0)
+            {
+                entries.push_back(Entry{ handler.m_name, static_cast<HandlerCallback>(callback), &profile });
+            }
+        }
+    };
+
+    for (const auto& [_, handler] : m_profiles)
+    {
+        collect(handler);
+    }
+    for (const auto& [_, handler] : m_retired)
+    {
+        collect(handler);
+    }
+
+    n = std::min(n, entries.size());
+    std::partial_sort(
+        entries.begin(),
+        entries.begin() + static_cast<ptrdiff_t>(n),
+        entries.end(),
+        [](const Entry& lhs, const Entry& rhs) { return lhs.m_profile->m_total > rhs.m_profile->m_total; }
+    );
+    entries.resize(n);
+
+    return entries;
+}
+
+} // namespace Sage
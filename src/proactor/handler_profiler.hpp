@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "proactor/handle.hpp"
+#include "timing/callback_profile.hpp"
+
+namespace Sage
+{
+
+enum class HandlerCallback : uint8_t
+{
+    TimerExpired = 0,
+    Connect,
+    Receive,
+    Close,
+    // FileHandle
+    Open,
+    FileRead,
+    FileWrite,
+    FileSync,
+    FileStat,
+    // SendFile, against the client sent to
+    FileSendProgress,
+    FileSendComplete,
+};
+
+constexpr size_t s_handlerCallbacks{ 11 };
+
+std::string_view GetCallbackName(HandlerCallback callback) noexcept;
+
+/// Time spent in every handler callback, keyed by handler id.
+/// Profiles outlive their handlers, a handler may remove itself from within a profiled callback. Once retired
+/// they're folded into one profile per handler name, so handlers coming and going don't grow the profiler
+class HandlerProfiler
+{
+public:
+    struct Entry
+    {
+        std::string_view m_handlerName;
+        HandlerCallback m_callback;
+        const CallbackProfile* m_profile;
+    };
+
+    struct Target
+    {
+        // owned by the profiler, safe to log after the handler is gone
+        std::string_view m_handlerName;
+        CallbackProfile& m_profile;
+    };
+
+    /// The name is only copied the first time a handler is seen
+    Target Get(Handle::Id id, std::string_view name, HandlerCallback callback)
+    {
+        auto [itr, inserted]{ m_profiles.try_emplace(id) };
+        if (inserted)
+        {
+            itr->second.m_name = name;
+        }
+        return Target{ itr->second.m_name, itr->second.m_callbacks[static_cast<size_t>(callback)] };
+    }
+
+    /// The handler is gone. Its profile is folded in by the next Collect
+    void Retire(Handle::Id id) { m_retiring.push_back(id); }
+
+    /// Folds the retired handlers' profiles into those of their names. Not from within a profiled callback
+    void Collect();
+
+    /// @returns up to n callbacks that were called, the most total time first
+    std::vector<Entry> Top(size_t n) const;
+
+private:
+    struct HandlerProfile
+    {
+        std::string m_name;
+        std::array<CallbackProfile, s_handlerCallbacks> m_callbacks;
+    };
+
+    // names beyond this many share a single profile
+    static constexpr size_t s_maxRetiredNames{ 256 };
+    static constexpr std::string_view s_otherRetiredName{ "(other retired)" };
+
+    static void Fold(HandlerProfile& into, const HandlerProfile& from) noexcept;
+
+    std::unordered_map<Handle::Id, HandlerProfile> m_profiles;
+    std::vector<Handle::Id> m_retiring;
+    // keyed by handler name
+    std::unordered_map<std::string, HandlerProfile> m_retired;
+};
+
+} // namespace Sage
@@ -0,0 +1,79 @@
+#include <stdexcept>
+
+#include "log/logger.hpp"
+#include "proactor/epoll_backend.hpp"
+#include "proactor/io_backend.hpp"
+#include "proactor/io_uring.hpp"
+#include "proactor/recording_backend.hpp"
+#include "proactor/replay_backend.hpp"
+
+namespace Sage
+{
+
+std::string_view GetBackendTypeName(BackendType type) noexcept
+{
+    switch (type)
+    {
+        case BackendType::IOURing:
+            return "io_uring";
+        case BackendType::Epoll:
+            return "epoll";
+        case BackendType::Replay:
+            return "replay";
+    }
+
+    return "Unknown";
+}
+
+std::optional<BackendType> ParseBackendType(std::string_view name) noexcept
+{
+    for (const auto type : { BackendType::IOURing, BackendType::Epoll })
+    {
+        if (name == GetBackendTypeName(type))
+        {
+            return type;
+        }
+    }
+
+    return std::nullopt;
+}
+
+namespace
+{
+
+std::unique_ptr<IOBackend> CreateLiveBackend(BackendType type, uint queueSize)
+{
+    if (type == BackendType::IOURing)
+    {
+        try
+        {
+            return std::make_unique<IOURing>(queueSize);
+        }
+        catch (const std::runtime_error& e)
+        {
+            LOG_WARNING("io_uring unavailable. falling back to epoll. {}", e.what());
+        }
+    }
+
+    return std::make_unique<EpollBackend>();
+}
+
+} // namespace
+
+std::unique_ptr<IOBackend> CreateBackend(const BackendOptions& options)
+{
+    if (options.m_type == BackendType::Replay)
+    {
+        return std::make_unique<ReplayBackend>(options.m_replayFile);
+    }
+
+    auto backend{ CreateLiveBackend(options.m_type, options.m_queueSize) };
+    if (not options.m_recordFile.empty())
+    {
+        return std::make_unique<RecordingBackend>(std::move(backend), options.m_recordFile);
+    }
+
+    return backend;
+}
+
+} // namespace Sage
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <liburing.h>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "metrics/metrics.hpp"
+#include "proactor/event_tracer.hpp"
+#include "proactor/io_uring_capabilities.hpp"
+#include "timing/time.hpp"
+
+namespace Sage
+{
+
+using UniqueUringCEvent = std::unique_ptr<io_uring_cqe, std::function<void(io_uring_cqe*)>>;
+
+enum class BackendType : uint8_t
+{
+    IOURing = 0,
+    Epoll,
+    // completes ops from a recorded trace
+    Replay,
+};
+
+std::string_view GetBackendTypeName(BackendType type) noexcept;
+
+/// Accepts the names GetBackendTypeName returns, bar replay which needs a trace
+std::optional<BackendType> ParseBackendType(std::string_view name) noexcept;
+
+struct BackendOptions
+{
+    BackendType m_type{ BackendType::IOURing };
+    uint m_queueSize{ 10'000 };
+    // submissions and completions are recorded to it when set
+    std::string m_recordFile{};
+    // the trace to replay when the type is replay
+    std::string m_replayFile{};
+};
+
+/**
+ * The async ops the proactor is built on. Every op completes with an io_uring completion carrying the
+ * caller's user data, whichever backend runs it, so completion handling doesn't depend on the backend
+ */
+class IOBackend
+{
+public:
+    // usually an id to reference against a map
+    using UserData = decltype(io_uring_sqe{}.user_data);
+
+    struct Stats
+    {
+        // times the kernel flagged completions as backlogged in the overflow list
+        size_t m_cqOverflows{ 0 };
+        // completions the kernel could not post at all. their events will never complete
+        size_t m_cqDropped{ 0 };
+        // times no submission entry was available
+        size_t m_sqFull{ 0 };
+        size_t m_resizes{ 0 };
+        size_t m_resizeFailures{ 0 };
+        uint m_sqEntries{ 0 };
+        uint m_cqEntries{ 0 };
+    };
+
+    /// Entries queued but not yet submitted, and completions not yet seen
+    struct Occupancy
+    {
+        uint m_sqQueued{ 0 };
+        uint m_cqReady{ 0 };
+    };
+
+    IOBackend() = default;
+
+    virtual ~IOBackend() = default;
+
+    virtual BackendType Type() const noexcept = 0;
+
+    /// Blocks until an op completes. nullptr if interrupted
+    virtual UniqueUringCEvent WaitForEvent() = 0;
+
+    /// Flushes any completions the kernel has backlogged due to the completion queue being full
+    /// @returns completions the kernel dropped since the last flush. their ops never complete
+    virtual size_t FlushOverflow() { return 0; }
+
+    /// Grows or shrinks the queues to fit the number of in-flight operations
+    virtual void AdaptCapacity(size_t /*inFlight*/) {}
+
+    virtual void AttachMetrics(Metrics::MetricsRegistry& registry) = 0;
+
+    /// Submissions are traced from then on
+    virtual void AttachTracer(EventTracer& tracer) noexcept { m_tracer = &tracer; }
+
+    /// Defers submitting queued ops until EndBatch so they reach the kernel in a single syscall.
+    /// Only for ops whose buffers outlive the queue call, i.e. not timeouts
+    virtual void BeginBatch() noexcept {}
+
+    virtual bool EndBatch() { return true; }
+
+    const Stats& GetStats() const noexcept { return m_stats; }
+
+    virtual Occupancy GetOccupancy() const noexcept = 0;
+
+    /// All unset when the backend isn't io_uring
+    const IOURingCapabilities& GetCapabilities() const noexcept { return m_capabilities; }
+
+    /// Completes straight away. the cheapest possible round trip through the backend
+    virtual bool QueueNop(const UserData& data) = 0;
+
+    /// Completes without IORING_CQE_F_MORE when the timeout can't keep firing. re-queue to re-arm
+    virtual bool QueueTimeoutEvent(const UserData& data, const TimeNS& timeout) = 0;
+
+    virtual bool CancelTimeoutEvent(const UserData& cancelData, const UserData& timeoutData) = 0;
+
+    virtual bool UpdateTimeoutEvent(const UserData& updateData, const UserData& timeoutData, const TimeNS& timeout) = 0;
+
+    virtual bool QueueSignalRead(const UserData& data, int fd, signalfd_siginfo& readBuff) = 0;
+
+    virtual bool QueueRead(const UserData& data, int fd, std::span<uint8_t> buffer) = 0;
+
+    /// @returns fd
+    virtual int QueueTcpConnect(const UserData& data, const std::string& host, const std::string& port) = 0;
+
+    /// Large buffers may be sent zero copy, completing a second time with IORING_CQE_F_NOTIF once released
+    virtual bool QueueTcpSend(const UserData& data, int fd, std::string_view buffer) = 0;
+
+    /// The opcode QueueTcpSend submits a buffer of size as
+    virtual uint8_t SendOpcode(size_t /*size*/) const noexcept { return IORING_OP_SEND; }
+
+    virtual bool QueueTcpRecv(const UserData& data, int fd, std::span<uint8_t> rxBuffer) = 0;
+
+    /// Reports each time fd becomes readable. Completes without IORING_CQE_F_MORE when it needs re-arming
+    virtual bool QueuePollIn(const UserData& data, int fd) = 0;
+
+    virtual bool CancelPoll(const UserData& cancelData, const UserData& pollData) = 0;
+
+    /// Completes with -ECANCELED, or the cancel with -ENOENT if the op already finished
+    virtual bool CancelOp(const UserData& cancelData, const UserData& targetData) = 0;
+
+    /// Buffers for ops that let the kernel pick one. memory is split into bufferSize sized buffers, a power of 2
+    /// count of them, and must outlive the group. false where the backend can't provide buffers
+    virtual bool AddBufferGroup(uint16_t groupId, std::span<uint8_t> memory, uint32_t bufferSize) = 0;
+
+    virtual void RemoveBufferGroup(uint16_t groupId) = 0;
+
+    /// Hands back a buffer a completion was given, once done with its contents
+    virtual void ReturnBuffer(uint16_t groupId, uint16_t bufferId) = 0;
+
+    /// Multishot. each datagram completes with IORING_CQE_F_BUFFER and the id of the buffer it was received into
+    /// above IORING_CQE_BUFFER_SHIFT, laid out as io_uring_recvmsg_out for message's name and control lengths.
+    /// message must outlive the op
+    virtual bool QueueRecvMsg(const UserData& data, int fd, const msghdr& message, uint16_t groupId) = 0;
+
+    /// message and everything it points to must outlive the op
+    virtual bool QueueSendMsg(const UserData& data, int fd, const msghdr& message) = 0;
+
+    /// Receives into message's own buffers, control data included, updating its lengths and flags as recvmsg
+    /// does. message and everything it points to must outlive the op
+    virtual bool QueueRecvMsg(const UserData& data, int fd, msghdr& message) = 0;
+
+    /// Completes with each accepted fd, non-blocking and close-on-exec. Completes without IORING_CQE_F_MORE when
+    /// it needs re-arming
+    virtual bool QueueAccept(const UserData& data, int listenFd) = 0;
+
+    /// Connects an already created non-blocking socket. address must outlive the op
+    virtual bool QueueConnect(const UserData& data, int fd, const sockaddr& address, socklen_t addressLen) = 0;
+
+    /// Moves up to len bytes from fdIn to fdOut, one of them a pipe, without copying them through user space.
+    /// offsetIn is where a file is read from, -1 for a pipe or socket. Doesn't wait on the pipe, nor on a
+    /// non-blocking socket, completing with -EAGAIN when it has nothing to give or no room. poll it and try again
+    virtual bool QueueSplice(const UserData& data, int fdIn, int64_t offsetIn, int fdOut, uint32_t len) = 0;
+
+    /// Completes once with the ready mask when fd is ready for events, either POLLIN or POLLOUT
+    virtual bool QueuePoll(const UserData& data, int fd, uint32_t events) = 0;
+
+    /// Completes with the fd or -errno. path must outlive the op
+    virtual bool QueueOpen(const UserData& data, const char* path, int flags, mode_t mode) = 0;
+
+    /// Through the registered buffer buffer lies within, if any
+    virtual bool QueueReadAt(const UserData& data, int fd, std::span<uint8_t> buffer, uint64_t offset) = 0;
+
+    /// Through the registered buffer buffer lies within, if any
+    virtual bool QueueWriteAt(const UserData& data, int fd, std::span<const uint8_t> buffer, uint64_t offset) = 0;
+
+    /// dataOnly skips metadata that isn't needed to read the data back, as fdatasync does
+    virtual bool QueueFsync(const UserData& data, int fd, bool dataOnly) = 0;
+
+    /// statxBuf must outlive the op
+    virtual bool QueueStatx(const UserData& data, int fd, struct statx& statxBuf) = 0;
+
+    /// Pins memory that file reads and writes go through, saving mapping it for every op. Replaces whatever was
+    /// registered before. false where the backend can't register buffers, ops through the memory work regardless
+    virtual bool RegisterBuffers(std::span<const iovec> /*buffers*/) { return false; }
+
+    virtual void UnregisterBuffers() {}
+
+protected:
+    IOBackend(const IOBackend&) = delete;
+    IOBackend(IOBackend&&) = delete;
+    IOBackend& operator=(const IOBackend&) = delete;
+    IOBackend& operator=(IOBackend&&) = delete;
+
+    Stats m_stats{};
+    IOURingCapabilities m_capabilities{};
+    // only set while tracing
+    EventTracer* m_tracer{ nullptr };
+};
+
+/// Falls back to epoll if io_uring is requested but unavailable, e.g. disabled by seccomp or sysctl.
+/// Throws std::runtime_error if a trace can't be opened
+std::unique_ptr<IOBackend> CreateBackend(const BackendOptions& options);
+
+} // namespace Sage
@@ -1,7 +1,12 @@
+#include <algorithm>
+#include <array>
 #include <cerrno>
 #include <cstring>
+#include <fcntl.h>
 #include <liburing.h>
 #include <netdb.h>
+#include <poll.h>
+#include <stdexcept>
 #include <string_view>
 #include <sys/socket.h>
 
@@ -13,15 +18,62 @@ namespace Sage
 
 IOURing::IOURing(uint queueSize) : m_queueSize{ queueSize }
 {
-    io_uring_queue_init(
-        m_queueSize,
-        &m_rawIOURing,
-        // Single threaded, so single issuer optimization
-        IORING_SETUP_SINGLE_ISSUER
+    constexpr std::array setupFlags{
+        // Single threaded, so single issuer optimization.
+        // Deferred task running is also required for resizing the rings at runtime
+        IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN,
+        // Older kernels
+        IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN,
+        IORING_SETUP_COOP_TASKRUN,
+        0U,
+    };
+
+    int res{ -EINVAL };
+    for (auto flags : setupFlags)
+    {
+        io_uring_params params{};
+        params.flags = flags;
+        res = io_uring_queue_init_params(m_queueSize, &m_rawIOURing, &params);
+        if (res != -EINVAL)
+        {
+            break;
+        }
+    }
+
+    if (res < 0)
+    {
+        LOG_CRITICAL("failed to init io_uring queue-size({}). {}", m_queueSize, strerror(-res));
+        throw std::runtime_error{ "IOURing Init Failed" };
+    }
+
+    if ((m_rawIOURing.features & IORING_FEAT_NODROP) == 0)
+    {
+        LOG_WARNING("kernel does not backlog overflowed completions. completions may be dropped under load");
+    }
+
+    m_resizable = (m_rawIOURing.flags & IORING_SETUP_DEFER_TASKRUN) != 0;
+    m_lastKernelOverflow = *m_rawIOURing.cq.koverflow;
+    SyncRingSizes();
+
+    LOG_INFO(
+        "io_uring created sq-entries({}) cq-entries({}) resizable({})",
+        m_stats.m_sqEntries,
+        m_stats.m_cqEntries,
+        m_resizable
     );
+
+    m_capabilities = ProbeCapabilities(m_rawIOURing);
+    m_capabilities.Log();
 }
 
-IOURing::~IOURing() { io_uring_queue_exit(&m_rawIOURing); }
+IOURing::~IOURing()
+{
+    for (const auto& [groupId, group] : m_bufferGroups)
+    {
+        io_uring_free_buf_ring(&m_rawIOURing, group.m_ring, group.m_count, groupId);
+    }
+    io_uring_queue_exit(&m_rawIOURing);
+}
 
 UniqueUringCEvent IOURing::WaitForEvent()
 {
@@ -30,8 +82,9 @@ UniqueUringCEvent IOURing::WaitForEvent()
     io_uring_cqe* rawCEvent{ nullptr };
     if (int res = io_uring_wait_cqe(&m_rawIOURing, &rawCEvent); res < 0)
     {
-        // Ignore interrupts. i.e debugger pause / suspend
-        if (res != -EINTR)
+        // Ignore interrupts. i.e debugger pause / suspend.
+        // Dropped completions are reported once via EBADR and accounted for in FlushOverflow
+        if (res != -EINTR and res != -EBADR)
         {
             LOG_ERROR("failed to waiting for event completion. {}", strerror(-res));
         }
@@ -48,6 +101,77 @@ UniqueUringCEvent IOURing::WaitForEvent()
                               } };
 }
 
+size_t IOURing::FlushOverflow()
+{
+    size_t dropped{ 0 };
+
+    // the kernel only bumps this when it could not even backlog a completion
+    if (const uint kernelOverflow{ *m_rawIOURing.cq.koverflow }; kernelOverflow != m_lastKernelOverflow) [[unlikely]]
+    {
+        dropped = kernelOverflow - m_lastKernelOverflow;
+        m_lastKernelOverflow = kernelOverflow;
+        m_stats.m_cqDropped += dropped;
+        LOG_CRITICAL("kernel dropped {} completion(s). total-dropped({})", dropped, m_stats.m_cqDropped);
+    }
+
+    if (not io_uring_cq_has_overflow(&m_rawIOURing)) [[likely]]
+    {
+        return dropped;
+    }
+
+    m_stats.m_cqOverflows++;
+    LOG_WARNING(
+        "completion queue overflowed. cq-entries({}) overflows({})", m_stats.m_cqEntries, m_stats.m_cqOverflows
+    );
+
+    // the completion queue is too small for the current load
+    if (m_resizable and m_stats.m_sqEntries < s_maxQueueSize)
+    {
+        Resize(std::min(m_stats.m_sqEntries * 2, s_maxQueueSize));
+    }
+
+    if (int res{ io_uring_get_events(&m_rawIOURing) }; res < 0 and res != -EINTR and res != -EBADR)
+    {
+        LOG_ERROR("failed to flush overflowed completions. {}", strerror(-res));
+    }
+
+    return dropped;
+}
+
+void IOURing::AdaptCapacity(size_t inFlight)
+{
+    if (not m_resizable)
+    {
+        return;
+    }
+
+    const size_t cqEntries{ m_stats.m_cqEntries };
+
+    // grow before a burst of completions from in-flight ops can overflow the completion queue
+    if (inFlight > cqEntries / 4 * 3)
+    {
+        m_lowLoadStreak = 0;
+        if (m_stats.m_sqEntries < s_maxQueueSize)
+        {
+            Resize(std::min(m_stats.m_sqEntries * 2, s_maxQueueSize));
+        }
+        return;
+    }
+
+    // only shrink after sustained low load so short lulls don't cause resize churn
+    if (inFlight >= cqEntries / 8 or m_stats.m_sqEntries <= s_minQueueSize)
+    {
+        m_lowLoadStreak = 0;
+        return;
+    }
+
+    if (++m_lowLoadStreak >= s_shrinkAfterIterations)
+    {
+        m_lowLoadStreak = 0;
+        Resize(std::max(m_stats.m_sqEntries / 2, s_minQueueSize));
+    }
+}
+
 bool IOURing::QueueTimeoutEvent(const UserData& data, const TimeNS& timeout)
 {
     io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
@@ -62,13 +186,29 @@ bool IOURing::QueueTimeoutEvent(const UserData& data, const TimeNS& timeout)
         submissionEvent,
         &ts,
         0,
-        // ensure timeout keeps firing without rearming
-        IORING_TIMEOUT_MULTISHOT | IORING_TIMEOUT_BOOTTIME
+        // ensure timeout keeps firing without rearming where supported.
+        // otherwise the completion comes without IORING_CQE_F_MORE and the caller re-arms it
+        m_capabilities.m_multishotTimeout ? IORING_TIMEOUT_MULTISHOT | IORING_TIMEOUT_BOOTTIME
+                                          : IORING_TIMEOUT_BOOTTIME
     );
 
     return SubmitEvents();
 }
 
+bool IOURing::QueueNop(const UserData& data)
+{
+    io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
+    if (submissionEvent == nullptr)
+    {
+        return false;
+    }
+
+    submissionEvent->user_data = data;
+    io_uring_prep_nop(submissionEvent);
+
+    return SubmitEvents();
+}
+
 bool IOURing::CancelTimeoutEvent(const UserData& cancelData, const UserData& timeoutData)
 {
     io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
@@ -112,6 +252,20 @@ bool IOURing::QueueSignalRead(const UserData& data, int fd, signalfd_siginfo& re
     return SubmitEvents();
 }
 
+bool IOURing::QueueRead(const UserData& data, int fd, std::span<uint8_t> buffer)
+{
+    io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
+    if (submissionEvent == nullptr)
+    {
+        return false;
+    }
+
+    submissionEvent->user_data = data;
+    io_uring_prep_read(submissionEvent, fd, buffer.data(), static_cast<unsigned>(buffer.size()), 0);
+
+    return SubmitEvents();
+}
+
 int IOURing::QueueTcpConnect(const UserData& data, const std::string& host, const std::string& port)
 {
     io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
@@ -170,6 +324,11 @@ int IOURing::QueueTcpConnect(const UserData& data, const std::string& host, cons
     return -1;
 }
 
+uint8_t IOURing::SendOpcode(size_t size) const noexcept
+{
+    return (m_capabilities.m_sendZeroCopy and size >= s_zeroCopySendThreshold) ? IORING_OP_SEND_ZC : IORING_OP_SEND;
+}
+
 bool IOURing::QueueTcpSend(const UserData& data, int fd, std::string_view buffer)
 {
     io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
@@ -179,12 +338,20 @@ bool IOURing::QueueTcpSend(const UserData& data, int fd, std::string_view buffer
     }
 
     submissionEvent->user_data = data;
-    io_uring_prep_send(submissionEvent, fd, buffer.data(), buffer.size(), 0);
+    if (SendOpcode(buffer.size()) == IORING_OP_SEND_ZC)
+    {
+        // completes twice. the buffer must outlive the second IORING_CQE_F_NOTIF completion
+        io_uring_prep_send_zc(submissionEvent, fd, buffer.data(), buffer.size(), 0, 0);
+    }
+    else
+    {
+        io_uring_prep_send(submissionEvent, fd, buffer.data(), buffer.size(), 0);
+    }
 
     return SubmitEvents();
 }
 
-bool IOURing::QueueTcpRecv(const UserData& data, int fd, RxBuffer& rxBuffer)
+bool IOURing::QueueTcpRecv(const UserData& data, int fd, std::span<uint8_t> rxBuffer)
 {
     io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
     if (submissionEvent == nullptr)
@@ -198,9 +365,380 @@ bool IOURing::QueueTcpRecv(const UserData& data, int fd, RxBuffer& rxBuffer)
     return SubmitEvents();
 }
 
+bool IOURing::QueuePollIn(const UserData& data, int fd)
+{
+    io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
+    if (submissionEvent == nullptr)
+    {
+        return false;
+    }
+
+    submissionEvent->user_data = data;
+    if (m_capabilities.m_multishotPoll)
+    {
+        io_uring_prep_poll_multishot(submissionEvent, fd, POLLIN);
+    }
+    else
+    {
+        io_uring_prep_poll_add(submissionEvent, fd, POLLIN);
+    }
+
+    return SubmitEvents();
+}
+
+bool IOURing::CancelPoll(const UserData& cancelData, const UserData& pollData)
+{
+    io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
+    if (submissionEvent == nullptr)
+    {
+        return false;
+    }
+
+    submissionEvent->user_data = cancelData;
+    io_uring_prep_poll_remove(submissionEvent, pollData);
+
+    return SubmitEvents();
+}
+
+bool IOURing::CancelOp(const UserData& cancelData, const UserData& targetData)
+{
+    io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
+    if (submissionEvent == nullptr)
+    {
+        return false;
+    }
+
+    submissionEvent->user_data = cancelData;
+    io_uring_prep_cancel64(submissionEvent, targetData, 0);
+
+    return SubmitEvents();
+}
+
+bool IOURing::AddBufferGroup(uint16_t groupId, std::span<uint8_t> memory, uint32_t bufferSize)
+{
+    const size_t count{ bufferSize == 0 ? 0 : memory.size() / bufferSize };
+    if (count == 0 or count > s_maxBufferGroupSize or (count & (count - 1)) != 0 or m_bufferGroups.contains(groupId))
+    {
+        LOG_ERROR("invalid buffer group({}) buffers({}) buffer-size({})", groupId, count, bufferSize);
+        return false;
+    }
+
+    int res{ 0 };
+    io_uring_buf_ring* ring{ io_uring_setup_buf_ring(&m_rawIOURing, static_cast<uint>(count), groupId, 0, &res) };
+    if (ring == nullptr)
+    {
+        LOG_ERROR("failed to register buffer group({}). {}", groupId, strerror(-res));
+        return false;
+    }
+
+    const int mask{ io_uring_buf_ring_mask(static_cast<uint>(count)) };
+    for (size_t i{ 0 }; i < count; i++)
+    {
+        io_uring_buf_ring_add(
+            ring, memory.data() + i * bufferSize, bufferSize, static_cast<uint16_t>(i), mask, static_cast<int>(i)
+        );
+    }
+    io_uring_buf_ring_advance(ring, static_cast<int>(count));
+
+    m_bufferGroups[groupId] = BufferGroup{ ring, memory.data(), bufferSize, static_cast<uint16_t>(count) };
+    return true;
+}
+
+void IOURing::RemoveBufferGroup(uint16_t groupId)
+{
+    auto itr{ m_bufferGroups.find(groupId) };
+    if (itr == m_bufferGroups.end())
+    {
+        return;
+    }
+
+    const BufferGroup& group{ itr->second };
+    if (int res{ io_uring_free_buf_ring(&m_rawIOURing, group.m_ring, group.m_count, groupId) }; res < 0)
+    {
+        LOG_ERROR("failed to unregister buffer group({}). {}", groupId, strerror(-res));
+    }
+    m_bufferGroups.erase(itr);
+}
+
+void IOURing::ReturnBuffer(uint16_t groupId, uint16_t bufferId)
+{
+    auto itr{ m_bufferGroups.find(groupId) };
+    if (itr == m_bufferGroups.end() or bufferId >= itr->second.m_count)
+    {
+        LOG_ERROR("returned buffer({}) isn't in a group({})", bufferId, groupId);
+        return;
+    }
+
+    const BufferGroup& group{ itr->second };
+    io_uring_buf_ring_add(
+        group.m_ring,
+        group.m_base + static_cast<size_t>(bufferId) * group.m_bufferSize,
+        group.m_bufferSize,
+        bufferId,
+        io_uring_buf_ring_mask(group.m_count),
+        0
+    );
+    io_uring_buf_ring_advance(group.m_ring, 1);
+}
+
+bool IOURing::QueueRecvMsg(const UserData& data, int fd, const msghdr& message, uint16_t groupId)
+{
+    io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
+    if (submissionEvent == nullptr)
+    {
+        return false;
+    }
+
+    submissionEvent->user_data = data;
+    // only the name and control lengths are read. buffers come from the group
+    io_uring_prep_recvmsg_multishot(submissionEvent, fd, const_cast<msghdr*>(&message), 0);
+    submissionEvent->flags |= IOSQE_BUFFER_SELECT;
+    submissionEvent->buf_group = groupId;
+
+    return SubmitEvents();
+}
+
+bool IOURing::QueueSendMsg(const UserData& data, int fd, const msghdr& message)
+{
+    io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
+    if (submissionEvent == nullptr)
+    {
+        return false;
+    }
+
+    submissionEvent->user_data = data;
+    // a stream socket keeps sending until it's all gone rather than completing part way
+    io_uring_prep_sendmsg(submissionEvent, fd, &message, MSG_WAITALL);
+
+    return SubmitEvents();
+}
+
+bool IOURing::QueueRecvMsg(const UserData& data, int fd, msghdr& message)
+{
+    io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
+    if (submissionEvent == nullptr)
+    {
+        return false;
+    }
+
+    submissionEvent->user_data = data;
+    // fds passed with the message mustn't leak into exec'd children
+    io_uring_prep_recvmsg(submissionEvent, fd, &message, MSG_CMSG_CLOEXEC);
+
+    return SubmitEvents();
+}
+
+bool IOURing::QueueAccept(const UserData& data, int listenFd)
+{
+    io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
+    if (submissionEvent == nullptr)
+    {
+        return false;
+    }
+
+    submissionEvent->user_data = data;
+    if (m_capabilities.m_multishotAccept)
+    {
+        io_uring_prep_multishot_accept(submissionEvent, listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    }
+    else
+    {
+        io_uring_prep_accept(submissionEvent, listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    }
+
+    return SubmitEvents();
+}
+
+bool IOURing::QueueConnect(const UserData& data, int fd, const sockaddr& address, socklen_t addressLen)
+{
+    io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
+    if (submissionEvent == nullptr)
+    {
+        return false;
+    }
+
+    submissionEvent->user_data = data;
+    io_uring_prep_connect(submissionEvent, fd, &address, addressLen);
+
+    return SubmitEvents();
+}
+
+bool IOURing::QueueSplice(const UserData& data, int fdIn, int64_t offsetIn, int fdOut, uint32_t len)
+{
+    io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
+    if (submissionEvent == nullptr)
+    {
+        return false;
+    }
+
+    submissionEvent->user_data = data;
+    // splice always runs on the ring's worker threads. non-blocking, so none of them sit on an idle socket
+    io_uring_prep_splice(submissionEvent, fdIn, offsetIn, fdOut, -1, len, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+    return SubmitEvents();
+}
+
+bool IOURing::QueuePoll(const UserData& data, int fd, uint32_t events)
+{
+    io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
+    if (submissionEvent == nullptr)
+    {
+        return false;
+    }
+
+    submissionEvent->user_data = data;
+    io_uring_prep_poll_add(submissionEvent, fd, events);
+
+    return SubmitEvents();
+}
+
+bool IOURing::QueueOpen(const UserData& data, const char* path, int flags, mode_t mode)
+{
+    io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
+    if (submissionEvent == nullptr)
+    {
+        return false;
+    }
+
+    submissionEvent->user_data = data;
+    io_uring_prep_openat(submissionEvent, AT_FDCWD, path, flags | O_CLOEXEC, mode);
+
+    return SubmitEvents();
+}
+
+bool IOURing::QueueReadAt(const UserData& data, int fd, std::span<uint8_t> buffer, uint64_t offset)
+{
+    io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
+    if (submissionEvent == nullptr)
+    {
+        return false;
+    }
+
+    submissionEvent->user_data = data;
+    const auto size{ static_cast<uint>(buffer.size()) };
+    if (int index{ FindRegisteredBuffer(buffer.data(), buffer.size()) }; index >= 0)
+    {
+        io_uring_prep_read_fixed(submissionEvent, fd, buffer.data(), size, offset, index);
+    }
+    else
+    {
+        io_uring_prep_read(submissionEvent, fd, buffer.data(), size, offset);
+    }
+
+    return SubmitEvents();
+}
+
+bool IOURing::QueueWriteAt(const UserData& data, int fd, std::span<const uint8_t> buffer, uint64_t offset)
+{
+    io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
+    if (submissionEvent == nullptr)
+    {
+        return false;
+    }
+
+    submissionEvent->user_data = data;
+    const auto size{ static_cast<uint>(buffer.size()) };
+    if (int index{ FindRegisteredBuffer(buffer.data(), buffer.size()) }; index >= 0)
+    {
+        io_uring_prep_write_fixed(submissionEvent, fd, buffer.data(), size, offset, index);
+    }
+    else
+    {
+        io_uring_prep_write(submissionEvent, fd, buffer.data(), size, offset);
+    }
+
+    return SubmitEvents();
+}
+
+bool IOURing::QueueFsync(const UserData& data, int fd, bool dataOnly)
+{
+    io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
+    if (submissionEvent == nullptr)
+    {
+        return false;
+    }
+
+    submissionEvent->user_data = data;
+    io_uring_prep_fsync(submissionEvent, fd, dataOnly ? IORING_FSYNC_DATASYNC : 0);
+
+    return SubmitEvents();
+}
+
+bool IOURing::QueueStatx(const UserData& data, int fd, struct statx& statxBuf)
+{
+    io_uring_sqe* submissionEvent{ GetSubmissionEvent() };
+    if (submissionEvent == nullptr)
+    {
+        return false;
+    }
+
+    submissionEvent->user_data = data;
+    io_uring_prep_statx(submissionEvent, fd, "", AT_EMPTY_PATH, STATX_BASIC_STATS, &statxBuf);
+
+    return SubmitEvents();
+}
+
+bool IOURing::RegisterBuffers(std::span<const iovec> buffers)
+{
+    UnregisterBuffers();
+    if (buffers.empty())
+    {
+        return true;
+    }
+
+    if (int res{ io_uring_register_buffers(&m_rawIOURing, buffers.data(), static_cast<uint>(buffers.size())) };
+        res < 0)
+    {
+        LOG_ERROR("failed to register buffers({}). {}", buffers.size(), strerror(-res));
+        return false;
+    }
+
+    m_registeredBuffers.assign(buffers.begin(), buffers.end());
+    return true;
+}
+
+void IOURing::UnregisterBuffers()
+{
+    if (m_registeredBuffers.empty())
+    {
+        return;
+    }
+
+    if (int res{ io_uring_unregister_buffers(&m_rawIOURing) }; res < 0)
+    {
+        LOG_ERROR("failed to unregister buffers({}). {}", m_registeredBuffers.size(), strerror(-res));
+    }
+    m_registeredBuffers.clear();
+}
+
+int IOURing::FindRegisteredBuffer(const void* data, size_t size) const noexcept
+{
+    const auto* begin{ static_cast<const uint8_t*>(data) };
+    for (size_t i{ 0 }; i < m_registeredBuffers.size(); i++)
+    {
+        const auto* base{ static_cast<const uint8_t*>(m_registeredBuffers[i].iov_base) };
+        if (begin >= base and begin + size <= base + m_registeredBuffers[i].iov_len)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+bool IOURing::EndBatch()
+{
+    m_batching = false;
+    return SubmitEvents();
+}
+
 bool IOURing::SubmitEvents()
 {
-    int res{ io_uring_submit(&m_rawIOURing) };
+    if (m_batching)
+    {
+        return true;
+    }
+
+    int res{ Submit() };
     bool success{ res >= 0 };
 
     if (success) [[likely]]
@@ -215,15 +753,98 @@ bool IOURing::SubmitEvents()
     return success;
 }
 
+int IOURing::Submit()
+{
+    // entries prepared since the last submit sit between the local head and tail
+    const io_uring_sq& sq{ m_rawIOURing.sq };
+    for (unsigned i{ sq.sqe_head }; i != sq.sqe_tail; i++)
+    {
+        m_opsSubmitted.Add(sq.sqes[i & sq.ring_mask].opcode);
+    }
+
+    if (m_tracer != nullptr) [[unlikely]]
+    {
+        for (unsigned i{ sq.sqe_head }; i != sq.sqe_tail; i++)
+        {
+            const io_uring_sqe& sqe{ sq.sqes[i & sq.ring_mask] };
+            m_tracer->Trace(TracePhase::Submit, sqe.user_data, 0, sqe.opcode);
+        }
+    }
+    m_submitCalls.Add();
+
+    return io_uring_submit(&m_rawIOURing);
+}
+
+void IOURing::AttachMetrics(Metrics::MetricsRegistry& registry)
+{
+    static_assert(IORING_OP_LAST <= Metrics::s_opcodeSlots);
+
+    m_opsSubmitted = registry.AddOpcodeCounters("ops_submitted");
+    m_submitCalls = registry.AddCounter("submit_calls");
+}
+
 io_uring_sqe* IOURing::GetSubmissionEvent()
 {
     io_uring_sqe* submissionEvent{ io_uring_get_sqe(&m_rawIOURing) };
+    if (submissionEvent == nullptr) [[unlikely]]
+    {
+        m_stats.m_sqFull++;
+
+        // hand what is queued to the kernel to free up entries, then try again
+        if (Submit() >= 0)
+        {
+            submissionEvent = io_uring_get_sqe(&m_rawIOURing);
+        }
+    }
+
     if (submissionEvent == nullptr)
     {
-        LOG_ERROR("failed. submission queue may be full?");
+        LOG_ERROR("failed. submission queue full. sq-full({})", m_stats.m_sqFull);
     }
 
     return submissionEvent;
 }
 
+bool IOURing::Resize(uint sqEntries)
+{
+    io_uring_params params{};
+    params.sq_entries = sqEntries;
+    params.cq_entries = sqEntries * 2;
+    params.flags = IORING_SETUP_CQSIZE;
+
+    if (int res{ io_uring_resize_rings(&m_rawIOURing, &params) }; res < 0)
+    {
+        m_stats.m_resizeFailures++;
+
+        // kernels without ring resizing reject the register opcode
+        if (res == -EINVAL)
+        {
+            m_resizable = false;
+            LOG_WARNING("io_uring ring resizing not supported by kernel. keeping sq-entries({})", m_stats.m_sqEntries);
+        }
+        else
+        {
+            LOG_ERROR("failed to resize io_uring to sq-entries({}). {}", sqEntries, strerror(-res));
+        }
+
+        return false;
+    }
+
+    const uint oldSqEntries{ m_stats.m_sqEntries };
+    m_stats.m_resizes++;
+    SyncRingSizes();
+
+    LOG_INFO(
+        "io_uring resized sq-entries({} -> {}) cq-entries({})", oldSqEntries, m_stats.m_sqEntries, m_stats.m_cqEntries
+    );
+
+    return true;
+}
+
+void IOURing::SyncRingSizes() noexcept
+{
+    m_stats.m_sqEntries = m_rawIOURing.sq.ring_entries;
+    m_stats.m_cqEntries = m_rawIOURing.cq.ring_entries;
+}
+
 } // namespace Sage
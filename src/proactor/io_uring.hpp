@@ -1,47 +1,109 @@
 #pragma once
 
-#include <array>
 #include <cstdint>
-#include <functional>
 #include <liburing.h>
-#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
 #include <sys/signalfd.h>
 #include <sys/types.h>
+#include <unordered_map>
+#include <vector>
 
+#include "metrics/metrics.hpp"
+#include "proactor/io_backend.hpp"
 #include "timing/time.hpp"
 
 namespace Sage
 {
 
-using UniqueUringCEvent = std::unique_ptr<io_uring_cqe, std::function<void(io_uring_cqe*)>>;
-
-class IOURing final
+class IOURing final : public IOBackend
 {
 public:
-    // usually an id to reference against a map
-    using UserData = decltype(io_uring_sqe{}.user_data);
-    using RxBuffer = std::array<uint8_t, 1024>;
-
     explicit IOURing(uint queueSize);
 
-    ~IOURing();
+    ~IOURing() override;
+
+    BackendType Type() const noexcept override { return BackendType::IOURing; }
+
+    UniqueUringCEvent WaitForEvent() override;
+
+    size_t FlushOverflow() override;
+
+    /// No-op if the kernel can't resize the rings
+    void AdaptCapacity(size_t inFlight) override;
+
+    void AttachMetrics(Metrics::MetricsRegistry& registry) override;
+
+    void BeginBatch() noexcept override { m_batching = true; }
+
+    bool EndBatch() override;
+
+    Occupancy GetOccupancy() const noexcept override
+    {
+        return Occupancy{ io_uring_sq_ready(&m_rawIOURing), io_uring_cq_ready(&m_rawIOURing) };
+    }
+
+    bool QueueNop(const UserData& data) override;
+
+    bool QueueTimeoutEvent(const UserData& data, const TimeNS& timeout) override;
+
+    bool CancelTimeoutEvent(const UserData& cancelData, const UserData& timeoutData) override;
+
+    bool UpdateTimeoutEvent(const UserData& cancelData, const UserData& timeoutData, const TimeNS& timeout) override;
+
+    bool QueueSignalRead(const UserData& data, int fd, signalfd_siginfo& readBuff) override;
+
+    bool QueueRead(const UserData& data, int fd, std::span<uint8_t> buffer) override;
+
+    int QueueTcpConnect(const UserData& data, const std::string& host, const std::string& port) override;
+
+    bool QueueTcpSend(const UserData& data, int fd, std::string_view buffer) override;
+
+    uint8_t SendOpcode(size_t size) const noexcept override;
 
-    UniqueUringCEvent WaitForEvent();
+    bool QueueTcpRecv(const UserData& data, int fd, std::span<uint8_t> rxBuffer) override;
 
-    bool QueueTimeoutEvent(const UserData& data, const TimeNS& timeout);
+    bool QueuePollIn(const UserData& data, int fd) override;
 
-    bool CancelTimeoutEvent(const UserData& cancelData, const UserData& timeoutData);
+    bool CancelPoll(const UserData& cancelData, const UserData& pollData) override;
 
-    bool UpdateTimeoutEvent(const UserData& cancelData, const UserData& timeoutData, const TimeNS& timeout);
+    bool CancelOp(const UserData& cancelData, const UserData& targetData) override;
 
-    bool QueueSignalRead(const UserData& data, int fd, signalfd_siginfo& readBuff);
+    bool AddBufferGroup(uint16_t groupId, std::span<uint8_t> memory, uint32_t bufferSize) override;
 
-    /// @returns fd
-    int QueueTcpConnect(const UserData& data, const std::string& host, const std::string& port);
+    void RemoveBufferGroup(uint16_t groupId) override;
 
-    bool QueueTcpSend(const UserData& data, int fd, std::string_view buffer);
+    void ReturnBuffer(uint16_t groupId, uint16_t bufferId) override;
 
-    bool QueueTcpRecv(const UserData& data, int fd, RxBuffer& rxBuffer);
+    bool QueueRecvMsg(const UserData& data, int fd, const msghdr& message, uint16_t groupId) override;
+
+    bool QueueSendMsg(const UserData& data, int fd, const msghdr& message) override;
+
+    bool QueueRecvMsg(const UserData& data, int fd, msghdr& message) override;
+
+    bool QueueAccept(const UserData& data, int listenFd) override;
+
+    bool QueueConnect(const UserData& data, int fd, const sockaddr& address, socklen_t addressLen) override;
+
+    bool QueueSplice(const UserData& data, int fdIn, int64_t offsetIn, int fdOut, uint32_t len) override;
+
+    bool QueuePoll(const UserData& data, int fd, uint32_t events) override;
+
+    bool QueueOpen(const UserData& data, const char* path, int flags, mode_t mode) override;
+
+    bool QueueReadAt(const UserData& data, int fd, std::span<uint8_t> buffer, uint64_t offset) override;
+
+    bool QueueWriteAt(const UserData& data, int fd, std::span<const uint8_t> buffer, uint64_t offset) override;
+
+    bool QueueFsync(const UserData& data, int fd, bool dataOnly) override;
+
+    bool QueueStatx(const UserData& data, int fd, struct statx& statxBuf) override;
+
+    /// Reads and writes lying within one of them go through it as fixed buffer ops
+    bool RegisterBuffers(std::span<const iovec> buffers) override;
+
+    void UnregisterBuffers() override;
 
 private:
     IOURing(const IOURing&) = delete;
@@ -53,8 +115,42 @@ private:
 
     bool SubmitEvents();
 
+    /// io_uring_submit, counting and tracing what's submitted by opcode
+    int Submit();
+
+    bool Resize(uint sqEntries);
+
+    void SyncRingSizes() noexcept;
+
+    /// Index of the registered buffer holding all of [data, data + size), -1 if none does
+    int FindRegisteredBuffer(const void* data, size_t size) const noexcept;
+
+    static constexpr uint s_minQueueSize{ 256 };
+    static constexpr uint s_maxQueueSize{ 32'768 };
+    static constexpr size_t s_shrinkAfterIterations{ 4'096 };
+    // below this zero copy send costs more in page pinning and notifications than the copy it saves
+    static constexpr size_t s_zeroCopySendThreshold{ 16 * 1024 };
+    static constexpr size_t s_maxBufferGroupSize{ 32'768 };
+
+    struct BufferGroup
+    {
+        io_uring_buf_ring* m_ring;
+        uint8_t* m_base;
+        uint32_t m_bufferSize;
+        uint16_t m_count;
+    };
+
     struct io_uring m_rawIOURing{};
     const uint m_queueSize;
+    bool m_resizable{ false };
+    bool m_batching{ false };
+    uint m_lastKernelOverflow{ 0 };
+    size_t m_lowLoadStreak{ 0 };
+    Metrics::CounterArray m_opsSubmitted;
+    Metrics::Counter m_submitCalls;
+    std::unordered_map<uint16_t, BufferGroup> m_bufferGroups;
+    // indexed as the kernel knows them. few enough to search
+    std::vector<iovec> m_registeredBuffers;
 };
 
 } // namespace Sage
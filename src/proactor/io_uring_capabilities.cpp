@@ -0,0 +1,71 @@
+#include <liburing.h>
+
+#include "log/logger.hpp"
+#include "proactor/io_uring_capabilities.hpp"
+
+namespace Sage
+{
+
+IOURingCapabilities ProbeCapabilities(io_uring& ring)
+{
+    IOURingCapabilities caps;
+    caps.m_setupFlags = ring.flags;
+    caps.m_features = ring.features;
+
+    if (io_uring_probe* probe{ io_uring_get_probe_ring(&ring) }; probe != nullptr)
+    {
+        for (uint8_t op{ 0 }; op < IORING_OP_LAST; op++)
+        {
+            caps.m_opcodes.set(op, io_uring_opcode_supported(probe, op) != 0);
+        }
+        io_uring_free_probe(probe);
+    }
+    else
+    {
+        LOG_WARNING("io_uring opcode probe not supported by kernel. using plain ops only");
+    }
+
+    // Flag level features have no probe, so they are keyed off an opcode or feature bit from the same kernel release
+
+    // multishot timeouts landed in 6.4. read multishot (6.7) is the first probeable op after it
+    caps.m_multishotTimeout = caps.SupportsOp(IORING_OP_READ_MULTISHOT);
+    caps.m_sendZeroCopy = caps.SupportsOp(IORING_OP_SEND_ZC);
+    // multishot poll landed in 5.13 alongside resource tags
+    caps.m_multishotPoll = (caps.m_features & IORING_FEAT_RSRC_TAGS) != 0;
+    // multishot recv landed in 6.0 alongside zero copy send
+    caps.m_multishotRecv = caps.SupportsOp(IORING_OP_SEND_ZC);
+    caps.m_recvSendBundle = (caps.m_features & IORING_FEAT_RECVSEND_BUNDLE) != 0;
+    // direct socket creation and provided buffer rings both landed in 5.19
+    caps.m_directDescriptors = caps.SupportsOp(IORING_OP_SOCKET);
+    caps.m_providedBufferRing = caps.SupportsOp(IORING_OP_SOCKET);
+    // as did multishot accept
+    caps.m_multishotAccept = caps.SupportsOp(IORING_OP_SOCKET);
+
+    return caps;
+}
+
+void IOURingCapabilities::Log() const
+{
+    LOG_INFO(
+        "io_uring capabilities setup-flags({:#x}) features({:#x}) supported-ops({}/{})",
+        m_setupFlags,
+        m_features,
+        m_opcodes.count(),
+        m_opcodes.size()
+    );
+
+    LOG_INFO("io_uring single-issuer:        {}", (m_setupFlags & IORING_SETUP_SINGLE_ISSUER) != 0);
+    LOG_INFO("io_uring defer-taskrun:        {}", (m_setupFlags & IORING_SETUP_DEFER_TASKRUN) != 0);
+    LOG_INFO("io_uring coop-taskrun:         {}", (m_setupFlags & IORING_SETUP_COOP_TASKRUN) != 0);
+    LOG_INFO("io_uring no-drop:              {}", (m_features & IORING_FEAT_NODROP) != 0);
+    LOG_INFO("io_uring timeout:              {}", m_multishotTimeout ? "multishot" : "re-armed");
+    LOG_INFO("io_uring send:                 {}", m_sendZeroCopy ? "zero-copy for large payloads" : "copy");
+    LOG_INFO("io_uring multishot-poll:       {}", m_multishotPoll);
+    LOG_INFO("io_uring multishot-recv:       {}", m_multishotRecv);
+    LOG_INFO("io_uring multishot-accept:     {}", m_multishotAccept);
+    LOG_INFO("io_uring recv/send-bundle:     {}", m_recvSendBundle);
+    LOG_INFO("io_uring direct-descriptors:   {}", m_directDescriptors);
+    LOG_INFO("io_uring provided-buffer-ring: {}", m_providedBufferRing);
+}
+
+} // namespace Sage
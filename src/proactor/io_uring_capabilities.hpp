@@ -0,0 +1,44 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <liburing.h>
+
+namespace Sage
+{
+
+struct IOURingCapabilities
+{
+    // IORING_SETUP_* flags the ring was created with
+    uint32_t m_setupFlags{ 0 };
+    // IORING_FEAT_* bits reported by the kernel
+    uint32_t m_features{ 0 };
+    std::bitset<IORING_OP_LAST> m_opcodes{};
+
+    // Fast paths selected from the above. Each op falls back to its plain variant when unset
+
+    // timeouts re-fire without being re-armed
+    bool m_multishotTimeout{ false };
+    // large sends skip the copy into kernel memory
+    bool m_sendZeroCopy{ false };
+    // one poll request keeps reporting readiness
+    bool m_multishotPoll{ false };
+    // one recv request keeps receiving into provided buffers
+    bool m_multishotRecv{ false };
+    // one accept request keeps accepting connections
+    bool m_multishotAccept{ false };
+    // a single recv/send completion can cover several provided buffers
+    bool m_recvSendBundle{ false };
+    // sockets and files can live in the ring's registered file table
+    bool m_directDescriptors{ false };
+    // provided buffers can be handed to the kernel via a shared ring
+    bool m_providedBufferRing{ false };
+
+    bool SupportsOp(uint8_t opcode) const noexcept { return opcode < m_opcodes.size() and m_opcodes.test(opcode); }
+
+    void Log() const;
+};
+
+IOURingCapabilities ProbeCapabilities(io_uring& ring);
+
+} // namespace Sage
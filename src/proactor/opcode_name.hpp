@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <liburing/io_uring.h>
+#include <string_view>
+
+namespace Sage
+{
+
+/// @returns the op's name, or an empty string for ops the proactor doesn't use
+constexpr std::string_view GetOpcodeName(uint8_t opcode) noexcept
+{
+    switch (opcode)
+    {
+        case IORING_OP_NOP:
+            return "nop";
+        case IORING_OP_READ:
+            return "read";
+        case IORING_OP_WRITE:
+            return "write";
+        case IORING_OP_READ_FIXED:
+            return "read_fixed";
+        case IORING_OP_WRITE_FIXED:
+            return "write_fixed";
+        case IORING_OP_OPENAT:
+            return "openat";
+        case IORING_OP_FSYNC:
+            return "fsync";
+        case IORING_OP_STATX:
+            return "statx";
+        case IORING_OP_TIMEOUT:
+            return "timeout";
+        case IORING_OP_TIMEOUT_REMOVE:
+            return "timeout_remove";
+        case IORING_OP_CONNECT:
+            return "connect";
+        case IORING_OP_SEND:
+            return "send";
+        case IORING_OP_SEND_ZC:
+            return "send_zc";
+        case IORING_OP_RECV:
+            return "recv";
+        case IORING_OP_SENDMSG:
+            return "sendmsg";
+        case IORING_OP_RECVMSG:
+            return "recvmsg";
+        case IORING_OP_ACCEPT:
+            return "accept";
+        case IORING_OP_SPLICE:
+            return "splice";
+        case IORING_OP_POLL_ADD:
+            return "poll_add";
+        case IORING_OP_POLL_REMOVE:
+            return "poll_remove";
+        case IORING_OP_ASYNC_CANCEL:
+            return "async_cancel";
+        default:
+            return {};
+    }
+}
+
+} // namespace Sage
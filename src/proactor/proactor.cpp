@@ -1,23 +1,124 @@
+#include <algorithm>
 #include <cerrno>
 #include <chrono>
+#include <climits>
 #include <csignal>
 #include <cstddef>
 #include <cstring>
+#include <fcntl.h>
+#include <fstream>
 #include <liburing/io_uring.h>
+#include <map>
+#include <netinet/udp.h>
+#include <poll.h>
+#include <print>
+#include <pthread.h>
 #include <sys/signalfd.h>
+#include <sys/socket.h>
 #include <unistd.h>
 #include <utility>
 
 #include "log/logger.hpp"
 #include "proactor/events.hpp"
+#include "proactor/file_handle.hpp"
+#include "proactor/file_send.hpp"
+#include "proactor/opcode_name.hpp"
 #include "proactor/proactor.hpp"
 #include "proactor/tcp_client.hpp"
+#include "proactor/tcp_relay.hpp"
 #include "proactor/timer_handler.hpp"
+#include "proactor/udp_socket.hpp"
+#include "proactor/unix_socket.hpp"
 #include "timing/scoped_deadline.hpp"
 
 namespace Sage
 {
 
+namespace
+{
+
+// handled by the loop unless the application does. the exit signals and SIGUSR1 for state dumps
+constexpr std::array s_loopSignals{ SIGINT, SIGQUIT, SIGTERM, SIGUSR1 };
+
+// single-shot ops timed from submission to completion. reads are signal and file watch reads. timeouts, polls and
+// accepts are left out, they wait on the clock or a peer
+constexpr std::array<uint8_t, 13> s_timedOps{ IORING_OP_CONNECT, IORING_OP_SEND,    IORING_OP_SEND_ZC,
+                                              IORING_OP_RECV,    IORING_OP_TIMEOUT_REMOVE, IORING_OP_READ,
+                                              IORING_OP_RECVMSG, IORING_OP_SENDMSG, IORING_OP_SPLICE,
+                                              IORING_OP_OPENAT,  IORING_OP_WRITE,   IORING_OP_FSYNC,
+                                              IORING_OP_STATX };
+
+/// What a file op is recorded as, whichever form the backend submitted it in
+uint8_t FileOpcode(FileOpKind kind) noexcept
+{
+    switch (kind)
+    {
+        case FileOpKind::Open:
+            return IORING_OP_OPENAT;
+        case FileOpKind::Read:
+            return IORING_OP_READ;
+        case FileOpKind::Write:
+            return IORING_OP_WRITE;
+        case FileOpKind::Sync:
+            return IORING_OP_FSYNC;
+        case FileOpKind::Stat:
+            return IORING_OP_STATX;
+    }
+    return IORING_OP_NOP;
+}
+
+/// What a file op's callback is profiled as
+HandlerCallback FileCallback(FileOpKind kind) noexcept
+{
+    switch (kind)
+    {
+        case FileOpKind::Open:
+            return HandlerCallback::Open;
+        case FileOpKind::Read:
+            return HandlerCallback::FileRead;
+        case FileOpKind::Write:
+            return HandlerCallback::FileWrite;
+        case FileOpKind::Sync:
+            return HandlerCallback::FileSync;
+        case FileOpKind::Stat:
+            return HandlerCallback::FileStat;
+    }
+
+    return HandlerCallback::FileRead;
+}
+
+template<typename... ETs> bool IsAnyOf(const Event& event) noexcept
+{
+    return ((dynamic_cast<const ETs*>(&event) != nullptr) or ...);
+}
+
+/// Ops that finish on their own shortly after submission, rather than waiting on a peer or a timer
+bool CompletesUnaided(const Event& event) noexcept
+{
+    if (const auto* splice{ dynamic_cast<const FileSendSplice*>(&event) }; splice != nullptr)
+    {
+        return splice->m_leg == FileSendLeg::Fill and splice->m_opcode == IORING_OP_SPLICE;
+    }
+
+    return IsAnyOf<FileOp, TimerUpdateEvent, TimerCancelEvent, TcpPollCancel, UdpRecvCancel, UnixCancel, RelayCancel,
+                   FileSendCancel>(event);
+}
+
+/// @returns the size a GRO coalesced payload splits into, or 0 for any other control message
+size_t GroSegmentSize(const cmsghdr& cmsg) noexcept
+{
+    if (cmsg.cmsg_level != SOL_UDP or cmsg.cmsg_type != UDP_GRO)
+    {
+        return 0;
+    }
+
+    int segmentSize{ 0 };
+    std::memcpy(&segmentSize, CMSG_DATA(&cmsg), sizeof(segmentSize));
+    return static_cast<size_t>(std::max(segmentSize, 0));
+}
+
+} // namespace
+
 class SignalEvent final : public Event
 {
 public:
@@ -33,11 +134,89 @@ public:
     signalfd_siginfo m_signalReadBuff{};
 };
 
-void Proactor::Create()
+class FileWatchEvent final : public Event
+{
+public:
+    explicit FileWatchEvent(OnCompleteFunc&& onComplete) : Event{ 0, std::move(onComplete) } {}
+
+    // fits a good number of events with names
+    alignas(inotify_event) std::array<uint8_t, 4096> m_readBuff{};
+};
+
+struct BroadcastState
+{
+    BroadcastState(SharedPayload&& payload, BroadcastCompleteFunc&& onComplete) :
+        m_payload{ std::move(payload) },
+        m_onComplete{ std::move(onComplete) }
+    {
+    }
+
+    void OnSent(int res)
+    {
+        const TimeNS sinceStart{ Clock::now() - m_start };
+        if (m_report.m_firstCompletion == TimeNS{ 0 })
+        {
+            m_report.m_firstCompletion = sinceStart;
+        }
+        m_report.m_lastCompletion = sinceStart;
+
+        if (res < 0)
+        {
+            m_report.m_failed++;
+        }
+
+        Release();
+    }
+
+    void Release()
+    {
+        if (--m_pending != 0)
+        {
+            return;
+        }
+
+        LOG_DEBUG(
+            "broadcast of {} byte(s) to {} client(s) done. skipped({}) failed({}) first({}) last({}) spread({})",
+            m_payload->size(),
+            m_report.m_clients,
+            m_report.m_skipped,
+            m_report.m_failed,
+            m_report.m_firstCompletion,
+            m_report.m_lastCompletion,
+            m_report.m_lastCompletion - m_report.m_firstCompletion
+        );
+
+        if (m_onComplete)
+        {
+            m_onComplete(m_report);
+        }
+    }
+
+    const SharedPayload m_payload;
+    BroadcastCompleteFunc m_onComplete;
+    const Clock::time_point m_start{ Clock::now() };
+    BroadcastReport m_report{};
+    // held by the broadcast itself until all sends are queued
+    size_t m_pending{ 1 };
+};
+
+void Proactor::Create(const BackendOptions& options)
 {
     if (s_instance == nullptr)
     {
-        s_instance = new Proactor;
+        // threads started from here on inherit the mask, so the signals only ever reach the loop's signalfds
+        sigset_t loopSignals{};
+        sigemptyset(&loopSignals);
+        for (int sig : s_loopSignals)
+        {
+            sigaddset(&loopSignals, sig);
+        }
+        if (int err{ pthread_sigmask(SIG_BLOCK, &loopSignals, &s_previousSignalMask) }; err != 0)
+        {
+            LOG_ERROR("loop signals could not be blocked. {}", strerror(err));
+        }
+
+        s_instance = new Proactor{ options };
     }
 }
 
@@ -47,12 +226,150 @@ void Proactor::Destroy()
     {
         delete s_instance;
         s_instance = nullptr;
+
+        pthread_sigmask(SIG_SETMASK, &s_previousSignalMask, nullptr);
+    }
+}
+
+Proactor::Proactor(const BackendOptions& options) : m_backend{ CreateBackend(options) }
+{
+    m_metrics = LoopMetrics{
+        .m_iterations = m_metricsRegistry.AddCounter("loop_iterations"),
+        .m_pendingEvents = m_metricsRegistry.AddGauge("pending_events"),
+        .m_cqDropped = m_metricsRegistry.AddCounter("cq_dropped"),
+        .m_orphansReaped = m_metricsRegistry.AddCounter("orphans_reaped"),
+        .m_opsCompleted = m_metricsRegistry.AddOpcodeCounters("ops_completed"),
+        .m_errors = m_metricsRegistry.AddErrnoCounters("errors"),
+        .m_bytesSent = m_metricsRegistry.AddCounter("tcp_bytes_sent"),
+        .m_bytesReceived = m_metricsRegistry.AddCounter("tcp_bytes_received"),
+        .m_sendSizes = m_metricsRegistry.AddHistogram("tcp_send_bytes"),
+        .m_recvSizes = m_metricsRegistry.AddHistogram("tcp_recv_bytes"),
+        .m_tcpConnects = m_metricsRegistry.AddCounter("tcp_connects"),
+        .m_tcpReconnectAttempts = m_metricsRegistry.AddCounter("tcp_reconnect_attempts"),
+        .m_udpDatagramsSent = m_metricsRegistry.AddCounter("udp_datagrams_sent"),
+        .m_udpDatagramsReceived = m_metricsRegistry.AddCounter("udp_datagrams_received"),
+        .m_unixAccepts = m_metricsRegistry.AddCounter("unix_accepts"),
+        .m_unixBytesSent = m_metricsRegistry.AddCounter("unix_bytes_sent"),
+        .m_unixBytesReceived = m_metricsRegistry.AddCounter("unix_bytes_received"),
+        .m_unixFdsReceived = m_metricsRegistry.AddCounter("unix_fds_received"),
+        .m_relayBytes = m_metricsRegistry.AddCounter("relay_bytes"),
+        .m_fileBytesRead = m_metricsRegistry.AddCounter("file_bytes_read"),
+        .m_fileBytesWritten = m_metricsRegistry.AddCounter("file_bytes_written"),
+        .m_fileSendBytes = m_metricsRegistry.AddCounter("file_send_bytes"),
+        .m_opLatency = {},
+    };
+    for (uint8_t opcode : s_timedOps)
+    {
+        m_metrics.m_opLatency[opcode] =
+            m_metricsRegistry.AddLatencyHistogram(std::format("{}_latency_ns", GetOpcodeName(opcode)));
+    }
+    m_backend->AttachMetrics(m_metricsRegistry);
+
+    LOG_INFO("proactor created. backend({})", GetBackendTypeName(m_backend->Type()));
+}
+
+Proactor::~Proactor()
+{
+    if (m_fileWatchFd != -1)
+    {
+        ::close(m_fileWatchFd);
+    }
+
+    const auto& stats{ m_backend->GetStats() };
+    LOG_INFO(
+        "proactor deleted. backend({}) cq-overflows({}) cq-dropped({}) sq-full({}) resizes({})",
+        GetBackendTypeName(m_backend->Type()),
+        stats.m_cqOverflows,
+        stats.m_cqDropped,
+        stats.m_sqFull,
+        stats.m_resizes
+    );
+    LogOpLatencies();
+    LogHandlerProfile();
+}
+
+void Proactor::EnableTracing(size_t capacity)
+{
+    m_tracer.Enable(capacity);
+    m_backend->AttachTracer(m_tracer);
+}
+
+void Proactor::LogHandlerProfile(size_t topN) const
+{
+    auto entries{ m_handlerProfiler.Top(topN) };
+    if (entries.empty())
+    {
+        return;
+    }
+
+    LOG_INFO("top {} handler callback(s) by time spent", entries.size());
+    LOG_INFO(
+        "{:<32} {:<20} {:>10} {:>14} {:>12} {:>12} {:>12}",
+        "handler",
+        "callback",
+        "calls",
+        "total",
+        "mean",
+        "p99",
+        "max"
+    );
+
+    for (const auto& [name, callback, profile] : entries)
+    {
+        LOG_INFO(
+            "{:<32} {:<20} {:>10} {:>14} {:>12} {:>12} {:>12}",
+            name,
+            GetCallbackName(callback),
+            profile->m_calls,
+            profile->m_total,
+            profile->Mean(),
+            profile->Percentile(99),
+            profile->m_max
+        );
+    }
+}
+
+std::vector<OpLatency> Proactor::OpLatencies() const
+{
+    std::vector<OpLatency> latencies;
+    latencies.reserve(s_timedOps.size());
+
+    for (uint8_t opcode : s_timedOps)
+    {
+        const Metrics::LatencyHistogram& histogram{ m_metrics.m_opLatency[opcode] };
+        latencies.push_back(OpLatency{
+            .m_op = GetOpcodeName(opcode),
+            .m_count = histogram.Count(),
+            .m_p50 = TimeNS{ histogram.Percentile(50) },
+            .m_p99 = TimeNS{ histogram.Percentile(99) },
+            .m_p999 = TimeNS{ histogram.Percentile(99.9) },
+            .m_max = TimeNS{ histogram.Max() },
+        });
     }
+
+    return latencies;
 }
 
-Proactor::Proactor() { LOG_INFO("proactor created"); }
+void Proactor::LogOpLatencies() const
+{
+    for (const OpLatency& latency : OpLatencies())
+    {
+        if (latency.m_count == 0)
+        {
+            continue;
+        }
 
-Proactor::~Proactor() { LOG_INFO("proactor deleted"); }
+        LOG_INFO(
+            "{} latency count({}) p50({}) p99({}) p99.9({}) max({})",
+            latency.m_op,
+            latency.m_count,
+            latency.m_p50,
+            latency.m_p99,
+            latency.m_p999,
+            latency.m_max
+        );
+    }
+}
 
 void Proactor::StartAllHandlers()
 {
@@ -65,41 +382,172 @@ void Proactor::StartAllHandlers()
     {
         RequestTcpConnect(*handler);
     }
+
+    for (auto [_, handler] : m_udpSockets)
+    {
+        RequestUdpRecv(*handler);
+    }
+
+    for (auto [_, handler] : m_unixListeners)
+    {
+        RequestUnixAccept(*handler);
+    }
+
+    for (auto [_, handler] : m_unixSockets)
+    {
+        if (handler->m_state == UnixSocket::Connecting)
+        {
+            RequestUnixConnect(*handler);
+        }
+        else if (handler->m_state == UnixSocket::Connected)
+        {
+            RequestUnixRecv(*handler);
+        }
+    }
+
+    for (auto [_, handler] : m_tcpRelays)
+    {
+        PumpRelay(*handler);
+    }
+
+    for (auto [_, handler] : m_fileHandles)
+    {
+        RequestFileOpen(*handler);
+    }
 }
 
 void Proactor::Run()
 {
     AttachExitHandlers();
+    AttachStateDumpHandler();
     StartAllHandlers();
 
     m_running = true;
 
     while (m_running)
     {
-        UniqueUringCEvent cEvent{ m_ioURing.WaitForEvent() };
-        if (cEvent == nullptr)
+        HandleCompletion();
+        FlushUdpSends();
+        m_handlerProfiler.Collect();
+
+        // the completion must have been marked as seen before the rings can be flushed or resized
+        if (const size_t dropped{ m_backend->FlushOverflow() }; dropped > 0) [[unlikely]]
         {
-            continue;
+            m_metrics.m_cqDropped.Add(dropped);
+            SuspectOrphans();
+        }
+        if (not m_orphanSuspects.empty()) [[unlikely]]
+        {
+            ReapOrphans();
         }
+        m_backend->AdaptCapacity(m_pendingEvents.size());
 
-        size_t userData{ cEvent->user_data };
-        auto itr{ m_pendingEvents.find(userData) };
-        if (itr == m_pendingEvents.end())
+        m_metrics.m_iterations.Add();
+        m_metrics.m_pendingEvents.Set(static_cast<int64_t>(m_pendingEvents.size()));
+
+        // rate limited sites whose bursts have stopped
+        Logger::ReportSuppressed();
+    }
+}
+
+void Proactor::SuspectOrphans()
+{
+    size_t unverifiable{ 0 };
+    for (const auto& [eventId, event] : m_pendingEvents)
+    {
+        // multishot ops show they're alive with their next completion
+        if (not event->m_removeOnComplete)
         {
-            LOG_ERROR("failed to find event for user-data={}", userData);
             continue;
         }
 
-        auto& event{ itr->second };
-        LOG_DEBUG("got event={}", event->NameAndType());
+        if (CompletesUnaided(*event))
+        {
+            m_orphanSuspects.push_back(eventId);
+        }
+        else
+        {
+            unverifiable++;
+        }
+    }
+
+    LOG_WARNING(
+        "completions dropped. ops({}) still pending in {} are presumed lost, ops({}) waiting on a peer can't be told "
+        "apart from lost ones",
+        m_orphanSuspects.size(),
+        s_orphanAge,
+        unverifiable
+    );
+}
+
+void Proactor::ReapOrphans()
+{
+    const Clock::time_point now{ Clock::now() };
+    if (now < m_nextOrphanCheck)
+    {
+        return;
+    }
+    m_nextOrphanCheck = now + 1s;
+
+    std::vector<EventId> suspects{ std::move(m_orphanSuspects) };
+    m_orphanSuspects.clear();
 
-        event->m_onCompleteCb(*event, *cEvent);
+    for (EventId eventId : suspects)
+    {
+        auto itr{ m_pendingEvents.find(eventId) };
+        if (itr == m_pendingEvents.end())
+        {
+            continue;
+        }
 
-        // dont remove the continuously firing timer
-        if (event->m_removeOnComplete)
+        if (now - itr->second->m_submitTime < s_orphanAge)
         {
-            m_pendingEvents.erase(itr);
+            m_orphanSuspects.push_back(eventId);
+            continue;
         }
+
+        auto& orphan{ itr->second };
+        LOG_WARNING("reaping event({}) whose completion was dropped", orphan->NameAndType());
+        m_metrics.m_orphansReaped.Add();
+
+        // fails the op as a cancel would, so its handler sees it end
+        io_uring_cqe orphanEvent{};
+        orphanEvent.user_data = eventId;
+        orphanEvent.res = -ECANCELED;
+        orphan->m_onCompleteCb(*orphan, orphanEvent);
+
+        m_pendingEvents.erase(eventId);
+    }
+}
+
+void Proactor::HandleCompletion()
+{
+    UniqueUringCEvent cEvent{ m_backend->WaitForEvent() };
+    if (cEvent == nullptr)
+    {
+        return;
+    }
+
+    size_t userData{ cEvent->user_data };
+    auto itr{ m_pendingEvents.find(userData) };
+    if (itr == m_pendingEvents.end())
+    {
+        LOG_ERROR_RATE_LIMITED(s_completionErrorsPerSecond, "failed to find event for user-data={}", userData);
+        return;
+    }
+
+    auto& event{ itr->second };
+    LOG_DEBUG("got event={}", event->NameAndType());
+
+    m_tracer.Trace(TracePhase::Complete, userData, event->m_handlerId, 0, cEvent->res);
+    m_tracer.Trace(TracePhase::CallbackBegin, userData, event->m_handlerId, 0, cEvent->res);
+    event->m_onCompleteCb(*event, *cEvent);
+    m_tracer.Trace(TracePhase::CallbackEnd, userData);
+
+    // dont remove the continuously firing timer
+    if (event->m_removeOnComplete)
+    {
+        m_pendingEvents.erase(itr);
     }
 }
 
@@ -151,6 +599,7 @@ void Proactor::RemoveTimerHandler(TimerHandler& handler)
     }
 
     LOG_INFO("[{}] handler removed", handler.Name());
+    m_handlerProfiler.Retire(handler.m_id);
 
     RequestTimerCancel(handler);
 }
@@ -194,88 +643,371 @@ void Proactor::RemoveSocketClient(TcpClient& handler)
     LOG_INFO("[{}] handler removed", handler.Name());
 
     m_tcpClients.erase(itr);
+    m_handlerProfiler.Retire(handler.m_id);
+
+    std::vector<FileSendId> sends;
+    for (const auto& [id, send] : m_fileSends)
+    {
+        if (send->m_clientId == handler.m_id)
+        {
+            sends.push_back(id);
+        }
+    }
+    for (FileSendId id : sends)
+    {
+        FinishFileSend(id, -ECANCELED);
+    }
 }
 
-void Proactor::RequestTimerContinuous(TimerHandler& handler)
+void Proactor::AddUdpSocket(UdpSocket& handler)
 {
-    auto event{ std::make_unique<TimerExpiredEvent>(
-        handler.m_id, [this](Event& event, const io_uring_cqe& cEvent) { CompleteTimerExpiredEvent(event, cEvent); }
-    ) };
-    auto eventId{ event->m_id };
-
-    if (auto data{ static_cast<IOURing::UserData>(event->m_id) };
-        not m_ioURing.QueueTimeoutEvent(data, handler.m_period))
+    if (m_udpSockets.contains(handler.m_id))
     {
-        LOG_ERROR("[{}] kick failed", handler.Name());
+        LOG_ERROR("[{}] handler already in collection", handler.Name());
         return;
     }
 
-    m_pendingEvents[eventId] = std::move(event);
-    LOG_DEBUG("[{}] timer kicked eventId({})", handler.Name(), eventId);
+    m_udpSockets[handler.m_id] = &handler;
+
+    if (m_running)
+    {
+        RequestUdpRecv(handler);
+    }
 }
 
-void Proactor::RequestTimerUpdate(TimerHandler& handler)
+void Proactor::RemoveUdpSocket(UdpSocket& handler)
 {
-    const auto timerExpireEvent{ FindPendingEvent<TimerExpiredEvent>(handler.m_id) };
-    if (timerExpireEvent == nullptr)
+    auto itr = m_udpSockets.find(handler.m_id);
+    if (itr == m_udpSockets.end())
     {
-        LOG_ERROR("[{}] failed to find pending expiry timer for handler {}", handler.Name(), handler.m_id);
+        LOG_ERROR("[{}] handler not in collection", handler.Name());
         return;
     }
 
-    std::unique_ptr<TimerUpdateEvent> updateEvent{ std::make_unique<TimerUpdateEvent>(
-        handler.m_id, [this](Event& event, const io_uring_cqe& cEvent) { CompleteTimerUpdateEvent(event, cEvent); }
+    LOG_INFO("[{}] handler removed", handler.Name());
+
+    m_udpSockets.erase(itr);
+    m_handlerProfiler.Retire(handler.m_id);
+    std::erase(m_udpFlushes, handler.m_id);
+
+    // the pending receive holds its own reference to the socket, closing the fd doesn't end it
+    Event* recvEvent{ FindPendingEvent<UdpRecvMsg>(handler.m_id) };
+    if (recvEvent == nullptr)
+    {
+        recvEvent = FindPendingEvent<UdpPoll>(handler.m_id);
+    }
+    if (recvEvent == nullptr)
+    {
+        return;
+    }
+
+    auto cancelEvent{ std::make_unique<UdpRecvCancel>(
+        handler.m_id, [this](Event& event, const io_uring_cqe& cEvent) { CompleteUdpRecvCancel(event, cEvent); }
     ) };
-    // the timeout user data must be the same as the inital timeout used data
-    IOURing::UserData currentTimerUserData{ timerExpireEvent->m_id };
-    IOURing::UserData userData{ updateEvent->m_id };
-    if (not m_ioURing.UpdateTimeoutEvent(userData, currentTimerUserData, handler.m_period))
+    IOBackend::UserData userData{ cancelEvent->m_id };
+
+    if (not m_backend->CancelOp(userData, static_cast<IOBackend::UserData>(recvEvent->m_id)))
     {
-        LOG_ERROR("[{}] update timer failed", handler.Name());
+        LOG_ERROR("[{}] failed to queue udp recv cancel", handler.Name());
         return;
     }
 
-    m_pendingEvents[userData] = std::move(updateEvent);
-    LOG_INFO(
-        "[{}] timer update triggered eventId({}) new-timeout: {}",
-        handler.Name(),
-        timerExpireEvent->m_id,
-        std::chrono::duration_cast<TimeMS>(handler.m_period)
-    );
+    m_pendingEvents[userData] = std::move(cancelEvent);
 }
 
-void Proactor::RequestTimerCancel(TimerHandler& handler)
+void Proactor::ScheduleUdpFlush(UdpSocket& handler) { m_udpFlushes.push_back(handler.m_id); }
+
+void Proactor::AddUnixListener(UnixListener& handler)
 {
-    const auto timerExpireEvent{ FindPendingEvent<TimerExpiredEvent>(handler.m_id) };
-    if (timerExpireEvent == nullptr)
+    if (m_unixListeners.contains(handler.m_id))
     {
-        LOG_ERROR("[{}] failed to find pending expiry timer for handler {}", handler.Name(), handler.m_id);
+        LOG_ERROR("[{}] handler already in collection", handler.Name());
         return;
     }
 
-    std::unique_ptr<TimerCancelEvent> cancelEvent{ std::make_unique<TimerCancelEvent>(
-        handler.m_id, [this](Event& event, const io_uring_cqe& cEvent) { CompleteTimerCancelEvent(event, cEvent); }
-    ) };
-    // the timeout user data must be the same as the inital timeout used data
-    IOURing::UserData currentTimerUserData{ timerExpireEvent->m_id };
-    IOURing::UserData userData{ cancelEvent->m_id };
-    if (not m_ioURing.CancelTimeoutEvent(userData, currentTimerUserData))
+    m_unixListeners[handler.m_id] = &handler;
+
+    if (m_running)
     {
-        LOG_ERROR("[{}] cancel failed", handler.Name());
-        return;
+        RequestUnixAccept(handler);
     }
-
-    m_pendingEvents[userData] = std::move(cancelEvent);
-    LOG_DEBUG("[{}] handler cancel triggered eventId({})", handler.Name(), timerExpireEvent->m_id);
 }
 
-void Proactor::AttachExitHandlers()
+void Proactor::RemoveUnixListener(UnixListener& handler)
 {
-    constexpr std::array exitSignals{ SIGINT, SIGQUIT, SIGTERM };
+    auto itr = m_unixListeners.find(handler.m_id);
+    if (itr == m_unixListeners.end())
+    {
+        LOG_ERROR("[{}] handler not in collection", handler.Name());
+        return;
+    }
 
-    for (auto sig : exitSignals)
+    LOG_INFO("[{}] handler removed", handler.Name());
+
+    m_unixListeners.erase(itr);
+    m_handlerProfiler.Retire(handler.m_id);
+
+    if (const Event* acceptEvent{ FindPendingEvent<UnixAccept>(handler.m_id) }; acceptEvent != nullptr)
     {
-        AddSignalHandler(
+        RequestUnixCancel(handler.m_id, handler.Name(), *acceptEvent);
+    }
+}
+
+void Proactor::AddUnixSocket(UnixSocket& handler)
+{
+    if (m_unixSockets.contains(handler.m_id))
+    {
+        LOG_ERROR("[{}] handler already in collection", handler.Name());
+        return;
+    }
+
+    m_unixSockets[handler.m_id] = &handler;
+
+    if (not m_running)
+    {
+        return;
+    }
+
+    if (handler.m_state == UnixSocket::Connecting)
+    {
+        RequestUnixConnect(handler);
+    }
+    else
+    {
+        RequestUnixRecv(handler);
+    }
+}
+
+void Proactor::RemoveUnixSocket(UnixSocket& handler)
+{
+    auto itr = m_unixSockets.find(handler.m_id);
+    if (itr == m_unixSockets.end())
+    {
+        LOG_ERROR("[{}] handler not in collection", handler.Name());
+        return;
+    }
+
+    LOG_INFO("[{}] handler removed", handler.Name());
+
+    m_unixSockets.erase(itr);
+    m_handlerProfiler.Retire(handler.m_id);
+
+    // the pending ops hold their own reference to the socket, closing the fd doesn't end them.
+    // sends in flight are left to finish
+    if (const Event* recvEvent{ FindPendingEvent<UnixRecv>(handler.m_id) }; recvEvent != nullptr)
+    {
+        RequestUnixCancel(handler.m_id, handler.Name(), *recvEvent);
+    }
+
+    if (const Event* connectEvent{ FindPendingEvent<UnixConnect>(handler.m_id) }; connectEvent != nullptr)
+    {
+        RequestUnixCancel(handler.m_id, handler.Name(), *connectEvent);
+    }
+}
+
+void Proactor::AddTcpRelay(TcpRelay& handler)
+{
+    if (m_tcpRelays.contains(handler.m_id))
+    {
+        LOG_ERROR("[{}] handler already in collection", handler.Name());
+        return;
+    }
+
+    m_tcpRelays[handler.m_id] = &handler;
+
+    if (m_running)
+    {
+        PumpRelay(handler);
+    }
+}
+
+void Proactor::RemoveTcpRelay(TcpRelay& handler)
+{
+    auto itr = m_tcpRelays.find(handler.m_id);
+    if (itr == m_tcpRelays.end())
+    {
+        LOG_ERROR("[{}] handler not in collection", handler.Name());
+        return;
+    }
+
+    LOG_INFO(
+        "[{}] handler removed. to-upstream({}B) to-client({}B)",
+        handler.Name(),
+        handler.BytesToUpstream(),
+        handler.BytesToClient()
+    );
+
+    m_tcpRelays.erase(itr);
+    m_handlerProfiler.Retire(handler.m_id);
+
+    // already cancelled when closed
+    if (not handler.m_closed)
+    {
+        handler.m_closed = true;
+        CancelRelayTransfers(handler);
+    }
+}
+
+void Proactor::AddFileHandle(FileHandle& handler)
+{
+    if (m_fileHandles.contains(handler.m_id))
+    {
+        LOG_ERROR("[{}] handler already in collection", handler.Name());
+        return;
+    }
+
+    m_fileHandles[handler.m_id] = &handler;
+
+    if (m_running)
+    {
+        RequestFileOpen(handler);
+    }
+}
+
+void Proactor::RemoveFileHandle(FileHandle& handler)
+{
+    auto itr = m_fileHandles.find(handler.m_id);
+    if (itr == m_fileHandles.end())
+    {
+        LOG_ERROR("[{}] handler not in collection", handler.Name());
+        return;
+    }
+
+    LOG_INFO(
+        "[{}] handler removed. in-flight({}) queued({})", handler.Name(), handler.m_inFlight, handler.m_queue.size()
+    );
+
+    m_fileHandles.erase(itr);
+    m_handlerProfiler.Retire(handler.m_id);
+
+    // ops in flight are left to finish, their buffers are the caller's
+    handler.m_queue.clear();
+    handler.m_state = FileHandle::Closed;
+}
+
+void Proactor::RequestFileRead(
+    FileHandle& handler, std::span<uint8_t> buffer, uint64_t offset, FileCompleteFunc&& onComplete
+)
+{
+    auto event{ MakeFileOp(handler, FileOpKind::Read) };
+    event->m_rxBuffer = buffer;
+    event->m_offset = offset;
+    event->m_onComplete = std::move(onComplete);
+    RequestFileOp(handler, std::move(event));
+}
+
+void Proactor::RequestFileWrite(
+    FileHandle& handler, std::span<const uint8_t> buffer, uint64_t offset, FileCompleteFunc&& onComplete
+)
+{
+    auto event{ MakeFileOp(handler, FileOpKind::Write) };
+    event->m_txBuffer = buffer;
+    event->m_offset = offset;
+    event->m_onComplete = std::move(onComplete);
+    RequestFileOp(handler, std::move(event));
+}
+
+void Proactor::RequestFileSync(FileHandle& handler, bool dataOnly, FileCompleteFunc&& onComplete)
+{
+    auto event{ MakeFileOp(handler, FileOpKind::Sync) };
+    event->m_dataOnly = dataOnly;
+    event->m_onComplete = std::move(onComplete);
+    RequestFileOp(handler, std::move(event));
+}
+
+void Proactor::RequestFileStat(FileHandle& handler, FileStatFunc&& onStat)
+{
+    auto event{ MakeFileOp(handler, FileOpKind::Stat) };
+    event->m_onStat = std::move(onStat);
+    RequestFileOp(handler, std::move(event));
+}
+
+void Proactor::RequestTimerContinuous(TimerHandler& handler)
+{
+    auto event{ std::make_unique<TimerExpiredEvent>(
+        handler.m_id, [this](Event& event, const io_uring_cqe& cEvent) { CompleteTimerExpiredEvent(event, cEvent); }
+    ) };
+    auto eventId{ event->m_id };
+
+    if (auto data{ static_cast<IOBackend::UserData>(event->m_id) };
+        not m_backend->QueueTimeoutEvent(data, handler.m_period))
+    {
+        LOG_ERROR("[{}] kick failed", handler.Name());
+        return;
+    }
+
+    m_pendingEvents[eventId] = std::move(event);
+    LOG_DEBUG("[{}] timer kicked eventId({})", handler.Name(), eventId);
+}
+
+void Proactor::RequestTimerUpdate(TimerHandler& handler)
+{
+    const auto timerExpireEvent{ FindPendingEvent<TimerExpiredEvent>(handler.m_id) };
+    if (timerExpireEvent == nullptr)
+    {
+        LOG_ERROR("[{}] failed to find pending expiry timer for handler {}", handler.Name(), handler.m_id);
+        return;
+    }
+
+    std::unique_ptr<TimerUpdateEvent> updateEvent{ std::make_unique<TimerUpdateEvent>(
+        handler.m_id, [this](Event& event, const io_uring_cqe& cEvent) { CompleteTimerUpdateEvent(event, cEvent); }
+    ) };
+    // the timeout user data must be the same as the inital timeout used data
+    IOBackend::UserData currentTimerUserData{ timerExpireEvent->m_id };
+    IOBackend::UserData userData{ updateEvent->m_id };
+    if (not m_backend->UpdateTimeoutEvent(userData, currentTimerUserData, handler.m_period))
+    {
+        LOG_ERROR("[{}] update timer failed", handler.Name());
+        return;
+    }
+
+    m_pendingEvents[userData] = std::move(updateEvent);
+    LOG_INFO(
+        "[{}] timer update triggered eventId({}) new-timeout: {}",
+        handler.Name(),
+        timerExpireEvent->m_id,
+        std::chrono::duration_cast<TimeMS>(handler.m_period)
+    );
+}
+
+void Proactor::RequestTimerCancel(TimerHandler& handler)
+{
+    const auto timerExpireEvent{ FindPendingEvent<TimerExpiredEvent>(handler.m_id) };
+    if (timerExpireEvent == nullptr)
+    {
+        LOG_ERROR("[{}] failed to find pending expiry timer for handler {}", handler.Name(), handler.m_id);
+        return;
+    }
+
+    std::unique_ptr<TimerCancelEvent> cancelEvent{ std::make_unique<TimerCancelEvent>(
+        handler.m_id, [this](Event& event, const io_uring_cqe& cEvent) { CompleteTimerCancelEvent(event, cEvent); }
+    ) };
+    // the timeout user data must be the same as the inital timeout used data
+    IOBackend::UserData currentTimerUserData{ timerExpireEvent->m_id };
+    IOBackend::UserData userData{ cancelEvent->m_id };
+    if (not m_backend->CancelTimeoutEvent(userData, currentTimerUserData))
+    {
+        LOG_ERROR("[{}] cancel failed", handler.Name());
+        return;
+    }
+
+    m_pendingEvents[userData] = std::move(cancelEvent);
+    LOG_DEBUG("[{}] handler cancel triggered eventId({})", handler.Name(), timerExpireEvent->m_id);
+}
+
+void Proactor::AttachExitHandlers()
+{
+    constexpr std::array exitSignals{ SIGINT, SIGQUIT, SIGTERM };
+
+    for (auto sig : exitSignals)
+    {
+        if (m_signalHandlers.contains(sig))
+        {
+            LOG_INFO("{} is handled by the application. the loop stops only if its handler calls Stop", strsignal(sig));
+            continue;
+        }
+
+        AddSignalHandler(
             sig,
             [this](const signalfd_siginfo& info)
             {
@@ -346,309 +1078,2456 @@ void Proactor::AddSignalHandler(int sig, SignalHandleFunc&& func)
     }
 }
 
-bool Proactor::RequestSignalRead(int signal, int signalFd)
+void Proactor::AttachStateDumpHandler()
 {
-    auto event{ std::make_unique<SignalEvent>(
-        signal,
-        signalFd,
-        [this](Event& event, const io_uring_cqe& cEvent)
-        { CompleteSignalEvent(static_cast<SignalEvent&>(event), cEvent); }
-    ) };
-    IOURing::UserData userData{ event->m_id };
-    if (not m_ioURing.QueueSignalRead(userData, event->m_signalFd, event->m_signalReadBuff))
+    if (m_signalHandlers.contains(SIGUSR1))
     {
-        LOG_ERROR("signal queue read failed for {}({})", strsignal(signal), signal);
-        return false;
+        LOG_INFO("SIGUSR1 is handled by the application. state dumps are only available on request");
+        return;
     }
 
-    LOG_DEBUG("signal {}({}) read queued", strsignal(signal), signal);
-    m_pendingEvents[userData] = std::move(event);
+    AddSignalHandler(
+        SIGUSR1,
+        [this](const signalfd_siginfo&)
+        {
+            DumpState(m_stateDumpFile);
+            LogOpLatencies();
+            LogHandlerProfile();
+        }
+    );
+}
 
-    return true;
+void Proactor::DumpState(const std::string& path) const
+{
+    const std::vector<std::string> lines{ StateSnapshot() };
+
+    if (path.empty())
+    {
+        for (const std::string& line : lines)
+        {
+            LOG_INFO("{}", line);
+        }
+        return;
+    }
+
+    std::ofstream file{ path, std::ios::out | std::ios::app };
+    if (not file)
+    {
+        LOG_ERROR("unable to write the state dump to '{}'", path);
+        return;
+    }
+
+    const Timestamp ts{ GetCurrentTimeStamp() };
+    std::println(file, "[{}{}]", ts.m_date, ts.m_ns);
+    for (const std::string& line : lines)
+    {
+        std::println(file, "{}", line);
+    }
+
+    LOG_INFO("state dumped to '{}'", path);
 }
 
-void Proactor::RequestTcpConnect(TcpClient& handler)
+std::vector<std::string> Proactor::StateSnapshot() const
 {
-    handler.m_state = TcpClient::Broken;
+    auto handlerName = [this](Handle::Id id) -> std::string_view
+    {
+        if (auto itr{ m_tcpClients.find(id) }; itr != m_tcpClients.end())
+        {
+            return itr->second->Name();
+        }
+        if (auto itr{ m_timerHandlers.find(id) }; itr != m_timerHandlers.end())
+        {
+            return itr->second->Name();
+        }
+        if (auto itr{ m_udpSockets.find(id) }; itr != m_udpSockets.end())
+        {
+            return itr->second->Name();
+        }
+        if (auto itr{ m_unixListeners.find(id) }; itr != m_unixListeners.end())
+        {
+            return itr->second->Name();
+        }
+        if (auto itr{ m_unixSockets.find(id) }; itr != m_unixSockets.end())
+        {
+            return itr->second->Name();
+        }
+        if (auto itr{ m_tcpRelays.find(id) }; itr != m_tcpRelays.end())
+        {
+            return itr->second->Name();
+        }
+        if (auto itr{ m_fileHandles.find(id) }; itr != m_fileHandles.end())
+        {
+            return itr->second->Name();
+        }
+        return "-";
+    };
 
-    auto event{ std::make_unique<TcpConnect>(
-        handler.m_id,
-        [this](Event& event, const io_uring_cqe& cEvent)
-        { CompleteTcpConnect(static_cast<TcpConnect&>(event), cEvent); },
-        handler.m_host,
-        handler.m_port
-    ) };
-    IOURing::UserData userData{ event->m_id };
-    event->m_fd = m_ioURing.QueueTcpConnect(userData, event->m_host, event->m_port);
-    if (event->m_fd == -1)
+    auto stateName = [](TcpClient::ConnectionState state) -> std::string_view
     {
-        LOG_ERROR("net connect queue failed for '{}:{}'", handler.m_host, handler.m_port);
+        switch (state)
+        {
+            case TcpClient::Unknown:
+                return "unknown";
+            case TcpClient::Broken:
+                return "broken";
+            case TcpClient::Connecting:
+                return "connecting";
+            case TcpClient::Connected:
+                return "connected";
+        }
+        return "invalid";
+    };
+
+    auto unixStateName = [](UnixSocket::State state) -> std::string_view
+    {
+        switch (state)
+        {
+            case UnixSocket::Connecting:
+                return "connecting";
+            case UnixSocket::Connected:
+                return "connected";
+            case UnixSocket::Closed:
+                return "closed";
+        }
+        return "invalid";
+    };
+
+    std::vector<std::string> lines;
+    const auto& stats{ m_backend->GetStats() };
+    const auto occupancy{ m_backend->GetOccupancy() };
+    const auto& eventPool{ Event::GetPoolStats() };
+    const auto& rxPool{ m_rxBufferPool.GetStats() };
+    const auto& txPool{ m_txBufferPool.GetStats() };
+
+    lines.push_back(std::format(
+        "state dump. backend({}) running({}) pending-events({}) timers({}) clients({}) udp-sockets({}) "
+        "unix-listeners({}) unix-sockets({}) relays({}) files({}) file-sends({}) signal-handlers({}) file-watches({})",
+        GetBackendTypeName(m_backend->Type()),
+        m_running,
+        m_pendingEvents.size(),
+        m_timerHandlers.size(),
+        m_tcpClients.size(),
+        m_udpSockets.size(),
+        m_unixListeners.size(),
+        m_unixSockets.size(),
+        m_tcpRelays.size(),
+        m_fileHandles.size(),
+        m_fileSends.size(),
+        m_signalHandlers.size(),
+        m_fileWatches.size()
+    ));
+    lines.push_back(std::format(
+        "ring sq-entries({}) cq-entries({}) sq-queued({}) cq-ready({}) cq-overflows({}) cq-dropped({}) sq-full({}) "
+        "resizes({})",
+        stats.m_sqEntries,
+        stats.m_cqEntries,
+        occupancy.m_sqQueued,
+        occupancy.m_cqReady,
+        stats.m_cqOverflows,
+        stats.m_cqDropped,
+        stats.m_sqFull,
+        stats.m_resizes
+    ));
+    lines.push_back(std::format("event pool allocations({}) live({})", eventPool.m_allocations, eventPool.m_live));
+    for (auto [poolName, pool] : { std::pair{ "rx", &rxPool }, std::pair{ "tx", &txPool } })
+    {
+        lines.push_back(std::format(
+            "{} buffer pool allocated({}) in-use({}) free({}) acquires({})",
+            poolName,
+            pool->m_blocksAllocated,
+            pool->m_blocksInUse,
+            pool->m_blocksFree,
+            pool->m_acquires
+        ));
+    }
+
+    // pending events grouped by type and handler
+    std::map<std::pair<std::string, Handle::Id>, size_t> pendingGroups;
+    for (const auto& [_, event] : m_pendingEvents)
+    {
+        pendingGroups[{ event->NameAndType(), event->m_handlerId }]++;
+    }
+    for (const auto& [group, count] : pendingGroups)
+    {
+        const auto& [type, handlerId] = group;
+        lines.push_back(
+            std::format("pending {} handler({}:{}) count({})", type, handlerId, handlerName(handlerId), count)
+        );
+    }
+
+    for (const auto& [_, handler] : m_timerHandlers)
+    {
+        lines.push_back(std::format("timer [{}] period({})", handler->Name(), handler->m_period));
+    }
+
+    for (const auto& [_, client] : m_tcpClients)
+    {
+        lines.push_back(std::format(
+            "client [{}] state({}) fd({}) tx-queued({}) rx-pending({}) recv-mode({})",
+            client->Name(),
+            stateName(client->m_state),
+            client->m_fd,
+            client->m_txBuffer.size(),
+            client->m_rxPending,
+            client->m_recvMode == TcpClient::CompletionRecv ? "completion" : "readiness"
+        ));
+    }
+
+    for (const auto& [_, socket] : m_udpSockets)
+    {
+        lines.push_back(std::format(
+            "udp [{}] fd({}) port({}) rx-pending({}) tx-batched({}) gso({})",
+            socket->Name(),
+            socket->m_fd,
+            socket->m_localPort,
+            socket->m_rxPending,
+            socket->m_segments,
+            socket->m_gso
+        ));
+    }
+
+    for (const auto& [_, listener] : m_unixListeners)
+    {
+        lines.push_back(std::format(
+            "unix listener [{}] fd({}) path({}) accept-pending({})",
+            listener->Name(),
+            listener->m_fd,
+            listener->m_path,
+            listener->m_acceptPending
+        ));
+    }
+
+    for (const auto& [_, socket] : m_unixSockets)
+    {
+        lines.push_back(std::format(
+            "unix [{}] state({}) fd({}) rx-pending({}) tx-pending({}) tx-queued({})",
+            socket->Name(),
+            unixStateName(socket->m_state),
+            socket->m_fd,
+            socket->m_rxPending,
+            socket->m_txPending,
+            socket->m_txQueue.size()
+        ));
+    }
+
+    for (const auto& [_, relay] : m_tcpRelays)
+    {
+        for (auto [direction, flow] : { std::pair{ "to-upstream", &relay->m_directions[TcpRelay::s_toUpstream] },
+                                        std::pair{ "to-client", &relay->m_directions[TcpRelay::s_toClient] } })
+        {
+            lines.push_back(std::format(
+                "relay [{}] {} mode({}) closed({}) buffered({}/{}) filling({}) draining({}) eof({}) bytes({})",
+                relay->Name(),
+                direction,
+                relay->m_mode == TcpRelay::Mode::Splice ? "splice" : "copy",
+                relay->m_closed,
+                flow->m_buffered,
+                flow->m_capacity,
+                flow->m_filling,
+                flow->m_draining,
+                flow->m_eof,
+                flow->m_bytes
+            ));
+        }
+    }
+
+    for (const auto& [_, file] : m_fileHandles)
+    {
+        lines.push_back(std::format(
+            "file [{}] state({}) fd({}) in-flight({}/{}) queued({}) direct({})",
+            file->Name(),
+            file->m_state == FileHandle::Open ? "open" : (file->m_state == FileHandle::Opening ? "opening" : "closed"),
+            file->m_fd,
+            file->m_inFlight,
+            file->m_options.m_queueDepth,
+            file->m_queue.size(),
+            file->m_options.m_direct
+        ));
+    }
+
+    for (const auto& [id, send] : m_fileSends)
+    {
+        lines.push_back(std::format(
+            "file send({}) [{}] sent({}/{}) buffered({}/{}) filling({}) draining({}) stalled({})",
+            id,
+            send->Name(),
+            send->m_sent,
+            send->m_total,
+            send->m_buffered,
+            send->m_capacity,
+            send->m_filling,
+            send->m_draining,
+            send->m_stalled
+        ));
+    }
+
+    return lines;
+}
+
+bool Proactor::RequestSignalRead(int signal, int signalFd)
+{
+    auto event{ std::make_unique<SignalEvent>(
+        signal,
+        signalFd,
+        [this](Event& event, const io_uring_cqe& cEvent)
+        { CompleteSignalEvent(static_cast<SignalEvent&>(event), cEvent); }
+    ) };
+    IOBackend::UserData userData{ event->m_id };
+    if (not m_backend->QueueSignalRead(userData, event->m_signalFd, event->m_signalReadBuff))
+    {
+        LOG_ERROR("signal queue read failed for {}({})", strsignal(signal), signal);
+        return false;
+    }
+
+    LOG_DEBUG("signal {}({}) read queued", strsignal(signal), signal);
+    m_pendingEvents[userData] = std::move(event);
+
+    return true;
+}
+
+int Proactor::AddFileWatch(const std::string& path, uint32_t mask, FileWatchFunc&& func)
+{
+    if (m_fileWatchFd == -1)
+    {
+        // blocking reads are fine. the ring waits for the fd to become readable
+        m_fileWatchFd = inotify_init1(IN_CLOEXEC);
+        if (m_fileWatchFd == -1)
+        {
+            int err{ errno };
+            LOG_ERROR("inotify fd creation failed. {}", strerror(err));
+            return -1;
+        }
+
+        if (not RequestFileWatchRead())
+        {
+            ::close(m_fileWatchFd);
+            m_fileWatchFd = -1;
+            return -1;
+        }
+    }
+
+    int watchId{ inotify_add_watch(m_fileWatchFd, path.c_str(), mask) };
+    if (watchId == -1)
+    {
+        int err{ errno };
+        LOG_ERROR("failed to watch '{}'. {}", path, strerror(err));
+        return -1;
+    }
+
+    // watching the same path again hands back the same id. the latest callback wins
+    m_fileWatches[watchId] = std::move(func);
+    LOG_DEBUG("watching '{}' watchId({})", path, watchId);
+
+    return watchId;
+}
+
+void Proactor::RemoveFileWatch(int watchId)
+{
+    if (m_fileWatches.erase(watchId) == 0)
+    {
+        LOG_ERROR("file watch {} not in collection", watchId);
+        return;
+    }
+
+    // the watch may already be gone along with the file
+    inotify_rm_watch(m_fileWatchFd, watchId);
+}
+
+bool Proactor::RequestFileWatchRead()
+{
+    auto event{ std::make_unique<FileWatchEvent>(
+        [this](Event& event, const io_uring_cqe& cEvent)
+        { CompleteFileWatchEvent(static_cast<FileWatchEvent&>(event), cEvent); }
+    ) };
+    IOBackend::UserData userData{ event->m_id };
+    if (not m_backend->QueueRead(userData, m_fileWatchFd, event->m_readBuff))
+    {
+        LOG_ERROR("file watch queue read failed");
+        return false;
+    }
+
+    m_pendingEvents[userData] = std::move(event);
+
+    return true;
+}
+
+void Proactor::RequestTcpConnect(TcpClient& handler)
+{
+    // the connection was lost or the last attempt failed
+    if (handler.m_state == TcpClient::Broken)
+    {
+        m_metrics.m_tcpReconnectAttempts.Add();
+    }
+    handler.m_state = TcpClient::Broken;
+
+    auto event{ std::make_unique<TcpConnect>(
+        handler.m_id,
+        [this](Event& event, const io_uring_cqe& cEvent)
+        { CompleteTcpConnect(static_cast<TcpConnect&>(event), cEvent); },
+        handler.m_host,
+        handler.m_port
+    ) };
+    IOBackend::UserData userData{ event->m_id };
+    event->m_fd = m_backend->QueueTcpConnect(userData, event->m_host, event->m_port);
+    if (event->m_fd == -1)
+    {
+        LOG_ERROR("net connect queue failed for '{}:{}'", handler.m_host, handler.m_port);
+        return;
+    }
+
+    handler.m_state = TcpClient::Connecting;
+    LOG_DEBUG("net connect queued for '{}:{}'", handler.m_host, handler.m_port);
+    m_pendingEvents[userData] = std::move(event);
+}
+
+void Proactor::RequestTcpSend(TcpClient& handler, std::string data) { QueueTcpSend(handler, std::move(data), {}); }
+
+void Proactor::RequestTcpSend(TcpClient& handler, std::span<const uint8_t> data, SendCompleteFunc&& onSent)
+{
+    QueueTcpSend(handler, SendPayload{ data }, std::move(onSent));
+}
+
+void Proactor::RequestTcpSend(TcpClient& handler, BufferHandle data) { QueueTcpSend(handler, std::move(data), {}); }
+
+void Proactor::RequestTcpSend(TcpClient& handler, SharedPayload data) { QueueTcpSend(handler, std::move(data), {}); }
+
+void Proactor::QueueTcpSend(TcpClient& handler, SendPayload&& data, SendCompleteFunc&& onSent)
+{
+    auto event{ std::make_unique<TcpSend>(
+        handler.m_id,
+        [this](Event& event, const io_uring_cqe& cEvent) { CompleteTcpSend(static_cast<TcpSend&>(event), cEvent); },
+        handler.m_fd,
+        std::move(data),
+        std::move(onSent)
+    ) };
+    IOBackend::UserData userData{ event->m_id };
+    event->m_opcode = m_backend->SendOpcode(event->Data().size());
+
+    if (not m_backend->QueueTcpSend(userData, event->m_fd, event->Data()))
+    {
+        LOG_ERROR_RATE_LIMITED(s_completionErrorsPerSecond, "[{}] failed to queue tcp send", handler.Name());
+        // let the caller release the data
+        if (event->m_onSent)
+        {
+            event->m_onSent(-EAGAIN);
+        }
+        return;
+    }
+
+    m_pendingEvents[userData] = std::move(event);
+}
+
+void Proactor::Broadcast(std::span<TcpClient* const> clients, SharedPayload payload, BroadcastCompleteFunc&& onComplete)
+{
+    if (payload == nullptr)
+    {
+        LOG_ERROR("broadcast requested without a payload");
+        return;
+    }
+
+    auto state{ std::make_shared<BroadcastState>(std::move(payload), std::move(onComplete)) };
+    const std::span data{ reinterpret_cast<const uint8_t*>(state->m_payload->data()), state->m_payload->size() };
+    state->m_report.m_clients = clients.size();
+
+    // every client borrows the same payload, which the state keeps alive until the last send completes
+    m_backend->BeginBatch();
+    for (TcpClient* client : clients)
+    {
+        if (client == nullptr or client->m_state != TcpClient::Connected)
+        {
+            state->m_report.m_skipped++;
+            continue;
+        }
+
+        state->m_pending++;
+        QueueTcpSend(*client, SendPayload{ data }, [state](int res) { state->OnSent(res); });
+    }
+
+    if (not m_backend->EndBatch())
+    {
+        LOG_ERROR("failed to submit broadcast to {} client(s)", clients.size());
+    }
+
+    state->Release();
+}
+
+void Proactor::RequestTcpRecv(TcpClient& handler)
+{
+    auto event{ std::make_unique<TcpRecv>(
+        handler.m_id,
+        [this](Event& event, const io_uring_cqe& cEvent) { CompleteTcpRecv(static_cast<TcpRecv&>(event), cEvent); },
+        handler.m_fd,
+        m_rxBufferPool.Acquire()
+    ) };
+    IOBackend::UserData userData{ event->m_id };
+
+    if (not m_backend->QueueTcpRecv(userData, event->m_fd, event->m_data.Span()))
+    {
+        LOG_ERROR_RATE_LIMITED(s_completionErrorsPerSecond, "[{}] failed to queue tcp recv", handler.Name());
+        return;
+    }
+
+    m_pendingEvents[userData] = std::move(event);
+}
+
+void Proactor::RequestTcpPoll(TcpClient& handler)
+{
+    auto event{ std::make_unique<TcpPoll>(
+        handler.m_id,
+        [this](Event& event, const io_uring_cqe& cEvent) { CompleteTcpPoll(static_cast<TcpPoll&>(event), cEvent); },
+        handler.m_fd,
+        handler.m_connection
+    ) };
+    IOBackend::UserData userData{ event->m_id };
+
+    if (not m_backend->QueuePollIn(userData, event->m_fd))
+    {
+        LOG_ERROR("[{}] failed to queue tcp poll", handler.Name());
+        return;
+    }
+
+    m_pendingEvents[userData] = std::move(event);
+}
+
+void Proactor::RequestTcpPollCancel(TcpClient& handler)
+{
+    const auto pollEvent{ FindPendingEvent<TcpPoll>(handler.m_id) };
+    if (pollEvent == nullptr)
+    {
+        LOG_DEBUG("[{}] no pending tcp poll to cancel", handler.Name());
+        return;
+    }
+
+    auto cancelEvent{ std::make_unique<TcpPollCancel>(
+        handler.m_id, [this](Event& event, const io_uring_cqe& cEvent) { CompleteTcpPollCancel(event, cEvent); }
+    ) };
+    IOBackend::UserData userData{ cancelEvent->m_id };
+
+    if (not m_backend->CancelPoll(userData, static_cast<IOBackend::UserData>(pollEvent->m_id)))
+    {
+        LOG_ERROR("[{}] failed to queue tcp poll cancel", handler.Name());
+        return;
+    }
+
+    m_pendingEvents[userData] = std::move(cancelEvent);
+}
+
+FileSendId Proactor::SendFile(
+    TcpClient& client,
+    int fd,
+    uint64_t offset,
+    uint64_t len,
+    FileSendCompleteFunc&& onComplete,
+    FileSendOptions options
+)
+{
+    if (client.m_state != TcpClient::Connected or len == 0)
+    {
+        LOG_ERROR(
+            "[{}] can't send file. connected({}) bytes({})", client.Name(), client.m_state == TcpClient::Connected, len
+        );
+        return 0;
+    }
+
+    const int socketFd{ ::fcntl(client.m_fd, F_DUPFD_CLOEXEC, 0) };
+    std::array<int, 2> pipe{ -1, -1 };
+    if (socketFd == -1 or ::pipe2(pipe.data(), O_NONBLOCK | O_CLOEXEC) != 0)
+    {
+        int err{ errno };
+        LOG_ERROR("[{}] failed to set up file send. {}", client.Name(), strerror(err));
+        if (socketFd != -1)
+        {
+            ::close(socketFd);
+        }
+        return 0;
+    }
+
+    auto send{ std::make_unique<FileSend>(m_nextFileSendId++, client.m_id, client.Name(), fd, socketFd, pipe) };
+
+    // what the kernel actually gave, which bounds the bytes in flight. the default if resizing isn't allowed
+    const uint64_t wanted{ uint64_t{ std::max(options.m_chunkSize, 1u) } * std::max(options.m_chunks, 1u) };
+    int capacity{ ::fcntl(pipe[1], F_SETPIPE_SZ, static_cast<int>(std::min<uint64_t>(wanted, INT_MAX))) };
+    if (capacity == -1)
+    {
+        int err{ errno };
+        capacity = ::fcntl(pipe[1], F_GETPIPE_SZ);
+        LOG_WARNING("[{}] failed to size file send pipe, using {}B. {}", client.Name(), capacity, strerror(err));
+    }
+    send->m_capacity = static_cast<size_t>(std::max(capacity, 1));
+    send->m_chunkSize = static_cast<uint32_t>(std::min<uint64_t>(std::max(options.m_chunkSize, 1u), send->m_capacity));
+    send->m_offset = offset;
+    send->m_end = offset + len;
+    send->m_total = len;
+    send->m_onComplete = std::move(onComplete);
+    send->m_onProgress = std::move(options.m_onProgress);
+
+    LOG_INFO(
+        "[{}] sending file fd({}) offset({}) bytes({}) chunk({}) pipe({})",
+        client.Name(),
+        fd,
+        offset,
+        len,
+        send->m_chunkSize,
+        send->m_capacity
+    );
+
+    const FileSendId id{ send->m_id };
+    FileSend& started{ *send };
+    m_fileSends[id] = std::move(send);
+    PumpFileSend(started);
+
+    return id;
+}
+
+void Proactor::CancelFileSend(FileSendId id)
+{
+    if (not m_fileSends.contains(id))
+    {
+        LOG_DEBUG("file send({}) already finished", id);
+        return;
+    }
+
+    FinishFileSend(id, -ECANCELED);
+}
+
+void Proactor::RequestUdpRecv(UdpSocket& handler)
+{
+    if (handler.m_rxPending)
+    {
+        return;
+    }
+
+    const auto& capabilities{ m_backend->GetCapabilities() };
+    if (capabilities.m_multishotRecv and capabilities.m_providedBufferRing)
+    {
+        const uint16_t groupId{ m_nextBufferGroup++ };
+        auto event{ std::make_unique<UdpRecvMsg>(
+            handler.m_id,
+            [this](Event& event, const io_uring_cqe& cEvent)
+            { CompleteUdpRecvMsg(static_cast<UdpRecvMsg&>(event), cEvent); },
+            handler.m_fd,
+            groupId,
+            handler.m_rxBufferSize,
+            handler.m_rxBufferCount
+        ) };
+        IOBackend::UserData userData{ event->m_id };
+
+        if (m_backend->AddBufferGroup(groupId, event->m_buffers, event->m_bufferSize))
+        {
+            if (m_backend->QueueRecvMsg(userData, event->m_fd, event->m_message, groupId))
+            {
+                handler.m_rxPending = true;
+                m_pendingEvents[userData] = std::move(event);
+                return;
+            }
+            m_backend->RemoveBufferGroup(groupId);
+        }
+
+        LOG_WARNING("[{}] failed to queue udp recvmsg. polling for readiness instead", handler.Name());
+    }
+
+    handler.m_rxBuffer.resize(handler.m_rxBufferSize);
+    auto event{ std::make_unique<UdpPoll>(
+        handler.m_id,
+        [this](Event& event, const io_uring_cqe& cEvent) { CompleteUdpPoll(static_cast<UdpPoll&>(event), cEvent); },
+        handler.m_fd
+    ) };
+    IOBackend::UserData userData{ event->m_id };
+
+    if (not m_backend->QueuePollIn(userData, event->m_fd))
+    {
+        LOG_ERROR("[{}] failed to queue udp poll", handler.Name());
+        return;
+    }
+
+    handler.m_rxPending = true;
+    m_pendingEvents[userData] = std::move(event);
+}
+
+void Proactor::RequestUdpSend(UdpSocket& handler, std::string data, uint16_t segmentSize, size_t segments)
+{
+    auto event{ std::make_unique<UdpSend>(
+        handler.m_id,
+        [this](Event& event, const io_uring_cqe& cEvent) { CompleteUdpSend(static_cast<UdpSend&>(event), cEvent); },
+        handler.m_fd,
+        handler.m_peer,
+        std::move(data),
+        segmentSize,
+        segments
+    ) };
+    IOBackend::UserData userData{ event->m_id };
+
+    if (not m_backend->QueueSendMsg(userData, event->m_fd, event->m_message))
+    {
+        LOG_ERROR_RATE_LIMITED(s_completionErrorsPerSecond, "[{}] failed to queue udp send", handler.Name());
+        return;
+    }
+
+    m_pendingEvents[userData] = std::move(event);
+}
+
+void Proactor::FlushUdpSends()
+{
+    if (m_udpFlushes.empty())
+    {
+        return;
+    }
+
+    // every socket's batch goes out in one submission
+    m_backend->BeginBatch();
+    for (Handle::Id id : m_udpFlushes)
+    {
+        if (auto itr{ m_udpSockets.find(id) }; itr != m_udpSockets.end())
+        {
+            itr->second->m_flushScheduled = false;
+            itr->second->Flush();
+        }
+    }
+    m_udpFlushes.clear();
+
+    if (not m_backend->EndBatch())
+    {
+        LOG_ERROR("failed to submit udp sends");
+    }
+}
+
+void Proactor::RequestUnixAccept(UnixListener& handler)
+{
+    if (handler.m_acceptPending)
+    {
+        return;
+    }
+
+    auto event{ std::make_unique<UnixAccept>(
+        handler.m_id,
+        [this](Event& event, const io_uring_cqe& cEvent)
+        { CompleteUnixAccept(static_cast<UnixAccept&>(event), cEvent); },
+        handler.m_fd
+    ) };
+    IOBackend::UserData userData{ event->m_id };
+
+    if (not m_backend->QueueAccept(userData, event->m_fd))
+    {
+        LOG_ERROR("[{}] failed to queue unix accept", handler.Name());
+        return;
+    }
+
+    handler.m_acceptPending = true;
+    m_pendingEvents[userData] = std::move(event);
+}
+
+void Proactor::RequestUnixConnect(UnixSocket& handler)
+{
+    auto event{ std::make_unique<UnixConnect>(
+        handler.m_id,
+        [this](Event& event, const io_uring_cqe& cEvent)
+        { CompleteUnixConnect(static_cast<UnixConnect&>(event), cEvent); },
+        handler.m_fd,
+        handler.m_address,
+        handler.m_addressLen
+    ) };
+    IOBackend::UserData userData{ event->m_id };
+
+    if (not m_backend->QueueConnect(
+            userData, event->m_fd, reinterpret_cast<const sockaddr&>(event->m_address), event->m_addressLen
+        ))
+    {
+        // not reported through OnClose. this can run from the base class constructor
+        LOG_ERROR("[{}] failed to queue unix connect", handler.Name());
+        handler.m_state = UnixSocket::Closed;
+        return;
+    }
+
+    m_pendingEvents[userData] = std::move(event);
+}
+
+void Proactor::RequestUnixRecv(UnixSocket& handler)
+{
+    if (handler.m_rxPending)
+    {
+        return;
+    }
+
+    auto event{ std::make_unique<UnixRecv>(
+        handler.m_id,
+        [this](Event& event, const io_uring_cqe& cEvent) { CompleteUnixRecv(static_cast<UnixRecv&>(event), cEvent); },
+        handler.m_fd,
+        handler.m_rxBufferSize
+    ) };
+    IOBackend::UserData userData{ event->m_id };
+
+    if (not m_backend->QueueRecvMsg(userData, event->m_fd, event->m_message))
+    {
+        LOG_ERROR("[{}] failed to queue unix recv", handler.Name());
+        return;
+    }
+
+    handler.m_rxPending = true;
+    m_pendingEvents[userData] = std::move(event);
+}
+
+void Proactor::RequestUnixSend(UnixSocket& handler, std::string data, std::vector<int> fds)
+{
+    auto event{ std::make_unique<UnixSend>(
+        handler.m_id,
+        [this](Event& event, const io_uring_cqe& cEvent) { CompleteUnixSend(static_cast<UnixSend&>(event), cEvent); },
+        handler.m_fd,
+        std::move(data),
+        std::move(fds)
+    ) };
+
+    if (handler.m_txPending)
+    {
+        handler.m_txQueue.push_back(std::move(event));
+        return;
+    }
+
+    SubmitUnixSend(handler, std::move(event));
+}
+
+void Proactor::SubmitUnixSend(UnixSocket& handler, std::unique_ptr<UnixSend> event)
+{
+    IOBackend::UserData userData{ event->m_id };
+    // queued sends have been waiting since they were made
+    event->m_submitTime = Clock::now();
+
+    if (not m_backend->QueueSendMsg(userData, event->m_fd, event->m_message))
+    {
+        LOG_ERROR_RATE_LIMITED(s_completionErrorsPerSecond, "[{}] failed to queue unix send", handler.Name());
+        return;
+    }
+
+    handler.m_txPending = true;
+    m_pendingEvents[userData] = std::move(event);
+}
+
+void Proactor::RequestUnixCancel(Handle::Id id, std::string_view name, const Event& target)
+{
+    auto cancelEvent{ std::make_unique<UnixCancel>(
+        id, [this](Event& event, const io_uring_cqe& cEvent) { CompleteUnixCancel(event, cEvent); }
+    ) };
+    IOBackend::UserData userData{ cancelEvent->m_id };
+
+    if (not m_backend->CancelOp(userData, static_cast<IOBackend::UserData>(target.m_id)))
+    {
+        LOG_ERROR("[{}] failed to queue unix cancel", name);
+        return;
+    }
+
+    m_pendingEvents[userData] = std::move(cancelEvent);
+}
+
+void Proactor::CloseUnixSocket(UnixSocket& handler, int res)
+{
+    if (handler.m_state == UnixSocket::Closed)
+    {
+        return;
+    }
+
+    handler.m_state = UnixSocket::Closed;
+    handler.m_txQueue.clear();
+
+    auto target{ m_handlerProfiler.Get(handler.m_id, handler.Name(), HandlerCallback::Close) };
+    ScopedDeadline dl{ target.m_handlerName, s_callbackDeadline, &target.m_profile };
+    handler.OnClose(res);
+}
+
+void Proactor::PumpRelay(TcpRelay& handler)
+{
+    for (size_t direction{ 0 }; direction < handler.m_directions.size(); direction++)
+    {
+        TcpRelay::Direction& flow{ handler.m_directions[direction] };
+        const bool fill{ not flow.m_filling and not flow.m_eof and not flow.m_stalled and
+                         flow.m_buffered < flow.m_capacity };
+        const bool drain{ not flow.m_draining and flow.m_buffered > 0 };
+        if ((fill and not RequestRelayTransfer(handler, direction, RelayLeg::Fill)) or
+            (drain and not RequestRelayTransfer(handler, direction, RelayLeg::Drain)))
+        {
+            CloseRelay(handler, -EIO);
+            return;
+        }
+
+        // everything the source sent is through. the destination sees the same hang up
+        if (flow.m_eof and flow.m_buffered == 0 and not flow.m_draining and not flow.m_shutdown)
+        {
+            flow.m_shutdown = true;
+            if (::shutdown(flow.m_to, SHUT_WR) != 0)
+            {
+                int err{ errno };
+                LOG_WARNING("[{}] failed to pass on hang up to fd({}). {}", handler.Name(), flow.m_to, strerror(err));
+            }
+        }
+    }
+
+    if (handler.m_directions[TcpRelay::s_toUpstream].m_shutdown and
+        handler.m_directions[TcpRelay::s_toClient].m_shutdown)
+    {
+        CloseRelay(handler, 0);
+    }
+}
+
+bool Proactor::RequestRelayTransfer(TcpRelay& handler, size_t direction, RelayLeg leg, bool poll)
+{
+    TcpRelay::Direction& flow{ handler.m_directions[direction] };
+    const bool fill{ leg == RelayLeg::Fill };
+    const bool splice{ handler.m_mode == TcpRelay::Mode::Splice };
+    const uint8_t opcode{ poll     ? IORING_OP_POLL_ADD
+                          : splice ? IORING_OP_SPLICE
+                          : fill   ? IORING_OP_RECV
+                                   : IORING_OP_SEND };
+
+    auto event{ std::make_unique<RelayTransfer>(
+        handler.m_id,
+        [this](Event& event, const io_uring_cqe& cEvent)
+        { CompleteRelayTransfer(static_cast<RelayTransfer&>(event), cEvent); },
+        direction,
+        leg,
+        opcode,
+        flow.m_buffer
+    ) };
+    IOBackend::UserData userData{ event->m_id };
+
+    bool queued{ false };
+    if (poll)
+    {
+        queued = m_backend->QueuePoll(userData, fill ? flow.m_from : flow.m_to, fill ? POLLIN : POLLOUT);
+    }
+    else if (fill)
+    {
+        const size_t room{ flow.m_capacity - flow.m_buffered };
+        if (splice)
+        {
+            queued = m_backend->QueueSplice(userData, flow.m_from, -1, flow.m_pipe[1], static_cast<uint32_t>(room));
+        }
+        else
+        {
+            // up to the end of the ring. whatever room is left at its start is filled by the next recv
+            const size_t tail{ (flow.m_head + flow.m_buffered) % flow.m_capacity };
+            queued = m_backend->QueueTcpRecv(
+                userData, flow.m_from, std::span{ *flow.m_buffer }.subspan(tail, std::min(room, flow.m_capacity - tail))
+            );
+        }
+    }
+    else
+    {
+        if (splice)
+        {
+            queued =
+                m_backend->QueueSplice(userData, flow.m_pipe[0], -1, flow.m_to, static_cast<uint32_t>(flow.m_buffered));
+        }
+        else
+        {
+            const size_t len{ std::min(flow.m_buffered, flow.m_capacity - flow.m_head) };
+            event->m_opcode = m_backend->SendOpcode(len);
+            queued = m_backend->QueueTcpSend(
+                userData, flow.m_to, { reinterpret_cast<const char*>(flow.m_buffer->data()) + flow.m_head, len }
+            );
+        }
+    }
+
+    if (not queued)
+    {
+        LOG_ERROR_RATE_LIMITED(
+            s_completionErrorsPerSecond, "[{}] failed to queue relay {}", handler.Name(), GetOpcodeName(opcode)
+        );
+        return false;
+    }
+
+    (fill ? flow.m_filling : flow.m_draining) = true;
+    flow.m_inFlight[static_cast<size_t>(leg)] = event->m_id;
+    m_pendingEvents[userData] = std::move(event);
+    return true;
+}
+
+void Proactor::CancelRelayTransfers(TcpRelay& handler)
+{
+    // the pending ops hold their own reference to the sockets and pipes, closing the fds doesn't end them
+    for (const TcpRelay::Direction& flow : handler.m_directions)
+    {
+        for (EventId target : flow.m_inFlight)
+        {
+            if (target == 0)
+            {
+                continue;
+            }
+
+            auto cancelEvent{ std::make_unique<RelayCancel>(
+                handler.m_id, [this](Event& event, const io_uring_cqe& cEvent) { CompleteRelayCancel(event, cEvent); }
+            ) };
+            IOBackend::UserData userData{ cancelEvent->m_id };
+
+            if (not m_backend->CancelOp(userData, static_cast<IOBackend::UserData>(target)))
+            {
+                LOG_ERROR("[{}] failed to queue relay cancel", handler.Name());
+                continue;
+            }
+
+            m_pendingEvents[userData] = std::move(cancelEvent);
+        }
+    }
+}
+
+void Proactor::CloseRelay(TcpRelay& handler, int res)
+{
+    if (handler.m_closed)
+    {
+        return;
+    }
+
+    handler.m_closed = true;
+    CancelRelayTransfers(handler);
+
+    auto target{ m_handlerProfiler.Get(handler.m_id, handler.Name(), HandlerCallback::Close) };
+    ScopedDeadline dl{ target.m_handlerName, s_callbackDeadline, &target.m_profile };
+    handler.OnClose(res);
+}
+
+void Proactor::PumpFileSend(FileSend& send)
+{
+    const bool fill{ not send.m_filling and not send.m_stalled and send.m_offset < send.m_end and
+                     send.m_buffered < send.m_capacity };
+    const bool drain{ not send.m_draining and send.m_buffered > 0 };
+    if ((fill and not RequestFileSendSplice(send, FileSendLeg::Fill)) or
+        (drain and not RequestFileSendSplice(send, FileSendLeg::Drain)))
+    {
+        FinishFileSend(send.m_id, -EIO);
+        return;
+    }
+
+    if (send.m_sent == send.m_total)
+    {
+        FinishFileSend(send.m_id, 0);
+    }
+}
+
+bool Proactor::RequestFileSendSplice(FileSend& send, FileSendLeg leg, bool poll)
+{
+    const bool fill{ leg == FileSendLeg::Fill };
+    auto event{ std::make_unique<FileSendSplice>(
+        send.m_clientId,
+        [this](Event& event, const io_uring_cqe& cEvent)
+        { CompleteFileSendSplice(static_cast<FileSendSplice&>(event), cEvent); },
+        send.m_id,
+        leg,
+        poll ? uint8_t{ IORING_OP_POLL_ADD } : uint8_t{ IORING_OP_SPLICE }
+    ) };
+    IOBackend::UserData userData{ event->m_id };
+
+    bool queued{ false };
+    if (poll)
+    {
+        // the pipe for a fill, the socket for a drain
+        queued = m_backend->QueuePoll(userData, fill ? send.m_pipe[1] : send.m_socketFd, POLLOUT);
+    }
+    else if (fill)
+    {
+        const uint64_t room{ std::min<uint64_t>(
+            { send.m_chunkSize, send.m_end - send.m_offset, send.m_capacity - send.m_buffered }
+        ) };
+        queued = m_backend->QueueSplice(
+            userData, send.m_fileFd, static_cast<int64_t>(send.m_offset), send.m_pipe[1], static_cast<uint32_t>(room)
+        );
+    }
+    else
+    {
+        queued = m_backend->QueueSplice(
+            userData, send.m_pipe[0], -1, send.m_socketFd, static_cast<uint32_t>(send.m_buffered)
+        );
+    }
+
+    if (not queued)
+    {
+        LOG_ERROR_RATE_LIMITED(
+            s_completionErrorsPerSecond, "[{}] failed to queue file send {}", send.Name(), fill ? "fill" : "drain"
+        );
+        return false;
+    }
+
+    (fill ? send.m_filling : send.m_draining) = true;
+    send.m_inFlight[static_cast<size_t>(leg)] = event->m_id;
+    m_pendingEvents[userData] = std::move(event);
+    return true;
+}
+
+void Proactor::FinishFileSend(FileSendId id, int res)
+{
+    auto node{ m_fileSends.extract(id) };
+    if (node.empty())
+    {
+        return;
+    }
+    std::unique_ptr<FileSend> send{ std::move(node.mapped()) };
+
+    // the pending splices hold their own reference to the pipe and socket, closing the fds doesn't end them
+    for (EventId target : send->m_inFlight)
+    {
+        if (target == 0)
+        {
+            continue;
+        }
+
+        auto cancelEvent{ std::make_unique<FileSendCancel>(
+            send->m_clientId,
+            [this](Event& event, const io_uring_cqe& cEvent) { CompleteFileSendCancel(event, cEvent); }
+        ) };
+        IOBackend::UserData userData{ cancelEvent->m_id };
+
+        if (not m_backend->CancelOp(userData, static_cast<IOBackend::UserData>(target)))
+        {
+            LOG_ERROR("[{}] failed to queue file send cancel", send->Name());
+            continue;
+        }
+
+        m_pendingEvents[userData] = std::move(cancelEvent);
+    }
+
+    if (res == 0)
+    {
+        LOG_INFO("[{}] file send({}) done. bytes({})", send->Name(), id, send->m_sent);
+    }
+    else
+    {
+        LOG_WARNING(
+            "[{}] file send({}) ended at bytes({}/{}). {}",
+            send->Name(),
+            id,
+            send->m_sent,
+            send->m_total,
+            strerror(-res)
+        );
+    }
+
+    if (send->m_onComplete)
+    {
+        auto target{ m_handlerProfiler.Get(send->m_clientId, send->Name(), HandlerCallback::FileSendComplete) };
+        ScopedDeadline dl{ target.m_handlerName, s_callbackDeadline, &target.m_profile };
+        send->m_onComplete(res, send->m_sent);
+    }
+}
+
+void Proactor::RequestFileOpen(FileHandle& handler)
+{
+    if (handler.m_openPending or handler.m_state != FileHandle::Opening)
+    {
+        return;
+    }
+
+    auto event{ MakeFileOp(handler, FileOpKind::Open) };
+    event->m_path = handler.m_path;
+    event->m_flags = handler.m_options.m_flags | (handler.m_options.m_direct ? O_DIRECT : 0);
+    event->m_mode = handler.m_options.m_mode;
+    IOBackend::UserData userData{ event->m_id };
+
+    if (not m_backend->QueueOpen(userData, event->m_path.c_str(), event->m_flags, event->m_mode))
+    {
+        // not reported through OnOpen. this can run from the base class constructor
+        LOG_ERROR("[{}] failed to queue file open", handler.Name());
+        handler.m_state = FileHandle::Closed;
+        FailQueuedFileOps(handler.m_id, -EAGAIN);
+        return;
+    }
+
+    handler.m_openPending = true;
+    m_pendingEvents[userData] = std::move(event);
+}
+
+std::unique_ptr<FileOp> Proactor::MakeFileOp(FileHandle& handler, FileOpKind kind)
+{
+    return std::make_unique<FileOp>(
+        handler.m_id,
+        [this](Event& event, const io_uring_cqe& cEvent) { CompleteFileOp(static_cast<FileOp&>(event), cEvent); },
+        kind
+    );
+}
+
+void Proactor::RequestFileOp(FileHandle& handler, std::unique_ptr<FileOp> event)
+{
+    // ops already waiting go first
+    if (handler.m_state != FileHandle::Open or handler.m_inFlight >= handler.m_options.m_queueDepth or
+        not handler.m_queue.empty())
+    {
+        handler.m_queue.push_back(std::move(event));
+        return;
+    }
+
+    if (auto rejected{ SubmitFileOp(handler, std::move(event)) }; rejected != nullptr)
+    {
+        FinishFileOp(handler, *rejected, -EAGAIN);
+    }
+}
+
+std::unique_ptr<FileOp> Proactor::SubmitFileOp(FileHandle& handler, std::unique_ptr<FileOp> event)
+{
+    IOBackend::UserData userData{ event->m_id };
+    // queued ops have been waiting since they were made
+    event->m_submitTime = Clock::now();
+
+    bool queued{ false };
+    switch (event->m_kind)
+    {
+        case FileOpKind::Read:
+            queued = m_backend->QueueReadAt(userData, handler.m_fd, event->m_rxBuffer, event->m_offset);
+            break;
+        case FileOpKind::Write:
+            queued = m_backend->QueueWriteAt(userData, handler.m_fd, event->m_txBuffer, event->m_offset);
+            break;
+        case FileOpKind::Sync:
+            queued = m_backend->QueueFsync(userData, handler.m_fd, event->m_dataOnly);
+            break;
+        case FileOpKind::Stat:
+            queued = m_backend->QueueStatx(userData, handler.m_fd, event->m_stat);
+            break;
+        case FileOpKind::Open:
+            break;
+    }
+
+    if (not queued)
+    {
+        LOG_ERROR_RATE_LIMITED(
+            s_completionErrorsPerSecond,
+            "[{}] failed to queue file {}",
+            handler.Name(),
+            GetOpcodeName(FileOpcode(event->m_kind))
+        );
+        return event;
+    }
+
+    handler.m_inFlight++;
+    m_pendingEvents[userData] = std::move(event);
+    return nullptr;
+}
+
+void Proactor::PumpFileOps(FileHandle& handler)
+{
+    const Handle::Id id{ handler.m_id };
+    // failed ops are only called back once the batch is submitted. a callback may remove the handle, or queue an
+    // op of its own, e.g. a timer whose timeout would be gone from its stack before the batch went in
+    std::vector<std::unique_ptr<FileOp>> rejected;
+
+    m_backend->BeginBatch();
+    while (handler.m_state == FileHandle::Open and not handler.m_queue.empty() and
+           handler.m_inFlight < handler.m_options.m_queueDepth)
+    {
+        std::unique_ptr<FileOp> event{ std::move(handler.m_queue.front()) };
+        handler.m_queue.pop_front();
+        if (auto failed{ SubmitFileOp(handler, std::move(event)) }; failed != nullptr)
+        {
+            rejected.push_back(std::move(failed));
+        }
+    }
+
+    if (not m_backend->EndBatch())
+    {
+        LOG_ERROR_RATE_LIMITED(s_completionErrorsPerSecond, "[{}] failed to submit file ops", handler.Name());
+    }
+
+    for (auto& event : rejected)
+    {
+        // the handle may have been removed by an earlier callback, its ops then end without theirs
+        auto itr{ m_fileHandles.find(id) };
+        if (itr == m_fileHandles.end())
+        {
+            break;
+        }
+        FinishFileOp(*itr->second, *event, -EAGAIN);
+    }
+}
+
+void Proactor::FailQueuedFileOps(Handle::Id id, int res)
+{
+    for (auto itr{ m_fileHandles.find(id) }; itr != m_fileHandles.end() and not itr->second->m_queue.empty();
+         itr = m_fileHandles.find(id))
+    {
+        FileHandle& handler{ *itr->second };
+        std::unique_ptr<FileOp> event{ std::move(handler.m_queue.front()) };
+        handler.m_queue.pop_front();
+        FinishFileOp(handler, *event, res);
+    }
+}
+
+void Proactor::FinishFileOp(FileHandle& handler, FileOp& event, int res)
+{
+    auto target{ m_handlerProfiler.Get(handler.m_id, handler.Name(), FileCallback(event.m_kind)) };
+    ScopedDeadline dl{ target.m_handlerName, s_callbackDeadline, &target.m_profile };
+    if (event.m_kind == FileOpKind::Stat)
+    {
+        if (event.m_onStat)
+        {
+            event.m_onStat(res, event.m_stat);
+        }
+    }
+    else if (event.m_onComplete)
+    {
+        event.m_onComplete(res);
+    }
+}
+
+void Proactor::CompleteTimerExpiredEvent(Event& event, const io_uring_cqe& cEvent)
+{
+    int eventRes{ cEvent.res };
+    // expiring is what a timeout is for
+    RecordCompletion(event, IORING_OP_TIMEOUT, eventRes == -ETIME ? 0 : eventRes);
+
+    auto itr{ m_timerHandlers.find(event.m_handlerId) };
+    if (itr == m_timerHandlers.end())
+    {
+        LOG_ERROR("failed to find handler for eventId({}) handlerId({})", event.m_id, event.m_handlerId);
+        return;
+    }
+
+    auto& handler{ *itr->second };
+
+    switch (eventRes)
+    {
+        // timer expired
+        case -ETIME:
+        {
+            LOG_DEBUG("[{}] triggering handler eventId({})", handler.Name(), event.m_id);
+
+            {
+                auto target{ m_handlerProfiler.Get(handler.m_id, handler.Name(), HandlerCallback::TimerExpired) };
+                ScopedDeadline dl{ target.m_handlerName, s_callbackDeadline, &target.m_profile };
+                handler.OnTimerExpired();
+            }
+
+            // single shot timeout on kernels without multishot support
+            if ((cEvent.flags & IORING_CQE_F_MORE) == 0 and
+                not m_backend->QueueTimeoutEvent(static_cast<IOBackend::UserData>(event.m_id), handler.m_period))
+            {
+                LOG_ERROR("[{}] re-arm failed eventId({})", handler.Name(), event.m_id);
+            }
+
+            break;
+        }
+
+        // timer cancelled
+        case -ECANCELED:
+        {
+            LOG_DEBUG("[{}] timer cancelled eventId({})", handler.Name(), event.m_id);
+            m_timerHandlers.erase(itr);
+            break;
+        }
+
+        default:
+        {
+            LOG_ERROR("failed eventId({}) res({}) {}", event.m_id, eventRes, strerror(-eventRes));
+            break;
+        }
+    }
+}
+
+void Proactor::CompleteTimerUpdateEvent(Event& event, const io_uring_cqe& cEvent)
+{
+    int eventRes{ cEvent.res };
+    RecordCompletion(event, IORING_OP_TIMEOUT_REMOVE, eventRes);
+    auto itr{ m_timerHandlers.find(event.m_handlerId) };
+    if (itr == m_timerHandlers.end())
+    {
+        LOG_ERROR("failed to find handler for eventId({}) handlerId({})", event.m_id, event.m_handlerId);
+        return;
+    }
+
+    auto& handler{ *itr->second };
+
+    switch (eventRes)
+    {
+        // timer update acknowledged
+        case 0:
+        {
+            LOG_DEBUG("[{}] timer update acknowledged eventId({})", handler.Name(), event.m_id);
+            break;
+        }
+
+        default:
+        {
+            LOG_ERROR("failed eventId({}) res({}) {}", event.m_id, eventRes, strerror(-eventRes));
+            break;
+        }
+    }
+}
+
+void Proactor::CompleteTimerCancelEvent(Event& event, const io_uring_cqe& cEvent)
+{
+    int eventRes{ cEvent.res };
+    RecordCompletion(event, IORING_OP_TIMEOUT_REMOVE, eventRes);
+    auto itr{ m_timerHandlers.find(event.m_handlerId) };
+    if (itr == m_timerHandlers.end())
+    {
+        LOG_ERROR("failed to find handler for eventId({}) handlerId({})", event.m_id, event.m_handlerId);
+        return;
+    }
+
+    auto& handler{ *itr->second };
+
+    switch (eventRes)
+    {
+        // timer cancellation acknowledged
+        case 0:
+        {
+            LOG_DEBUG("[{}] timer cancellation acknowledged eventId({})", handler.Name(), event.m_id);
+            break;
+        }
+
+        default:
+        {
+            LOG_ERROR("failed eventId({}) res({}) {}", event.m_id, eventRes, strerror(-eventRes));
+            break;
+        }
+    }
+}
+
+void Proactor::CompleteSignalEvent(SignalEvent& event, const io_uring_cqe& cEvent)
+{
+    int res{ cEvent.res };
+    RecordCompletion(event, IORING_OP_READ, res);
+    if (res < 0)
+    {
+        LOG_ERROR("read failed for signal {}({}). {}", strsignal(event.m_signal), event.m_signal, strerror(-res));
+        return;
+    }
+
+    if (res != sizeof(signalfd_siginfo))
+    {
+        LOG_ERROR(
+            "read failed for signal {}({}). expected-read-size({}) actual-read-size({})",
+            strsignal(event.m_signal),
+            event.m_signal,
+            sizeof(signalfd_siginfo),
+            res
+        );
+        return;
+    }
+
+    auto itr{ m_signalHandlers.find(event.m_signal) };
+    if (itr == m_signalHandlers.end())
+    {
+        LOG_ERROR("could not find signal {}({}) in handler map", strsignal(event.m_signal), event.m_signal);
+        return;
+    }
+
+    const auto& [sig, data]{ *itr };
+
+    LOG_INFO("invoking signal handler for signal {}({})", strsignal(sig), sig);
+
+    (data->m_callback)(event.m_signalReadBuff);
+
+    if (not RequestSignalRead(data->m_signal, data->m_fd))
+    {
+        LOG_CRITICAL("failed to request signal {}({}) read", strsignal(event.m_signal), event.m_signal);
+    }
+}
+
+void Proactor::CompleteFileWatchEvent(FileWatchEvent& event, const io_uring_cqe& cEvent)
+{
+    int res{ cEvent.res };
+    RecordCompletion(event, IORING_OP_READ, res);
+    if (res <= 0)
+    {
+        LOG_ERROR("read failed for file watches. {}", strerror(-res));
+        return;
+    }
+
+    for (size_t offset{ 0 }; offset + sizeof(inotify_event) <= static_cast<size_t>(res);)
+    {
+        const auto* watchEvent{ reinterpret_cast<const inotify_event*>(event.m_readBuff.data() + offset) };
+        offset += sizeof(inotify_event) + watchEvent->len;
+
+        // events still queued for a removed watch
+        auto itr{ m_fileWatches.find(watchEvent->wd) };
+        if (itr == m_fileWatches.end())
+        {
+            continue;
+        }
+
+        LOG_TRACE("file watch event watchId({}) mask({:#x})", watchEvent->wd, watchEvent->mask);
+
+        // callbacks must not remove their own watch
+        (itr->second)(*watchEvent);
+
+        // the kernel dropped the watch. the watched path was removed or unmounted
+        if (watchEvent->mask & IN_IGNORED)
+        {
+            m_fileWatches.erase(watchEvent->wd);
+        }
+    }
+
+    if (not RequestFileWatchRead())
+    {
+        LOG_CRITICAL("failed to request file watch read");
+    }
+}
+
+void Proactor::CompleteTcpConnect(TcpConnect& event, const io_uring_cqe& cEvent)
+{
+    int res{ cEvent.res };
+    RecordCompletion(event, IORING_OP_CONNECT, res);
+    auto itr{ m_tcpClients.find(event.m_handlerId) };
+    if (itr == m_tcpClients.end())
+    {
+        LOG_ERROR("failed to find socket client for '{}:{}'", event.m_host, event.m_port);
+        return;
+    }
+
+    auto [_, handler] = *itr;
+    handler->m_state = TcpClient::Broken;
+    if (res < 0)
+    {
+        LOG_WARNING("[{}] tcp connect failed. {}. closing fd", handler->Name(), strerror(-res));
+
+        if (event.m_fd > 0 and ::close(event.m_fd) == -1)
+        {
+            int err{ errno };
+            LOG_ERROR("[{}] tcp connect res failed. failed to close socket. {}", handler->Name(), strerror(err));
+        }
+        return;
+    }
+
+    m_metrics.m_tcpConnects.Add();
+    handler->m_state = TcpClient::Connected;
+    handler->m_fd = event.m_fd;
+    ++handler->m_connection;
+    // receive from the start rather than from the client's next timer tick
+    handler->QueueRecv();
+    auto target{ m_handlerProfiler.Get(handler->m_id, handler->Name(), HandlerCallback::Connect) };
+    ScopedDeadline dl{ target.m_handlerName, s_callbackDeadline, &target.m_profile };
+    handler->OnConnect();
+}
+
+void Proactor::CompleteTcpSend(TcpSend& event, const io_uring_cqe& cEvent)
+{
+    // zero copy sends hold on to the data until the kernel notifies it has been released
+    event.m_removeOnComplete = (cEvent.flags & IORING_CQE_F_MORE) == 0;
+    if ((cEvent.flags & IORING_CQE_F_NOTIF) == 0)
+    {
+        event.m_result = cEvent.res;
+        RecordCompletion(event, event.m_opcode, event.m_result);
+        if (event.m_result > 0)
+        {
+            m_metrics.m_bytesSent.Add(static_cast<uint64_t>(event.m_result));
+            m_metrics.m_sendSizes.Record(static_cast<uint64_t>(event.m_result));
+        }
+        LogTcpSendResult(event);
+    }
+
+    if (event.m_removeOnComplete and event.m_onSent)
+    {
+        event.m_onSent(event.m_result);
+    }
+}
+
+void Proactor::LogTcpSendResult(const TcpSend& event)
+{
+    int res{ event.m_result };
+    auto itr{ m_tcpClients.find(event.m_handlerId) };
+    if (itr == m_tcpClients.end())
+    {
+        LOG_ERROR("failed to find socket client for handlerId({})", event.m_handlerId);
+        return;
+    }
+
+    auto [_, handler] = *itr;
+    if (res < 0)
+    {
+        LOG_ERROR_RATE_LIMITED(
+            s_completionErrorsPerSecond, "[{}] tcp send res failed. {}", handler->Name(), strerror(-res)
+        );
+    }
+}
+
+void Proactor::CompleteTcpRecv(TcpRecv& event, const io_uring_cqe& cEvent)
+{
+    int res{ cEvent.res };
+    RecordCompletion(event, IORING_OP_RECV, res);
+    auto itr{ m_tcpClients.find(event.m_handlerId) };
+    if (itr == m_tcpClients.end())
+    {
+        LOG_ERROR("failed to find socket client for handlerId({})", event.m_handlerId);
+        return;
+    }
+
+    auto [_, handler] = *itr;
+    handler->m_rxPending = false;
+
+    if (res < 0)
+    {
+        LOG_ERROR_RATE_LIMITED(
+            s_completionErrorsPerSecond, "[{}] tcp recv res failed. {}", handler->Name(), strerror(-res)
+        );
+        return;
+    }
+
+    if (res == 0)
+    {
+        LOG_INFO("[{}] tcp connection received 0 bytes", handler->Name());
+        return;
+    }
+
+    m_metrics.m_bytesReceived.Add(static_cast<uint64_t>(res));
+    m_metrics.m_recvSizes.Record(static_cast<uint64_t>(res));
+    {
+        auto target{ m_handlerProfiler.Get(handler->m_id, handler->Name(), HandlerCallback::Receive) };
+        ScopedDeadline dl{ target.m_handlerName, s_callbackDeadline, &target.m_profile };
+        handler->OnReceiveBuffer(event.m_data.Slice(0, static_cast<size_t>(res)));
+    }
+    // re-queue  for another recv
+    handler->QueueRecv();
+}
+
+void Proactor::CompleteTcpPoll(TcpPoll& event, const io_uring_cqe& cEvent)
+{
+    int res{ cEvent.res };
+    RecordCompletion(event, IORING_OP_POLL_ADD, res);
+    const bool rearmNeeded{ (cEvent.flags & IORING_CQE_F_MORE) == 0 };
+    event.m_removeOnComplete = rearmNeeded;
+
+    auto itr{ m_tcpClients.find(event.m_handlerId) };
+    if (itr == m_tcpClients.end())
+    {
+        LOG_ERROR("failed to find socket client for handlerId({})", event.m_handlerId);
+        return;
+    }
+
+    auto [_, handler] = *itr;
+    // the client has since reconnected on a new socket, possibly with the same fd number
+    if (handler->m_connection != event.m_connection)
+    {
+        return;
+    }
+
+    if (res == -ECANCELED)
+    {
+        LOG_DEBUG("[{}] tcp poll cancelled", handler->Name());
+        handler->m_rxPending = false;
+        return;
+    }
+
+    if (res < 0)
+    {
+        LOG_ERROR_RATE_LIMITED(
+            s_completionErrorsPerSecond, "[{}] tcp poll res failed. {}", handler->Name(), strerror(-res)
+        );
+        handler->m_rxPending = false;
+        return;
+    }
+
+    // drain everything that's available. readiness won't be reported again for data already queued.
+    // unless a handle is kept the same pooled buffer is reused for every read
+    const Handle::Id id{ handler->m_id };
+    auto target{ m_handlerProfiler.Get(id, handler->Name(), HandlerCallback::Receive) };
+    ssize_t rxBytes{ 0 };
+    int err{ 0 };
+    do
+    {
+        BufferHandle buff{ m_rxBufferPool.Acquire() };
+        rxBytes = ::recv(event.m_fd, buff.Data(), buff.Size(), MSG_DONTWAIT);
+        err = errno;
+        if (rxBytes > 0)
+        {
+            m_metrics.m_bytesReceived.Add(static_cast<uint64_t>(rxBytes));
+            m_metrics.m_recvSizes.Record(static_cast<uint64_t>(rxBytes));
+            ScopedDeadline dl{ target.m_handlerName, s_callbackDeadline, &target.m_profile };
+            handler->OnReceiveBuffer(buff.Slice(0, static_cast<size_t>(rxBytes)));
+            // the callback may have removed the client
+            if (not m_tcpClients.contains(id))
+            {
+                return;
+            }
+        }
+    } while (rxBytes == static_cast<ssize_t>(m_rxBufferPool.BlockSize()));
+
+    if (rxBytes == 0)
+    {
+        LOG_INFO("[{}] tcp connection received 0 bytes", handler->Name());
+        if (not rearmNeeded)
+        {
+            RequestTcpPollCancel(*handler);
+        }
+        handler->m_rxPending = false;
+        return;
+    }
+
+    if (rxBytes < 0 and err != EAGAIN and err != EWOULDBLOCK and err != EINTR)
+    {
+        LOG_ERROR_RATE_LIMITED(s_completionErrorsPerSecond, "[{}] tcp read failed. {}", handler->Name(), strerror(err));
+        // cancels the poll. the timer reconnects
+        handler->Disconnect();
+        return;
+    }
+
+    if (rearmNeeded)
+    {
+        handler->m_rxPending = false;
+        handler->QueueRecv();
+    }
+}
+
+void Proactor::CompleteTcpPollCancel(Event& event, const io_uring_cqe& cEvent)
+{
+    int res{ cEvent.res };
+    RecordCompletion(event, IORING_OP_POLL_REMOVE, res);
+    switch (res)
+    {
+        // poll cancellation acknowledged
+        case 0:
+        // poll already finished
+        case -ENOENT:
+        case -EALREADY:
+        {
+            LOG_DEBUG("tcp poll cancel acknowledged eventId({}) res({})", event.m_id, res);
+            break;
+        }
+
+        default:
+        {
+            LOG_ERROR("failed eventId({}) res({}) {}", event.m_id, res, strerror(-res));
+            break;
+        }
+    }
+}
+
+void Proactor::CompleteUdpRecvMsg(UdpRecvMsg& event, const io_uring_cqe& cEvent)
+{
+    int res{ cEvent.res };
+    RecordCompletion(event, IORING_OP_RECVMSG, res);
+
+    auto itr{ m_udpSockets.find(event.m_handlerId) };
+    if (itr != m_udpSockets.end() and (cEvent.flags & IORING_CQE_F_BUFFER) != 0)
+    {
+        const auto bufferId{ static_cast<uint16_t>(cEvent.flags >> IORING_CQE_BUFFER_SHIFT) };
+        std::span<uint8_t> buffer{ event.Buffer(bufferId) };
+        io_uring_recvmsg_out* out{
+            res > 0 ? io_uring_recvmsg_validate(buffer.data(), res, &event.m_message) : nullptr
+        };
+        if (out != nullptr)
+        {
+            if ((out->flags & MSG_TRUNC) != 0)
+            {
+                LOG_ERROR_RATE_LIMITED(
+                    s_completionErrorsPerSecond, "[{}] udp datagram truncated", itr->second->Name()
+                );
+            }
+
+            sockaddr_in from{};
+            std::memcpy(&from, io_uring_recvmsg_name(out), std::min<size_t>(out->namelen, sizeof(from)));
+
+            size_t segmentSize{ 0 };
+            for (cmsghdr* cmsg{ io_uring_recvmsg_cmsg_firsthdr(out, &event.m_message) }; cmsg != nullptr;
+                 cmsg = io_uring_recvmsg_cmsg_nexthdr(out, &event.m_message, cmsg))
+            {
+                segmentSize = std::max(segmentSize, GroSegmentSize(*cmsg));
+            }
+
+            const std::span payload{
+                static_cast<const uint8_t*>(io_uring_recvmsg_payload(out, &event.m_message)),
+                io_uring_recvmsg_payload_length(out, res, &event.m_message),
+            };
+            DeliverDatagrams(*itr->second, payload, segmentSize, from);
+        }
+
+        m_backend->ReturnBuffer(event.m_groupId, bufferId);
+    }
+
+    if ((cEvent.flags & IORING_CQE_F_MORE) != 0)
+    {
+        return;
+    }
+
+    // the handler may have been removed by its own callback
+    itr = m_udpSockets.find(event.m_handlerId);
+    const bool rearm{ res >= 0 or res == -ENOBUFS };
+    if (itr != m_udpSockets.end() and not rearm)
+    {
+        LOG_ERROR("[{}] udp recvmsg res failed. {}", itr->second->Name(), strerror(-res));
+    }
+
+    // ran out of buffers or the kernel otherwise stopped. the same op and buffers are queued again
+    if (itr != m_udpSockets.end() and rearm and
+        m_backend->QueueRecvMsg(event.m_id, event.m_fd, event.m_message, event.m_groupId))
+    {
+        return;
+    }
+
+    // the kernel is done with the buffers
+    m_backend->RemoveBufferGroup(event.m_groupId);
+    event.m_removeOnComplete = true;
+    if (itr != m_udpSockets.end())
+    {
+        itr->second->m_rxPending = false;
+    }
+}
+
+void Proactor::CompleteUdpPoll(UdpPoll& event, const io_uring_cqe& cEvent)
+{
+    int res{ cEvent.res };
+    RecordCompletion(event, IORING_OP_POLL_ADD, res);
+    const bool rearmNeeded{ (cEvent.flags & IORING_CQE_F_MORE) == 0 };
+    event.m_removeOnComplete = rearmNeeded;
+
+    auto itr{ m_udpSockets.find(event.m_handlerId) };
+    if (itr == m_udpSockets.end())
+    {
+        return;
+    }
+
+    auto [id, handler] = *itr;
+    if (res < 0)
+    {
+        if (res != -ECANCELED)
+        {
+            LOG_ERROR("[{}] udp poll res failed. {}", handler->Name(), strerror(-res));
+        }
+        handler->m_rxPending = false;
+        return;
+    }
+
+    // drain everything that's available. readiness won't be reported again for datagrams already queued
+    ssize_t rxBytes{ 0 };
+    while (m_udpSockets.contains(id))
+    {
+        sockaddr_in from{};
+        alignas(cmsghdr) std::array<uint8_t, UdpRecvMsg::s_controlSize> control{};
+        iovec iov{ .iov_base = handler->m_rxBuffer.data(), .iov_len = handler->m_rxBuffer.size() };
+        msghdr message{
+            .msg_name = &from,
+            .msg_namelen = sizeof(from),
+            .msg_iov = &iov,
+            .msg_iovlen = 1,
+            .msg_control = control.data(),
+            .msg_controllen = control.size(),
+            .msg_flags = 0,
+        };
+
+        rxBytes = ::recvmsg(event.m_fd, &message, MSG_DONTWAIT);
+        if (rxBytes < 0)
+        {
+            break;
+        }
+
+        size_t segmentSize{ 0 };
+        for (cmsghdr* cmsg{ CMSG_FIRSTHDR(&message) }; cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg))
+        {
+            segmentSize = std::max(segmentSize, GroSegmentSize(*cmsg));
+        }
+
+        DeliverDatagrams(
+            *handler, std::span{ handler->m_rxBuffer }.first(static_cast<size_t>(rxBytes)), segmentSize, from
+        );
+    }
+
+    if (rxBytes < 0 and errno != EAGAIN and errno != EWOULDBLOCK and errno != EINTR)
+    {
+        int err{ errno };
+        LOG_ERROR("[{}] udp read failed. {}", handler->Name(), strerror(err));
+    }
+
+    if (rearmNeeded and m_udpSockets.contains(id))
+    {
+        handler->m_rxPending = false;
+        RequestUdpRecv(*handler);
+    }
+}
+
+void Proactor::CompleteUdpSend(UdpSend& event, const io_uring_cqe& cEvent)
+{
+    int res{ cEvent.res };
+    RecordCompletion(event, IORING_OP_SENDMSG, res);
+    if (res < 0)
+    {
+        LOG_ERROR_RATE_LIMITED(
+            s_completionErrorsPerSecond,
+            "udp send of {} datagram(s) failed. handlerId({}) {}",
+            event.m_segments,
+            event.m_handlerId,
+            strerror(-res)
+        );
+        return;
+    }
+
+    m_metrics.m_udpDatagramsSent.Add(event.m_segments);
+}
+
+void Proactor::CompleteUdpRecvCancel(Event& event, const io_uring_cqe& cEvent)
+{
+    int res{ cEvent.res };
+    RecordCompletion(event, IORING_OP_ASYNC_CANCEL, res);
+    switch (res)
+    {
+        // cancellation acknowledged
+        case 0:
+        // recv already finished
+        case -ENOENT:
+        case -EALREADY:
+        {
+            LOG_DEBUG("udp recv cancel acknowledged eventId({}) res({})", event.m_id, res);
+            break;
+        }
+
+        default:
+        {
+            LOG_ERROR("failed eventId({}) res({}) {}", event.m_id, res, strerror(-res));
+            break;
+        }
+    }
+}
+
+void Proactor::DeliverDatagrams(
+    UdpSocket& handler, std::span<const uint8_t> payload, size_t segmentSize, const sockaddr_in& from
+)
+{
+    auto target{ m_handlerProfiler.Get(handler.m_id, handler.Name(), HandlerCallback::Receive) };
+    ScopedDeadline dl{ target.m_handlerName, s_callbackDeadline, &target.m_profile };
+    m_metrics.m_udpDatagramsReceived.Add(handler.Deliver(payload, segmentSize, from));
+}
+
+void Proactor::CompleteUnixAccept(UnixAccept& event, const io_uring_cqe& cEvent)
+{
+    int res{ cEvent.res };
+    RecordCompletion(event, IORING_OP_ACCEPT, res);
+    const bool rearmNeeded{ (cEvent.flags & IORING_CQE_F_MORE) == 0 };
+    event.m_removeOnComplete = rearmNeeded;
+
+    auto itr{ m_unixListeners.find(event.m_handlerId) };
+    if (itr == m_unixListeners.end())
+    {
+        // accepted as the listener went away. nobody is left to take it
+        if (res >= 0)
+        {
+            ::close(res);
+        }
+        return;
+    }
+
+    auto [id, handler] = *itr;
+    if (rearmNeeded)
+    {
+        handler->m_acceptPending = false;
+    }
+
+    if (res >= 0)
+    {
+        m_metrics.m_unixAccepts.Add();
+        auto target{ m_handlerProfiler.Get(handler->m_id, handler->Name(), HandlerCallback::Connect) };
+        ScopedDeadline dl{ target.m_handlerName, s_callbackDeadline, &target.m_profile };
+        handler->OnAccept(res);
+    }
+
+    // the connection went away before it was accepted. anything else, e.g. out of fds, would fail again straight away
+    const bool transient{ res >= 0 or res == -ECONNABORTED or res == -EINTR or res == -EAGAIN };
+    if (not transient and res != -ECANCELED)
+    {
+        LOG_ERROR("[{}] unix accept failed, no longer accepting. {}", handler->Name(), strerror(-res));
+    }
+
+    // the handler may have been removed by its own callback
+    if (rearmNeeded and transient and m_unixListeners.contains(id))
+    {
+        RequestUnixAccept(*handler);
+    }
+}
+
+void Proactor::CompleteUnixConnect(UnixConnect& event, const io_uring_cqe& cEvent)
+{
+    int res{ cEvent.res };
+    RecordCompletion(event, IORING_OP_CONNECT, res);
+
+    auto itr{ m_unixSockets.find(event.m_handlerId) };
+    if (itr == m_unixSockets.end())
+    {
+        return;
+    }
+
+    auto [_, handler] = *itr;
+    if (res < 0)
+    {
+        LOG_WARNING("[{}] unix connect failed. {}", handler->Name(), strerror(-res));
+        CloseUnixSocket(*handler, res);
+        return;
+    }
+
+    handler->m_state = UnixSocket::Connected;
+    RequestUnixRecv(*handler);
+    auto target{ m_handlerProfiler.Get(handler->m_id, handler->Name(), HandlerCallback::Connect) };
+    ScopedDeadline dl{ target.m_handlerName, s_callbackDeadline, &target.m_profile };
+    handler->OnConnect();
+}
+
+void Proactor::CompleteUnixRecv(UnixRecv& event, const io_uring_cqe& cEvent)
+{
+    int res{ cEvent.res };
+    RecordCompletion(event, IORING_OP_RECVMSG, res);
+
+    // fds are installed by the kernel whether or not anyone is left to take them
+    std::vector<int> fds;
+    if (res >= 0)
+    {
+        for (cmsghdr* cmsg{ CMSG_FIRSTHDR(&event.m_message) }; cmsg != nullptr;
+             cmsg = CMSG_NXTHDR(&event.m_message, cmsg))
+        {
+            if (cmsg->cmsg_level == SOL_SOCKET and cmsg->cmsg_type == SCM_RIGHTS)
+            {
+                const size_t count{ (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int) };
+                const size_t offset{ fds.size() };
+                fds.resize(offset + count);
+                std::memcpy(fds.data() + offset, CMSG_DATA(cmsg), count * sizeof(int));
+            }
+        }
+    }
+
+    auto itr{ m_unixSockets.find(event.m_handlerId) };
+    if (itr == m_unixSockets.end())
+    {
+        for (int fd : fds)
+        {
+            ::close(fd);
+        }
+        event.m_removeOnComplete = true;
         return;
     }
 
-    handler.m_state = TcpClient::Connecting;
-    LOG_DEBUG("net connect queued for '{}:{}'", handler.m_host, handler.m_port);
-    m_pendingEvents[userData] = std::move(event);
-}
-
-void Proactor::RequestTcpSend(TcpClient& handler, std::string data)
-{
-    auto event{ std::make_unique<TcpSend>(
-        handler.m_id,
-        [this](Event& event, const io_uring_cqe& cEvent) { CompleteTcpSend(static_cast<TcpSend&>(event), cEvent); },
-        handler.m_host,
-        handler.m_port,
-        handler.m_fd,
-        std::move(data)
-    ) };
-    IOURing::UserData userData{ event->m_id };
-
-    if (not m_ioURing.QueueTcpSend(userData, event->m_fd, event->m_data))
+    auto [id, handler] = *itr;
+    // a seqpacket message can be nothing but fds. otherwise nothing received is the peer hanging up
+    if (res < 0 or (res == 0 and fds.empty()))
     {
-        LOG_ERROR("[{}] failed to queue tcp send", handler.Name());
+        handler->m_rxPending = false;
+        event.m_removeOnComplete = true;
+        if (res < 0 and res != -ECONNRESET)
+        {
+            LOG_ERROR("[{}] unix recv res failed. {}", handler->Name(), strerror(-res));
+        }
+        if (res != -ECANCELED)
+        {
+            CloseUnixSocket(*handler, res);
+        }
         return;
     }
 
-    m_pendingEvents[userData] = std::move(event);
-}
+    if ((event.m_message.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) != 0)
+    {
+        // truncated fds were closed by the kernel, a truncated message's tail is gone
+        LOG_ERROR_RATE_LIMITED(
+            s_completionErrorsPerSecond,
+            "[{}] unix message truncated. data({}) fds({})",
+            handler->Name(),
+            (event.m_message.msg_flags & MSG_TRUNC) != 0,
+            (event.m_message.msg_flags & MSG_CTRUNC) != 0
+        );
+    }
 
-void Proactor::RequestTcpRecv(TcpClient& handler)
-{
-    auto event{ std::make_unique<TcpRecv>(
-        handler.m_id,
-        [this](Event& event, const io_uring_cqe& cEvent) { CompleteTcpRecv(static_cast<TcpRecv&>(event), cEvent); },
-        handler.m_host,
-        handler.m_port,
-        handler.m_fd
-    ) };
-    IOURing::UserData userData{ event->m_id };
+    m_metrics.m_unixBytesReceived.Add(static_cast<uint64_t>(res));
+    m_metrics.m_unixFdsReceived.Add(fds.size());
+    {
+        auto target{ m_handlerProfiler.Get(handler->m_id, handler->Name(), HandlerCallback::Receive) };
+        ScopedDeadline dl{ target.m_handlerName, s_callbackDeadline, &target.m_profile };
+        handler->OnReceive(std::span{ event.m_buffer }.first(static_cast<size_t>(res)), fds);
+    }
 
-    if (not m_ioURing.QueueTcpRecv(userData, event->m_fd, event->m_data))
+    // the same op and buffer are queued again, unless the handler removed itself in its callback
+    event.Reset();
+    if (m_unixSockets.contains(id) and m_backend->QueueRecvMsg(event.m_id, event.m_fd, event.m_message))
     {
-        LOG_ERROR("[{}] failed to queue tcp send", handler.Name());
         return;
     }
 
-    m_pendingEvents[userData] = std::move(event);
+    event.m_removeOnComplete = true;
+    if (m_unixSockets.contains(id))
+    {
+        LOG_ERROR("[{}] failed to queue unix recv", handler->Name());
+        handler->m_rxPending = false;
+    }
 }
 
-void Proactor::CompleteTimerExpiredEvent(Event& event, const io_uring_cqe& cEvent)
+void Proactor::CompleteUnixSend(UnixSend& event, const io_uring_cqe& cEvent)
 {
-    int eventRes{ cEvent.res };
+    int res{ cEvent.res };
+    RecordCompletion(event, IORING_OP_SENDMSG, res);
+    event.m_removeOnComplete = true;
+    if (res > 0)
+    {
+        m_metrics.m_unixBytesSent.Add(static_cast<uint64_t>(res));
+    }
 
-    auto itr{ m_timerHandlers.find(event.m_handlerId) };
-    if (itr == m_timerHandlers.end())
+    auto itr{ m_unixSockets.find(event.m_handlerId) };
+    if (itr == m_unixSockets.end())
     {
-        LOG_ERROR("failed to find handler for eventId({}) handlerId({})", event.m_id, event.m_handlerId);
         return;
     }
 
-    auto& handler{ *itr->second };
+    auto [_, handler] = *itr;
+    if (res < 0)
+    {
+        LOG_ERROR_RATE_LIMITED(
+            s_completionErrorsPerSecond, "[{}] unix send res failed. {}", handler->Name(), strerror(-res)
+        );
+    }
 
-    switch (eventRes)
+    // a stream send that went out in part continues with the rest, ahead of anything queued
+    if (res > 0 and event.m_sent + static_cast<size_t>(res) < event.m_data.size())
     {
-        // timer expired
-        case -ETIME:
+        event.Advance(static_cast<size_t>(res));
+        if (m_backend->QueueSendMsg(event.m_id, event.m_fd, event.m_message))
         {
-            LOG_DEBUG("[{}] triggering handler eventId({})", handler.Name(), event.m_id);
-
-            {
-                ScopedDeadline dl{ "TimerHandler:" + std::string{ handler.Name() }, 20ms };
-                handler.OnTimerExpired();
-            }
-
-            break;
+            event.m_removeOnComplete = false;
+            return;
         }
+        LOG_ERROR("[{}] failed to queue the rest of a unix send", handler->Name());
+    }
 
-        // timer cancelled
-        case -ECANCELED:
+    handler->m_txPending = false;
+    if (not handler->m_txQueue.empty() and handler->m_state == UnixSocket::Connected)
+    {
+        std::unique_ptr<UnixSend> next{ std::move(handler->m_txQueue.front()) };
+        handler->m_txQueue.pop_front();
+        SubmitUnixSend(*handler, std::move(next));
+    }
+}
+
+void Proactor::CompleteUnixCancel(Event& event, const io_uring_cqe& cEvent)
+{
+    int res{ cEvent.res };
+    RecordCompletion(event, IORING_OP_ASYNC_CANCEL, res);
+    switch (res)
+    {
+        // cancellation acknowledged
+        case 0:
+        // op already finished
+        case -ENOENT:
+        case -EALREADY:
         {
-            LOG_DEBUG("[{}] timer cancelled eventId({})", handler.Name(), event.m_id);
-            m_timerHandlers.erase(itr);
+            LOG_DEBUG("unix cancel acknowledged eventId({}) res({})", event.m_id, res);
             break;
         }
 
         default:
         {
-            LOG_ERROR("failed eventId({}) res({}) {}", event.m_id, eventRes, strerror(-eventRes));
+            LOG_ERROR("failed eventId({}) res({}) {}", event.m_id, res, strerror(-res));
             break;
         }
     }
 }
 
-void Proactor::CompleteTimerUpdateEvent(Event& event, const io_uring_cqe& cEvent)
+void Proactor::CompleteRelayTransfer(RelayTransfer& event, const io_uring_cqe& cEvent)
 {
-    int eventRes{ cEvent.res };
-    auto itr{ m_timerHandlers.find(event.m_handlerId) };
-    if (itr == m_timerHandlers.end())
+    // a zero copy send holds on to the buffer until the kernel notifies it has been released
+    event.m_removeOnComplete = (cEvent.flags & IORING_CQE_F_MORE) == 0;
+    if ((cEvent.flags & IORING_CQE_F_NOTIF) == 0)
+    {
+        event.m_result = cEvent.res;
+        RecordCompletion(event, event.m_opcode, event.m_result);
+    }
+
+    if (not event.m_removeOnComplete)
     {
-        LOG_ERROR("failed to find handler for eventId({}) handlerId({})", event.m_id, event.m_handlerId);
         return;
     }
 
-    auto& handler{ *itr->second };
+    const int res{ event.m_result };
+    auto itr{ m_tcpRelays.find(event.m_handlerId) };
+    if (itr == m_tcpRelays.end())
+    {
+        return;
+    }
 
-    switch (eventRes)
+    auto [_, handler] = *itr;
+    TcpRelay::Direction& flow{ handler->m_directions[event.m_direction] };
+    const bool fill{ event.m_leg == RelayLeg::Fill };
+    (fill ? flow.m_filling : flow.m_draining) = false;
+    flow.m_inFlight[static_cast<size_t>(event.m_leg)] = 0;
+    if (handler->m_closed)
     {
-        // timer update acknowledged
-        case 0:
+        return;
+    }
+
+    // ready, or errored or hung up, which the transfer tried again reports
+    if (event.m_opcode == IORING_OP_POLL_ADD and res >= 0)
+    {
+        if (not RequestRelayTransfer(*handler, event.m_direction, event.m_leg))
         {
-            LOG_DEBUG("[{}] timer update acknowledged eventId({})", handler.Name(), event.m_id);
-            break;
+            CloseRelay(*handler, -EIO);
         }
+        return;
+    }
 
-        default:
+    // a splice found the socket with nothing to give or no room. a fill can also find the pipe's slots used up by
+    // small segments before its bytes are, which only the drain in flight frees
+    if (res == -EAGAIN)
+    {
+        if (fill and flow.m_buffered > 0)
         {
-            LOG_ERROR("failed eventId({}) res({}) {}", event.m_id, eventRes, strerror(-eventRes));
-            break;
+            flow.m_stalled = true;
+        }
+        else if (not RequestRelayTransfer(*handler, event.m_direction, event.m_leg, true))
+        {
+            CloseRelay(*handler, -EIO);
         }
+        return;
     }
-}
 
-void Proactor::CompleteTimerCancelEvent(Event& event, const io_uring_cqe& cEvent)
-{
-    int eventRes{ cEvent.res };
-    auto itr{ m_timerHandlers.find(event.m_handlerId) };
-    if (itr == m_timerHandlers.end())
+    // the kernel can't splice on the ring. with nothing in either pipe yet the relay can carry on by copying
+    const bool nothingSpliced{ std::ranges::all_of(
+        handler->m_directions,
+        [](const TcpRelay::Direction& other) { return other.m_bytes == 0 and other.m_buffered == 0; }
+    ) };
+    if (res == -EINVAL and event.m_opcode == IORING_OP_SPLICE and
+        (handler->m_mode == TcpRelay::Mode::Copy or nothingSpliced))
     {
-        LOG_ERROR("failed to find handler for eventId({}) handlerId({})", event.m_id, event.m_handlerId);
+        if (handler->m_mode == TcpRelay::Mode::Splice)
+        {
+            LOG_WARNING("[{}] splice not supported, relaying by copying", handler->Name());
+            handler->UseCopy();
+        }
+        PumpRelay(*handler);
         return;
     }
 
-    auto& handler{ *itr->second };
+    if (res < 0)
+    {
+        if (res == -ECANCELED)
+        {
+            return;
+        }
 
-    switch (eventRes)
+        // resets and broken pipes are a peer going away rather than a fault
+        if (res != -ECONNRESET and res != -EPIPE)
+        {
+            LOG_ERROR_RATE_LIMITED(
+                s_completionErrorsPerSecond,
+                "[{}] relay {} failed. {}",
+                handler->Name(),
+                GetOpcodeName(event.m_opcode),
+                strerror(-res)
+            );
+        }
+        CloseRelay(*handler, res);
+        return;
+    }
+
+    const auto bytes{ static_cast<size_t>(res) };
+    if (fill)
     {
-        // timer cancellation acknowledged
+        flow.m_eof = bytes == 0;
+        flow.m_buffered += bytes;
+    }
+    else
+    {
+        flow.m_buffered -= bytes;
+        flow.m_bytes += bytes;
+        flow.m_stalled = false;
+        m_metrics.m_relayBytes.Add(bytes);
+        if (handler->m_mode == TcpRelay::Mode::Copy)
+        {
+            // back to the start of the ring while nothing's being received into it, keeping transfers whole
+            flow.m_head = (flow.m_head + bytes) % flow.m_capacity;
+            if (flow.m_buffered == 0 and not flow.m_filling)
+            {
+                flow.m_head = 0;
+            }
+        }
+    }
+
+    PumpRelay(*handler);
+}
+
+void Proactor::CompleteRelayCancel(Event& event, const io_uring_cqe& cEvent)
+{
+    int res{ cEvent.res };
+    RecordCompletion(event, IORING_OP_ASYNC_CANCEL, res);
+    switch (res)
+    {
+        // cancellation acknowledged
         case 0:
+        // op already finished
+        case -ENOENT:
+        case -EALREADY:
         {
-            LOG_DEBUG("[{}] timer cancellation acknowledged eventId({})", handler.Name(), event.m_id);
+            LOG_DEBUG("relay cancel acknowledged eventId({}) res({})", event.m_id, res);
             break;
         }
 
         default:
         {
-            LOG_ERROR("failed eventId({}) res({}) {}", event.m_id, eventRes, strerror(-eventRes));
+            LOG_ERROR("failed eventId({}) res({}) {}", event.m_id, res, strerror(-res));
             break;
         }
     }
 }
 
-void Proactor::CompleteSignalEvent(SignalEvent& event, const io_uring_cqe& cEvent)
+void Proactor::CompleteFileOp(FileOp& event, const io_uring_cqe& cEvent)
 {
     int res{ cEvent.res };
-    if (res < 0)
+    RecordCompletion(event, FileOpcode(event.m_kind), res);
+    if (res > 0 and event.m_kind == FileOpKind::Read)
     {
-        LOG_ERROR("read failed for signal {}({}). {}", strsignal(event.m_signal), event.m_signal, strerror(-res));
-        return;
+        m_metrics.m_fileBytesRead.Add(static_cast<uint64_t>(res));
     }
-
-    if (res != sizeof(signalfd_siginfo))
+    else if (res > 0 and event.m_kind == FileOpKind::Write)
     {
-        LOG_ERROR(
-            "read failed for signal {}({}). expected-read-size({}) actual-read-size({})",
-            strsignal(event.m_signal),
-            event.m_signal,
-            sizeof(signalfd_siginfo),
-            res
-        );
-        return;
+        m_metrics.m_fileBytesWritten.Add(static_cast<uint64_t>(res));
     }
 
-    auto itr{ m_signalHandlers.find(event.m_signal) };
-    if (itr == m_signalHandlers.end())
+    auto itr{ m_fileHandles.find(event.m_handlerId) };
+    if (itr == m_fileHandles.end())
     {
-        LOG_ERROR("could not find signal {}({}) in handler map", strsignal(event.m_signal), event.m_signal);
+        // opened after the handle was gone, nothing else will close it
+        if (event.m_kind == FileOpKind::Open and res >= 0)
+        {
+            ::close(res);
+        }
         return;
     }
 
-    const auto& [sig, data]{ *itr };
+    auto [id, handler] = *itr;
+    if (event.m_kind == FileOpKind::Open)
+    {
+        handler->m_openPending = false;
+        if (res >= 0)
+        {
+            LOG_INFO("[{}] file open fd({}) path({})", handler->Name(), res, handler->Path());
+            handler->m_fd = res;
+            handler->m_state = FileHandle::Open;
+        }
+        else
+        {
+            LOG_ERROR("[{}] failed to open {}. {}", handler->Name(), handler->Path(), strerror(-res));
+            handler->m_state = FileHandle::Closed;
+        }
 
-    LOG_INFO("invoking signal handler for signal {}({})", strsignal(sig), sig);
+        {
+            auto target{ m_handlerProfiler.Get(id, handler->Name(), HandlerCallback::Open) };
+            ScopedDeadline dl{ target.m_handlerName, s_callbackDeadline, &target.m_profile };
+            handler->OnOpen(std::min(res, 0));
+        }
 
-    (data->m_callback)(event.m_signalReadBuff);
+        if (res < 0)
+        {
+            FailQueuedFileOps(id, res);
+            return;
+        }
+    }
+    else
+    {
+        handler->m_inFlight--;
+        if (res < 0)
+        {
+            LOG_ERROR_RATE_LIMITED(
+                s_completionErrorsPerSecond,
+                "[{}] file {} failed. {}",
+                handler->Name(),
+                GetOpcodeName(FileOpcode(event.m_kind)),
+                strerror(-res)
+            );
+        }
+        FinishFileOp(*handler, event, res);
+    }
 
-    if (not RequestSignalRead(data->m_signal, data->m_fd))
+    // the callback may have removed the handle
+    if (auto after{ m_fileHandles.find(id) }; after != m_fileHandles.end())
     {
-        LOG_CRITICAL("failed to request signal {}({}) read", strsignal(event.m_signal), event.m_signal);
+        PumpFileOps(*after->second);
     }
 }
 
-void Proactor::CompleteTcpConnect(TcpConnect& event, const io_uring_cqe& cEvent)
+void Proactor::CompleteFileSendSplice(FileSendSplice& event, const io_uring_cqe& cEvent)
 {
     int res{ cEvent.res };
-    auto itr{ m_tcpClients.find(event.m_handlerId) };
-    if (itr == m_tcpClients.end())
+    RecordCompletion(event, event.m_opcode, res);
+
+    // finished or cancelled since
+    auto itr{ m_fileSends.find(event.m_sendId) };
+    if (itr == m_fileSends.end())
     {
-        LOG_ERROR("failed to find socket client for '{}:{}'", event.m_host, event.m_port);
         return;
     }
 
-    auto [_, handler] = *itr;
-    handler->m_state = TcpClient::Broken;
-    if (res < 0)
-    {
-        LOG_WARNING("[{}] tcp connect failed. {}. closing fd", handler->Name(), strerror(-res));
+    FileSend& send{ *itr->second };
+    const bool fill{ event.m_leg == FileSendLeg::Fill };
+    (fill ? send.m_filling : send.m_draining) = false;
+    send.m_inFlight[static_cast<size_t>(event.m_leg)] = 0;
 
-        if (event.m_fd > 0 and ::close(event.m_fd) == -1)
+    if (event.m_opcode == IORING_OP_POLL_ADD)
+    {
+        // ready, or in error which the splice retried next reports
+        if (res < 0)
         {
-            int err{ errno };
-            LOG_ERROR("[{}] tcp connect res failed. failed to close socket. {}", handler->Name(), strerror(err));
+            FinishFileSend(send.m_id, res);
+            return;
         }
-        return;
     }
-
-    handler->m_state = TcpClient::Connected;
-    handler->m_fd = event.m_fd;
-    handler->OnConnect();
-}
-
-void Proactor::CompleteTcpSend(TcpSend& event, const io_uring_cqe& cEvent)
-{
-    int res{ cEvent.res };
-    auto itr{ m_tcpClients.find(event.m_handlerId) };
-    if (itr == m_tcpClients.end())
+    else if (res == -EAGAIN)
     {
-        LOG_ERROR("failed to find socket client for '{}:{}'", event.m_host, event.m_port);
-        return;
+        // the pipe ran out of slots, a drain frees them. otherwise wait for room
+        if (fill and send.m_buffered > 0)
+        {
+            send.m_stalled = true;
+        }
+        else if (not RequestFileSendSplice(send, event.m_leg, true))
+        {
+            FinishFileSend(send.m_id, -EIO);
+            return;
+        }
     }
-
-    auto [_, handler] = *itr;
-    if (res < 0)
+    else if (res <= 0)
     {
-        LOG_ERROR("[{}] tcp send res failed. {}", handler->Name(), strerror(-res));
+        // the file ended early, or the socket broke
+        FinishFileSend(send.m_id, res < 0 ? res : (fill ? -ENODATA : -EPIPE));
+        return;
     }
-}
-
-void Proactor::CompleteTcpRecv(TcpRecv& event, const io_uring_cqe& cEvent)
-{
-    int res{ cEvent.res };
-    auto itr{ m_tcpClients.find(event.m_handlerId) };
-    if (itr == m_tcpClients.end())
+    else if (fill)
     {
-        LOG_ERROR("failed to find socket client for '{}:{}'", event.m_host, event.m_port);
-        return;
+        send.m_offset += static_cast<uint64_t>(res);
+        send.m_buffered += static_cast<size_t>(res);
     }
+    else
+    {
+        send.m_buffered -= static_cast<size_t>(res);
+        send.m_sent += static_cast<uint64_t>(res);
+        send.m_stalled = false;
+        m_metrics.m_fileSendBytes.Add(static_cast<uint64_t>(res));
 
-    auto [_, handler] = *itr;
-    handler->m_rxPending = false;
+        if (send.m_onProgress)
+        {
+            // held outside the send, which the callback may cancel
+            FileSendProgressFunc onProgress{ std::move(send.m_onProgress) };
+            const FileSendId id{ send.m_id };
+            {
+                auto target{ m_handlerProfiler.Get(send.m_clientId, send.Name(), HandlerCallback::FileSendProgress) };
+                ScopedDeadline dl{ target.m_handlerName, s_callbackDeadline, &target.m_profile };
+                onProgress(send.m_sent, send.m_total);
+            }
 
-    if (res < 0)
-    {
-        LOG_ERROR("[{}] tcp recv res failed. {}", handler->Name(), strerror(-res));
-        return;
+            itr = m_fileSends.find(id);
+            if (itr == m_fileSends.end())
+            {
+                return;
+            }
+            itr->second->m_onProgress = std::move(onProgress);
+        }
     }
 
-    if (res == 0)
+    PumpFileSend(*itr->second);
+}
+
+void Proactor::CompleteFileSendCancel(Event& event, const io_uring_cqe& cEvent)
+{
+    int res{ cEvent.res };
+    RecordCompletion(event, IORING_OP_ASYNC_CANCEL, res);
+    switch (res)
     {
-        LOG_INFO("[{}] tcp connection received 0 bytes", handler->Name());
-        return;
-    }
+        // cancellation acknowledged
+        case 0:
+        // op already finished
+        case -ENOENT:
+        case -EALREADY:
+        {
+            LOG_DEBUG("file send cancel acknowledged eventId({}) res({})", event.m_id, res);
+            break;
+        }
 
-    std::span buff{ event.m_data.begin(), static_cast<size_t>(res) };
-    handler->OnReceive(buff);
-    // re-queue  for another recv
-    handler->QueueRecv();
+        default:
+        {
+            LOG_ERROR("failed eventId({}) res({}) {}", event.m_id, res, strerror(-res));
+            break;
+        }
+    }
 }
 
 } // namespace Sage
@@ -1,11 +1,25 @@
 #pragma once
 
+#include <array>
+#include <csignal>
 #include <functional>
 #include <memory>
-
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <netinet/in.h>
+#include <sys/inotify.h>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "metrics/metrics.hpp"
+#include "proactor/buffer_pool.hpp"
+#include "proactor/event_tracer.hpp"
 #include "proactor/events.hpp"
 #include "proactor/handle.hpp"
-#include "proactor/io_uring.hpp"
+#include "proactor/handler_profiler.hpp"
+#include "proactor/io_backend.hpp"
 
 namespace Sage
 {
@@ -15,15 +29,93 @@ class TcpClient;
 class TcpConnect;
 class TcpRecv;
 class TcpSend;
+class TcpPoll;
+class TcpPollCancel;
+class UdpSocket;
+class UdpRecvMsg;
+class UdpPoll;
+class UdpSend;
+class UnixListener;
+class UnixSocket;
+class UnixAccept;
+class UnixConnect;
+class UnixRecv;
+class UnixSend;
+class TcpRelay;
+class RelayTransfer;
+enum class RelayLeg : uint8_t;
+class FileHandle;
+class FileOp;
+enum class FileOpKind : uint8_t;
+struct FileSend;
+class FileSendSplice;
+enum class FileSendLeg : uint8_t;
 class SignalEvent;
+class FileWatchEvent;
+struct ProactorInternals;
+
+struct BroadcastReport
+{
+    size_t m_clients{ 0 };
+    // clients that weren't connected
+    size_t m_skipped{ 0 };
+    size_t m_failed{ 0 };
+    // relative to the broadcast being queued.
+    // for zero copy sends a client completes once the kernel has released the payload
+    TimeNS m_firstCompletion{ 0 };
+    TimeNS m_lastCompletion{ 0 };
+};
+
+/// Time from an op being submitted to its completion. ns precise to ~6%
+struct OpLatency
+{
+    std::string_view m_op;
+    uint64_t m_count{ 0 };
+    TimeNS m_p50{ 0 };
+    TimeNS m_p99{ 0 };
+    TimeNS m_p999{ 0 };
+    TimeNS m_max{ 0 };
+};
+
+using BroadcastCompleteFunc = std::move_only_function<void(const BroadcastReport&)>;
+
+// bytes sent or -errno
+using SendCompleteFunc = std::move_only_function<void(int res)>;
+// caller owned memory, an owned copy, a pooled buffer or a payload shared with other sends
+using SendPayload = std::variant<std::span<const uint8_t>, std::string, BufferHandle, SharedPayload>;
+// bytes read or written, 0 for a sync, or -errno
+using FileCompleteFunc = std::move_only_function<void(int res)>;
+// 0 or -errno. stat is only filled in on success
+using FileStatFunc = std::move_only_function<void(int res, const struct statx& stat)>;
+
+using FileSendId = uint64_t;
+// bytes that have reached the socket, out of the send's total
+using FileSendProgressFunc = std::move_only_function<void(uint64_t sent, uint64_t total)>;
+// 0 once every byte is in the socket, or -errno. -ENODATA if the file ended first, -ECANCELED if cancelled
+using FileSendCompleteFunc = std::move_only_function<void(int res, uint64_t sent)>;
+
+struct FileSendOptions
+{
+    // spliced from the file at a time
+    uint32_t m_chunkSize{ 64 * 1024 };
+    // the pipe holds this many chunks, how far reading the file runs ahead of the socket
+    uint32_t m_chunks{ 4 };
+    // after every splice to the socket
+    FileSendProgressFunc m_onProgress{};
+};
 
 class Proactor
 {
 public:
     using SignalHandleFunc = std::move_only_function<void(const signalfd_siginfo&)>;
+    using FileWatchFunc = std::move_only_function<void(const inotify_event&)>;
 
 public:
-    static void Create();
+    /// io_uring falls back to epoll where the kernel doesn't allow it.
+    /// Blocks the signals the loop handles for the calling thread and any it starts after, create before them
+    static void Create(BackendType backend = BackendType::IOURing) { Create(BackendOptions{ .m_type = backend }); }
+
+    static void Create(const BackendOptions& options);
 
     static void Destroy();
 
@@ -33,6 +125,35 @@ public:
 
     void Run();
 
+    /// Run returns once the completion being handled is done with
+    void Stop() noexcept { m_running = false; }
+
+    /// The backend actually running, which may differ from the one requested
+    BackendType Backend() const noexcept { return m_backend->Type(); }
+
+    const IOBackend::Stats& RingStats() const noexcept { return m_backend->GetStats(); }
+
+    const IOURingCapabilities& RingCapabilities() const noexcept { return m_backend->GetCapabilities(); }
+
+    /// Removes the metrics from /dev/shm, for a process that exits without Destroy
+    void UnpublishMetrics() noexcept { m_metricsRegistry.Unpublish(); }
+
+    const BufferPool::Stats& RxBufferStats() const noexcept { return m_rxBufferPool.GetStats(); }
+
+    /// Submit to completion latency of the connect, send, recv, poll, timeout, read and file ops
+    std::vector<OpLatency> OpLatencies() const;
+
+    void LogOpLatencies() const;
+
+    /// Logs the handler callbacks the loop spent the most time in
+    void LogHandlerProfile(size_t topN = 10) const;
+
+    /// Records every event's submission, completion and callback, keeping the latest capacity records
+    void EnableTracing(size_t capacity = s_defaultTraceCapacity);
+
+    /// Writes the records kept so far as a chrome trace
+    bool WriteTrace(const std::string& path) const { return m_tracer.WriteChromeTrace(path); }
+
     void AddTimerHandler(TimerHandler& handler);
 
     void StartTimerHandler(TimerHandler& handler);
@@ -49,11 +170,105 @@ public:
 
     void RequestTcpSend(TcpClient&, std::string);
 
+    /// Sends caller owned memory without copying it. It must stay valid until onSent is invoked
+    void RequestTcpSend(TcpClient&, std::span<const uint8_t> data, SendCompleteFunc&& onSent);
+
+    void RequestTcpSend(TcpClient&, BufferHandle data);
+
+    void RequestTcpSend(TcpClient&, SharedPayload data);
+
+    /// Sends one payload to every connected client, submitting all the sends at once.
+    /// The payload is released and onComplete invoked after the last send completes
+    void Broadcast(std::span<TcpClient* const> clients, SharedPayload payload, BroadcastCompleteFunc&& onComplete = {});
+
+    /// @returns a pooled buffer to build an outgoing message in. slice it down to the bytes written
+    BufferHandle AcquireTxBuffer() { return m_txBufferPool.Acquire(); }
+
     void RequestTcpRecv(TcpClient&);
 
+    void RequestTcpPoll(TcpClient&);
+
+    /// Streams len bytes of fd from offset to the client, moving file pages through a pipe so they never reach
+    /// user space. fd is the caller's and must stay open until onComplete, invoked once however the send ends,
+    /// which includes the client being removed. Nothing else should be sent to the client meanwhile
+    /// @returns the id to cancel the send with, 0 if it couldn't be started
+    FileSendId SendFile(
+        TcpClient& client,
+        int fd,
+        uint64_t offset,
+        uint64_t len,
+        FileSendCompleteFunc&& onComplete,
+        FileSendOptions options = {}
+    );
+
+    /// onComplete is invoked with -ECANCELED before it returns. What's already in the socket still goes out
+    void CancelFileSend(FileSendId id);
+
+    void RequestTcpPollCancel(TcpClient&);
+
+    void AddUdpSocket(UdpSocket& handler);
+
+    void RemoveUdpSocket(UdpSocket& handler);
+
+    /// Sends data as one datagram, or as datagrams of segmentSize bytes with GSO
+    void RequestUdpSend(UdpSocket&, std::string data, uint16_t segmentSize, size_t segments);
+
+    /// The socket's pending batch is flushed once the completion being handled is done with
+    void ScheduleUdpFlush(UdpSocket& handler);
+
+    void AddUnixListener(UnixListener& handler);
+
+    void RemoveUnixListener(UnixListener& handler);
+
+    void AddUnixSocket(UnixSocket& handler);
+
+    void RemoveUnixSocket(UnixSocket& handler);
+
+    /// Sends data, passing fds along with it. The fds are owned by the send and closed once it's done
+    void RequestUnixSend(UnixSocket&, std::string data, std::vector<int> fds);
+
+    void AddTcpRelay(TcpRelay& handler);
+
+    void RemoveTcpRelay(TcpRelay& handler);
+
+    void AddFileHandle(FileHandle& handler);
+
+    void RemoveFileHandle(FileHandle& handler);
+
+    void RequestFileRead(FileHandle&, std::span<uint8_t> buffer, uint64_t offset, FileCompleteFunc&& onComplete);
+
+    void RequestFileWrite(FileHandle&, std::span<const uint8_t> buffer, uint64_t offset, FileCompleteFunc&& onComplete);
+
+    void RequestFileSync(FileHandle&, bool dataOnly, FileCompleteFunc&& onComplete);
+
+    void RequestFileStat(FileHandle&, FileStatFunc&& onStat);
+
+    /// File reads and writes through this memory skip mapping it on every op. Replaces what was registered before,
+    /// none of it may be in use by an op. false where the backend can't register, ops through the memory still work
+    bool RegisterFileBuffers(std::span<const iovec> buffers) { return m_backend->RegisterBuffers(buffers); }
+
+    /// Watches path with inotify. events are read through the ring so an idle watch costs nothing
+    /// @returns the watch id or -1
+    int AddFileWatch(const std::string& path, uint32_t mask, FileWatchFunc&& func);
+
+    void RemoveFileWatch(int watchId);
+
+    /// Runs func on the loop thread every time signal arrives. The signal is blocked for the calling thread, so
+    /// register before starting other threads. SIGINT, SIGQUIT, SIGTERM and SIGUSR1 are already blocked by Create.
+    /// A handler for SIGINT, SIGQUIT or SIGTERM added before Run replaces its built-in shutdown, call Stop to exit.
+    /// Throws if the signal already has a handler
+    void AddSignalHandler(int signal, SignalHandleFunc&& func);
+
+    /// Snapshot of the pending events, handlers, ring and pools. Logged when path is empty, otherwise appended
+    /// to the file. SIGUSR1 dumps it unless the application handles SIGUSR1 itself
+    void DumpState(const std::string& path = {}) const;
+
+    /// Where SIGUSR1 dumps go. the log by default
+    void SetStateDumpFile(std::string path) { m_stateDumpFile = std::move(path); }
+
 private:
     // creation via factory
-    Proactor();
+    explicit Proactor(const BackendOptions& options);
 
     Proactor(const Proactor&) = delete;
     Proactor(Proactor&&) = delete;
@@ -62,9 +277,20 @@ private:
 
     void StartAllHandlers();
 
+    void HandleCompletion();
+
+    /// After completions were dropped, notes the pending single-shot ops that complete without waiting on a peer.
+    /// Cancelling them to find out would end the ones still in flight
+    void SuspectOrphans();
+
+    /// Suspects still pending s_orphanAge after their submission lost their completion. They fail with -ECANCELED
+    void ReapOrphans();
+
     void AttachExitHandlers();
 
-    void AddSignalHandler(int signal, SignalHandleFunc&& func);
+    void AttachStateDumpHandler();
+
+    std::vector<std::string> StateSnapshot() const;
 
     void RequestTimerContinuous(TimerHandler& handler);
 
@@ -74,8 +300,87 @@ private:
 
     bool RequestSignalRead(int signal, int signalFd);
 
+    bool RequestFileWatchRead();
+
     void RequestTcpConnect(TcpClient&);
 
+    void QueueTcpSend(TcpClient&, SendPayload&& data, SendCompleteFunc&& onSent);
+
+    /// Provided buffers with multishot recvmsg where the backend has them, otherwise polled readiness
+    void RequestUdpRecv(UdpSocket&);
+
+    void FlushUdpSends();
+
+    void RequestUnixAccept(UnixListener&);
+
+    void RequestUnixConnect(UnixSocket&);
+
+    void RequestUnixRecv(UnixSocket&);
+
+    void SubmitUnixSend(UnixSocket&, std::unique_ptr<UnixSend> event);
+
+    /// Cancels one of the handler's pending ops, which may be mid completion
+    void RequestUnixCancel(Handle::Id id, std::string_view name, const Event& target);
+
+    /// Nothing is received after. Queued sends are dropped
+    void CloseUnixSocket(UnixSocket& handler, int res);
+
+    /// Queues whatever each direction has room to fill or bytes to drain, passing on hang ups once drained
+    void PumpRelay(TcpRelay& handler);
+
+    /// poll waits for the socket the transfer needs to be ready instead
+    bool RequestRelayTransfer(TcpRelay& handler, size_t direction, RelayLeg leg, bool poll = false);
+
+    void CancelRelayTransfers(TcpRelay& handler);
+
+    /// Nothing is relayed after
+    void CloseRelay(TcpRelay& handler, int res);
+
+    void RequestFileOpen(FileHandle& handler);
+
+    std::unique_ptr<FileOp> MakeFileOp(FileHandle& handler, FileOpKind kind);
+
+    /// Waits its turn if the file isn't open or the queue depth is reached
+    void RequestFileOp(FileHandle& handler, std::unique_ptr<FileOp> event);
+
+    /// @returns the op back if it couldn't be queued, for the caller to fail
+    std::unique_ptr<FileOp> SubmitFileOp(FileHandle& handler, std::unique_ptr<FileOp> event);
+
+    /// Submits waiting ops up to the queue depth
+    void PumpFileOps(FileHandle& handler);
+
+    /// Queues a splice in or out of the pipe for whatever it has room for or holds
+    void PumpFileSend(FileSend& send);
+
+    /// poll waits for the pipe or socket to have room instead
+    bool RequestFileSendSplice(FileSend& send, FileSendLeg leg, bool poll = false);
+
+    /// Cancels the send's ops in flight and invokes its callback. Nothing is sent after
+    void FinishFileSend(FileSendId id, int res);
+
+    /// Fails each waiting op with res, for as long as the handle lives
+    void FailQueuedFileOps(Handle::Id id, int res);
+
+    /// Invokes the op's callback, profiled
+    void FinishFileOp(FileHandle& handler, FileOp& event, int res);
+
+    /// -errno results are counted as errors. Only single-shot ops are timed
+    void RecordCompletion(Event& event, uint8_t opcode, int res) noexcept
+    {
+        const Clock::time_point now{ Clock::now() };
+        if (not event.m_multishot)
+        {
+            m_metrics.m_opLatency[opcode].Record(static_cast<uint64_t>((now - event.m_submitTime).count()));
+        }
+        event.m_submitTime = now;
+
+        m_metrics.m_opsCompleted.Add(opcode);
+        if (res < 0)
+        {
+            m_metrics.m_errors.Add(static_cast<size_t>(-res));
+        }
+    }
+
     void CompleteTimerExpiredEvent(Event& event, const io_uring_cqe& cEvent);
 
     void CompleteTimerUpdateEvent(Event& event, const io_uring_cqe& cEvent);
@@ -84,12 +389,52 @@ private:
 
     void CompleteSignalEvent(SignalEvent& event, const io_uring_cqe& cEvent);
 
+    void CompleteFileWatchEvent(FileWatchEvent& event, const io_uring_cqe& cEvent);
+
     void CompleteTcpConnect(TcpConnect& event, const io_uring_cqe& cEvent);
 
     void CompleteTcpSend(TcpSend& event, const io_uring_cqe& cEvent);
 
+    void LogTcpSendResult(const TcpSend& event);
+
     void CompleteTcpRecv(TcpRecv& event, const io_uring_cqe& cEvent);
 
+    void CompleteTcpPoll(TcpPoll& event, const io_uring_cqe& cEvent);
+
+    void CompleteTcpPollCancel(Event& event, const io_uring_cqe& cEvent);
+
+    void CompleteUdpRecvMsg(UdpRecvMsg& event, const io_uring_cqe& cEvent);
+
+    void CompleteUdpPoll(UdpPoll& event, const io_uring_cqe& cEvent);
+
+    void CompleteUdpSend(UdpSend& event, const io_uring_cqe& cEvent);
+
+    void CompleteUdpRecvCancel(Event& event, const io_uring_cqe& cEvent);
+
+    void CompleteUnixAccept(UnixAccept& event, const io_uring_cqe& cEvent);
+
+    void CompleteUnixConnect(UnixConnect& event, const io_uring_cqe& cEvent);
+
+    void CompleteUnixRecv(UnixRecv& event, const io_uring_cqe& cEvent);
+
+    void CompleteUnixSend(UnixSend& event, const io_uring_cqe& cEvent);
+
+    void CompleteUnixCancel(Event& event, const io_uring_cqe& cEvent);
+
+    void CompleteRelayTransfer(RelayTransfer& event, const io_uring_cqe& cEvent);
+
+    void CompleteRelayCancel(Event& event, const io_uring_cqe& cEvent);
+
+    void CompleteFileOp(FileOp& event, const io_uring_cqe& cEvent);
+
+    void CompleteFileSendSplice(FileSendSplice& event, const io_uring_cqe& cEvent);
+
+    void CompleteFileSendCancel(Event& event, const io_uring_cqe& cEvent);
+
+    void DeliverDatagrams(
+        UdpSocket& handler, std::span<const uint8_t> payload, size_t segmentSize, const sockaddr_in& from
+    );
+
     template<typename ET> auto FindPendingEvent(Handle::Id id)
     {
         ET* res{ nullptr };
@@ -115,12 +460,40 @@ private:
 
 private:
     static inline Proactor* s_instance{ nullptr };
-
-    IOURing m_ioURing{ 10'000 };
+    // the creating thread's mask before the loop signals were blocked, restored by Destroy
+    static inline sigset_t s_previousSignalMask{};
+    // cap for error sites that can fire on every completion
+    static constexpr uint32_t s_completionErrorsPerSecond{ 10 };
+    // ~8MB of trace records
+    static constexpr size_t s_defaultTraceCapacity{ 256 * 1024 };
+    // handler callbacks running longer than this are logged
+    static constexpr TimeMS s_callbackDeadline{ 20 };
+    // far longer than an op that doesn't wait on a peer takes, even a sync to a busy disk
+    static constexpr std::chrono::seconds s_orphanAge{ 60 };
+
+    // first in, last out. everything below may hold metric handles
+    Metrics::MetricsRegistry m_metricsRegistry;
+    std::unique_ptr<IOBackend> m_backend;
     bool m_running{ false };
-    std::unordered_map<EventId, std::unique_ptr<Event>> m_pendingEvents;
+    // must outlive the pending events holding their buffers
+    BufferPool m_rxBufferPool{ 4 * 1024, 1024 };
+    BufferPool m_txBufferPool{ 16 * 1024, 256 };
+    // map nodes are recycled so tracking an event doesn't hit the heap
+    std::pmr::unsynchronized_pool_resource m_pendingEventsPool;
+    std::pmr::unordered_map<EventId, std::unique_ptr<Event>> m_pendingEvents{ &m_pendingEventsPool };
     std::unordered_map<Handle::Id, TimerHandler*> m_timerHandlers;
     std::unordered_map<Handle::Id, TcpClient*> m_tcpClients;
+    std::unordered_map<Handle::Id, UdpSocket*> m_udpSockets;
+    // sockets with datagrams batched during the current completion
+    std::vector<Handle::Id> m_udpFlushes;
+    // each socket receiving into provided buffers has a group of its own
+    uint16_t m_nextBufferGroup{ 0 };
+    std::unordered_map<Handle::Id, UnixListener*> m_unixListeners;
+    std::unordered_map<Handle::Id, UnixSocket*> m_unixSockets;
+    std::unordered_map<Handle::Id, TcpRelay*> m_tcpRelays;
+    std::unordered_map<Handle::Id, FileHandle*> m_fileHandles;
+    std::unordered_map<FileSendId, std::unique_ptr<FileSend>> m_fileSends;
+    FileSendId m_nextFileSendId{ 1 };
 
     struct SignalHandleData
     {
@@ -131,6 +504,51 @@ private:
 
     // map signal num -> handler data
     std::unordered_map<int, std::unique_ptr<SignalHandleData>> m_signalHandlers;
+
+    struct LoopMetrics
+    {
+        Metrics::Counter m_iterations;
+        Metrics::Gauge m_pendingEvents;
+        // completions the kernel dropped, and the pending events left without one that were reaped
+        Metrics::Counter m_cqDropped;
+        Metrics::Counter m_orphansReaped;
+        Metrics::CounterArray m_opsCompleted;
+        Metrics::CounterArray m_errors;
+        Metrics::Counter m_bytesSent;
+        Metrics::Counter m_bytesReceived;
+        Metrics::Histogram m_sendSizes;
+        Metrics::Histogram m_recvSizes;
+        Metrics::Counter m_tcpConnects;
+        Metrics::Counter m_tcpReconnectAttempts;
+        Metrics::Counter m_udpDatagramsSent;
+        Metrics::Counter m_udpDatagramsReceived;
+        Metrics::Counter m_unixAccepts;
+        Metrics::Counter m_unixBytesSent;
+        Metrics::Counter m_unixBytesReceived;
+        Metrics::Counter m_unixFdsReceived;
+        Metrics::Counter m_relayBytes;
+        Metrics::Counter m_fileBytesRead;
+        Metrics::Counter m_fileBytesWritten;
+        Metrics::Counter m_fileSendBytes;
+        // indexed by opcode. ops that aren't timed share an unregistered histogram
+        std::array<Metrics::LatencyHistogram, Metrics::s_opcodeSlots> m_opLatency;
+    };
+
+    LoopMetrics m_metrics;
+    // pending ops that may have lost their completion, and when they're next looked at
+    std::vector<EventId> m_orphanSuspects;
+    Clock::time_point m_nextOrphanCheck{};
+    HandlerProfiler m_handlerProfiler;
+    EventTracer m_tracer;
+
+    // one inotify fd shared by every watch. created on first use
+    int m_fileWatchFd{ -1 };
+    std::unordered_map<int, FileWatchFunc> m_fileWatches;
+
+    std::string m_stateDumpFile;
+
+    // tools reach in through proactor_internals.hpp
+    friend struct ProactorInternals;
 };
 
 } // namespace Sage
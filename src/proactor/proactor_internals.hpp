@@ -0,0 +1,27 @@
+#pragma once
+
+#include "proactor/proactor.hpp"
+
+namespace Sage
+{
+
+/**
+ * Reaches past the proactor's public interface, for tools that measure or inspect the loop directly.
+ * Not for handlers, none of it is stable
+ */
+struct ProactorInternals
+{
+    static auto& PendingEvents(Proactor& proactor) noexcept { return proactor.m_pendingEvents; }
+
+    static IOBackend& Backend(Proactor& proactor) noexcept { return *proactor.m_backend; }
+
+    /// Waits for a single completion and dispatches it
+    static void HandleCompletion(Proactor& proactor) { proactor.HandleCompletion(); }
+
+    template<typename ET> static ET* FindPendingEvent(Proactor& proactor, Handle::Id id)
+    {
+        return proactor.FindPendingEvent<ET>(id);
+    }
+};
+
+} // namespace Sage
@@ -0,0 +1,293 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <print>
+#include <stdexcept>
+
+#include "log/logger.hpp"
+#include "proactor/recording_backend.hpp"
+
+namespace Sage
+{
+
+RecordingBackend::RecordingBackend(std::unique_ptr<IOBackend> backend, const std::string& path) :
+    m_backend{ std::move(backend) },
+    m_trace{ path, std::ios::out | std::ios::trunc }
+{
+    if (not m_trace.is_open())
+    {
+        int err{ errno };
+        LOG_CRITICAL("failed to open cqe trace {}. {}", path, strerror(err));
+        throw std::runtime_error{ "CQE Trace Open Failed" };
+    }
+
+    m_capabilities = m_backend->GetCapabilities();
+    std::println(m_trace, "{}", s_traceHeader);
+    std::println(m_trace, "K {:d} {:d}", m_capabilities.m_multishotRecv, m_capabilities.m_providedBufferRing);
+
+    LOG_INFO("recording completions to {}", path);
+}
+
+RecordingBackend::~RecordingBackend()
+{
+    m_trace.flush();
+    LOG_INFO("recorded {} completion(s)", m_completions);
+}
+
+UniqueUringCEvent RecordingBackend::WaitForEvent()
+{
+    UniqueUringCEvent cEvent{ m_backend->WaitForEvent() };
+    if (cEvent == nullptr)
+    {
+        return cEvent;
+    }
+
+    const TimeNS offset{ std::chrono::duration_cast<TimeNS>(Clock::now() - m_start) };
+    std::print(m_trace, "C {} {} {} {}", offset.count(), cEvent->user_data, cEvent->res, cEvent->flags);
+
+    if (const std::span<const uint8_t> bytes{ ReadBytes(*cEvent) }; not bytes.empty())
+    {
+        constexpr std::string_view digits{ "0123456789abcdef" };
+        std::string hex(" ");
+        for (uint8_t byte : bytes)
+        {
+            hex.push_back(digits[byte >> 4]);
+            hex.push_back(digits[byte & 0xf]);
+        }
+        m_trace << hex;
+    }
+
+    if ((cEvent->flags & IORING_CQE_F_MORE) == 0)
+    {
+        m_buffers.erase(cEvent->user_data);
+        m_groupOps.erase(cEvent->user_data);
+    }
+
+    m_trace << '\n';
+    m_completions++;
+
+    return cEvent;
+}
+
+size_t RecordingBackend::FlushOverflow()
+{
+    const size_t dropped{ m_backend->FlushOverflow() };
+    m_stats = m_backend->GetStats();
+    return dropped;
+}
+
+void RecordingBackend::AdaptCapacity(size_t inFlight)
+{
+    m_backend->AdaptCapacity(inFlight);
+    m_stats = m_backend->GetStats();
+}
+
+bool RecordingBackend::QueueNop(const UserData& data)
+{
+    Submitted(data, IORING_OP_NOP);
+    return m_backend->QueueNop(data);
+}
+
+bool RecordingBackend::QueueTimeoutEvent(const UserData& data, const TimeNS& timeout)
+{
+    Submitted(data, IORING_OP_TIMEOUT);
+    return m_backend->QueueTimeoutEvent(data, timeout);
+}
+
+bool RecordingBackend::CancelTimeoutEvent(const UserData& cancelData, const UserData& timeoutData)
+{
+    Submitted(cancelData, IORING_OP_TIMEOUT_REMOVE);
+    return m_backend->CancelTimeoutEvent(cancelData, timeoutData);
+}
+
+bool RecordingBackend::UpdateTimeoutEvent(
+    const UserData& updateData, const UserData& timeoutData, const TimeNS& timeout
+)
+{
+    Submitted(updateData, IORING_OP_TIMEOUT_REMOVE);
+    return m_backend->UpdateTimeoutEvent(updateData, timeoutData, timeout);
+}
+
+bool RecordingBackend::QueueSignalRead(const UserData& data, int fd, signalfd_siginfo& readBuff)
+{
+    Submitted(data, IORING_OP_READ);
+    m_buffers[data] = std::span{ reinterpret_cast<const uint8_t*>(&readBuff), sizeof(readBuff) };
+    return m_backend->QueueSignalRead(data, fd, readBuff);
+}
+
+bool RecordingBackend::QueueRead(const UserData& data, int fd, std::span<uint8_t> buffer)
+{
+    Submitted(data, IORING_OP_READ);
+    m_buffers[data] = buffer;
+    return m_backend->QueueRead(data, fd, buffer);
+}
+
+int RecordingBackend::QueueTcpConnect(const UserData& data, const std::string& host, const std::string& port)
+{
+    Submitted(data, IORING_OP_CONNECT);
+    return m_backend->QueueTcpConnect(data, host, port);
+}
+
+bool RecordingBackend::QueueTcpSend(const UserData& data, int fd, std::string_view buffer)
+{
+    Submitted(data, SendOpcode(buffer.size()));
+    return m_backend->QueueTcpSend(data, fd, buffer);
+}
+
+bool RecordingBackend::QueueTcpRecv(const UserData& data, int fd, std::span<uint8_t> rxBuffer)
+{
+    Submitted(data, IORING_OP_RECV);
+    m_buffers[data] = rxBuffer;
+    return m_backend->QueueTcpRecv(data, fd, rxBuffer);
+}
+
+bool RecordingBackend::QueuePollIn(const UserData& data, int fd)
+{
+    Submitted(data, IORING_OP_POLL_ADD);
+    return m_backend->QueuePollIn(data, fd);
+}
+
+bool RecordingBackend::CancelPoll(const UserData& cancelData, const UserData& pollData)
+{
+    Submitted(cancelData, IORING_OP_POLL_REMOVE);
+    return m_backend->CancelPoll(cancelData, pollData);
+}
+
+bool RecordingBackend::CancelOp(const UserData& cancelData, const UserData& targetData)
+{
+    Submitted(cancelData, IORING_OP_ASYNC_CANCEL);
+    return m_backend->CancelOp(cancelData, targetData);
+}
+
+bool RecordingBackend::AddBufferGroup(uint16_t groupId, std::span<uint8_t> memory, uint32_t bufferSize)
+{
+    if (not m_backend->AddBufferGroup(groupId, memory, bufferSize))
+    {
+        return false;
+    }
+
+    m_bufferGroups[groupId] = { memory, bufferSize };
+    return true;
+}
+
+void RecordingBackend::RemoveBufferGroup(uint16_t groupId)
+{
+    m_bufferGroups.erase(groupId);
+    m_backend->RemoveBufferGroup(groupId);
+}
+
+bool RecordingBackend::QueueRecvMsg(const UserData& data, int fd, const msghdr& message, uint16_t groupId)
+{
+    Submitted(data, IORING_OP_RECVMSG);
+    m_groupOps[data] = groupId;
+    return m_backend->QueueRecvMsg(data, fd, message, groupId);
+}
+
+bool RecordingBackend::QueueSendMsg(const UserData& data, int fd, const msghdr& message)
+{
+    Submitted(data, IORING_OP_SENDMSG);
+    return m_backend->QueueSendMsg(data, fd, message);
+}
+
+bool RecordingBackend::QueueRecvMsg(const UserData& data, int fd, msghdr& message)
+{
+    Submitted(data, IORING_OP_RECVMSG);
+    // the payload is recorded. passed fds mean nothing outside the recorded process
+    if (message.msg_iovlen > 0)
+    {
+        m_buffers[data] = std::span{ static_cast<const uint8_t*>(message.msg_iov[0].iov_base),
+                                     message.msg_iov[0].iov_len };
+    }
+    return m_backend->QueueRecvMsg(data, fd, message);
+}
+
+bool RecordingBackend::QueueAccept(const UserData& data, int listenFd)
+{
+    Submitted(data, IORING_OP_ACCEPT);
+    return m_backend->QueueAccept(data, listenFd);
+}
+
+bool RecordingBackend::QueueConnect(const UserData& data, int fd, const sockaddr& address, socklen_t addressLen)
+{
+    Submitted(data, IORING_OP_CONNECT);
+    return m_backend->QueueConnect(data, fd, address, addressLen);
+}
+
+bool RecordingBackend::QueueSplice(const UserData& data, int fdIn, int64_t offsetIn, int fdOut, uint32_t len)
+{
+    Submitted(data, IORING_OP_SPLICE);
+    return m_backend->QueueSplice(data, fdIn, offsetIn, fdOut, len);
+}
+
+bool RecordingBackend::QueuePoll(const UserData& data, int fd, uint32_t events)
+{
+    Submitted(data, IORING_OP_POLL_ADD);
+    return m_backend->QueuePoll(data, fd, events);
+}
+
+bool RecordingBackend::QueueOpen(const UserData& data, const char* path, int flags, mode_t mode)
+{
+    Submitted(data, IORING_OP_OPENAT);
+    return m_backend->QueueOpen(data, path, flags, mode);
+}
+
+bool RecordingBackend::QueueReadAt(const UserData& data, int fd, std::span<uint8_t> buffer, uint64_t offset)
+{
+    Submitted(data, IORING_OP_READ);
+    m_buffers[data] = buffer;
+    return m_backend->QueueReadAt(data, fd, buffer, offset);
+}
+
+bool RecordingBackend::QueueWriteAt(const UserData& data, int fd, std::span<const uint8_t> buffer, uint64_t offset)
+{
+    Submitted(data, IORING_OP_WRITE);
+    return m_backend->QueueWriteAt(data, fd, buffer, offset);
+}
+
+bool RecordingBackend::QueueFsync(const UserData& data, int fd, bool dataOnly)
+{
+    Submitted(data, IORING_OP_FSYNC);
+    return m_backend->QueueFsync(data, fd, dataOnly);
+}
+
+bool RecordingBackend::QueueStatx(const UserData& data, int fd, struct statx& statxBuf)
+{
+    Submitted(data, IORING_OP_STATX);
+    return m_backend->QueueStatx(data, fd, statxBuf);
+}
+
+std::span<const uint8_t> RecordingBackend::ReadBytes(const io_uring_cqe& cEvent)
+{
+    if (cEvent.res <= 0)
+    {
+        return {};
+    }
+
+    std::span<const uint8_t> buffer{};
+    if (auto itr{ m_buffers.find(cEvent.user_data) }; itr != m_buffers.end())
+    {
+        buffer = itr->second;
+    }
+    else if ((cEvent.flags & IORING_CQE_F_BUFFER) != 0)
+    {
+        // the kernel picked the buffer. it's found by the op's group and the id in the flags
+        auto op{ m_groupOps.find(cEvent.user_data) };
+        auto group{ op == m_groupOps.end() ? m_bufferGroups.end() : m_bufferGroups.find(op->second) };
+        if (group != m_bufferGroups.end())
+        {
+            const auto& [memory, bufferSize]{ group->second };
+            const size_t bufferId{ cEvent.flags >> IORING_CQE_BUFFER_SHIFT };
+            const size_t offset{ std::min(bufferId * bufferSize, memory.size()) };
+            buffer = memory.subspan(offset, std::min<size_t>(bufferSize, memory.size() - offset));
+        }
+    }
+
+    return buffer.first(std::min(static_cast<size_t>(cEvent.res), buffer.size()));
+}
+
+void RecordingBackend::Submitted(UserData data, uint8_t opcode)
+{
+    std::println(m_trace, "S {} {}", opcode, data);
+}
+
+} // namespace Sage
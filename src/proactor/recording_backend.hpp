@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <sys/signalfd.h>
+#include <unordered_map>
+#include <utility>
+
+#include "metrics/metrics.hpp"
+#include "proactor/io_backend.hpp"
+#include "timing/time.hpp"
+
+namespace Sage
+{
+
+/**
+ * Runs another backend, writing every submission and completion to a trace ReplayBackend can play back.
+ * The trace is text, one record per line, so it can be inspected or written by hand as a script:
+ *   K <multishot recv> <provided buffer rings>   capabilities the proactor picks ops by, 0 or 1
+ *   S <opcode> <user data>
+ *   C <ns since recording started> <user data> <res> <flags> [bytes read, hex]
+ */
+class RecordingBackend final : public IOBackend
+{
+public:
+    static constexpr std::string_view s_traceHeader{ "# cqe trace v1" };
+
+    /// Throws std::runtime_error if path can't be written
+    RecordingBackend(std::unique_ptr<IOBackend> backend, const std::string& path);
+
+    ~RecordingBackend() override;
+
+    BackendType Type() const noexcept override { return m_backend->Type(); }
+
+    UniqueUringCEvent WaitForEvent() override;
+
+    size_t FlushOverflow() override;
+
+    void AdaptCapacity(size_t inFlight) override;
+
+    void AttachMetrics(Metrics::MetricsRegistry& registry) override { m_backend->AttachMetrics(registry); }
+
+    void AttachTracer(EventTracer& tracer) noexcept override { m_backend->AttachTracer(tracer); }
+
+    void BeginBatch() noexcept override { m_backend->BeginBatch(); }
+
+    bool EndBatch() override { return m_backend->EndBatch(); }
+
+    Occupancy GetOccupancy() const noexcept override { return m_backend->GetOccupancy(); }
+
+    bool QueueNop(const UserData& data) override;
+
+    bool QueueTimeoutEvent(const UserData& data, const TimeNS& timeout) override;
+
+    bool CancelTimeoutEvent(const UserData& cancelData, const UserData& timeoutData) override;
+
+    bool UpdateTimeoutEvent(const UserData& updateData, const UserData& timeoutData, const TimeNS& timeout) override;
+
+    bool QueueSignalRead(const UserData& data, int fd, signalfd_siginfo& readBuff) override;
+
+    bool QueueRead(const UserData& data, int fd, std::span<uint8_t> buffer) override;
+
+    int QueueTcpConnect(const UserData& data, const std::string& host, const std::string& port) override;
+
+    bool QueueTcpSend(const UserData& data, int fd, std::string_view buffer) override;
+
+    uint8_t SendOpcode(size_t size) const noexcept override { return m_backend->SendOpcode(size); }
+
+    bool QueueTcpRecv(const UserData& data, int fd, std::span<uint8_t> rxBuffer) override;
+
+    bool QueuePollIn(const UserData& data, int fd) override;
+
+    bool CancelPoll(const UserData& cancelData, const UserData& pollData) override;
+
+    bool CancelOp(const UserData& cancelData, const UserData& targetData) override;
+
+    bool AddBufferGroup(uint16_t groupId, std::span<uint8_t> memory, uint32_t bufferSize) override;
+
+    void RemoveBufferGroup(uint16_t groupId) override;
+
+    void ReturnBuffer(uint16_t groupId, uint16_t bufferId) override { m_backend->ReturnBuffer(groupId, bufferId); }
+
+    bool QueueRecvMsg(const UserData& data, int fd, const msghdr& message, uint16_t groupId) override;
+
+    bool QueueSendMsg(const UserData& data, int fd, const msghdr& message) override;
+
+    bool QueueRecvMsg(const UserData& data, int fd, msghdr& message) override;
+
+    bool QueueAccept(const UserData& data, int listenFd) override;
+
+    bool QueueConnect(const UserData& data, int fd, const sockaddr& address, socklen_t addressLen) override;
+
+    bool QueueSplice(const UserData& data, int fdIn, int64_t offsetIn, int fdOut, uint32_t len) override;
+
+    bool QueuePoll(const UserData& data, int fd, uint32_t events) override;
+
+    bool QueueOpen(const UserData& data, const char* path, int flags, mode_t mode) override;
+
+    bool QueueReadAt(const UserData& data, int fd, std::span<uint8_t> buffer, uint64_t offset) override;
+
+    bool QueueWriteAt(const UserData& data, int fd, std::span<const uint8_t> buffer, uint64_t offset) override;
+
+    bool QueueFsync(const UserData& data, int fd, bool dataOnly) override;
+
+    bool QueueStatx(const UserData& data, int fd, struct statx& statxBuf) override;
+
+    bool RegisterBuffers(std::span<const iovec> buffers) override { return m_backend->RegisterBuffers(buffers); }
+
+    void UnregisterBuffers() override { m_backend->UnregisterBuffers(); }
+
+private:
+    RecordingBackend(const RecordingBackend&) = delete;
+    RecordingBackend(RecordingBackend&&) = delete;
+    RecordingBackend& operator=(const RecordingBackend&) = delete;
+    RecordingBackend& operator=(RecordingBackend&&) = delete;
+
+    void Submitted(UserData data, uint8_t opcode);
+
+    /// @returns what the completion read, if anything
+    std::span<const uint8_t> ReadBytes(const io_uring_cqe& cEvent);
+
+    std::unique_ptr<IOBackend> m_backend;
+    std::ofstream m_trace;
+    const Clock::time_point m_start{ Clock::now() };
+    // ops reading into a buffer. what they read is recorded with their completion
+    std::unordered_map<UserData, std::span<const uint8_t>> m_buffers;
+    // buffer group id -> its memory and buffer size
+    std::unordered_map<uint16_t, std::pair<std::span<const uint8_t>, uint32_t>> m_bufferGroups;
+    // ops picking their buffers from a group
+    std::unordered_map<UserData, uint16_t> m_groupOps;
+    size_t m_completions{ 0 };
+};
+
+} // namespace Sage
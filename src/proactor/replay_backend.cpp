@@ -0,0 +1,495 @@
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "log/logger.hpp"
+#include "proactor/opcode_name.hpp"
+#include "proactor/recording_backend.hpp"
+#include "proactor/replay_backend.hpp"
+
+namespace Sage
+{
+
+namespace
+{
+
+/// Splits off the next space separated field
+std::string_view NextField(std::string_view& line) noexcept
+{
+    const size_t start{ std::min(line.find_first_not_of(' '), line.size()) };
+    const size_t end{ std::min(line.find(' ', start), line.size()) };
+    std::string_view field{ line.substr(start, end - start) };
+    line.remove_prefix(end);
+    return field;
+}
+
+template<typename T> bool ParseField(std::string_view& line, T& value) noexcept
+{
+    const std::string_view field{ NextField(line) };
+    const auto [ptr, ec]{ std::from_chars(field.data(), field.data() + field.size(), value) };
+    return not field.empty() and ec == std::errc{} and ptr == field.data() + field.size();
+}
+
+bool ParseHex(std::string_view hex, std::vector<uint8_t>& bytes)
+{
+    if (hex.size() % 2 != 0)
+    {
+        return false;
+    }
+
+    bytes.resize(hex.size() / 2);
+    for (size_t i{ 0 }; i < bytes.size(); i++)
+    {
+        const auto [ptr, ec]{ std::from_chars(hex.data() + i * 2, hex.data() + i * 2 + 2, bytes[i], 16) };
+        if (ec != std::errc{} or ptr != hex.data() + i * 2 + 2)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+ReplayBackend::ReplayBackend(const std::string& path)
+{
+    Load(path);
+
+    LOG_INFO(
+        "replaying {} submission(s) and {} completion(s) from {}", m_submissions.size(), m_completions.size(), path
+    );
+}
+
+ReplayBackend::~ReplayBackend()
+{
+    const Clock::time_point end{ m_lastWait == Clock::time_point{} ? Clock::now() : m_lastWait };
+    const TimeNS elapsed{
+        m_firstWait == Clock::time_point{} ? TimeNS{ 0 } : std::chrono::duration_cast<TimeNS>(end - m_firstWait)
+    };
+
+    LOG_INFO(
+        "replayed {} completion(s) in {}us. {:.0f}ns per completion. unmatched({})",
+        m_replayed,
+        std::chrono::duration_cast<TimeUS>(elapsed).count(),
+        m_replayed == 0 ? 0 : static_cast<double>(elapsed.count()) / static_cast<double>(m_replayed),
+        m_unmatched
+    );
+}
+
+UniqueUringCEvent ReplayBackend::WaitForEvent()
+{
+    if (m_firstWait == Clock::time_point{}) [[unlikely]]
+    {
+        m_firstWait = Clock::now();
+    }
+
+    while (m_nextCompletion < m_completions.size())
+    {
+        const Completion& completion{ m_completions[m_nextCompletion++] };
+
+        auto itr{ m_liveData.find(completion.m_data) };
+        if (itr == m_liveData.end())
+        {
+            m_unmatched++;
+            m_unmatchedCounter.Add();
+            continue;
+        }
+
+        const UserData data{ itr->second };
+        if (not completion.m_payload.empty())
+        {
+            const std::span<uint8_t> buffer{ Destination(data, completion.m_flags) };
+            const size_t size{ std::min(completion.m_payload.size(), buffer.size()) };
+            std::copy_n(completion.m_payload.begin(), size, buffer.begin());
+        }
+
+        // the recorded fd was the recorded process's. the caller gets something real to use and close
+        int res{ completion.m_res };
+        if (res >= 0 and m_accepts.contains(data))
+        {
+            res = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            res = res >= 0 ? res : -errno;
+        }
+        else if (res >= 0 and m_opens.contains(data))
+        {
+            res = ::open("/dev/null", O_RDWR | O_CLOEXEC);
+            res = res >= 0 ? res : -errno;
+        }
+
+        if ((completion.m_flags & IORING_CQE_F_MORE) == 0)
+        {
+            m_liveData.erase(itr);
+            m_buffers.erase(data);
+            m_groupOps.erase(data);
+            m_signalReads.erase(data);
+            m_accepts.erase(data);
+            m_opens.erase(data);
+        }
+
+        m_replayed++;
+        return Hand(data, res, completion.m_flags);
+    }
+
+    return Shutdown();
+}
+
+void ReplayBackend::AttachMetrics(Metrics::MetricsRegistry& registry)
+{
+    m_opsSubmitted = registry.AddOpcodeCounters("ops_submitted");
+    m_unmatchedCounter = registry.AddCounter("replay_unmatched");
+}
+
+bool ReplayBackend::QueueNop(const UserData& data)
+{
+    Submitted(data, IORING_OP_NOP);
+    return true;
+}
+
+bool ReplayBackend::QueueTimeoutEvent(const UserData& data, const TimeNS&)
+{
+    Submitted(data, IORING_OP_TIMEOUT);
+    return true;
+}
+
+bool ReplayBackend::CancelTimeoutEvent(const UserData& cancelData, const UserData&)
+{
+    Submitted(cancelData, IORING_OP_TIMEOUT_REMOVE);
+    return true;
+}
+
+bool ReplayBackend::UpdateTimeoutEvent(const UserData& updateData, const UserData&, const TimeNS&)
+{
+    Submitted(updateData, IORING_OP_TIMEOUT_REMOVE);
+    return true;
+}
+
+bool ReplayBackend::QueueSignalRead(const UserData& data, int fd, signalfd_siginfo& readBuff)
+{
+    Submitted(data, IORING_OP_READ);
+    m_buffers[data] = std::span{ reinterpret_cast<uint8_t*>(&readBuff), sizeof(readBuff) };
+    m_signalReads[data] = fd;
+    return true;
+}
+
+bool ReplayBackend::QueueRead(const UserData& data, int, std::span<uint8_t> buffer)
+{
+    Submitted(data, IORING_OP_READ);
+    m_buffers[data] = buffer;
+    return true;
+}
+
+int ReplayBackend::QueueTcpConnect(const UserData& data, const std::string&, const std::string&)
+{
+    Submitted(data, IORING_OP_CONNECT);
+
+    // something real for the caller to set options on and close
+    const int sockFd{ ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0) };
+    if (sockFd == -1)
+    {
+        int err{ errno };
+        LOG_ERROR("failed to create socket. e={}", strerror(err));
+    }
+
+    return sockFd;
+}
+
+bool ReplayBackend::QueueTcpSend(const UserData& data, int, std::string_view)
+{
+    Submitted(data, IORING_OP_SEND);
+    return true;
+}
+
+bool ReplayBackend::QueueTcpRecv(const UserData& data, int, std::span<uint8_t> rxBuffer)
+{
+    Submitted(data, IORING_OP_RECV);
+    m_buffers[data] = rxBuffer;
+    return true;
+}
+
+bool ReplayBackend::QueuePollIn(const UserData& data, int)
+{
+    Submitted(data, IORING_OP_POLL_ADD);
+    return true;
+}
+
+bool ReplayBackend::CancelPoll(const UserData& cancelData, const UserData&)
+{
+    Submitted(cancelData, IORING_OP_POLL_REMOVE);
+    return true;
+}
+
+bool ReplayBackend::CancelOp(const UserData& cancelData, const UserData&)
+{
+    Submitted(cancelData, IORING_OP_ASYNC_CANCEL);
+    return true;
+}
+
+bool ReplayBackend::AddBufferGroup(uint16_t groupId, std::span<uint8_t> memory, uint32_t bufferSize)
+{
+    m_bufferGroups[groupId] = { memory, bufferSize };
+    return true;
+}
+
+bool ReplayBackend::QueueRecvMsg(const UserData& data, int, const msghdr&, uint16_t groupId)
+{
+    Submitted(data, IORING_OP_RECVMSG);
+    m_groupOps[data] = groupId;
+    return true;
+}
+
+bool ReplayBackend::QueueSendMsg(const UserData& data, int, const msghdr&)
+{
+    Submitted(data, IORING_OP_SENDMSG);
+    return true;
+}
+
+bool ReplayBackend::QueueRecvMsg(const UserData& data, int, msghdr& message)
+{
+    Submitted(data, IORING_OP_RECVMSG);
+    // only the payload was recorded. no fds arrive with it
+    message.msg_controllen = 0;
+    message.msg_flags = 0;
+    if (message.msg_iovlen > 0)
+    {
+        m_buffers[data] = std::span{ static_cast<uint8_t*>(message.msg_iov[0].iov_base), message.msg_iov[0].iov_len };
+    }
+    return true;
+}
+
+bool ReplayBackend::QueueAccept(const UserData& data, int)
+{
+    Submitted(data, IORING_OP_ACCEPT);
+    m_accepts.insert(data);
+    return true;
+}
+
+bool ReplayBackend::QueueConnect(const UserData& data, int, const sockaddr&, socklen_t)
+{
+    Submitted(data, IORING_OP_CONNECT);
+    return true;
+}
+
+bool ReplayBackend::QueueSplice(const UserData& data, int, int64_t, int, uint32_t)
+{
+    Submitted(data, IORING_OP_SPLICE);
+    return true;
+}
+
+bool ReplayBackend::QueuePoll(const UserData& data, int, uint32_t)
+{
+    Submitted(data, IORING_OP_POLL_ADD);
+    return true;
+}
+
+bool ReplayBackend::QueueOpen(const UserData& data, const char*, int, mode_t)
+{
+    Submitted(data, IORING_OP_OPENAT);
+    m_opens.insert(data);
+    return true;
+}
+
+bool ReplayBackend::QueueReadAt(const UserData& data, int, std::span<uint8_t> buffer, uint64_t)
+{
+    Submitted(data, IORING_OP_READ);
+    m_buffers[data] = buffer;
+    return true;
+}
+
+bool ReplayBackend::QueueWriteAt(const UserData& data, int, std::span<const uint8_t>, uint64_t)
+{
+    Submitted(data, IORING_OP_WRITE);
+    return true;
+}
+
+bool ReplayBackend::QueueFsync(const UserData& data, int, bool)
+{
+    Submitted(data, IORING_OP_FSYNC);
+    return true;
+}
+
+bool ReplayBackend::QueueStatx(const UserData& data, int, struct statx&)
+{
+    Submitted(data, IORING_OP_STATX);
+    return true;
+}
+
+void ReplayBackend::Load(const std::string& path)
+{
+    std::ifstream file{ path };
+    if (not file.is_open())
+    {
+        int err{ errno };
+        LOG_CRITICAL("failed to open cqe trace {}. {}", path, strerror(err));
+        throw std::runtime_error{ "CQE Trace Open Failed" };
+    }
+
+    std::string line;
+    if (not std::getline(file, line) or line != RecordingBackend::s_traceHeader)
+    {
+        LOG_CRITICAL("{} is not a cqe trace", path);
+        throw std::runtime_error{ "CQE Trace Invalid" };
+    }
+
+    size_t lineNo{ 1 };
+    while (std::getline(file, line))
+    {
+        lineNo++;
+        std::string_view fields{ line };
+        const std::string_view tag{ NextField(fields) };
+        bool valid{ true };
+
+        if (tag.empty() or tag.starts_with('#'))
+        {
+            continue;
+        }
+        else if (tag == "K")
+        {
+            // the proactor picks ops by these, so the run has to see what the recorded one did
+            int multishotRecv{ 0 };
+            int providedBufferRing{ 0 };
+            valid = ParseField(fields, multishotRecv) and ParseField(fields, providedBufferRing);
+            m_capabilities.m_multishotRecv = multishotRecv != 0;
+            m_capabilities.m_providedBufferRing = providedBufferRing != 0;
+        }
+        else if (tag == "S")
+        {
+            Submission submission{};
+            valid = ParseField(fields, submission.m_opcode) and ParseField(fields, submission.m_data);
+            m_submissions.push_back(submission);
+        }
+        else if (tag == "C")
+        {
+            Completion completion{};
+            TimeNS::rep offset{ 0 };
+            valid = ParseField(fields, offset) and ParseField(fields, completion.m_data) and
+                    ParseField(fields, completion.m_res) and ParseField(fields, completion.m_flags);
+            if (const std::string_view payload{ NextField(fields) }; valid and not payload.empty())
+            {
+                valid = ParseHex(payload, completion.m_payload);
+            }
+            completion.m_offset = TimeNS{ offset };
+            m_completions.push_back(std::move(completion));
+        }
+        else
+        {
+            valid = false;
+        }
+
+        if (not valid)
+        {
+            LOG_CRITICAL("invalid cqe trace record {}:{} '{}'", path, lineNo, line);
+            throw std::runtime_error{ "CQE Trace Invalid" };
+        }
+    }
+}
+
+void ReplayBackend::Submitted(UserData data, uint8_t opcode)
+{
+    m_opsSubmitted.Add(opcode);
+
+    if (m_tracer != nullptr) [[unlikely]]
+    {
+        m_tracer->Trace(TracePhase::Submit, data, 0, opcode);
+    }
+
+    // queued past the end of the trace. it never completes
+    if (m_nextSubmission == m_submissions.size())
+    {
+        return;
+    }
+
+    const Submission& recorded{ m_submissions[m_nextSubmission++] };
+    if (recorded.m_opcode != opcode)
+    {
+        LOG_RATE_LIMITED(
+            Sage::Logger::Warning,
+            1,
+            "replay diverged. {} queued where {} was recorded",
+            GetOpcodeName(opcode),
+            GetOpcodeName(recorded.m_opcode)
+        );
+        m_unmatched++;
+        m_unmatchedCounter.Add();
+    }
+
+    m_liveData[recorded.m_data] = data;
+}
+
+UniqueUringCEvent ReplayBackend::Shutdown()
+{
+    if (not m_shutdownRaised)
+    {
+        m_lastWait = Clock::now();
+        m_shutdownRaised = true;
+        // exit signals are blocked and read through signal fds, so this is only picked up below
+        ::raise(SIGTERM);
+    }
+
+    for (const auto& [data, fd] : m_signalReads)
+    {
+        pollfd pollFd{ .fd = fd, .events = POLLIN, .revents = 0 };
+        if (::poll(&pollFd, 1, 0) != 1)
+        {
+            continue;
+        }
+
+        std::span<uint8_t> buffer{ m_buffers[data] };
+        const ssize_t res{ ::read(fd, buffer.data(), buffer.size()) };
+        if (res > 0)
+        {
+            const UserData live{ data };
+            m_signalReads.erase(live);
+            m_buffers.erase(live);
+            return Hand(live, static_cast<int>(res), 0);
+        }
+    }
+
+    LOG_CRITICAL("cqe trace finished with no signal read to stop on");
+    throw std::runtime_error{ "CQE Trace Exhausted" };
+}
+
+std::span<uint8_t> ReplayBackend::Destination(UserData data, uint32_t flags)
+{
+    if (auto itr{ m_buffers.find(data) }; itr != m_buffers.end())
+    {
+        return itr->second;
+    }
+
+    auto op{ m_groupOps.find(data) };
+    if (op == m_groupOps.end() or (flags & IORING_CQE_F_BUFFER) == 0)
+    {
+        return {};
+    }
+
+    auto group{ m_bufferGroups.find(op->second) };
+    if (group == m_bufferGroups.end())
+    {
+        return {};
+    }
+
+    const auto& [memory, bufferSize]{ group->second };
+    const size_t bufferId{ flags >> IORING_CQE_BUFFER_SHIFT };
+    const size_t offset{ std::min(bufferId * bufferSize, memory.size()) };
+    return memory.subspan(offset, std::min<size_t>(bufferSize, memory.size() - offset));
+}
+
+UniqueUringCEvent ReplayBackend::Hand(UserData data, int res, uint32_t flags)
+{
+    m_current->user_data = data;
+    m_current->res = res;
+    m_current->flags = flags;
+
+    // nothing to release. the next wait overwrites it
+    return UniqueUringCEvent{ m_current.get(), [](io_uring_cqe*) {} };
+}
+
+} // namespace Sage
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <sys/signalfd.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "metrics/metrics.hpp"
+#include "proactor/io_backend.hpp"
+#include "timing/time.hpp"
+
+namespace Sage
+{
+
+/**
+ * Completes ops from a trace written by RecordingBackend, as fast as they're waited for, so the cost of
+ * dispatch and handler logic can be measured without the kernel. The nth op queued stands in for the nth one
+ * recorded, so the run must queue ops in the order the recorded one did. Reads get the recorded bytes, in the
+ * provided buffer the recorded kernel picked where it picked one, tcp connects and accepts get a fresh unconnected
+ * socket and file opens /dev/null. fds passed with a message aren't replayed, nor spliced data which never passed
+ * through the loop, nor stat results.
+ * Once the trace runs out SIGTERM is raised and the signal handed to the pending signal read, stopping the
+ * proactor as a real shutdown would
+ */
+class ReplayBackend final : public IOBackend
+{
+public:
+    /// Throws std::runtime_error if path can't be read or isn't a trace
+    explicit ReplayBackend(const std::string& path);
+
+    ~ReplayBackend() override;
+
+    BackendType Type() const noexcept override { return BackendType::Replay; }
+
+    UniqueUringCEvent WaitForEvent() override;
+
+    void AttachMetrics(Metrics::MetricsRegistry& registry) override;
+
+    Occupancy GetOccupancy() const noexcept override
+    {
+        return Occupancy{ 0, static_cast<uint>(m_completions.size() - m_nextCompletion) };
+    }
+
+    bool QueueNop(const UserData& data) override;
+
+    bool QueueTimeoutEvent(const UserData& data, const TimeNS& timeout) override;
+
+    bool CancelTimeoutEvent(const UserData& cancelData, const UserData& timeoutData) override;
+
+    bool UpdateTimeoutEvent(const UserData& updateData, const UserData& timeoutData, const TimeNS& timeout) override;
+
+    bool QueueSignalRead(const UserData& data, int fd, signalfd_siginfo& readBuff) override;
+
+    bool QueueRead(const UserData& data, int fd, std::span<uint8_t> buffer) override;
+
+    int QueueTcpConnect(const UserData& data, const std::string& host, const std::string& port) override;
+
+    bool QueueTcpSend(const UserData& data, int fd, std::string_view buffer) override;
+
+    bool QueueTcpRecv(const UserData& data, int fd, std::span<uint8_t> rxBuffer) override;
+
+    bool QueuePollIn(const UserData& data, int fd) override;
+
+    bool CancelPoll(const UserData& cancelData, const UserData& pollData) override;
+
+    bool CancelOp(const UserData& cancelData, const UserData& targetData) override;
+
+    bool AddBufferGroup(uint16_t groupId, std::span<uint8_t> memory, uint32_t bufferSize) override;
+
+    void RemoveBufferGroup(uint16_t groupId) override { m_bufferGroups.erase(groupId); }
+
+    void ReturnBuffer(uint16_t, uint16_t) override {}
+
+    bool QueueRecvMsg(const UserData& data, int fd, const msghdr& message, uint16_t groupId) override;
+
+    bool QueueSendMsg(const UserData& data, int fd, const msghdr& message) override;
+
+    bool QueueRecvMsg(const UserData& data, int fd, msghdr& message) override;
+
+    bool QueueAccept(const UserData& data, int listenFd) override;
+
+    bool QueueConnect(const UserData& data, int fd, const sockaddr& address, socklen_t addressLen) override;
+
+    bool QueueSplice(const UserData& data, int fdIn, int64_t offsetIn, int fdOut, uint32_t len) override;
+
+    bool QueuePoll(const UserData& data, int fd, uint32_t events) override;
+
+    bool QueueOpen(const UserData& data, const char* path, int flags, mode_t mode) override;
+
+    bool QueueReadAt(const UserData& data, int fd, std::span<uint8_t> buffer, uint64_t offset) override;
+
+    bool QueueWriteAt(const UserData& data, int fd, std::span<const uint8_t> buffer, uint64_t offset) override;
+
+    bool QueueFsync(const UserData& data, int fd, bool dataOnly) override;
+
+    bool QueueStatx(const UserData& data, int fd, struct statx& statxBuf) override;
+
+private:
+    ReplayBackend(const ReplayBackend&) = delete;
+    ReplayBackend(ReplayBackend&&) = delete;
+    ReplayBackend& operator=(const ReplayBackend&) = delete;
+    ReplayBackend& operator=(ReplayBackend&&) = delete;
+
+    struct Submission
+    {
+        uint8_t m_opcode;
+        UserData m_data;
+    };
+
+    struct Completion
+    {
+        TimeNS m_offset;
+        UserData m_data;
+        int m_res;
+        uint32_t m_flags;
+        std::vector<uint8_t> m_payload;
+    };
+
+    void Load(const std::string& path);
+
+    /// Pairs the next recorded submission with the live one
+    void Submitted(UserData data, uint8_t opcode);
+
+    /// Hands a real exit signal to the pending signal read it's ready on
+    UniqueUringCEvent Shutdown();
+
+    UniqueUringCEvent Hand(UserData data, int res, uint32_t flags);
+
+    /// @returns where the completion's recorded bytes go, if anywhere
+    std::span<uint8_t> Destination(UserData data, uint32_t flags);
+
+    std::vector<Submission> m_submissions;
+    std::vector<Completion> m_completions;
+    size_t m_nextSubmission{ 0 };
+    size_t m_nextCompletion{ 0 };
+    // recorded user data -> live user data
+    std::unordered_map<UserData, UserData> m_liveData;
+    // ops reading into a buffer, by live user data
+    std::unordered_map<UserData, std::span<uint8_t>> m_buffers;
+    // buffer group id -> its memory and buffer size
+    std::unordered_map<uint16_t, std::pair<std::span<uint8_t>, uint32_t>> m_bufferGroups;
+    // ops picking their buffers from a group, by live user data
+    std::unordered_map<UserData, uint16_t> m_groupOps;
+    // signal reads by live user data -> signal fd
+    std::unordered_map<UserData, int> m_signalReads;
+    // accepts by live user data. their completions get a fresh socket in place of the recorded fd
+    std::unordered_set<UserData> m_accepts;
+    // file opens by live user data. their completions get /dev/null in place of the recorded fd
+    std::unordered_set<UserData> m_opens;
+    // the completion handed out by WaitForEvent. a cqe ends in a flexible array so can't be held by value
+    std::unique_ptr<io_uring_cqe> m_current{ std::make_unique<io_uring_cqe>() };
+    Clock::time_point m_firstWait{};
+    Clock::time_point m_lastWait{};
+    size_t m_replayed{ 0 };
+    // completions of ops the run never queued, or that were queued as a different op
+    size_t m_unmatched{ 0 };
+    bool m_shutdownRaised{ false };
+    Metrics::CounterArray m_opsSubmitted;
+    Metrics::Counter m_unmatchedCounter;
+};
+
+} // namespace Sage
@@ -12,11 +12,12 @@
 namespace Sage
 {
 
-TcpClient::TcpClient(const std::string& host, const std::string& port) :
+TcpClient::TcpClient(const std::string& host, const std::string& port, RecvMode recvMode) :
     TimerHandler{ host + '@' + port, 1s },
     m_host{ host },
     m_port{ port },
-    m_tag{ host + '@' + port }
+    m_tag{ host + '@' + port },
+    m_recvMode{ recvMode }
 {
     LOG_DEBUG("[{}] c'tor", ClientName());
     Proactor::Instance().AddSocketClient(*this);
@@ -52,15 +53,7 @@ void TcpClient::OnTimerExpired()
         {
             if (not IsSocketConnected())
             {
-                UpdateInterval(20ms);
-                if (::close(m_fd) != 0)
-                {
-                    int err{ errno };
-                    LOG_ERROR("failed to close fd. {}", strerror(err));
-                }
-                m_state = Broken;
-                m_rxPending = false;
-                m_fd = -1;
+                Disconnect();
             }
             else
             {
@@ -82,7 +75,7 @@ void TcpClient::SendPending()
 {
     while (not m_txBuffer.empty())
     {
-        std::string data{ m_txBuffer.front() };
+        std::string data{ std::move(m_txBuffer.front()) };
         m_txBuffer.pop();
         Proactor::Instance().RequestTcpSend(*this, std::move(data));
     }
@@ -90,11 +83,38 @@ void TcpClient::SendPending()
 
 void TcpClient::QueueRecv()
 {
-    if (not m_rxPending)
+    if (m_rxPending)
+    {
+        return;
+    }
+
+    if (m_recvMode == ReadinessRecv)
+    {
+        Proactor::Instance().RequestTcpPoll(*this);
+    }
+    else
     {
         Proactor::Instance().RequestTcpRecv(*this);
-        m_rxPending = true;
     }
+    m_rxPending = true;
+}
+
+void TcpClient::Disconnect()
+{
+    UpdateInterval(20ms);
+    if (m_recvMode == ReadinessRecv and m_rxPending)
+    {
+        Proactor::Instance().RequestTcpPollCancel(*this);
+    }
+
+    if (::close(m_fd) != 0)
+    {
+        int err{ errno };
+        LOG_ERROR("failed to close fd. {}", strerror(err));
+    }
+    m_state = Broken;
+    m_rxPending = false;
+    m_fd = -1;
 }
 
 bool TcpClient::IsSocketConnected()
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "proactor/buffer_pool.hpp"
 #include "proactor/handle.hpp"
 #include "proactor/proactor.hpp"
 #include "proactor/timer_handler.hpp"
@@ -9,6 +10,7 @@
 #include <span>
 #include <string>
 #include <string_view>
+#include <variant>
 
 namespace Sage
 {
@@ -31,41 +33,79 @@ public:
 class TcpSend final : public Event
 {
 public:
-    TcpSend(
-        Handle::Id handlerId, OnCompleteFunc&& onComplete, const std::string& host, const std::string& port, int fd,
-        std::string data
-    ) :
+    TcpSend(Handle::Id handlerId, OnCompleteFunc&& onComplete, int fd, SendPayload data, SendCompleteFunc&& onSent) :
         Event{ handlerId, std::move(onComplete) },
-        m_host{ host },
-        m_port{ port },
         m_fd{ fd },
-        m_data{ std::move(data) }
+        m_data{ std::move(data) },
+        m_onSent{ std::move(onSent) }
     {
     }
 
-    std::string m_host;
-    std::string m_port;
+    std::string_view Data() const noexcept
+    {
+        if (auto borrowed{ std::get_if<std::span<const uint8_t>>(&m_data) }; borrowed != nullptr)
+        {
+            return { reinterpret_cast<const char*>(borrowed->data()), borrowed->size() };
+        }
+
+        if (auto owned{ std::get_if<std::string>(&m_data) }; owned != nullptr)
+        {
+            return *owned;
+        }
+
+        if (auto pooled{ std::get_if<BufferHandle>(&m_data) }; pooled != nullptr)
+        {
+            return pooled->View();
+        }
+
+        const auto& shared{ std::get<SharedPayload>(m_data) };
+        return shared == nullptr ? std::string_view{} : std::string_view{ *shared };
+    }
+
     int m_fd;
-    std::string m_data;
+    SendPayload m_data;
+    // invoked once the kernel no longer references the data
+    SendCompleteFunc m_onSent;
+    // as submitted. a failed zero copy send completes without IORING_CQE_F_MORE, like a plain send
+    uint8_t m_opcode{ IORING_OP_SEND };
+    int m_result{ 0 };
 };
 
 class TcpRecv final : public Event
 {
 public:
-    TcpRecv(
-        Handle::Id handlerId, OnCompleteFunc&& onComplete, const std::string& host, const std::string& port, int fd
-    ) :
+    TcpRecv(Handle::Id handlerId, OnCompleteFunc&& onComplete, int fd, BufferHandle data) :
         Event{ handlerId, std::move(onComplete) },
-        m_host{ host },
-        m_port{ port },
-        m_fd{ fd }
+        m_fd{ fd },
+        m_data{ std::move(data) }
     {
     }
 
-    std::string m_host;
-    std::string m_port;
     int m_fd;
-    IOURing::RxBuffer m_data{};
+    BufferHandle m_data;
+};
+
+class TcpPoll final : public Event
+{
+public:
+    TcpPoll(Handle::Id handlerId, OnCompleteFunc&& onComplete, int fd, uint32_t connection) :
+        Event{ handlerId, std::move(onComplete) },
+        m_fd{ fd },
+        m_connection{ connection }
+    {
+        // multishot. removed once the kernel stops reporting readiness
+        m_removeOnComplete = false;
+        m_multishot = true;
+    }
+
+    int m_fd;
+    uint32_t m_connection;
+};
+
+class TcpPollCancel final : public Event
+{
+public:
+    TcpPollCancel(Handle::Id handlerId, OnCompleteFunc&& onComplete) : Event{ handlerId, std::move(onComplete) } {}
 };
 
 class TcpClient : public TimerHandler
@@ -79,7 +119,16 @@ public:
         Connected
     };
 
-    TcpClient(const std::string& host, const std::string& port);
+    enum RecvMode
+    {
+        // a recv with its own buffer is always posted
+        CompletionRecv = 0,
+        // readiness is polled and data is read into a shared buffer only once available.
+        // idle clients hold no buffers, for very large numbers of mostly idle connections
+        ReadinessRecv
+    };
+
+    TcpClient(const std::string& host, const std::string& port, RecvMode recvMode = CompletionRecv);
 
     ~TcpClient() override;
 
@@ -90,6 +139,10 @@ protected:
 
     virtual void OnReceive(std::span<uint8_t> buff) = 0;
 
+    /// Override to keep, slice or forward the received data without copying it.
+    /// The buffer stays alive for as long as a copy of the handle is held
+    virtual void OnReceiveBuffer(BufferHandle buff) { OnReceive(buff.Span()); }
+
 private:
     void OnTimerExpired() override;
 
@@ -97,15 +150,21 @@ private:
 
     void QueueRecv();
 
+    /// Closes the socket and leaves the reconnect to the timer
+    void Disconnect();
+
     bool IsSocketConnected();
 
     std::string m_host;
     std::string m_port;
     std::string m_tag;
     int m_fd{ -1 };
+    // bumped on every connect. fd numbers are reused, this tells a new socket from an old one
+    uint32_t m_connection{ 0 };
     ConnectionState m_state{ Unknown };
     const Handle::Id m_id{ Handle::NextId() };
     std::queue<std::string> m_txBuffer;
+    const RecvMode m_recvMode;
     bool m_rxPending{ false };
 
     friend class Proactor;
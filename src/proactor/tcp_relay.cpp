@@ -0,0 +1,124 @@
+#include "proactor/tcp_relay.hpp"
+#include "log/logger.hpp"
+#include "proactor/proactor.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace Sage
+{
+
+namespace
+{
+
+void CloseFd(std::string_view name, int fd)
+{
+    if (fd != -1 and ::close(fd) != 0)
+    {
+        int err{ errno };
+        LOG_ERROR("[{}] failed to close fd({}). {}", name, fd, strerror(err));
+    }
+}
+
+} // namespace
+
+TcpRelay::TcpRelay(std::string_view name, int clientFd, int upstreamFd, const Options& options) :
+    m_name{ name },
+    m_mode{ options.m_mode },
+    m_clientFd{ clientFd },
+    m_upstreamFd{ upstreamFd }
+{
+    LOG_DEBUG("[{}] c'tor client-fd({}) upstream-fd({})", Name(), clientFd, upstreamFd);
+
+    m_directions[s_toUpstream].m_from = clientFd;
+    m_directions[s_toUpstream].m_to = upstreamFd;
+    m_directions[s_toClient].m_from = upstreamFd;
+    m_directions[s_toClient].m_to = clientFd;
+
+    for (int fd : { clientFd, upstreamFd })
+    {
+        const int flags{ ::fcntl(fd, F_GETFL) };
+        if (flags == -1 or ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0)
+        {
+            int err{ errno };
+            LOG_WARNING("[{}] failed to make fd({}) non-blocking. {}", Name(), fd, strerror(err));
+        }
+    }
+
+    for (Direction& direction : m_directions)
+    {
+        direction.m_capacity = options.m_maxInFlight;
+        if (m_mode == Mode::Copy)
+        {
+            continue;
+        }
+
+        if (::pipe2(direction.m_pipe.data(), O_NONBLOCK | O_CLOEXEC) != 0)
+        {
+            int err{ errno };
+            LOG_CRITICAL("[{}] failed to create relay pipe. {}", Name(), strerror(err));
+            // the destructor won't run, the fds adopted are closed here
+            CloseFd(Name(), m_clientFd);
+            CloseFd(Name(), m_upstreamFd);
+            for (Direction& created : m_directions)
+            {
+                CloseFd(Name(), created.m_pipe[0]);
+                CloseFd(Name(), created.m_pipe[1]);
+            }
+            throw std::runtime_error{ "Relay Pipe Create Failed" };
+        }
+
+        // what the kernel actually gave, which bounds the bytes spliced in. the default if resizing isn't allowed
+        int capacity{ ::fcntl(direction.m_pipe[1], F_SETPIPE_SZ, static_cast<int>(options.m_maxInFlight)) };
+        if (capacity == -1)
+        {
+            int err{ errno };
+            capacity = ::fcntl(direction.m_pipe[1], F_GETPIPE_SZ);
+            LOG_WARNING("[{}] failed to size relay pipe, using {}B. {}", Name(), capacity, strerror(err));
+        }
+        direction.m_capacity = static_cast<size_t>(std::max(capacity, 1));
+    }
+
+    if (m_mode == Mode::Copy)
+    {
+        UseCopy();
+    }
+
+    LOG_INFO(
+        "[{}] relaying. mode({}) max-in-flight({})",
+        Name(),
+        m_mode == Mode::Splice ? "splice" : "copy",
+        m_directions[s_toUpstream].m_capacity
+    );
+    Proactor::Instance().AddTcpRelay(*this);
+}
+
+TcpRelay::~TcpRelay()
+{
+    LOG_DEBUG("[{}] d'tor", Name());
+    Proactor::Instance().RemoveTcpRelay(*this);
+
+    CloseFd(Name(), m_clientFd);
+    CloseFd(Name(), m_upstreamFd);
+    for (Direction& direction : m_directions)
+    {
+        CloseFd(Name(), direction.m_pipe[0]);
+        CloseFd(Name(), direction.m_pipe[1]);
+    }
+}
+
+void TcpRelay::UseCopy()
+{
+    m_mode = Mode::Copy;
+    for (Direction& direction : m_directions)
+    {
+        direction.m_buffer = std::make_shared<std::vector<uint8_t>>(direction.m_capacity);
+        direction.m_head = 0;
+    }
+}
+
+} // namespace Sage
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "proactor/handle.hpp"
+#include "proactor/proactor.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Sage
+{
+
+enum class RelayLeg : uint8_t
+{
+    // from the source socket into the pipe or buffer
+    Fill = 0,
+    // out of the pipe or buffer to the destination socket
+    Drain,
+};
+
+class RelayTransfer final : public Event
+{
+public:
+    RelayTransfer(
+        Handle::Id handlerId,
+        OnCompleteFunc&& onComplete,
+        size_t direction,
+        RelayLeg leg,
+        uint8_t opcode,
+        std::shared_ptr<std::vector<uint8_t>> buffer
+    ) :
+        Event{ handlerId, std::move(onComplete) },
+        m_direction{ direction },
+        m_leg{ leg },
+        m_opcode{ opcode },
+        m_buffer{ std::move(buffer) }
+    {
+    }
+
+    size_t m_direction;
+    RelayLeg m_leg;
+    // a splice, a copying recv or send, or a poll waiting for the socket to be ready for them
+    uint8_t m_opcode;
+    // copying only. held so a relay closed mid transfer doesn't free what the kernel is using
+    std::shared_ptr<std::vector<uint8_t>> m_buffer;
+    // a zero copy send's result, kept until the kernel has released the buffer
+    int m_result{ 0 };
+};
+
+class RelayCancel final : public Event
+{
+public:
+    RelayCancel(Handle::Id handlerId, OnCompleteFunc&& onComplete) : Event{ handlerId, std::move(onComplete) } {}
+};
+
+/**
+ * Relays bytes both ways between two connected stream sockets, e.g. an accepted client and its upstream, until
+ * both have hung up. Each direction splices through a pipe of its own so the bytes never reach user space, or
+ * copies through a buffer with recv and send. A direction holds at most the pipe or buffer's worth in flight,
+ * filling from one socket while draining into the other. A side hanging up is passed on as a shutdown of writes
+ * to the other once everything it sent is through
+ */
+class TcpRelay
+{
+public:
+    enum class Mode : uint8_t
+    {
+        Splice = 0,
+        Copy,
+    };
+
+    struct Options
+    {
+        // falls back to copying where the kernel can't splice on the ring
+        Mode m_mode{ Mode::Splice };
+        // per direction. the kernel rounds a pipe up to a power of 2 pages
+        size_t m_maxInFlight{ 64 * 1024 };
+    };
+
+    /// Takes ownership of both fds, made non-blocking. Throws std::runtime_error if a pipe can't be created,
+    /// the fds are closed all the same
+    TcpRelay(std::string_view name, int clientFd, int upstreamFd, const Options& options);
+
+    virtual ~TcpRelay();
+
+    std::string_view Name() const noexcept { return m_name; }
+
+    Mode GetMode() const noexcept { return m_mode; }
+
+    uint64_t BytesToUpstream() const noexcept { return m_directions[s_toUpstream].m_bytes; }
+
+    uint64_t BytesToClient() const noexcept { return m_directions[s_toClient].m_bytes; }
+
+    bool IsClosed() const noexcept { return m_closed; }
+
+protected:
+    /// Both sides hung up and everything was relayed (0), or either connection broke (-errno). nothing is relayed
+    /// after it
+    virtual void OnClose(int /*res*/) {}
+
+private:
+    TcpRelay() = delete;
+    TcpRelay(const TcpRelay&) = delete;
+    TcpRelay(TcpRelay&&) = delete;
+    TcpRelay& operator=(const TcpRelay&) = delete;
+    TcpRelay& operator=(TcpRelay&&) = delete;
+
+    static constexpr size_t s_toUpstream{ 0 };
+    static constexpr size_t s_toClient{ 1 };
+
+    struct Direction
+    {
+        int m_from{ -1 };
+        int m_to{ -1 };
+        // read end, write end. splicing only
+        std::array<int, 2> m_pipe{ -1, -1 };
+        // copying only, used as a ring
+        std::shared_ptr<std::vector<uint8_t>> m_buffer;
+        size_t m_capacity{ 0 };
+        // waiting to be drained
+        size_t m_buffered{ 0 };
+        // where the buffered bytes start. copying only
+        size_t m_head{ 0 };
+        bool m_filling{ false };
+        bool m_draining{ false };
+        // the transfer in flight per leg, 0 for none. cancelled when the relay closes
+        std::array<EventId, 2> m_inFlight{};
+        // the pipe ran out of slots before bytes, small segments each taking one. a drain frees them
+        bool m_stalled{ false };
+        // the source hung up
+        bool m_eof{ false };
+        // the hang up was passed on
+        bool m_shutdown{ false };
+        uint64_t m_bytes{ 0 };
+    };
+
+    /// Swaps the pipes for buffers of the same capacity
+    void UseCopy();
+
+    const std::string m_name;
+    Mode m_mode;
+    const Handle::Id m_id{ Handle::NextId() };
+    const int m_clientFd;
+    const int m_upstreamFd;
+    std::array<Direction, 2> m_directions;
+    bool m_closed{ false };
+
+    friend class Proactor;
+};
+
+} // namespace Sage
@@ -15,6 +15,7 @@ public:
     TimerExpiredEvent(Handle::Id handlerId, OnCompleteFunc&& onComplete) : Event{ handlerId, std::move(onComplete) }
     {
         m_removeOnComplete = false;
+        m_multishot = true;
     }
 };
 
@@ -0,0 +1,239 @@
+#include "proactor/udp_socket.hpp"
+#include "log/logger.hpp"
+#include "proactor/proactor.hpp"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace Sage
+{
+
+namespace
+{
+
+bool ParseAddress(const std::string& host, in_addr& addr) { return ::inet_pton(AF_INET, host.c_str(), &addr) == 1; }
+
+} // namespace
+
+UdpSocket::UdpSocket(std::string_view name, const Options& options) :
+    m_name{ name },
+    m_rxBufferSize{ options.m_rxBufferSize },
+    m_rxBufferCount{ options.m_rxBufferCount }
+{
+    LOG_DEBUG("[{}] c'tor", Name());
+    Setup(options);
+    Proactor::Instance().AddUdpSocket(*this);
+}
+
+UdpSocket::~UdpSocket()
+{
+    LOG_DEBUG("[{}] d'tor", Name());
+    Proactor::Instance().RemoveUdpSocket(*this);
+
+    if (::close(m_fd) != 0)
+    {
+        int err{ errno };
+        LOG_ERROR("[{}] failed to close fd. {}", Name(), strerror(err));
+    }
+}
+
+void UdpSocket::Setup(const Options& options)
+{
+    m_fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_fd == -1)
+    {
+        int err{ errno };
+        LOG_CRITICAL("[{}] failed to create udp socket. {}", Name(), strerror(err));
+        throw std::runtime_error{ "UDP Socket Create Failed" };
+    }
+
+    auto fail = [this](std::string_view what)
+    {
+        int err{ errno };
+        LOG_CRITICAL("[{}] {}. {}", Name(), what, strerror(err));
+        ::close(m_fd);
+        throw std::runtime_error{ "UDP Socket Setup Failed" };
+    };
+
+    // several sockets may listen on the same multicast group and port
+    int enable{ 1 };
+    if (::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) != 0)
+    {
+        fail("failed to set SO_REUSEADDR");
+    }
+
+    sockaddr_in local{ .sin_family = AF_INET, .sin_port = htons(options.m_bindPort), .sin_addr = {}, .sin_zero = {} };
+    if (not ParseAddress(options.m_bindHost, local.sin_addr))
+    {
+        errno = EINVAL;
+        fail(std::format("invalid bind address '{}'", options.m_bindHost));
+    }
+
+    if (::bind(m_fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0)
+    {
+        fail(std::format("failed to bind {}:{}", options.m_bindHost, options.m_bindPort));
+    }
+
+    socklen_t localLen{ sizeof(local) };
+    if (::getsockname(m_fd, reinterpret_cast<sockaddr*>(&local), &localLen) != 0)
+    {
+        fail("failed to get bound address");
+    }
+    m_localPort = ntohs(local.sin_port);
+
+    if (not options.m_peerHost.empty())
+    {
+        m_peer.sin_family = AF_INET;
+        m_peer.sin_port = htons(options.m_peerPort);
+        if (not ParseAddress(options.m_peerHost, m_peer.sin_addr))
+        {
+            errno = EINVAL;
+            fail(std::format("invalid peer address '{}'", options.m_peerHost));
+        }
+        m_hasPeer = true;
+    }
+
+    if (options.m_gro and ::setsockopt(m_fd, SOL_UDP, UDP_GRO, &enable, sizeof(enable)) != 0)
+    {
+        int err{ errno };
+        LOG_WARNING("[{}] udp gro unavailable. {}", Name(), strerror(err));
+    }
+
+    // probe rather than finding out on the first send
+    int segmentSize{ 0 };
+    socklen_t segmentSizeLen{ sizeof(segmentSize) };
+    m_gso = options.m_gso and ::getsockopt(m_fd, SOL_UDP, UDP_SEGMENT, &segmentSize, &segmentSizeLen) == 0;
+    if (options.m_gso and not m_gso)
+    {
+        int err{ errno };
+        LOG_WARNING("[{}] udp gso unavailable. {}", Name(), strerror(err));
+    }
+
+    if (not options.m_interface.empty() and not ParseAddress(options.m_interface, m_interface))
+    {
+        errno = EINVAL;
+        fail(std::format("invalid multicast interface '{}'", options.m_interface));
+    }
+
+    const ip_mreqn request{ .imr_multiaddr = {}, .imr_address = m_interface, .imr_ifindex = 0 };
+    if (::setsockopt(m_fd, IPPROTO_IP, IP_MULTICAST_IF, &request, sizeof(request)) != 0)
+    {
+        fail("failed to set IP_MULTICAST_IF");
+    }
+
+    const uint8_t loop{ options.m_multicastLoop };
+    if (::setsockopt(m_fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) != 0)
+    {
+        fail("failed to set IP_MULTICAST_LOOP");
+    }
+
+    for (const auto& group : options.m_groups)
+    {
+        if (not JoinGroup(group))
+        {
+            fail(std::format("failed to join multicast group {}", group));
+        }
+    }
+
+    LOG_INFO(
+        "[{}] udp socket bound to {}:{}. gro({}) gso({}) groups({})",
+        Name(),
+        options.m_bindHost,
+        m_localPort,
+        options.m_gro,
+        m_gso,
+        options.m_groups.size()
+    );
+}
+
+void UdpSocket::Send(std::span<const uint8_t> datagram)
+{
+    if (not m_hasPeer)
+    {
+        LOG_ERROR_RATE_LIMITED(10, "[{}] udp send without a peer", Name());
+        return;
+    }
+
+    // a GSO batch is equal sized datagrams bar a shorter last one
+    const bool fits{ m_gso and m_segments < s_maxSegments and m_batch.size() + datagram.size() <= s_maxBatchBytes and
+                     datagram.size() <= m_segmentSize and m_batch.size() == m_segments * m_segmentSize };
+    if (m_segments != 0 and not fits)
+    {
+        Flush();
+    }
+
+    if (m_segments == 0)
+    {
+        m_segmentSize = datagram.size();
+    }
+    m_batch.append(reinterpret_cast<const char*>(datagram.data()), datagram.size());
+    m_segments++;
+
+    if (not m_flushScheduled)
+    {
+        m_flushScheduled = true;
+        Proactor::Instance().ScheduleUdpFlush(*this);
+    }
+}
+
+void UdpSocket::Flush()
+{
+    if (m_segments == 0)
+    {
+        return;
+    }
+
+    // a lone datagram goes without a segment size, as it must with GSO unavailable
+    const auto segmentSize{ static_cast<uint16_t>(m_segments > 1 ? m_segmentSize : 0) };
+    Proactor::Instance().RequestUdpSend(*this, std::move(m_batch), segmentSize, m_segments);
+    m_batch = {};
+    m_segments = 0;
+    m_segmentSize = 0;
+}
+
+bool UdpSocket::JoinGroup(const std::string& group) { return SetMembership(group, IP_ADD_MEMBERSHIP); }
+
+bool UdpSocket::LeaveGroup(const std::string& group) { return SetMembership(group, IP_DROP_MEMBERSHIP); }
+
+bool UdpSocket::SetMembership(const std::string& group, int option)
+{
+    ip_mreqn request{ .imr_multiaddr = {}, .imr_address = m_interface, .imr_ifindex = 0 };
+    if (not ParseAddress(group, request.imr_multiaddr))
+    {
+        LOG_ERROR("[{}] invalid multicast group '{}'", Name(), group);
+        return false;
+    }
+
+    if (::setsockopt(m_fd, IPPROTO_IP, option, &request, sizeof(request)) != 0)
+    {
+        int err{ errno };
+        LOG_ERROR("[{}] failed to update membership of {}. {}", Name(), group, strerror(err));
+        return false;
+    }
+
+    LOG_INFO("[{}] {} multicast group {}", Name(), option == IP_ADD_MEMBERSHIP ? "joined" : "left", group);
+    return true;
+}
+
+size_t UdpSocket::Deliver(std::span<const uint8_t> payload, size_t segmentSize, const sockaddr_in& from)
+{
+    if (segmentSize == 0 or segmentSize >= payload.size())
+    {
+        OnDatagram(payload, from);
+        return 1;
+    }
+
+    size_t datagrams{ 0 };
+    for (size_t offset{ 0 }; offset < payload.size(); offset += segmentSize)
+    {
+        OnDatagram(payload.subspan(offset, std::min(segmentSize, payload.size() - offset)), from);
+        datagrams++;
+    }
+
+    return datagrams;
+}
+
+} // namespace Sage
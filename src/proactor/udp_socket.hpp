@@ -0,0 +1,227 @@
+#pragma once
+
+#include "proactor/handle.hpp"
+#include "proactor/proactor.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <span>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <vector>
+
+namespace Sage
+{
+
+class UdpRecvMsg final : public Event
+{
+public:
+    // a gro segment size is all that's asked for
+    static constexpr size_t s_controlSize{ CMSG_SPACE(sizeof(int)) };
+    // every provided buffer starts with the io_uring_recvmsg_out header, the name and the control data
+    static constexpr size_t s_headerSize{ sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_in) + s_controlSize };
+
+    UdpRecvMsg(
+        Handle::Id handlerId,
+        OnCompleteFunc&& onComplete,
+        int fd,
+        uint16_t groupId,
+        uint32_t payloadSize,
+        uint32_t count
+    ) :
+        Event{ handlerId, std::move(onComplete) },
+        m_fd{ fd },
+        m_groupId{ groupId },
+        m_bufferSize{ static_cast<uint32_t>(payloadSize + s_headerSize) },
+        m_buffers(static_cast<size_t>(m_bufferSize) * count)
+    {
+        // multishot. only removed once the kernel has stopped using the buffers
+        m_removeOnComplete = false;
+        m_multishot = true;
+        m_message.msg_namelen = sizeof(sockaddr_in);
+        m_message.msg_controllen = s_controlSize;
+    }
+
+    std::span<uint8_t> Buffer(uint16_t bufferId) noexcept
+    {
+        return std::span{ m_buffers }.subspan(static_cast<size_t>(bufferId) * m_bufferSize, m_bufferSize);
+    }
+
+    int m_fd;
+    uint16_t m_groupId;
+    uint32_t m_bufferSize;
+    // the group's memory. lives with the op rather than the socket so it outlives a socket closed mid receive
+    std::vector<uint8_t> m_buffers;
+    // only the name and control lengths are read by the kernel
+    msghdr m_message{};
+};
+
+class UdpPoll final : public Event
+{
+public:
+    UdpPoll(Handle::Id handlerId, OnCompleteFunc&& onComplete, int fd) :
+        Event{ handlerId, std::move(onComplete) },
+        m_fd{ fd }
+    {
+        // multishot. removed once the kernel stops reporting readiness
+        m_removeOnComplete = false;
+        m_multishot = true;
+    }
+
+    int m_fd;
+};
+
+class UdpRecvCancel final : public Event
+{
+public:
+    UdpRecvCancel(Handle::Id handlerId, OnCompleteFunc&& onComplete) : Event{ handlerId, std::move(onComplete) } {}
+};
+
+class UdpSend final : public Event
+{
+public:
+    UdpSend(
+        Handle::Id handlerId,
+        OnCompleteFunc&& onComplete,
+        int fd,
+        const sockaddr_in& peer,
+        std::string data,
+        uint16_t segmentSize,
+        size_t segments
+    ) :
+        Event{ handlerId, std::move(onComplete) },
+        m_fd{ fd },
+        m_peer{ peer },
+        m_data{ std::move(data) },
+        m_segments{ segments }
+    {
+        m_iov.iov_base = m_data.data();
+        m_iov.iov_len = m_data.size();
+        m_message.msg_name = &m_peer;
+        m_message.msg_namelen = sizeof(m_peer);
+        m_message.msg_iov = &m_iov;
+        m_message.msg_iovlen = 1;
+
+        // the kernel splits the buffer into segmentSize datagrams, the last one possibly shorter
+        if (segmentSize != 0)
+        {
+            m_message.msg_control = m_control.data();
+            m_message.msg_controllen = m_control.size();
+            cmsghdr* cmsg{ CMSG_FIRSTHDR(&m_message) };
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(segmentSize));
+            std::memcpy(CMSG_DATA(cmsg), &segmentSize, sizeof(segmentSize));
+        }
+    }
+
+    int m_fd;
+    sockaddr_in m_peer;
+    std::string m_data;
+    size_t m_segments;
+    iovec m_iov{};
+    alignas(cmsghdr) std::array<uint8_t, CMSG_SPACE(sizeof(uint16_t))> m_control{};
+    msghdr m_message{};
+};
+
+/**
+ * An IPv4 UDP socket, bound on creation and received from for as long as it lives.
+ * Where the kernel allows, one multishot recvmsg into a group of provided buffers receives everything and GRO
+ * coalesces a flow's datagrams into one buffer, split again before OnDatagram. Otherwise readiness is polled and
+ * datagrams read as they arrive. Datagrams sent during a completion are batched and go out together once it's
+ * handled, equal sized runs as one GSO sendmsg
+ */
+class UdpSocket
+{
+public:
+    struct Options
+    {
+        // IPv4 address to bind. port 0 picks one
+        std::string m_bindHost{ "0.0.0.0" };
+        uint16_t m_bindPort{ 0 };
+        // where Send goes. nothing is sent when unset
+        std::string m_peerHost{};
+        uint16_t m_peerPort{ 0 };
+        // multicast groups joined on creation
+        std::vector<std::string> m_groups{};
+        // multicast interface address. any when empty
+        std::string m_interface{};
+        bool m_multicastLoop{ true };
+        bool m_gro{ true };
+        bool m_gso{ true };
+        // largest payload received at once. up to 64KB with GRO
+        uint32_t m_rxBufferSize{ 64 * 1024 };
+        // a power of 2. datagrams are dropped by the kernel while they're all in use
+        uint32_t m_rxBufferCount{ 64 };
+    };
+
+    /// Throws std::runtime_error if the socket can't be created or bound
+    UdpSocket(std::string_view name, const Options& options);
+
+    virtual ~UdpSocket();
+
+    std::string_view Name() const noexcept { return m_name; }
+
+    uint16_t LocalPort() const noexcept { return m_localPort; }
+
+    /// Copies the datagram into the pending batch
+    void Send(std::span<const uint8_t> datagram);
+
+    /// Sends the pending batch now rather than once the current completion is handled
+    void Flush();
+
+    bool JoinGroup(const std::string& group);
+
+    bool LeaveGroup(const std::string& group);
+
+protected:
+    virtual void OnDatagram(std::span<const uint8_t> datagram, const sockaddr_in& from) = 0;
+
+private:
+    UdpSocket() = delete;
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket(UdpSocket&&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+    UdpSocket& operator=(UdpSocket&&) = delete;
+
+    // the kernel's limit on segments per GSO send
+    static constexpr size_t s_maxSegments{ 64 };
+    // largest IPv4 UDP payload
+    static constexpr size_t s_maxBatchBytes{ 65'507 };
+
+    void Setup(const Options& options);
+
+    bool SetMembership(const std::string& group, int option);
+
+    /// Splits a GRO coalesced payload back into its datagrams. segmentSize is 0 for a single datagram
+    /// @returns the number of datagrams
+    size_t Deliver(std::span<const uint8_t> payload, size_t segmentSize, const sockaddr_in& from);
+
+    const std::string m_name;
+    const Handle::Id m_id{ Handle::NextId() };
+    int m_fd{ -1 };
+    uint16_t m_localPort{ 0 };
+    in_addr m_interface{};
+    sockaddr_in m_peer{};
+    bool m_hasPeer{ false };
+    bool m_gso{ false };
+    uint32_t m_rxBufferSize;
+    uint32_t m_rxBufferCount;
+    bool m_rxPending{ false };
+    // datagrams waiting to be sent. all segment size long, bar possibly the last
+    std::string m_batch;
+    size_t m_segmentSize{ 0 };
+    size_t m_segments{ 0 };
+    bool m_flushScheduled{ false };
+    // what the readiness path reads into
+    std::vector<uint8_t> m_rxBuffer;
+
+    friend class Proactor;
+};
+
+} // namespace Sage
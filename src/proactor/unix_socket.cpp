@@ -0,0 +1,202 @@
+#include "proactor/unix_socket.hpp"
+#include "log/logger.hpp"
+#include "proactor/proactor.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Sage
+{
+
+namespace
+{
+
+int SocketType(UnixSocketType type) noexcept { return type == UnixSocketType::Stream ? SOCK_STREAM : SOCK_SEQPACKET; }
+
+std::string_view TypeName(UnixSocketType type) noexcept
+{
+    return type == UnixSocketType::Stream ? "stream" : "seqpacket";
+}
+
+} // namespace
+
+bool MakeUnixAddress(const std::string& path, sockaddr_un& address, socklen_t& addressLen) noexcept
+{
+    address = sockaddr_un{};
+    address.sun_family = AF_UNIX;
+    if (path.empty() or path.size() >= sizeof(address.sun_path))
+    {
+        return false;
+    }
+
+    std::memcpy(address.sun_path, path.data(), path.size());
+    // an abstract name is exactly its bytes, a leading nul and no terminator
+    const bool abstract{ path.front() == '@' };
+    if (abstract)
+    {
+        address.sun_path[0] = '\0';
+    }
+    addressLen = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size() + (abstract ? 0 : 1));
+
+    return true;
+}
+
+UnixListener::UnixListener(std::string_view name, const std::string& path, UnixSocketType type) :
+    m_name{ name },
+    m_path{ path },
+    m_type{ type }
+{
+    LOG_DEBUG("[{}] c'tor", Name());
+
+    sockaddr_un address{};
+    socklen_t addressLen{ 0 };
+    if (not MakeUnixAddress(path, address, addressLen))
+    {
+        LOG_CRITICAL("[{}] invalid unix socket path '{}'", Name(), path);
+        throw std::runtime_error{ "Unix Listener Path Invalid" };
+    }
+
+    m_fd = ::socket(AF_UNIX, SocketType(type) | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_fd == -1)
+    {
+        int err{ errno };
+        LOG_CRITICAL("[{}] failed to create unix socket. {}", Name(), strerror(err));
+        throw std::runtime_error{ "Unix Socket Create Failed" };
+    }
+
+    // a previous run that didn't clean up leaves its socket file behind. anything else at path is left alone
+    struct stat existing{};
+    if (path.front() != '@' and ::lstat(path.c_str(), &existing) == 0 and S_ISSOCK(existing.st_mode))
+    {
+        ::unlink(path.c_str());
+    }
+
+    if (::bind(m_fd, reinterpret_cast<const sockaddr*>(&address), addressLen) != 0 or ::listen(m_fd, SOMAXCONN) != 0)
+    {
+        int err{ errno };
+        LOG_CRITICAL("[{}] failed to listen on {}. {}", Name(), path, strerror(err));
+        ::close(m_fd);
+        throw std::runtime_error{ "Unix Listener Setup Failed" };
+    }
+
+    LOG_INFO("[{}] listening on unix {} socket {}", Name(), TypeName(type), path);
+    Proactor::Instance().AddUnixListener(*this);
+}
+
+UnixListener::~UnixListener()
+{
+    LOG_DEBUG("[{}] d'tor", Name());
+    Proactor::Instance().RemoveUnixListener(*this);
+
+    if (::close(m_fd) != 0)
+    {
+        int err{ errno };
+        LOG_ERROR("[{}] failed to close fd. {}", Name(), strerror(err));
+    }
+
+    if (m_path.front() != '@' and ::unlink(m_path.c_str()) != 0)
+    {
+        int err{ errno };
+        LOG_WARNING("[{}] failed to remove {}. {}", Name(), m_path, strerror(err));
+    }
+}
+
+UnixSocket::UnixSocket(std::string_view name, const std::string& path, UnixSocketType type, size_t rxBufferSize) :
+    m_name{ name },
+    m_type{ type },
+    m_rxBufferSize{ rxBufferSize }
+{
+    LOG_DEBUG("[{}] c'tor", Name());
+
+    if (not MakeUnixAddress(path, m_address, m_addressLen))
+    {
+        LOG_CRITICAL("[{}] invalid unix socket path '{}'", Name(), path);
+        throw std::runtime_error{ "Unix Socket Path Invalid" };
+    }
+
+    m_fd = ::socket(AF_UNIX, SocketType(type) | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_fd == -1)
+    {
+        int err{ errno };
+        LOG_CRITICAL("[{}] failed to create unix socket. {}", Name(), strerror(err));
+        throw std::runtime_error{ "Unix Socket Create Failed" };
+    }
+
+    Proactor::Instance().AddUnixSocket(*this);
+}
+
+UnixSocket::UnixSocket(std::string_view name, int fd, UnixSocketType type, size_t rxBufferSize) :
+    m_name{ name },
+    m_type{ type },
+    m_rxBufferSize{ rxBufferSize },
+    m_fd{ fd },
+    m_state{ Connected }
+{
+    LOG_DEBUG("[{}] c'tor fd({})", Name(), fd);
+    Proactor::Instance().AddUnixSocket(*this);
+}
+
+UnixSocket::~UnixSocket()
+{
+    LOG_DEBUG("[{}] d'tor", Name());
+    Proactor::Instance().RemoveUnixSocket(*this);
+
+    if (::close(m_fd) != 0)
+    {
+        int err{ errno };
+        LOG_ERROR("[{}] failed to close fd. {}", Name(), strerror(err));
+    }
+}
+
+bool UnixSocket::Send(std::span<const uint8_t> data, std::span<const int> fds)
+{
+    if (m_state != Connected)
+    {
+        LOG_ERROR_RATE_LIMITED(10, "[{}] unix send while not connected", Name());
+        return false;
+    }
+
+    if (fds.size() > UnixRecv::s_maxFds)
+    {
+        LOG_ERROR("[{}] can't pass {} fds in one send. at most {}", Name(), fds.size(), UnixRecv::s_maxFds);
+        return false;
+    }
+
+    // a stream only carries fds alongside data
+    if (m_type == UnixSocketType::Stream and data.empty() and not fds.empty())
+    {
+        LOG_ERROR("[{}] can't pass fds on a stream without data", Name());
+        return false;
+    }
+
+    // the caller's fds may be closed before the send goes out
+    std::vector<int> passed;
+    passed.reserve(fds.size());
+    for (int fd : fds)
+    {
+        const int dup{ ::fcntl(fd, F_DUPFD_CLOEXEC, 0) };
+        if (dup == -1)
+        {
+            int err{ errno };
+            LOG_ERROR("[{}] failed to duplicate fd({}) to pass. {}", Name(), fd, strerror(err));
+            for (int copy : passed)
+            {
+                ::close(copy);
+            }
+            return false;
+        }
+        passed.push_back(dup);
+    }
+
+    Proactor::Instance().RequestUnixSend(
+        *this, std::string{ reinterpret_cast<const char*>(data.data()), data.size() }, std::move(passed)
+    );
+    return true;
+}
+
+} // namespace Sage
@@ -0,0 +1,280 @@
+#pragma once
+
+#include "proactor/handle.hpp"
+#include "proactor/proactor.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+namespace Sage
+{
+
+enum class UnixSocketType : uint8_t
+{
+    // a byte stream, as tcp
+    Stream = 0,
+    // connected, reliable and message boundaries kept
+    SeqPacket,
+};
+
+class UnixAccept final : public Event
+{
+public:
+    UnixAccept(Handle::Id handlerId, OnCompleteFunc&& onComplete, int fd) :
+        Event{ handlerId, std::move(onComplete) },
+        m_fd{ fd }
+    {
+        // multishot. removed once the kernel stops accepting
+        m_removeOnComplete = false;
+        m_multishot = true;
+    }
+
+    int m_fd;
+};
+
+class UnixConnect final : public Event
+{
+public:
+    UnixConnect(Handle::Id handlerId, OnCompleteFunc&& onComplete, int fd, const sockaddr_un& address, socklen_t len) :
+        Event{ handlerId, std::move(onComplete) },
+        m_fd{ fd },
+        m_address{ address },
+        m_addressLen{ len }
+    {
+    }
+
+    int m_fd;
+    sockaddr_un m_address;
+    socklen_t m_addressLen;
+};
+
+class UnixRecv final : public Event
+{
+public:
+    // the most fds a single message passes
+    static constexpr size_t s_maxFds{ 16 };
+
+    UnixRecv(Handle::Id handlerId, OnCompleteFunc&& onComplete, int fd, size_t bufferSize) :
+        Event{ handlerId, std::move(onComplete) },
+        m_fd{ fd },
+        m_buffer(bufferSize)
+    {
+        // re-queued after every message, only removed once the socket is done receiving
+        m_removeOnComplete = false;
+        Reset();
+    }
+
+    /// recvmsg shrinks the lengths to what it filled in
+    void Reset() noexcept
+    {
+        m_iov.iov_base = m_buffer.data();
+        m_iov.iov_len = m_buffer.size();
+        m_message.msg_iov = &m_iov;
+        m_message.msg_iovlen = 1;
+        m_message.msg_control = m_control.data();
+        m_message.msg_controllen = m_control.size();
+        m_message.msg_flags = 0;
+    }
+
+    int m_fd;
+    // lives with the op rather than the socket so it outlives a socket closed mid receive
+    std::vector<uint8_t> m_buffer;
+    iovec m_iov{};
+    alignas(cmsghdr) std::array<uint8_t, CMSG_SPACE(sizeof(int) * s_maxFds)> m_control{};
+    msghdr m_message{};
+};
+
+class UnixSend final : public Event
+{
+public:
+    /// Takes ownership of fds, closed once the send is done with them
+    UnixSend(Handle::Id handlerId, OnCompleteFunc&& onComplete, int fd, std::string data, std::vector<int> fds) :
+        Event{ handlerId, std::move(onComplete) },
+        m_fd{ fd },
+        m_data{ std::move(data) },
+        m_fds{ std::move(fds) }
+    {
+        m_iov.iov_base = m_data.data();
+        m_iov.iov_len = m_data.size();
+        m_message.msg_iov = &m_iov;
+        m_message.msg_iovlen = 1;
+
+        if (not m_fds.empty())
+        {
+            m_message.msg_control = m_control.data();
+            m_message.msg_controllen = CMSG_SPACE(sizeof(int) * m_fds.size());
+            cmsghdr* cmsg{ CMSG_FIRSTHDR(&m_message) };
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int) * m_fds.size());
+            std::memcpy(CMSG_DATA(cmsg), m_fds.data(), sizeof(int) * m_fds.size());
+        }
+    }
+
+    ~UnixSend() noexcept override
+    {
+        for (int fd : m_fds)
+        {
+            ::close(fd);
+        }
+    }
+
+    /// A stream send can go out in parts. the fds went with the first
+    void Advance(size_t sent) noexcept
+    {
+        m_sent += sent;
+        m_iov.iov_base = m_data.data() + m_sent;
+        m_iov.iov_len = m_data.size() - m_sent;
+        m_message.msg_control = nullptr;
+        m_message.msg_controllen = 0;
+    }
+
+    int m_fd;
+    std::string m_data;
+    std::vector<int> m_fds;
+    size_t m_sent{ 0 };
+    iovec m_iov{};
+    alignas(cmsghdr) std::array<uint8_t, CMSG_SPACE(sizeof(int) * UnixRecv::s_maxFds)> m_control{};
+    msghdr m_message{};
+};
+
+class UnixCancel final : public Event
+{
+public:
+    UnixCancel(Handle::Id handlerId, OnCompleteFunc&& onComplete) : Event{ handlerId, std::move(onComplete) } {}
+};
+
+/**
+ * Listens on a unix domain socket path, accepting connections for as long as it lives. A path starting with '@'
+ * is in the abstract namespace and leaves nothing on the filesystem
+ */
+class UnixListener
+{
+public:
+    /// Throws std::runtime_error if path can't be bound. a socket file already at path is replaced
+    UnixListener(std::string_view name, const std::string& path, UnixSocketType type = UnixSocketType::Stream);
+
+    virtual ~UnixListener();
+
+    std::string_view Name() const noexcept { return m_name; }
+
+    const std::string& Path() const noexcept { return m_path; }
+
+    UnixSocketType Type() const noexcept { return m_type; }
+
+protected:
+    /// The accepted fd is the handler's, to hand to a UnixSocket or close
+    virtual void OnAccept(int fd) = 0;
+
+private:
+    UnixListener() = delete;
+    UnixListener(const UnixListener&) = delete;
+    UnixListener(UnixListener&&) = delete;
+    UnixListener& operator=(const UnixListener&) = delete;
+    UnixListener& operator=(UnixListener&&) = delete;
+
+    const std::string m_name;
+    const std::string m_path;
+    const UnixSocketType m_type;
+    const Handle::Id m_id{ Handle::NextId() };
+    int m_fd{ -1 };
+    bool m_acceptPending{ false };
+
+    friend class Proactor;
+};
+
+/**
+ * One end of a unix domain stream or seqpacket connection, either connected to a listener's path or adopted from
+ * an accepted fd. A receive is always posted. fds can be passed with anything sent and arrive with what's received,
+ * alongside the first byte of a stream send or with the message of a seqpacket one. There's no reconnecting, once
+ * closed a new socket is needed
+ */
+class UnixSocket
+{
+public:
+    enum State
+    {
+        Connecting = 0,
+        Connected,
+        Closed,
+    };
+
+    // largest seqpacket message received whole
+    static constexpr size_t s_defaultRxBufferSize{ 64 * 1024 };
+
+    /// Connects to a listener's path. Throws std::runtime_error if the socket can't be created
+    UnixSocket(
+        std::string_view name,
+        const std::string& path,
+        UnixSocketType type = UnixSocketType::Stream,
+        size_t rxBufferSize = s_defaultRxBufferSize
+    );
+
+    /// Takes ownership of an fd from UnixListener::OnAccept
+    UnixSocket(
+        std::string_view name,
+        int fd,
+        UnixSocketType type = UnixSocketType::Stream,
+        size_t rxBufferSize = s_defaultRxBufferSize
+    );
+
+    virtual ~UnixSocket();
+
+    std::string_view Name() const noexcept { return m_name; }
+
+    State GetState() const noexcept { return m_state; }
+
+    UnixSocketType Type() const noexcept { return m_type; }
+
+    /// Copies data, and duplicates fds so the caller can close its own. Sends go out in the order they're made
+    /// @returns false if not connected, passing more than UnixRecv::s_maxFds fds or fds without stream data
+    bool Send(std::span<const uint8_t> data, std::span<const int> fds = {});
+
+protected:
+    virtual void OnConnect() {}
+
+    /// fds passed with the data are the handler's to close
+    virtual void OnReceive(std::span<const uint8_t> data, std::span<const int> fds) = 0;
+
+    /// The peer hung up (0), the connect failed or the connection broke (-errno). nothing's received after it
+    virtual void OnClose(int /*res*/) {}
+
+private:
+    UnixSocket() = delete;
+    UnixSocket(const UnixSocket&) = delete;
+    UnixSocket(UnixSocket&&) = delete;
+    UnixSocket& operator=(const UnixSocket&) = delete;
+    UnixSocket& operator=(UnixSocket&&) = delete;
+
+    const std::string m_name;
+    const UnixSocketType m_type;
+    const size_t m_rxBufferSize;
+    const Handle::Id m_id{ Handle::NextId() };
+    int m_fd{ -1 };
+    State m_state{ Connecting };
+    sockaddr_un m_address{};
+    socklen_t m_addressLen{ 0 };
+    bool m_rxPending{ false };
+    // one send in flight at a time keeps a stream's bytes in order whatever the backend
+    std::deque<std::unique_ptr<UnixSend>> m_txQueue;
+    bool m_txPending{ false };
+
+    friend class Proactor;
+};
+
+/// Fills in address for path, '@' prefixed for the abstract namespace
+/// @returns false if path is empty or too long
+bool MakeUnixAddress(const std::string& path, sockaddr_un& address, socklen_t& addressLen) noexcept;
+
+} // namespace Sage
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+#include "timing/time.hpp"
+
+namespace Sage
+{
+
+/// Time spent in a callback. Buckets are powers of 2 of ns so percentiles are within 2x
+struct CallbackProfile
+{
+    // bucket i counts durations with a bit width of i. the last one also takes anything longer, ~9 minutes
+    static constexpr size_t s_buckets{ 40 };
+
+    void Record(const TimeNS& elapsed) noexcept
+    {
+        const auto ns{ static_cast<uint64_t>(std::max(elapsed.count(), TimeNS::rep{ 0 })) };
+        m_buckets[std::min(static_cast<size_t>(std::bit_width(ns)), s_buckets - 1)]++;
+        m_calls++;
+        m_total += elapsed;
+        m_max = std::max(m_max, elapsed);
+    }
+
+    /// @param percentile in [0, 100]
+    /// @returns the upper bound of the bucket the percentile falls in, capped to the max
+    TimeNS Percentile(double percentile) const noexcept
+    {
+        const auto rank{ static_cast<uint64_t>(std::ceil(percentile / 100 * static_cast<double>(m_calls))) };
+        uint64_t seen{ 0 };
+        for (size_t bucket{ 0 }; bucket < s_buckets; bucket++)
+        {
+            seen += m_buckets[bucket];
+            if (seen != 0 and seen >= rank)
+            {
+                return std::min(TimeNS{ (TimeNS::rep{ 1 } << bucket) - 1 }, m_max);
+            }
+        }
+
+        return m_max;
+    }
+
+    void Merge(const CallbackProfile& other) noexcept
+    {
+        for (size_t bucket{ 0 }; bucket < s_buckets; bucket++)
+        {
+            m_buckets[bucket] += other.m_buckets[bucket];
+        }
+        m_calls += other.m_calls;
+        m_total += other.m_total;
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    TimeNS Mean() const noexcept { return m_calls == 0 ? TimeNS{ 0 } : m_total / static_cast<TimeNS::rep>(m_calls); }
+
+    uint64_t m_calls{ 0 };
+    TimeNS m_total{ 0 };
+    TimeNS m_max{ 0 };
+    std::array<uint32_t, s_buckets> m_buckets{};
+};
+
+} // namespace Sage
@@ -8,6 +8,11 @@ namespace Sage
 ScopedDeadline::~ScopedDeadline()
 {
     auto now = Clock::now();
+    if (m_profile != nullptr)
+    {
+        m_profile->Record(now - m_start);
+    }
+
     auto duration = std::chrono::duration_cast<TimeMS>(now - m_start);
     if (duration <= m_deadline)
     {
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <string_view>
+
+#include "timing/callback_profile.hpp"
 #include "timing/time.hpp"
 
 namespace Sage
@@ -7,17 +10,21 @@ namespace Sage
 
 struct ScopedDeadline final
 {
-    ScopedDeadline(const std::string& tag, const TimeMS& deadline) :
+    /// The tag is only read when it's logged so it must outlive the scope.
+    /// Every run is recorded in profile if one is given
+    ScopedDeadline(std::string_view tag, const TimeMS& deadline, CallbackProfile* profile = nullptr) noexcept :
         m_tag{ tag },
-        m_deadline{ deadline }
+        m_deadline{ deadline },
+        m_profile{ profile }
     { }
 
     ~ScopedDeadline();
 
 private:
     const Clock::time_point m_start{ Clock::now() };
-    const std::string m_tag;
+    const std::string_view m_tag;
     const TimeMS m_deadline;
+    CallbackProfile* const m_profile;
 };
 
 } // namespace Sage
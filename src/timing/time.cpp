@@ -7,15 +7,29 @@ namespace Sage
 
 Timestamp GetCurrentTimeStamp() noexcept
 {
-    Timestamp ts;
     timespec timeSpec{};
+    std::timespec_get(&timeSpec, TIME_UTC);
+
+    return ToTimeStamp(timeSpec);
+}
+
+Timestamp ToTimeStamp(const timespec& timeSpec) noexcept
+{
+    Timestamp ts;
     std::tm localTime{};
 
-    std::timespec_get(&timeSpec, TIME_UTC);
     std::strftime(ts.m_date, sizeof(ts.m_date), "%d-%m-%Y %H:%M:%S", ::localtime_r(&timeSpec.tv_sec, &localTime));
     ::snprintf(ts.m_ns, sizeof(ts.m_ns), ":%09lu", timeSpec.tv_nsec);
 
     return ts;
 }
 
+TimeNS GetCoarseMonotonicTime() noexcept
+{
+    timespec timeSpec{};
+    ::clock_gettime(CLOCK_MONOTONIC_COARSE, &timeSpec);
+
+    return TimeS{ timeSpec.tv_sec } + TimeNS{ timeSpec.tv_nsec };
+}
+
 } // namespace Sage
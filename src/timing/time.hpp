@@ -47,4 +47,9 @@ constexpr __kernel_timespec ChronoTimeToKernelTimeSpec(const TimeNS& duration) n
 
 Timestamp GetCurrentTimeStamp() noexcept;
 
+Timestamp ToTimeStamp(const timespec& timeSpec) noexcept;
+
+/// Tick resolution monotonic time. a few ns to read, for when precision doesn't matter
+TimeNS GetCoarseMonotonicTime() noexcept;
+
 } // namespace Sage
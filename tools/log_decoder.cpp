@@ -0,0 +1,407 @@
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <print>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "log/binary_log_format.hpp"
+#include "log/logger.hpp"
+#include "timing/time.hpp"
+
+/**
+ * Renders binary logs written with --binary back into the regular text format.
+ * Usage: log-decoder [file]. reads stdin when no file is given
+ */
+
+namespace
+{
+
+using namespace Sage;
+using namespace Sage::Logger;
+
+using Arg = std::variant<bool, char, int64_t, uint64_t, float, double, const void*, std::string>;
+
+struct Site
+{
+    Level m_level{ Level::Info };
+    uint32_t m_line{ 0 };
+    bool m_preformatted{ false };
+    std::vector<BinaryLog::ArgType> m_argTypes;
+    std::string m_file;
+    std::string m_format;
+};
+
+// records are never anywhere near this big. anything larger means the stream is corrupt
+constexpr uint32_t s_maxRecordSize{ 1 << 20 };
+
+class RecordDecoder
+{
+public:
+    explicit RecordDecoder(std::string_view payload) : m_payload{ payload } {}
+
+    template<typename T>
+    std::optional<T> Get()
+    {
+        if (m_payload.size() < sizeof(T))
+        {
+            return std::nullopt;
+        }
+
+        T value{};
+        std::memcpy(&value, m_payload.data(), sizeof(T));
+        m_payload.remove_prefix(sizeof(T));
+        return value;
+    }
+
+    std::optional<std::string> GetString()
+    {
+        auto length{ Get<uint32_t>() };
+        if (not length or m_payload.size() < *length)
+        {
+            return std::nullopt;
+        }
+
+        std::string str{ m_payload.substr(0, *length) };
+        m_payload.remove_prefix(*length);
+        return str;
+    }
+
+    std::optional<Arg> GetArg(BinaryLog::ArgType type)
+    {
+        auto wrap = [](auto value) -> std::optional<Arg>
+        {
+            if (not value)
+            {
+                return std::nullopt;
+            }
+            return Arg{ *value };
+        };
+
+        switch (type)
+        {
+            case BinaryLog::ArgType::Bool:
+                if (auto value{ Get<uint8_t>() })
+                {
+                    return Arg{ *value != 0 };
+                }
+                return std::nullopt;
+            case BinaryLog::ArgType::Char:
+                return wrap(Get<char>());
+            case BinaryLog::ArgType::Int:
+                return wrap(Get<int64_t>());
+            case BinaryLog::ArgType::UInt:
+                return wrap(Get<uint64_t>());
+            case BinaryLog::ArgType::Float:
+                return wrap(Get<float>());
+            case BinaryLog::ArgType::Double:
+                return wrap(Get<double>());
+            case BinaryLog::ArgType::Pointer:
+                if (auto value{ Get<uint64_t>() })
+                {
+                    return Arg{ reinterpret_cast<const void*>(static_cast<uintptr_t>(*value)) };
+                }
+                return std::nullopt;
+            case BinaryLog::ArgType::String:
+                return wrap(GetString());
+        }
+
+        return std::nullopt;
+    }
+
+private:
+    std::string_view m_payload;
+};
+
+/// Substitutes each replacement field in turn. nested width / precision arguments aren't supported
+std::string Render(std::string_view format, const std::vector<Arg>& args)
+{
+    std::string out;
+    size_t nextArg{ 0 };
+
+    while (not format.empty())
+    {
+        const size_t pos{ format.find_first_of("{}") };
+        out.append(format.substr(0, pos));
+        if (pos == std::string_view::npos)
+        {
+            break;
+        }
+
+        const char brace{ format[pos] };
+        format.remove_prefix(pos + 1);
+
+        // escaped {{ or }}
+        if (not format.empty() and format.front() == brace)
+        {
+            out.push_back(brace);
+            format.remove_prefix(1);
+            continue;
+        }
+
+        if (brace == '}')
+        {
+            out.push_back(brace);
+            continue;
+        }
+
+        const size_t end{ format.find('}') };
+        if (end == std::string_view::npos)
+        {
+            out.push_back(brace);
+            continue;
+        }
+
+        std::string_view field{ format.substr(0, end) };
+        format.remove_prefix(end + 1);
+
+        std::string_view spec;
+        if (size_t colon{ field.find(':') }; colon != std::string_view::npos)
+        {
+            spec = field.substr(colon);
+            field = field.substr(0, colon);
+        }
+
+        size_t index{ nextArg++ };
+        if (not field.empty())
+        {
+            std::from_chars(field.data(), field.data() + field.size(), index);
+        }
+
+        if (index >= args.size())
+        {
+            out.append("{?}");
+            continue;
+        }
+
+        const std::string argFormat{ std::format("{{{}}}", spec) };
+        try
+        {
+            auto formatArg = [&out, &argFormat](const auto& value)
+            {
+                out.append(std::vformat(argFormat, std::make_format_args(value)));
+            };
+            std::visit(formatArg, args[index]);
+        }
+        catch (const std::format_error&)
+        {
+            out.append("{?}");
+        }
+    }
+
+    return out;
+}
+
+class Decoder
+{
+public:
+    /// @returns false once the stream is unusable
+    bool Decode(Logger::BinaryLog::RecordKind kind, std::string_view payload)
+    {
+        RecordDecoder decoder{ payload };
+
+        switch (kind)
+        {
+            case BinaryLog::RecordKind::Header:
+                return DecodeHeader(decoder);
+            case BinaryLog::RecordKind::Site:
+                return DecodeSite(decoder);
+            case BinaryLog::RecordKind::Line:
+                return DecodeLine(decoder);
+            case BinaryLog::RecordKind::Text:
+                if (auto text{ decoder.GetString() })
+                {
+                    std::cout << *text;
+                }
+                return true;
+        }
+
+        std::println(std::cerr, "skipping unknown record kind {}", static_cast<int>(kind));
+        return true;
+    }
+
+private:
+    bool DecodeHeader(RecordDecoder& decoder)
+    {
+        auto magic{ decoder.Get<std::remove_const_t<decltype(BinaryLog::s_magic)>>() };
+        auto version{ decoder.Get<uint32_t>() };
+        if (not magic or *magic != BinaryLog::s_magic or not version or *version != BinaryLog::s_version)
+        {
+            std::println(std::cerr, "not a binary log or unsupported version");
+            return false;
+        }
+
+        // a recreated log file starts over
+        m_sites.clear();
+        return true;
+    }
+
+    bool DecodeSite(RecordDecoder& decoder)
+    {
+        auto id{ decoder.Get<uint32_t>() };
+        auto level{ decoder.Get<uint8_t>() };
+        auto line{ decoder.Get<uint32_t>() };
+        auto preformatted{ decoder.Get<uint8_t>() };
+        auto argCount{ decoder.Get<uint8_t>() };
+        if (not id or not level or not line or not preformatted or not argCount or *level > Level::Critical)
+        {
+            std::println(std::cerr, "skipping malformed site record");
+            return true;
+        }
+
+        Site site{};
+        site.m_level = static_cast<Level>(*level);
+        site.m_line = *line;
+        site.m_preformatted = *preformatted != 0;
+        for (uint8_t i{ 0 }; i < *argCount; i++)
+        {
+            auto type{ decoder.Get<BinaryLog::ArgType>() };
+            if (not type)
+            {
+                std::println(std::cerr, "skipping malformed site record");
+                return true;
+            }
+            site.m_argTypes.push_back(*type);
+        }
+
+        auto file{ decoder.GetString() };
+        auto format{ decoder.GetString() };
+        if (not file or not format)
+        {
+            std::println(std::cerr, "skipping malformed site record");
+            return true;
+        }
+
+        site.m_file = std::move(*file);
+        site.m_format = std::move(*format);
+        m_sites.insert_or_assign(*id, std::move(site));
+        return true;
+    }
+
+    bool DecodeLine(RecordDecoder& decoder)
+    {
+        auto id{ decoder.Get<uint32_t>() };
+        auto unixNs{ decoder.Get<int64_t>() };
+        if (not id or not unixNs)
+        {
+            std::println(std::cerr, "skipping malformed line record");
+            return true;
+        }
+
+        auto it{ m_sites.find(*id) };
+        if (it == m_sites.end())
+        {
+            std::println(std::cerr, "skipping line from unknown site {}", *id);
+            return true;
+        }
+
+        const Site& site{ it->second };
+        std::string message;
+        if (site.m_preformatted)
+        {
+            message = decoder.GetString().value_or("{?}");
+        }
+        else
+        {
+            std::vector<Arg> args;
+            args.reserve(site.m_argTypes.size());
+            for (BinaryLog::ArgType type : site.m_argTypes)
+            {
+                auto arg{ decoder.GetArg(type) };
+                if (not arg)
+                {
+                    break;
+                }
+                args.push_back(std::move(*arg));
+            }
+            message = Render(site.m_format, args);
+        }
+
+        const timespec timeSpec{ .tv_sec = *unixNs / 1'000'000'000, .tv_nsec = *unixNs % 1'000'000'000 };
+        const Timestamp ts{ ToTimeStamp(timeSpec) };
+
+        std::println(
+            std::cout,
+            "{}[{}{}] [{}] [{}:{}] {}{}",
+            Logger::Internal::GetLevelFormatter(site.m_level),
+            ts.m_date,
+            ts.m_ns,
+            Logger::Internal::GetLevelName(site.m_level),
+            site.m_file,
+            site.m_line,
+            message,
+            Logger::Internal::GetFormatEnd()
+        );
+        return true;
+    }
+
+    std::unordered_map<uint32_t, Site> m_sites;
+};
+
+} // namespace
+
+int main(int argc, char* const argv[])
+{
+    if (argc > 2)
+    {
+        std::println(std::cerr, "Usage: {} [binary log file]", argv[0]);
+        return 1;
+    }
+
+    std::FILE* input{ argc == 2 ? std::fopen(argv[1], "rb") : stdin };
+    if (input == nullptr)
+    {
+        std::println(std::cerr, "unable to open '{}'. {}", argv[1], std::strerror(errno));
+        return 1;
+    }
+
+    Decoder decoder;
+    std::string payload;
+    int res{ 0 };
+
+    while (true)
+    {
+        std::array<char, BinaryLog::s_recordHeaderSize> header;
+        if (std::fread(header.data(), 1, header.size(), input) != header.size())
+        {
+            break;
+        }
+
+        uint32_t size;
+        std::memcpy(&size, header.data(), sizeof(size));
+        if (size < header.size() or size > s_maxRecordSize)
+        {
+            std::println(std::cerr, "corrupt record size {}", size);
+            res = 1;
+            break;
+        }
+
+        payload.resize(size - header.size());
+        if (std::fread(payload.data(), 1, payload.size(), input) != payload.size())
+        {
+            std::println(std::cerr, "truncated record");
+            res = 1;
+            break;
+        }
+
+        if (not decoder.Decode(static_cast<BinaryLog::RecordKind>(header.back()), payload))
+        {
+            res = 1;
+            break;
+        }
+    }
+
+    if (input != stdin)
+    {
+        std::fclose(input);
+    }
+
+    return res;
+}
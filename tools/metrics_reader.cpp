@@ -0,0 +1,199 @@
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <print>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#include "metrics/metrics_layout.hpp"
+#include "proactor/opcode_name.hpp"
+
+/**
+ * Prints the metrics a running proactor publishes under /dev/shm in the prometheus text format.
+ * Usage: metrics-reader <name|path> [interval-ms]. prints once unless an interval is given
+ */
+
+namespace
+{
+
+using namespace Sage::Metrics;
+
+std::string OpcodeName(size_t opcode)
+{
+    if (auto name{ Sage::GetOpcodeName(static_cast<uint8_t>(opcode)) }; not name.empty())
+    {
+        return std::string{ name };
+    }
+
+    return std::format("op{}", opcode);
+}
+
+std::string ErrnoName(size_t err)
+{
+    if (const char* name{ ::strerrorname_np(static_cast<int>(err)) }; name != nullptr)
+    {
+        return name;
+    }
+
+    return std::format("errno{}", err);
+}
+
+void Print(const Layout& layout)
+{
+    const uint32_t count{ layout.m_metricCount.load(std::memory_order_acquire) };
+
+    for (uint32_t i{ 0 }; i < count and i < s_maxMetrics; i++)
+    {
+        const MetricDescriptor& descriptor{ layout.m_metrics[i] };
+        const std::string_view name{ descriptor.m_name.data() };
+        if (descriptor.m_offset + descriptor.m_size > s_maxValues)
+        {
+            continue;
+        }
+
+        auto value = [&](size_t index) -> uint64_t
+        { return layout.m_values[descriptor.m_offset + index].load(std::memory_order_relaxed); };
+
+        switch (descriptor.m_type)
+        {
+            case MetricType::Counter:
+                std::println("# TYPE proactor_{} counter", name);
+                std::println("proactor_{} {}", name, value(0));
+                break;
+
+            case MetricType::Gauge:
+                std::println("# TYPE proactor_{} gauge", name);
+                std::println("proactor_{} {}", name, static_cast<int64_t>(value(0)));
+                break;
+
+            case MetricType::Histogram:
+            {
+                std::println("# TYPE proactor_{} histogram", name);
+                uint64_t cumulative{ 0 };
+                for (size_t bucket{ 0 }; bucket < s_histogramBuckets; bucket++)
+                {
+                    if (value(bucket) == 0)
+                    {
+                        continue;
+                    }
+
+                    cumulative += value(bucket);
+                    // bucket i holds values below 2^i
+                    const uint64_t upperBound{ bucket == 0 ? 0 : ~uint64_t{ 0 } >> (64 - bucket) };
+                    std::println("proactor_{}_bucket{{le=\"{}\"}} {}", name, upperBound, cumulative);
+                }
+                std::println("proactor_{}_bucket{{le=\"+Inf\"}} {}", name, value(s_histogramBuckets));
+                std::println("proactor_{}_count {}", name, value(s_histogramBuckets));
+                std::println("proactor_{}_sum {}", name, value(s_histogramBuckets + 1));
+                break;
+            }
+
+            case MetricType::LatencyHistogram:
+            {
+                const std::atomic<uint64_t>* values{ layout.m_values.data() + descriptor.m_offset };
+                std::println("# TYPE proactor_{} summary", name);
+                for (double quantile : { 0.5, 0.99, 0.999, 1.0 })
+                {
+                    std::println(
+                        "proactor_{}{{quantile=\"{}\"}} {}", name, quantile, LatencyPercentile(values, quantile * 100)
+                    );
+                }
+                std::println("proactor_{}_count {}", name, value(s_latencyBuckets));
+                std::println("proactor_{}_sum {}", name, value(s_latencyBuckets + 1));
+                break;
+            }
+
+            case MetricType::OpcodeCounters:
+            case MetricType::ErrnoCounters:
+            {
+                const bool opcodes{ descriptor.m_type == MetricType::OpcodeCounters };
+                std::println("# TYPE proactor_{} counter", name);
+                for (size_t index{ 0 }; index < descriptor.m_size; index++)
+                {
+                    if (value(index) == 0)
+                    {
+                        continue;
+                    }
+
+                    std::println(
+                        "proactor_{}{{{}=\"{}\"}} {}",
+                        name,
+                        opcodes ? "op" : "errno",
+                        opcodes ? OpcodeName(index) : ErrnoName(index),
+                        value(index)
+                    );
+                }
+                break;
+            }
+        }
+    }
+
+    std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char* const argv[])
+{
+    if (argc < 2 or argc > 3)
+    {
+        std::println(std::cerr, "Usage: {} <name|path> [interval-ms]", argv[0]);
+        return 1;
+    }
+
+    std::string path{ argv[1] };
+    if (not path.contains('/'))
+    {
+        path = "/dev/shm/" + path;
+    }
+
+    int fd{ ::open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+    if (fd == -1)
+    {
+        std::println(std::cerr, "unable to open '{}'. {}", path, std::strerror(errno));
+        return 1;
+    }
+
+    struct stat fileStat{};
+    if (::fstat(fd, &fileStat) == -1 or static_cast<size_t>(fileStat.st_size) < sizeof(Layout))
+    {
+        std::println(std::cerr, "'{}' is not a metrics file", path);
+        ::close(fd);
+        return 1;
+    }
+
+    void* memory{ ::mmap(nullptr, sizeof(Layout), PROT_READ, MAP_SHARED, fd, 0) };
+    int err{ errno };
+    ::close(fd);
+    if (memory == MAP_FAILED)
+    {
+        std::println(std::cerr, "unable to map '{}'. {}", path, std::strerror(err));
+        return 1;
+    }
+
+    const auto& layout{ *static_cast<const Layout*>(memory) };
+    if (layout.m_magic != s_magic or layout.m_version != s_version)
+    {
+        std::println(std::cerr, "'{}' is not a metrics file or has an unsupported version", path);
+        return 1;
+    }
+
+    const auto interval{ std::chrono::milliseconds{ argc == 3 ? std::stoul(argv[2]) : 0 } };
+    Print(layout);
+
+    while (interval.count() != 0)
+    {
+        std::this_thread::sleep_for(interval);
+        std::println("");
+        Print(layout);
+    }
+
+    ::munmap(memory, sizeof(Layout));
+    return 0;
+}